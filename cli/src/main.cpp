@@ -1,11 +1,20 @@
 #include <stdio.h>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <optional>
 #include <pdif_cli/pdif_cli_config.hpp>
 #include <pdif/pdif_engine_config.hpp>
 #include <pdif/pdf.hpp>
 #include <pdif/lcs_stream_differ.hpp>
+#include <pdif/histogram_stream_differ.hpp>
+#include <pdif/bitparallel_lcs_stream_differ.hpp>
+#include <pdif/hierarchical_stream_differ.hpp>
+#include <pdif/chunked_stream_differ.hpp>
+#include <pdif/compare_cache.hpp>
+#include <pdif/compare_pipeline.hpp>
+#include <pdif/similarity_index.hpp>
+#include <pdif/output_buffer.hpp>
 
 void print_version()
 {
@@ -29,13 +38,31 @@ struct args {
     int pageno = -1;
     int context_lines = 3;
     bool word_count = false;
+    int image_similarity = -1;
+    std::optional<std::string> algorithm;
+    int max_edits = -1;
+    bool chunking = true;
+    bool detect_moves = false;
+    std::optional<std::string> cache_dir;
+    uintmax_t cache_size_mb = pdif::compare_cache::DEFAULT_MAX_BYTES >> 20;
+    bool cache_stats = false;
+    bool print_stats = false;
+    bool extraction_cache = false;
+    unsigned threads = 1;
+    pdif::output_format format = pdif::output_format::text;
+    std::string index_action;
+    std::string index_dir;
+    std::vector<std::string> index_files;
+    size_t top_k = 10;
 };
 
 void print_usage()
 {
-    printf("usage: pdif [diff|extract|help|version]\n");
+    printf("usage: pdif [diff|extract|index|help|version]\n");
     printf("  diff [diff_options] <pdf1> <pdf2>: compare two PDF files and output the differences\n");
     printf("  extract [extract_options] <file>: extract the content of a PDF file\n");
+    printf("  index add <index_dir> <pdf>...: add PDF files to a similarity index\n");
+    printf("  index query [query_options] <index_dir> <pdf>: list the indexed PDF files most similar to a PDF file\n");
     printf("  help: print this message\n");
     printf("  version: print the version of pdif_cli\n");
 
@@ -50,6 +77,20 @@ void print_usage()
     printf("    -n, --no-color: do not use console colors in the output\n");
     printf("    -c, --context <number>: the number of context lines to show\n");
     printf("    -i, --ignore-repeated: ignore repeated state changes\n");
+    printf("    -I, --image-similarity <bits>: match images whose perceptual fingerprints differ by at most <bits> (0-64)\n");
+    printf("        similarity is not transitive: a can match b and b match c while a and c differ\n");
+    printf("    -a, --algorithm <lcs|histogram|bitparallel|hierarchical>: the diff algorithm to use (bitparallel for letter granularity, otherwise lcs)\n");
+    printf("        hierarchical diffs sentences and refines changed ones down to the chosen word or letter granularity\n");
+    printf("    -M, --max-edits <number>: report a page as replaced once it needs more than <number> inserts and deletes\n");
+    printf("    --moves: show blocks that were deleted in one place and inserted in another as moves (< and >)\n");
+    printf("    --no-chunking: diff document scope streams element by element instead of only the content-defined chunks that changed\n");
+    printf("    --cache <dir>: reuse compare results stored in <dir> for identical files and options\n");
+    printf("    --cache-size <MB>: the size bound of the cache directory (default: 256)\n");
+    printf("    --cache-stats: print cache hit/miss statistics to stderr\n");
+    printf("    --stats: report the time and work of each stage and page (to stderr as text, or as a final stats record with --format)\n");
+    printf("    -x, --extraction-cache: load each PDF from its <pdf>.pdifx extraction cache when it is up to date\n");
+    printf("    -j, --threads <number>: extract the pages of each PDF on <number> threads (0 for all cores, default: 1)\n");
+    printf("    -f, --format <text|json|ndjson>: the output format (default: text)\n");
     printf("\n");
     printf("   extract_options:\n");
     printf("    -g, --granularity <letter|word|sentence>: the granularity of the extraction\n");
@@ -59,6 +100,26 @@ void print_usage()
     printf("    -n, --no-color: do not use console colors in the output\n");
     printf("    -i, --ignore-repeated: ignore repeated state changes\n");
     printf("    -w, --word-count: show total number of words extracted\n");
+    printf("    -x, --extraction-cache: load from <file>.pdifx when it is up to date, otherwise extract and write it\n");
+    printf("    -j, --threads <number>: extract the pages on <number> threads (0 for all cores, default: 1)\n");
+    printf("    -f, --format <text|json|ndjson>: the output format (default: text)\n");
+    printf("\n");
+    printf("   query_options:\n");
+    printf("    -k, --top <number>: the number of candidates to list (default: 10)\n");
+}
+
+pdif::output_format parse_format(const std::string& format) {
+    if (format == "text") {
+        return pdif::output_format::text;
+    } else if (format == "json") {
+        return pdif::output_format::json;
+    } else if (format == "ndjson") {
+        return pdif::output_format::ndjson;
+    }
+
+    std::cerr << "Error: Invalid format '" << format << "'\n";
+    print_usage();
+    exit(1);
 }
 
 args parse_arguments(int argc, char *argv[]) {
@@ -138,6 +199,32 @@ args parse_arguments(int argc, char *argv[]) {
                 a.ingnore_repeated = false;
             } else if (arg == "-w" || arg == "--word-count") {
                 a.word_count = true;
+            } else if (arg == "-x" || arg == "--extraction-cache") {
+                a.extraction_cache = true;
+            } else if (arg == "-j" || arg == "--threads") {
+                if (i + 1 < argc - 1) {
+                    int threads = std::stoi(argv[i + 1]);
+                    if (threads < 0) {
+                        std::cerr << "Error: Invalid number of threads '" << threads << "'\n";
+                        print_usage();
+                        exit(1);
+                    }
+                    a.threads = threads;
+                    ++i; // Skip the next argument
+                } else {
+                    std::cerr << "Error: Missing argument for threads\n";
+                    print_usage();
+                    exit(1);
+                }
+            } else if (arg == "-f" || arg == "--format") {
+                if (i + 1 < argc - 1) {
+                    a.format = parse_format(argv[i + 1]);
+                    ++i; // Skip the next argument
+                } else {
+                    std::cerr << "Error: Missing argument for format\n";
+                    print_usage();
+                    exit(1);
+                }
             } else {
                 std::cerr << "Error: Unknown option '" << arg << "'\n";
                 print_usage();
@@ -149,6 +236,51 @@ args parse_arguments(int argc, char *argv[]) {
         return a;
     }
 
+    if (a.command == "index") {
+        if (argc < 5) {
+            print_usage();
+            exit(1);
+        }
+
+        a.index_action = argv[2];
+        if (a.index_action != "add" && a.index_action != "query") {
+            std::cerr << "Error: Invalid index command '" << a.index_action << "'\n";
+            print_usage();
+            exit(1);
+        }
+
+        int i = 3;
+        for (; i < argc - 2 && argv[i][0] == '-'; i++) {
+            std::string arg = argv[i];
+            if (a.index_action == "query" && (arg == "-k" || arg == "--top")) {
+                int top = std::stoi(argv[i + 1]);
+                if (top <= 0) {
+                    std::cerr << "Error: Invalid number of candidates '" << top << "'\n";
+                    print_usage();
+                    exit(1);
+                }
+                a.top_k = top;
+                i++;
+            } else {
+                std::cerr << "Error: Unknown option '" << arg << "'\n";
+                print_usage();
+                exit(1);
+            }
+        }
+
+        a.index_dir = argv[i++];
+        for (; i < argc; i++) {
+            a.index_files.push_back(argv[i]);
+        }
+
+        if (a.index_files.empty() || (a.index_action == "query" && a.index_files.size() != 1)) {
+            print_usage();
+            exit(1);
+        }
+
+        return a;
+    }
+
     if (argc < 4) {
         print_usage();
         exit(1);
@@ -243,6 +375,110 @@ args parse_arguments(int argc, char *argv[]) {
                 print_usage();
                 exit(1);
             }
+        } else if (arg == "-I" || arg == "--image-similarity") {
+            if (i + 1 < argc - 2) {
+                a.image_similarity = std::stoi(argv[i + 1]);
+
+                if (a.image_similarity < 0 || a.image_similarity > 64) {
+                    std::cerr << "Error: Invalid image similarity '" << a.image_similarity << "'\n";
+                    print_usage();
+                    exit(1);
+                }
+                i++;
+            } else {
+                std::cerr << "Error: Missing argument for image similarity\n";
+                print_usage();
+                exit(1);
+            }
+        } else if (arg == "--cache") {
+            if (i + 1 < argc - 2) {
+                a.cache_dir = argv[i + 1];
+                i++;
+            } else {
+                std::cerr << "Error: Missing argument for cache directory\n";
+                print_usage();
+                exit(1);
+            }
+        } else if (arg == "--cache-size") {
+            if (i + 1 < argc - 2) {
+                int size = std::stoi(argv[i + 1]);
+
+                if (size <= 0) {
+                    std::cerr << "Error: Invalid cache size '" << size << "'\n";
+                    print_usage();
+                    exit(1);
+                }
+                a.cache_size_mb = size;
+                i++;
+            } else {
+                std::cerr << "Error: Missing argument for cache size\n";
+                print_usage();
+                exit(1);
+            }
+        } else if (arg == "--cache-stats") {
+            a.cache_stats = true;
+        } else if (arg == "--stats") {
+            a.print_stats = true;
+        } else if (arg == "--no-chunking") {
+            a.chunking = false;
+        } else if (arg == "--moves") {
+            a.detect_moves = true;
+        } else if (arg == "-x" || arg == "--extraction-cache") {
+            a.extraction_cache = true;
+        } else if (arg == "-j" || arg == "--threads") {
+            if (i + 1 < argc - 2) {
+                int threads = std::stoi(argv[i + 1]);
+                if (threads < 0) {
+                    std::cerr << "Error: Invalid number of threads '" << threads << "'\n";
+                    print_usage();
+                    exit(1);
+                }
+                a.threads = threads;
+                ++i; // Skip the next argument
+            } else {
+                std::cerr << "Error: Missing argument for threads\n";
+                print_usage();
+                exit(1);
+            }
+        } else if (arg == "-f" || arg == "--format") {
+            if (i + 1 < argc - 2) {
+                a.format = parse_format(argv[i + 1]);
+                i++;
+            } else {
+                std::cerr << "Error: Missing argument for format\n";
+                print_usage();
+                exit(1);
+            }
+        } else if (arg == "-M" || arg == "--max-edits") {
+            if (i + 1 < argc - 2) {
+                a.max_edits = std::stoi(argv[i + 1]);
+
+                if (a.max_edits < 0) {
+                    std::cerr << "Error: Invalid max edits '" << a.max_edits << "'\n";
+                    print_usage();
+                    exit(1);
+                }
+                i++;
+            } else {
+                std::cerr << "Error: Missing argument for max edits\n";
+                print_usage();
+                exit(1);
+            }
+        } else if (arg == "-a" || arg == "--algorithm") {
+            if (i + 1 < argc - 2) {
+                std::string algorithm = argv[i + 1];
+                if (algorithm != "lcs" && algorithm != "histogram" && algorithm != "bitparallel" && algorithm != "hierarchical") {
+                    std::cerr << "Error: Invalid algorithm '" << algorithm << "'\n";
+                    print_usage();
+                    exit(1);
+                }
+                a.algorithm = algorithm;
+                i++;
+            } else {
+                std::cerr << "Error: Missing argument for algorithm\n";
+                print_usage();
+                exit(1);
+            }
         } else if (arg == "-n" || arg == "--no-color") {
             a.write_console_colors = false;
         } else if (arg == "-m" || arg == "--meta") {
@@ -280,7 +516,7 @@ bool is_word(std::string word) {
 
 int calc_word_count(pdif::PDF &pdf) {
     int count = 0;
-    auto streams = pdf.get_streams();
+    const auto& streams = pdf.get_streams();
     for (auto &stream : streams) {
         for (int i = 0; i < (int)stream.size(); i++) {
             if (stream[i]->type() == pdif::stream_type::text) {
@@ -300,82 +536,266 @@ int calc_word_count(pdif::PDF &pdf) {
     return count;
 }
 
+bool uses_chunking(const args& a) {
+    // hierarchical diffs already skip equal sentences, chunking would split them across chunks
+    return a.chunking && a.scope == pdif::scope::document && a.algorithm != "hierarchical";
+}
+
+pdif::compare_options make_compare_options(const args& a) {
+    pdif::compare_options options;
+    options.g = a.granularity;
+    options.s = a.scope;
+    options.pageno = a.pageno - 1;
+    options.allow_state_set_nochange = a.ingnore_repeated;
+    options.image_similarity = a.image_similarity;
+    options.max_edit_distance = a.max_edits;
+    options.differ = a.algorithm.value_or("lcs");
+    if (uses_chunking(a)) {
+        options.differ = "chunked-" + options.differ;
+    }
+    if (a.detect_moves) {
+        options.differ += "+moves";
+    }
+    return options;
+}
+
+std::unique_ptr<pdif::output_buffer> open_output(const args& a, std::ofstream& ofs) {
+    if (a.output_file.has_value()) {
+        ofs = std::ofstream(a.output_file.value());
+        return std::make_unique<pdif::output_buffer>(ofs);
+    }
+
+#if !defined(_WIN32)
+    // stdout is written directly, nothing else writes to it through std::cout
+    return std::make_unique<pdif::output_buffer>(fileno(stdout));
+#else
+    return std::make_unique<pdif::output_buffer>(std::cout);
+#endif
+}
+
+std::optional<std::string> extraction_cache_path(const args& a, const std::string& file) {
+    if (!a.extraction_cache) {
+        return std::nullopt;
+    }
+
+    return pdif::extraction_cache::default_path(file);
+}
+
+template<typename T>
+pdif::diff compare_with(pdif::PDF& file1, pdif::PDF& file2, const args& a) {
+    if (uses_chunking(a)) {
+        return file1.compare<pdif::chunked_stream_differ<T>>(file2, a.max_edits);
+    }
+
+    return file1.compare<T>(file2, a.max_edits);
+}
+
+pdif::compare_pipeline::page_differ_f pipeline_differ(const args& a, pdif::granularity finest) {
+    if (a.algorithm == "hierarchical") {
+        return pdif::compare_pipeline::make_differ<pdif::hierarchical_stream_differ>(a.max_edits, finest);
+    } else if (a.algorithm == "histogram") {
+        return pdif::compare_pipeline::make_differ<pdif::histogram_stream_differ>(a.max_edits);
+    } else if (a.algorithm == "bitparallel") {
+        return pdif::compare_pipeline::make_differ<pdif::bitparallel_lcs_stream_differ>(a.max_edits);
+    }
+
+    return pdif::compare_pipeline::make_differ<pdif::lcs_stream_differ>(a.max_edits);
+}
+
+size_t min_move_length(pdif::granularity g) {
+    // a moved sentence is worth reporting, a few moved letters or common words usually are not
+    switch (g) {
+        case pdif::granularity::sentence:
+            return 1;
+        case pdif::granularity::letter:
+            return 12;
+        default:
+            return pdif::diff::DEFAULT_MIN_MOVE_LENGTH;
+    }
+}
+
+pdif::diff run_compare(const args& a) {
+    // hierarchical diffs extract sentences and refine to the requested granularity
+    bool hierarchical = a.algorithm == "hierarchical";
+    pdif::granularity extract_granularity = hierarchical ? pdif::granularity::sentence : a.granularity;
+    pdif::granularity finest = a.granularity == pdif::granularity::letter ? pdif::granularity::letter : pdif::granularity::word;
+
+    // page scoped diffs are pipelined, each pair of pages is diffed while the next pair is extracted. With
+    // several threads each document is extracted in parallel up front instead
+    if (a.scope == pdif::scope::page && !a.extraction_cache && a.threads == 1) {
+        pdif::compare_pipeline pipeline(a.file1, a.file2, pipeline_differ(a, finest), extract_granularity, a.write_console_colors, a.pageno - 1, a.ingnore_repeated, a.image_similarity);
+        return pipeline.run();
+    }
+
+    pdif::PDF file1(a.file1, extract_granularity, a.scope, a.write_console_colors, a.pageno - 1, a.ingnore_repeated, a.image_similarity, extraction_cache_path(a, a.file1), a.threads);
+    pdif::PDF file2(a.file2, extract_granularity, a.scope, a.write_console_colors, a.pageno - 1, a.ingnore_repeated, a.image_similarity, extraction_cache_path(a, a.file2), a.threads);
+
+    if (hierarchical) {
+        return file1.compare<pdif::hierarchical_stream_differ>(file2, a.max_edits, finest);
+    } else if (a.algorithm == "histogram") {
+        return compare_with<pdif::histogram_stream_differ>(file1, file2, a);
+    } else if (a.algorithm == "bitparallel") {
+        return compare_with<pdif::bitparallel_lcs_stream_differ>(file1, file2, a);
+    }
+
+    return compare_with<pdif::lcs_stream_differ>(file1, file2, a);
+}
+
 int main(int argc, char** argv)
 {
     args a = parse_arguments(argc, argv);
 
     if (a.command == "diff") {
-        pdif::PDF file1(a.file1, a.granularity, a.scope, a.write_console_colors, a.pageno - 1, a.ingnore_repeated);
-        pdif::PDF file2(a.file2, a.granularity, a.scope, a.write_console_colors, a.pageno - 1, a.ingnore_repeated);
+        if (!a.algorithm.has_value()) {
+            a.algorithm = a.granularity == pdif::granularity::letter ? "bitparallel" : "lcs";
+        }
 
-        pdif::diff diff = file1.compare<pdif::lcs_stream_differ>(file2);
-        diff.set_allowed_context(a.context_lines);
+        pdif::stats stats;
+        pdif::stats::collect collect(a.print_stats ? &stats : nullptr);
 
-        std::ofstream ofs;
-        std::ostream *output;
+        std::optional<pdif::compare_cache> cache;
+        std::string cache_key;
+        std::optional<pdif::diff> cached;
 
-        if (a.output_file.has_value()) {
-            ofs = std::ofstream(a.output_file.value());
-            output = &ofs;
-        } else {
-            output = &std::cout;
+        if (a.cache_dir.has_value()) {
+            cache.emplace(a.cache_dir.value(), a.cache_size_mb << 20);
+            cache_key = pdif::compare_cache::make_key(a.file1, a.file2, make_compare_options(a));
+            cached = cache->load(cache_key, a.write_console_colors);
         }
 
-        if (a.meta_only) {
-            diff.output_meta_edit_script(*output);
-            if (a.summary) {
-                diff.output_meta_summary(*output);
+        pdif::diff diff;
+        if (cached.has_value()) {
+            diff = cached.value();
+        } else {
+            diff = run_compare(a);
+
+            if (a.detect_moves) {
+                diff.detect_moves(min_move_length(a.granularity));
             }
 
-            *output << std::endl;
+            if (cache.has_value()) {
+                cache->store(cache_key, diff);
+            }
         }
 
-        if (a.content_only) {
-            diff.output_edit_script(*output);
+        diff.set_allowed_context(a.context_lines);
+
+        std::ofstream ofs;
+        std::unique_ptr<pdif::output_buffer> output = open_output(a, ofs);
+        pdif::stats::timer render(pdif::stats::stage::render);
+
+        if (a.format != pdif::output_format::text) {
+            pdif::json_writer writer(*output, a.format);
+
+            if (a.meta_only) {
+                writer.write_meta_edit_script(diff);
+                if (a.summary) {
+                    writer.write_meta_summary(diff);
+                }
+            }
+
+            if (a.content_only) {
+                writer.write_edit_script(diff);
+                if (a.summary) {
+                    writer.write_edit_summary(diff);
+                }
+            }
+
+            if (a.print_stats) {
+                render.stop();
+                writer.write_stats(stats);
+            }
+
+            writer.finish();
+        } else {
+            if (a.meta_only) {
+                diff.output_meta_edit_script(*output);
+                if (a.summary) {
+                    diff.output_meta_summary(*output);
+                }
+
+                *output << '\n';
+            }
+
+            if (a.content_only) {
+                diff.output_edit_script(*output);
 
-            if (a.summary) {
-                diff.output_edit_summary(*output);
+                if (a.summary) {
+                    diff.output_edit_summary(*output);
+                }
             }
         }
 
+        output->flush();
         if (a.output_file.has_value()) {
             ofs.close();
         }
+        render.stop();
 
-    } else if (a.command == "extract") {
-        pdif::PDF file(a.file1, a.granularity, pdif::scope::page, a.write_console_colors, a.pageno - 1, a.ingnore_repeated);
+        if (a.print_stats && a.format == pdif::output_format::text) {
+            stats.output(std::cerr);
+        }
 
-        std::ofstream ofs;
-        std::ostream *output;
+        if (a.cache_stats && cache.has_value()) {
+            cache->output_stats(std::cerr);
+        }
 
-        if (a.output_file.has_value()) {
-            ofs = std::ofstream(a.output_file.value());
-            output = &ofs;
+    } else if (a.command == "index") {
+        pdif::similarity_index index(a.index_dir);
+
+        if (a.index_action == "add") {
+            for (const auto& file : a.index_files) {
+                index.add(file);
+            }
+            std::cout << "Indexed " << a.index_files.size() << " file(s), " << index.size() << " in total\n";
         } else {
-            output = &std::cout;
+            // one candidate per line: estimated similarity, query pages matched in the candidate, candidate pages, path
+            for (const auto& c : index.query(a.index_files[0], a.top_k)) {
+                printf("%.3f\t%zu\t%zu\t%s\n", c.similarity, c.matched_pages, c.pages, c.path.c_str());
+            }
+        }
+    } else if (a.command == "extract") {
+        pdif::PDF file(a.file1, a.granularity, pdif::scope::page, a.write_console_colors, a.pageno - 1, a.ingnore_repeated, -1, extraction_cache_path(a, a.file1), a.threads);
+
+        if (a.extraction_cache && !file.from_extraction_cache()) {
+            file.write_extraction_cache();
         }
 
+        std::ofstream ofs;
+        std::unique_ptr<pdif::output_buffer> output = open_output(a, ofs);
+
         if (a.word_count) {
             if (a.write_console_colors) {
-                *output << util::CONSOLE_COLOR_CODE::TEXT_BOLD;
+                *output << pdif::console_color(util::CONSOLE_COLOR_CODE::TEXT_BOLD);
             }
             *output << "Total Word count: ";
 
             if (a.write_console_colors) {
-                *output << util::CONSOLE_COLOR_CODE::TEXT_RESET;
+                *output << pdif::console_color(util::CONSOLE_COLOR_CODE::TEXT_RESET);
             }
 
-            *output << calc_word_count(file) << std::endl;
+            *output << calc_word_count(file) << '\n';
+            output->flush();
             return 0;
         }
 
-        if (a.pageno == 0) {
+        if (a.format != pdif::output_format::text) {
+            pdif::json_writer writer(*output, a.format);
+
+            if (a.pageno == 0) {
+                writer.write_meta(file.get_meta());
+            } else {
+                file.dump_content(writer);
+            }
+
+            writer.finish();
+        } else if (a.pageno == 0) {
             file.dump_meta(*output);
         } else {
             file.dump_content(*output, a.spacing);
         }
 
-
+        output->flush();
         if (a.output_file.has_value()) {
             ofs.close();
         }
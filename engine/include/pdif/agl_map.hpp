@@ -5,6 +5,7 @@
 #include <pdif/pdif_engine_config.hpp>
 
 #include <map>
+#include <mutex>
 #include <set>
 #include <iostream>
 #include <fstream>
@@ -36,18 +37,26 @@ public:
 private:
 
     /**
-     * @brief The map of glyph names to utf8 strings
+     * @brief Glyph names that have already been warned about, guarded by m_warnings_mutex
      * 
      */
-    static std::map<std::string, std::string> m_agl_map;
     static std::set<std::string> m_warnings;
+    static std::mutex m_warnings_mutex;
+
+    /**
+     * @brief The map of glyph names to utf8 strings, loaded once on first use
+     * 
+     * @return const std::map<std::string, std::string>& the map
+     */
+    static const std::map<std::string, std::string>& agl();
 
     /**
      * @brief load the adobe glyph list map
      * 
      * @param file_path the file
+     * @param map the map to add the glyphs to
      */
-    static void load_agl_map(const std::string& file_path);
+    static void load_agl_map(const std::string& file_path, std::map<std::string, std::string>& map);
 };
 
 } // namespace pdif
@@ -0,0 +1,74 @@
+#ifndef __PDIF_BITPARALLEL_LCS_STREAM_DIFFER_HPP__
+#define __PDIF_BITPARALLEL_LCS_STREAM_DIFFER_HPP__
+
+#include <pdif/stream_differ_base.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace pdif {
+
+/**
+ * @brief A bit-parallel (Allison-Dix / Hyyro) LCS stream differ
+ * 
+ * The elements of both streams are interned into a small alphabet and each row of the LCS matrix is
+ * held as a bit vector over stream1, so 64 cells (256 with AVX2) are computed per machine operation.
+ * Every row is kept so the edit script can be recovered with an O(m + n) traceback.
+ * 
+ * Intended for letter granularity, where the alphabet is small and the streams are long. Streams whose
+ * alphabet or matrix would exceed the memory budget are handed to the histogram_stream_differ instead.
+ * 
+ */
+class bitparallel_lcs_stream_differ : public stream_differ_base {
+public:
+
+    bitparallel_lcs_stream_differ(pdif::stream_view stream1, pdif::stream_view stream2) : stream_differ_base(stream1, stream2) {}
+    DELETE_TEMPORARY_STREAMS(bitparallel_lcs_stream_differ)
+    ~bitparallel_lcs_stream_differ() override = default;
+
+    /**
+     * @brief Implement the diff method to compare the two streams using the bit-parallel LCS algorithm
+     * 
+     * @param diff The diff object to populate with the differences between the two streams.
+     */
+    virtual void diff(pdif::diff&) override;
+
+    /**
+     * @brief the maximum number of 64 bit words used for the match masks and the stored rows together
+     * 
+     */
+    static constexpr size_t MAX_WORDS = size_t(1) << 24;
+
+private:
+
+    /**
+     * @brief intern the elements of both streams into symbol ids
+     * 
+     * Elements of stream2 that do not occur in stream1 are given the symbol -1. Images compared by
+     * similarity are interned against the first image of their class, as similarity is not transitive.
+     * 
+     * @return int the number of distinct symbols in stream1
+     */
+    int intern();
+
+    /**
+     * @brief advance a row by one element of stream2
+     * 
+     * Computes V = (V + (V & peq)) | (V & ~peq) over all words, carrying between words. On x86-64 rows of
+     * 4 or more words use an AVX2 kernel when the CPU supports it.
+     * 
+     * @param row the previous row, also the output row
+     * @param peq the match mask of the stream2 element
+     * @param words the number of words in a row
+     */
+    static void advance_row(uint64_t* row, const uint64_t* peq, size_t words);
+
+private:
+
+    std::vector<int> m_symbols1;
+    std::vector<int> m_symbols2;
+};
+
+}
+
+#endif // __PDIF_BITPARALLEL_LCS_STREAM_DIFFER_HPP__
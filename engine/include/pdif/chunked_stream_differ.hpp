@@ -0,0 +1,128 @@
+#ifndef __PDIF_CHUNKED_STREAM_DIFFER_HPP__
+#define __PDIF_CHUNKED_STREAM_DIFFER_HPP__
+
+#include <pdif/stream_differ_base.hpp>
+#include <pdif/lcs_stream_differ.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace pdif {
+
+/**
+ * @brief Splits streams into content-defined chunks and aligns the chunks of two streams
+ *
+ * Cut points are chosen by a rolling (gear) hash over the element hashes, so they depend only on the
+ * elements around them: an edit moves the cut points of the chunks it touches and no others. Chunks are
+ * then aligned patience style, anchoring on chunks that occur exactly once in both streams and extending
+ * the matches to equal neighbouring chunks.
+ *
+ */
+class content_chunker {
+public:
+
+    /**
+     * @brief the smallest chunk, except at the end of a stream
+     *
+     */
+    static constexpr size_t MIN_CHUNK = 8;
+    /**
+     * @brief cut when the rolling hash has these bits clear, giving chunks of about MIN_CHUNK + 32 elements.
+     * The high bits depend on the last 64 elements, the low bits only on the last few
+     *
+     */
+    static constexpr uint64_t CUT_MASK = 31ull << 59;
+    /**
+     * @brief the largest chunk, cut regardless of the hash
+     *
+     */
+    static constexpr size_t MAX_CHUNK = 256;
+
+    /**
+     * @brief a run of elements of a stream
+     *
+     */
+    struct chunk {
+        size_t start;
+        size_t size;
+        uint64_t hash;
+    };
+
+    /**
+     * @brief a range of stream1 aligned with a range of stream2
+     *
+     * equal ranges contain the same elements, the other ranges still need diffing
+     *
+     */
+    struct aligned_range {
+        size_t a0, a1;
+        size_t b0, b1;
+        bool equal;
+    };
+
+    /**
+     * @brief split a stream into content-defined chunks
+     *
+     * @param s the stream
+     * @return std::vector<chunk> the chunks, covering the stream in order
+     */
+    static std::vector<chunk> split(stream_view s);
+
+    /**
+     * @brief align two streams by their chunks
+     *
+     * @param a the first stream
+     * @param b the second stream
+     * @return std::vector<aligned_range> ranges covering both streams in order
+     */
+    static std::vector<aligned_range> align(stream_view a, stream_view b);
+
+private:
+
+    /**
+     * @brief check the elements of two chunks are equal, guarding against hash collisions
+     *
+     */
+    static bool chunks_equal(stream_view a, const chunk& ca, stream_view b, const chunk& cb);
+};
+
+/**
+ * @brief A stream differ for long streams (scope::document) that only diffs the chunks that changed
+ *
+ * The streams are aligned by content_chunker and the differ T is run on each range of unmatched chunks,
+ * so the cost grows with the amount of change instead of the product of the stream lengths. The edit script
+ * may be less minimal than T's across a chunk boundary.
+ *
+ * @tparam T the stream differ for unmatched ranges, which must diff the streams as given (not hierarchical)
+ */
+template<typename T = lcs_stream_differ>
+class chunked_stream_differ : public stream_differ_base {
+public:
+
+    chunked_stream_differ(pdif::stream_view stream1, pdif::stream_view stream2) : stream_differ_base(stream1, stream2) {}
+    DELETE_TEMPORARY_STREAMS(chunked_stream_differ)
+    ~chunked_stream_differ() override = default;
+
+    /**
+     * @brief Implement the diff method to compare the two streams chunk by chunk
+     *
+     * @param diff The diff object to populate with the differences between the two streams.
+     */
+    virtual void diff(pdif::diff& diff) override {
+        for (const auto& range : content_chunker::align(stream1, stream2)) {
+            if (range.equal) {
+                for (size_t i = range.a0; i < range.a1; i++) {
+                    diff.add_edit_op(edit_op(edit_op_type::EQ));
+                }
+                continue;
+            }
+
+            T differ(stream1.subspan(range.a0, range.a1 - range.a0), stream2.subspan(range.b0, range.b1 - range.b0));
+            differ.diff(diff);
+        }
+    }
+};
+
+}
+
+#endif // __PDIF_CHUNKED_STREAM_DIFFER_HPP__
@@ -0,0 +1,165 @@
+#ifndef __PDIF_COMPARE_CACHE_HPP__
+#define __PDIF_COMPARE_CACHE_HPP__
+
+#include <pdif/diff.hpp>
+#include <pdif/content_extractor.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace pdif {
+
+/**
+ * @brief The options that affect the result of a compare, used as part of the compare_cache key
+ * 
+ */
+struct compare_options {
+    granularity g = granularity::word;
+    scope s = scope::page;
+    int pageno = -1;
+    bool allow_state_set_nochange = true;
+    int image_similarity = -1;
+    int max_edit_distance = -1;
+    /**
+     * @brief the name of the differ and any differ specific settings
+     * 
+     */
+    std::string differ = "lcs";
+
+    /**
+     * @brief a canonical string of the options
+     * 
+     * @return std::string 
+     */
+    std::string to_string() const;
+};
+
+/**
+ * @brief A directory based, size bounded LRU cache of compare results
+ * 
+ * Entries are keyed by the content hashes of both PDFs, the compare_options, the engine version, the
+ * result version and the serialiser and extraction format versions, and hold the serialised diff (see pdif::serializer), so a hit returns
+ * without opening either PDF.
+ * 
+ * Several processes may share a directory: entries are written to a temporary file and renamed into
+ * place, so readers only ever see complete entries. Recency is the entry's modification time, refreshed
+ * on every hit. Eviction tolerates entries disappearing underneath it, and unreadable entries are treated
+ * as misses and removed.
+ * 
+ */
+class compare_cache {
+public:
+
+    /**
+     * @brief hit/miss statistics for this cache object
+     * 
+     */
+    struct statistics {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;
+        uint64_t evictions = 0;
+    };
+
+    /**
+     * @brief the default size bound (256MB)
+     * 
+     */
+    static constexpr uintmax_t DEFAULT_MAX_BYTES = uintmax_t(256) << 20;
+
+    /**
+     * @brief the version of the extraction and diff results, part of every key
+     * 
+     * Bump this whenever a change to extraction or a differ changes the diff of the same inputs without
+     * changing a serialisation format, so entries written by older builds are no longer served.
+     * 
+     */
+    static constexpr uint32_t RESULT_VERSION = 2;
+
+    /**
+     * @brief Construct a new compare cache, creating the directory if needed
+     * 
+     * @param directory the cache directory
+     * @param max_bytes the total size of the entries to keep (default: DEFAULT_MAX_BYTES)
+     */
+    compare_cache(const std::string& directory, uintmax_t max_bytes = DEFAULT_MAX_BYTES);
+
+    /**
+     * @brief the SHA1 (hex) of a file's contents
+     * 
+     * @param path the file
+     * @return std::string the hex digest
+     */
+    static std::string file_hash(const std::string& path);
+
+    /**
+     * @brief build the key for comparing two files with the given options
+     * 
+     * @param path1 the first PDF
+     * @param path2 the second PDF
+     * @param options the compare options
+     * @return std::string the key
+     */
+    static std::string make_key(const std::string& path1, const std::string& path2, const compare_options& options);
+
+    /**
+     * @brief look up a compare result
+     * 
+     * @param key the key from make_key
+     * @param write_console_colors whether the returned diff writes console colors
+     * @return std::optional<diff> the diff on a hit
+     */
+    std::optional<diff> load(const std::string& key, bool write_console_colors = true);
+
+    /**
+     * @brief store a compare result, evicting the least recently used entries over the size bound
+     * 
+     * @param key the key from make_key
+     * @param d the diff
+     */
+    void store(const std::string& key, const diff& d);
+
+    /**
+     * @brief the statistics of this cache object
+     * 
+     * @return const statistics& 
+     */
+    inline const statistics& stats() const { return m_stats; }
+
+    /**
+     * @brief the number of entries currently in the directory
+     * 
+     * @return size_t 
+     */
+    size_t entries() const;
+    /**
+     * @brief the total size of the entries currently in the directory
+     * 
+     * @return uintmax_t 
+     */
+    uintmax_t size_bytes() const;
+
+    /**
+     * @brief write the statistics to an output stream
+     * 
+     * @param os the output stream
+     */
+    void output_stats(std::ostream& os) const;
+
+private:
+
+    std::filesystem::path entry_path(const std::string& key) const;
+    void evict();
+
+    std::filesystem::path m_directory;
+    uintmax_t m_max_bytes;
+    statistics m_stats;
+
+    static constexpr const char* ENTRY_EXTENSION = ".pdifc";
+};
+
+}
+
+#endif // __PDIF_COMPARE_CACHE_HPP__
@@ -0,0 +1,100 @@
+#ifndef __PDIF_COMPARE_PIPELINE_HPP__
+#define __PDIF_COMPARE_PIPELINE_HPP__
+
+#include <pdif/stream.hpp>
+#include <pdif/diff.hpp>
+#include <pdif/compare_session.hpp>
+#include <pdif/content_extractor.hpp>
+
+#include <qpdf/QPDF.hh>
+
+#include <functional>
+#include <string>
+
+namespace pdif {
+
+/**
+ * @brief A comparison that diffs each pair of pages as soon as both are extracted
+ *
+ * PDF::compare extracts every page of both documents before the first page is diffed. The pipeline
+ * instead pulls the pages of both documents from extract_content_lazily one pair at a time, and page k is
+ * diffed and handed to the page callback while page k + 1 of each document is tokenized on a single worker
+ * thread that lives for the whole run, so only one content filter runs beside the differ. The first page's hunks are therefore available after extracting one page of each document, and
+ * only two pairs of extracted pages are held at a time (the diff still keeps the original pages it
+ * renders).
+ *
+ * Pages are matched by index and the diff returned is equal to what PDF::compare would return with the
+ * same options.
+ *
+ */
+class compare_pipeline {
+public:
+
+    /**
+     * @brief diffs one page into a diff, see compare_session::page_differ_f
+     *
+     */
+    using page_differ_f = compare_session::page_differ_f;
+    /**
+     * @brief called with the diff of each page as soon as it is diffed
+     *
+     * The page diff is self contained: its hunks are numbered from the start of the page and it holds the
+     * original page to render them.
+     *
+     */
+    using page_callback_f = std::function<void(size_t page, const pdif::diff& page_diff)>;
+
+    /**
+     * @brief make a page differ that uses the stream differ T, see compare_session::make_differ
+     *
+     */
+    template<typename T, typename... Args, typename = std::enable_if_t<std::is_base_of_v<stream_differ_base, T>>>
+    static page_differ_f make_differ(int max_edit_distance = -1, const Args&... args) {
+        return compare_session::make_differ<T>(max_edit_distance, args...);
+    }
+
+    /**
+     * @brief Construct a new compare pipeline and open both documents
+     *
+     * No page is extracted until run() is called.
+     *
+     * @param path1 the path of the original PDF
+     * @param path2 the path of the revised PDF
+     * @param differ the page differ
+     * @param g the granularity of the extractor (default: word)
+     * @param write_console_colors flag to set whether the diff writes console colors (default: true)
+     * @param pageno the page number to compare STARTING FROM 0 (default: -1 for all)
+     * @param allow_state_set_nochange allow state elements to be added even if the state has not changed (default: true)
+     * @param image_similarity match images whose perceptual fingerprints differ by at most this many bits (default: -1 for exact matching only)
+     */
+    compare_pipeline(const std::string& path1, const std::string& path2, page_differ_f differ, granularity g = granularity::word, bool write_console_colors = true, int pageno = -1, bool allow_state_set_nochange = true, int image_similarity = -1);
+
+    /**
+     * @brief compare the documents page by page
+     *
+     * The meta data is diffed first, then each pair of pages is extracted, diffed and passed to the
+     * callback in page order, on the calling thread. The differ and callback run concurrently with the
+     * extraction of the next pages. An exception thrown while extracting is rethrown once the page being
+     * diffed is done.
+     *
+     * @param on_page called with each page diff (default: none)
+     * @return pdif::diff the differences between the two PDFs
+     */
+    pdif::diff run(const page_callback_f& on_page = nullptr) const;
+
+private:
+
+    page_differ_f m_differ;
+    granularity m_granularity;
+    bool m_write_console_colors;
+    int m_pageno;
+    bool m_allow_state_set_nochange;
+    int m_image_similarity;
+
+    std::shared_ptr<QPDF> m_pdf1;
+    std::shared_ptr<QPDF> m_pdf2;
+};
+
+}
+
+#endif // __PDIF_COMPARE_PIPELINE_HPP__
@@ -0,0 +1,171 @@
+#ifndef __PDIF_COMPARE_SESSION_HPP__
+#define __PDIF_COMPARE_SESSION_HPP__
+
+#include <pdif/stream.hpp>
+#include <pdif/stream_meta.hpp>
+#include <pdif/diff.hpp>
+#include <pdif/stream_differ_base.hpp>
+#include <pdif/content_extractor.hpp>
+
+#include <qpdf/QPDF.hh>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace pdif {
+
+/**
+ * @brief An incremental comparison of a document against revisions of another
+ *
+ * The session keeps the extracted pages of both documents and the edit script of every page. When the
+ * revised document changes on disk, update() hashes the content streams and resources of each of its
+ * pages, and only pages whose hash changed are extracted and diffed again. Their ops are spliced into the
+ * aggregated diff in place, so an update costs one pass of hashing plus work proportional to the changed
+ * pages rather than a full compare.
+ *
+ * Pages are matched by index, as in PDF::compare, so inserting a page near the start of the revision
+ * changes every page after it. The extraction is always page scoped.
+ *
+ */
+class compare_session {
+public:
+
+    /**
+     * @brief diffs one page into a diff, see stream_differ_base::diff_page
+     *
+     */
+    using page_differ_f = std::function<void(pdif::diff& d, const stream* page1, const stream* page2)>;
+
+    /**
+     * @brief make a page differ that uses the stream differ T
+     *
+     * @tparam T the stream differ to use
+     * @tparam Args extra constructor arguments for the stream differ
+     * @param max_edit_distance see stream_differ_base::bounded_diff (default: -1 for unbounded)
+     * @param args extra arguments passed to each stream differ after the two streams
+     * @return page_differ_f the page differ
+     */
+    template<typename T, typename... Args, typename = std::enable_if_t<std::is_base_of_v<stream_differ_base, T>>>
+    static page_differ_f make_differ(int max_edit_distance = -1, const Args&... args) {
+        return [=](pdif::diff& d, const stream* page1, const stream* page2) {
+            stream_differ_base::diff_page<T>(d, page1, page2, max_edit_distance, args...);
+        };
+    }
+
+    /**
+     * @brief Construct a new compare session and run the initial compare
+     *
+     * @param path1 the path of the original PDF
+     * @param path2 the path of the revised PDF
+     * @param differ the page differ
+     * @param g the granularity of the extractor (default: word)
+     * @param write_console_colors flag to set whether the diff writes console colors (default: true)
+     * @param allow_state_set_nochange allow state elements to be added even if the state has not changed (default: true)
+     * @param image_similarity match images whose perceptual fingerprints differ by at most this many bits (default: -1 for exact matching only)
+     */
+    compare_session(const std::string& path1, const std::string& path2, page_differ_f differ, granularity g = granularity::word, bool write_console_colors = true, bool allow_state_set_nochange = true, int image_similarity = -1);
+
+    /**
+     * @brief read the revised PDF again and re-diff the pages that changed
+     *
+     * @return size_t the number of pages that were diffed again
+     */
+    size_t update();
+    /**
+     * @brief read a new revision from another path and re-diff the pages that changed
+     *
+     * @param path2 the path of the revised PDF
+     * @return size_t the number of pages that were diffed again
+     */
+    size_t update(const std::string& path2);
+
+    /**
+     * @brief get the aggregated diff of the documents
+     *
+     * @return const pdif::diff& the diff, equal to what PDF::compare would return
+     */
+    inline const pdif::diff& get_diff() const { return m_diff; }
+    /**
+     * @brief get the edit script of one page
+     *
+     * @param page the page index, STARTING FROM 0
+     * @return const pdif::diff& the diff of the page
+     * @throws pdif_out_of_bounds if the page is not in either document
+     */
+    const pdif::diff& page_diff(size_t page) const;
+    /**
+     * @brief get the number of pages compared, the page count of the longer document
+     *
+     * @return size_t the number of pages
+     */
+    inline size_t page_count() const { return m_page_diffs.size(); }
+
+    /**
+     * @brief get the pages of the original PDF
+     *
+     * @return const std::vector<stream>& the pages
+     */
+    inline const std::vector<stream>& original_pages() const { return m_pages1; }
+    /**
+     * @brief get the pages of the current revision
+     *
+     * @return const std::vector<stream>& the pages
+     */
+    inline const std::vector<stream>& revised_pages() const { return m_pages2; }
+
+    /**
+     * @brief hash the content of each page of a PDF
+     *
+     * The hash covers the page's content streams, everything reachable from its resources (fonts,
+     * images, forms) and its annotations with their form field values, i.e. everything the extraction of
+     * the page reads. Objects shared between pages are only hashed once. A reference to a page (a link
+     * destination or action) is hashed as the page's index, and the back links, appearances and
+     * modification dates of annotations are skipped, so editing a page does not change the pages that
+     * link to it.
+     *
+     * @param pdf the PDF
+     * @return std::vector<std::string> the SHA1 (hex) of each page
+     */
+    static std::vector<std::string> page_hashes(std::shared_ptr<QPDF> pdf);
+
+private:
+
+    /**
+     * @brief load a revision and re-diff the pages that changed since the last one
+     *
+     * @param path2 the path of the revised PDF
+     * @param full diff every page, for the initial load
+     * @return size_t the number of pages that were diffed again
+     */
+    size_t load(const std::string& path2, bool full);
+    /**
+     * @brief diff one page into a new page diff
+     *
+     * @param page the page index
+     * @return pdif::diff the diff of the page
+     */
+    pdif::diff diff_page(size_t page) const;
+
+private:
+
+    std::string m_path2;
+    page_differ_f m_differ;
+    granularity m_granularity;
+    bool m_allow_state_set_nochange;
+    int m_image_similarity;
+
+    std::vector<stream> m_pages1;
+    stream_meta m_meta1;
+
+    std::vector<stream> m_pages2;
+    stream_meta m_meta2;
+    std::vector<std::string> m_hashes2;
+
+    std::vector<pdif::diff> m_page_diffs;
+    pdif::diff m_diff;
+};
+
+}
+
+#endif // __PDIF_COMPARE_SESSION_HPP__
@@ -4,6 +4,7 @@
 #include <vector>
 #include <pdif/stream.hpp>
 #include <pdif/stream_meta.hpp>
+#include <pdif/generator.hpp>
 
 #include <qpdf/QPDF.hh>
 #include <qpdf/QPDFObjectHandle.hh>
@@ -40,6 +41,13 @@ enum class scope {
 /**
  * @brief extract the metadata from a given PDF
  * 
+ * The entries of the trailer /Info dictionary are keyed by their name without the leading /. Strings and
+ * names are their text, arrays, dictionaries and streams the hex page_visitor::structural_hash of their
+ * structure, and other values are unparsed after resolving them, so object numbers are never compared. The
+ * properties of the catalog's XMP /Metadata stream are flattened by pdif::xmp_parser and keyed by their
+ * path prefixed with "XMP/", e.g. "XMP/dc:title[x-default]". An unreadable or malformed XMP packet is
+ * skipped with a warning.
+ * 
  * @param pdf the PDF to extract the metadata from
  * @return pdif::stream_meta the metadata
  */
@@ -52,9 +60,67 @@ extern pdif::stream_meta extract_meta(std::shared_ptr<QPDF> pdf);
  * @param g the granularity to use
  * @param s the scope to use
  * @param pageno the page number to extract from, -1 for all, 0 for first. Default is -1
+ * @param allow_state_set_nochange allow state elements to be added even if the state has not changed. Default is true
+ * @param image_similarity fingerprint images and match them within this many bits, negative to disable. Default is -1
+ * @return std::vector<pdif::stream> the extracted content
+ */
+extern std::vector<pdif::stream> extract_content(std::shared_ptr<QPDF> pdf, granularity g, scope s, int pageno = -1, bool allow_state_set_nochange = true, int image_similarity = -1);
+
+/**
+ * @brief extract the content from a given PDF lazily, one page at a time
+ * 
+ * Each page is only parsed when the generator is advanced to it, so a consumer can work on a page before
+ * the next one is read. With document scope the single stream is yielded once every page is extracted.
+ * The streams yielded are the same as those returned by extract_content.
+ * 
+ * @param pdf the PDF to extract the content from
+ * @param g the granularity to use
+ * @param s the scope to use
+ * @param pageno the page number to extract from, -1 for all, 0 for first. Default is -1
+ * @param allow_state_set_nochange allow state elements to be added even if the state has not changed. Default is true
+ * @param image_similarity fingerprint images and match them within this many bits, negative to disable. Default is -1
+ * @return generator<pdif::stream> the extracted content
+ */
+extern generator<pdif::stream> extract_content_lazily(std::shared_ptr<QPDF> pdf, granularity g, scope s, int pageno = -1, bool allow_state_set_nochange = true, int image_similarity = -1);
+
+/**
+ * @brief extract the content from a given PDF on several threads
+ * 
+ * QPDF objects cannot be shared between threads, so every worker opens the file with its own QPDF (the
+ * calling thread uses pdf). The pages are split into contiguous shards, a few per thread so that
+ * expensive pages do not hold up one worker, and each worker extracts the shards it takes with its own
+ * image and form caches. The pages are merged in order, and concatenated for document scope, so the
+ * result is the same as extract_content's.
+ * 
+ * If a worker throws, the other workers finish their current shard and the first exception (in thread
+ * order) is rethrown.
+ * 
+ * @param pdf the PDF to extract the content from, opened from path
+ * @param path the path of the PDF, opened again by each worker
+ * @param g the granularity to use
+ * @param s the scope to use
+ * @param pageno the page number to extract from, -1 for all, 0 for first. A single page is extracted on the calling thread. Default is -1
+ * @param allow_state_set_nochange allow state elements to be added even if the state has not changed. Default is true
+ * @param image_similarity fingerprint images and match them within this many bits, negative to disable. Default is -1
+ * @param threads the number of threads to use, at most one per page. Default is 0 for the hardware concurrency
  * @return std::vector<pdif::stream> the extracted content
  */
-extern std::vector<pdif::stream> extract_content(std::shared_ptr<QPDF> pdf, granularity g, scope s, int pageno = -1, bool allow_state_set_nochange = true);
+extern std::vector<pdif::stream> extract_content_parallel(std::shared_ptr<QPDF> pdf, const std::string& path, granularity g, scope s, int pageno = -1, bool allow_state_set_nochange = true, int image_similarity = -1, unsigned threads = 0);
+
+/**
+ * @brief extract the content of some pages of a given PDF, one stream per page
+ * 
+ * Images and forms shared between the pages are only decoded once.
+ * 
+ * @param pdf the PDF to extract the content from
+ * @param pagenos the page numbers to extract, STARTING FROM 0
+ * @param g the granularity to use
+ * @param allow_state_set_nochange allow state elements to be added even if the state has not changed. Default is true
+ * @param image_similarity fingerprint images and match them within this many bits, negative to disable. Default is -1
+ * @return std::vector<pdif::stream> the extracted content, in the order of pagenos
+ * @throws pdif_out_of_bounds if a page number is out of range
+ */
+extern std::vector<pdif::stream> extract_pages(std::shared_ptr<QPDF> pdf, const std::vector<int>& pagenos, granularity g, bool allow_state_set_nochange = true, int image_similarity = -1);
 
 }
 
@@ -6,9 +6,12 @@
 #include <pdif/edit_op.hpp>
 #include <pdif/meta_edit_op.hpp>
 #include <pdif/logger.hpp>
+#include <pdif/render.hpp>
+#include <pdif/output_buffer.hpp>
 
 #include <util/colormod.hpp>
 
+#include <functional>
 #include <sstream>
 #include <optional>
 
@@ -53,6 +56,42 @@ public:
         int to_count = 0;
     };
 
+    /**
+     * @brief Represent a chunk of change in the diff as elements, before rendering
+     * 
+     */
+    struct edit_hunk {
+        /**
+         * @brief one line of the hunk, EQ lines are context
+         * 
+         */
+        struct line {
+            edit_op_type type;
+            rstream_elem elem;
+            /**
+             * @brief the move id of MOVE_FROM and MOVE_TO lines
+             * 
+             */
+            size_t move = 0;
+        };
+
+        /**
+         * @brief The lines of the hunk
+         * 
+         */
+        std::vector<line> lines;
+        int from_file_start = 0;
+        int to_file_start = 0;
+        int from_count = 0;
+        int to_count = 0;
+    };
+
+    /**
+     * @brief the default shortest block of elements reported as a move by detect_moves
+     * 
+     */
+    static constexpr size_t DEFAULT_MIN_MOVE_LENGTH = 4;
+
     diff(bool write_console_colors = true) : m_write_console_colors(write_console_colors) {}
 
     /**
@@ -115,6 +154,12 @@ public:
      * @param os the output stream
      */
     void output_edit_script(std::ostream& os) const;
+    /**
+     * @brief output the edit script to the given output buffer
+     * 
+     * @param os the output buffer
+     */
+    void output_edit_script(output_buffer& os) const;
 
     /**
      * @brief output the meta edit script to the given output stream
@@ -122,6 +167,12 @@ public:
      * @param os the output stream
      */
     void output_meta_edit_script(std::ostream& os) const;
+    /**
+     * @brief output the meta edit script to the given output buffer
+     * 
+     * @param os the output buffer
+     */
+    void output_meta_edit_script(output_buffer& os) const;
 
     /**
      * @brief reverse the edit script
@@ -149,6 +200,53 @@ public:
      * @param s the original stream
      */
     void add_original_stream(const stream& s) { m_original_streams.push_back(s); }
+    /**
+     * @brief replace an original stream of the diff
+     * 
+     * @param index the index of the original stream
+     * @param s the original stream
+     * @throws pdif_out_of_bounds if there is no original stream at index
+     */
+    void set_original_stream(size_t index, const stream& s);
+    /**
+     * @brief replace a range of the edit script with the edit script of another diff
+     * 
+     * Used to update part of a diff in place, e.g. the ops of one page after it is diffed again.
+     * 
+     * @param index the index of the first op to replace
+     * @param count the number of ops to replace
+     * @param source the diff whose edit script is inserted in their place
+     * @throws pdif_out_of_bounds if the range is not within the edit script
+     */
+    void replace_edit_ops(size_t index, size_t count, const diff& source);
+    /**
+     * @brief pair deleted and inserted blocks with the same content as moves
+     * 
+     * Every k-gram (k = min_length) of the runs of deleted elements is indexed in a hash table, then the
+     * runs of inserted elements are scanned for k-grams in the index. A hit is verified and extended as far
+     * as both runs stay equal, and the matched DELETE and INSERT ops become MOVE_FROM and MOVE_TO ops with
+     * a new move id. The pass is linear in the number of changed elements (a k-gram shared by many deleted
+     * blocks checks a bounded number of them). Deletes and inserts of the same hunk are never paired.
+     * 
+     * The edit script still applies to the same result. The original streams must be set, as for rendering.
+     * 
+     * @param min_length the shortest block reported as a move, in elements (default: DEFAULT_MIN_MOVE_LENGTH)
+     * @return size_t the number of moves found
+     * @throws pdif_invalid_argment if min_length is 0
+     * @throws pdif_out_of_bounds if the original streams do not cover the deleted elements
+     */
+    size_t detect_moves(size_t min_length = DEFAULT_MIN_MOVE_LENGTH);
+    /**
+     * @brief remove all the meta edit ops
+     * 
+     */
+    inline void clear_meta_edit_ops() { m_meta_edit_script.clear(); }
+    /**
+     * @brief get the original streams added to the diff
+     * 
+     * @return const std::vector<stream>& 
+     */
+    inline const std::vector<stream>& original_streams() const { return m_original_streams; }
 
     /**
      * @brief get a reference end iterator for the edit script
@@ -169,14 +267,33 @@ public:
      * @return std::vector<edit_chunk> 
      */
     std::vector<edit_chunk> edit_chunk_summary() const;
+    /**
+     * @brief visit the diff as a series of hunks, without rendering the elements
+     * 
+     * The same hunk object is reused between calls, so it should not be kept by the callback.
+     * 
+     * @param callback called once per hunk, in order
+     */
+    void for_each_edit_hunk(const std::function<void(const edit_hunk&)>& callback) const;
     /**
      * @brief count the number of each type of operation in the edit script
      * 
+     * MOVE_TO ops are counted as inserts and MOVE_FROM ops as deletes.
+     * 
      * @param plus 
      * @param minus 
      * @param eq 
      */
     void count_edit_op_types(int& plus, int& minus, int&eq) const;
+    /**
+     * @brief count the number of each type of operation in the edit script, counting moves separately
+     * 
+     * @param plus 
+     * @param minus 
+     * @param eq 
+     * @param moved the number of MOVE_TO ops (elements moved)
+     */
+    void count_edit_op_types(int& plus, int& minus, int&eq, int& moved) const;
 
     /**
      * @brief Count the number of each type of operation in the meta edit script
@@ -193,28 +310,32 @@ public:
      * @param os 
      */
     void output_edit_summary(std::ostream& os) const;
+    void output_edit_summary(output_buffer& os) const;
     /**
      * @brief output a summary of the meta edit script to the given output stream
      * 
      * @param os 
      */
     void output_meta_summary(std::ostream& os) const;
+    void output_meta_summary(output_buffer& os) const;
 
 private:
 
 
     std::string get_original_line(int index) const;
+    const rstream_elem& get_original_elem(int index) const;
 
     friend std::ostream& operator<<(std::ostream& os, const edit_chunk& chunk);
 
     void check_edit_index(size_t index) const;
     void check_meta_index(size_t index) const;
 
-    void output_summary(std::ostream& os, int plus, int minus, int last, std::string last_char, util::CONSOLE_COLOR_CODE last_color) const;
+    void output_summary(output_buffer& os, int plus, int minus, int last, std::string last_char, util::CONSOLE_COLOR_CODE last_color, int moved = 0) const;
 
-    void write_edit_chunk(std::ostream& os, const edit_chunk& chunk) const;
+    void render_hunk_line(std::string& buffer, const edit_hunk::line& line) const;
+    void write_edit_hunk(std::string& buffer, const edit_hunk& hunk) const;
 
-    std::string cc(util::CONSOLE_COLOR_CODE code) const;
+    std::string_view cc(util::CONSOLE_COLOR_CODE code) const;
 
 private:
 
@@ -13,11 +13,16 @@ namespace pdif {
 /**
  * @brief enum type for edit operations
  * 
+ * MOVE_FROM and MOVE_TO are a DELETE and an INSERT of the same block of elements, paired by a move id
+ * (see diff::detect_moves). They are applied exactly as a DELETE and an INSERT.
+ * 
  */
 enum class edit_op_type {
     DELETE = 0,
     EQ = 1,
     INSERT = 2,
+    MOVE_FROM = 3,
+    MOVE_TO = 4,
 };
 
 /**
@@ -38,6 +43,12 @@ inline std::ostream& operator<<(std::ostream& os, const edit_op_type& type) {
         case edit_op_type::EQ:
             os << "EQ";
             break;
+        case edit_op_type::MOVE_FROM:
+            os << "MOVE_FROM";
+            break;
+        case edit_op_type::MOVE_TO:
+            os << "MOVE_TO";
+            break;
     }
     return os;
 }
@@ -59,6 +70,10 @@ inline std::istream& operator>>(std::istream& is, edit_op_type& type) {
         type = edit_op_type::DELETE;
     } else if (str == "EQ") {
         type = edit_op_type::EQ;
+    } else if (str == "MOVE_FROM") {
+        type = edit_op_type::MOVE_FROM;
+    } else if (str == "MOVE_TO") {
+        type = edit_op_type::MOVE_TO;
     } else {
         PDIF_LOG_ERROR("edit_op_type::operator>> - invalid edit_op_type");
         throw pdif::pdif_invalid_argment("edit_op_type::operator>> - invalid edit_op_type");
@@ -78,9 +93,10 @@ public:
      * @brief Construct a new edit op object
      * 
      * @param type the type of edit operaiton
-     * @param t_arg the argument for the edit operation. Only valid for INSERT edit_op
+     * @param t_arg the argument for the edit operation. Only valid for INSERT and MOVE_TO edit_op
+     * @param t_move the id pairing the two sides of a move. Only valid for MOVE_FROM and MOVE_TO edit_op (default: 0)
      */
-    edit_op(edit_op_type type, std::optional<pdif::rstream_elem> t_arg);
+    edit_op(edit_op_type type, std::optional<pdif::rstream_elem> t_arg, size_t t_move = 0);
     /**
      * @brief Construct a new edit op object
      * 
@@ -121,6 +137,25 @@ public:
         return arg.has_value();
     }
 
+    /**
+     * @brief checks if the edit operation is one side of a move
+     * 
+     * @return true if the type is MOVE_FROM or MOVE_TO
+     * @return false otherwise
+     */
+    inline bool is_move() const {
+        return type == edit_op_type::MOVE_FROM || type == edit_op_type::MOVE_TO;
+    }
+
+    /**
+     * @brief Get the move id, shared by the MOVE_FROM and MOVE_TO ops of the same moved block
+     * 
+     * @return size_t the move id
+     */
+    inline size_t get_move() const {
+        return move;
+    }
+
     /**
      * @brief This function will executer the edit operation on the stream at the given index, and update the index accordingly
      * 
@@ -133,6 +168,7 @@ private:
 
     edit_op_type type;
     std::optional<pdif::rstream_elem> arg;
+    size_t move = 0;
 
 };
 
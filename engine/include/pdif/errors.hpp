@@ -236,6 +236,64 @@ private:
 
 };
 
+/**
+ * @brief pdif_invalid_format is thrown when serialised data is truncated, corrupt or from another format version.
+ * 
+ */
+class pdif_invalid_format : public std::exception {
+public:
+
+    /**
+     * @brief Construct a new pdif invalid format object
+     * 
+     * @param t_msg the message to be displayed
+     */
+    pdif_invalid_format(const std::string& t_msg) : m_msg(t_msg) {m_msg = "PDIF Invalid Format: " + m_msg;}
+
+    /**
+     * @brief override of std::exception::what()
+     * 
+     * @return const char* the message to be displayed
+     */
+    virtual const char* what() const noexcept override {
+        return m_msg.c_str();
+    }
+
+private:
+
+    std::string m_msg;
+
+};
+
+/**
+ * @brief pdif_io_error is thrown when output cannot be written.
+ * 
+ */
+class pdif_io_error : public std::exception {
+public:
+
+    /**
+     * @brief Construct a new pdif io error object
+     * 
+     * @param t_msg the message to be displayed
+     */
+    pdif_io_error(const std::string& t_msg) : m_msg(t_msg) {m_msg = "PDIF IO Error: " + m_msg;}
+
+    /**
+     * @brief override of std::exception::what()
+     * 
+     * @return const char* the message to be displayed
+     */
+    virtual const char* what() const noexcept override {
+        return m_msg.c_str();
+    }
+
+private:
+
+    std::string m_msg;
+
+};
+
 }
 
-#endif // __PDIF_ERRORS_HPP__
\ No newline at end of file
+#endif // __PDIF_ERRORS_HPP__
@@ -0,0 +1,217 @@
+#ifndef __PDIF_EXTRACTION_CACHE_HPP__
+#define __PDIF_EXTRACTION_CACHE_HPP__
+
+#include <pdif/stream.hpp>
+#include <pdif/stream_meta.hpp>
+#include <pdif/content_extractor.hpp>
+#include <pdif/errors.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace pdif {
+
+/**
+ * @brief The extraction options an extraction cache was written with
+ * 
+ */
+struct extraction_options {
+    granularity g = granularity::word;
+    scope s = scope::page;
+    int pageno = -1;
+    bool allow_state_set_nochange = true;
+    int image_similarity = -1;
+
+    bool operator==(const extraction_options&) const = default;
+};
+
+/**
+ * @brief A memory mapped binary cache of the streams and metadata extracted from a PDF
+ * 
+ * The file starts with a versioned header holding the SHA1 of the PDF it was extracted from and the
+ * extraction_options, followed by fixed size tables and a string blob. Identical elements and strings
+ * are stored once and each stream is a list of element indices, so the file is compact and can be read
+ * in place: elem() and meta() return views into the mapping without allocating.
+ * 
+ * load_streams() materialises the streams, creating one stream_elem per distinct element and sharing it
+ * between every position it occurs at.
+ * 
+ */
+class extraction_cache {
+public:
+
+    /**
+     * @brief a view of one element, strings point into the mapping
+     * 
+     */
+    struct elem_view {
+        stream_type type;
+        /**
+         * @brief the text, font name, image hash, annotation subtype or form field name
+         * 
+         */
+        std::string_view text;
+        /**
+         * @brief the annotation contents, or the form field type and value
+         * 
+         */
+        std::string_view detail[2];
+        /**
+         * @brief the font size, or the image width, height and similarity threshold
+         * 
+         */
+        int32_t values[3];
+        /**
+         * @brief the red, green and blue of a colour
+         * 
+         */
+        float color[3];
+        /**
+         * @brief the rectangle of an annotation
+         * 
+         */
+        float rect[4];
+        /**
+         * @brief whether the image has a fingerprint, set for every annotation
+         * 
+         */
+        bool has_fingerprint;
+        /**
+         * @brief the image fingerprint, or the annotation dictionary hash
+         * 
+         */
+        uint64_t fingerprint;
+    };
+
+    /**
+     * @brief the version written into the header, bumped whenever the layout or the extracted content changes
+     * 
+     */
+    static constexpr uint32_t FORMAT_VERSION = 3;
+
+    /**
+     * @brief the path of the cache written next to a PDF
+     * 
+     * @param pdf_path the PDF
+     * @return std::string the PDF path with a .pdifx extension appended
+     */
+    static std::string default_path(const std::string& pdf_path) { return pdf_path + ".pdifx"; }
+
+    /**
+     * @brief write an extraction cache
+     * 
+     * @param path the file to write
+     * @param file_hash the SHA1 (hex) of the PDF the content was extracted from
+     * @param options the options the content was extracted with
+     * @param meta the extracted metadata
+     * @param streams the extracted streams
+     */
+    static void write(const std::string& path, const std::string& file_hash, const extraction_options& options, const stream_meta& meta, const std::vector<stream>& streams);
+
+    /**
+     * @brief map and validate an extraction cache
+     * 
+     * @param path the file to map
+     * @throws pdif_invalid_format if the file cannot be read, is from another version or is corrupt
+     */
+    extraction_cache(const std::string& path);
+    ~extraction_cache();
+
+    extraction_cache(const extraction_cache&) = delete;
+    extraction_cache& operator=(const extraction_cache&) = delete;
+
+    /**
+     * @brief check if the cache was extracted from the given PDF content with the given options
+     * 
+     * @param file_hash the SHA1 (hex) of the PDF
+     * @param options the extraction options
+     * @return true if the cache can be used in place of extracting
+     */
+    bool matches(const std::string& file_hash, const extraction_options& options) const;
+
+    /**
+     * @brief the SHA1 (hex) of the PDF the cache was extracted from
+     * 
+     * @return std::string
+     */
+    std::string file_hash() const;
+    /**
+     * @brief the options the cache was extracted with
+     * 
+     * @return extraction_options
+     */
+    extraction_options options() const;
+
+    /**
+     * @brief the number of streams
+     * 
+     * @return size_t
+     */
+    size_t stream_count() const;
+    /**
+     * @brief the number of elements in a stream
+     * 
+     * @param s the stream index
+     * @return size_t
+     */
+    size_t stream_size(size_t s) const;
+    /**
+     * @brief view an element of a stream
+     * 
+     * @param s the stream index
+     * @param i the element index within the stream
+     * @return elem_view
+     */
+    elem_view elem(size_t s, size_t i) const;
+
+    /**
+     * @brief the number of metadata entries
+     * 
+     * @return size_t
+     */
+    size_t meta_count() const;
+    /**
+     * @brief view a metadata entry
+     * 
+     * @param i the entry index
+     * @return std::pair<std::string_view, std::string_view> the key and value
+     */
+    std::pair<std::string_view, std::string_view> meta(size_t i) const;
+
+    /**
+     * @brief materialise the streams
+     * 
+     * @return std::vector<stream>
+     */
+    std::vector<stream> load_streams() const;
+    /**
+     * @brief materialise the metadata
+     * 
+     * @return stream_meta
+     */
+    stream_meta load_meta() const;
+
+private:
+
+    struct header;
+    struct elem_record;
+    struct meta_record;
+    struct stream_record;
+
+    const header& head() const;
+    elem_view unique_elem(uint32_t id) const;
+    std::string_view string_at(uint64_t offset, uint32_t size) const;
+    void validate() const;
+
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+    // the fallback buffer where memory mapping is unavailable
+    std::vector<unsigned char> m_buffer;
+};
+
+}
+
+#endif // __PDIF_EXTRACTION_CACHE_HPP__
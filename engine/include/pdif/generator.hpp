@@ -0,0 +1,143 @@
+#ifndef __PDIF_GENERATOR_HPP__
+#define __PDIF_GENERATOR_HPP__
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace pdif {
+
+/**
+ * @brief A lazy sequence of values produced by a coroutine
+ *
+ * A coroutine returning a generator runs up to its first co_yield when begin() is called, and on to the
+ * next co_yield each time the iterator is advanced, so only the values that are asked for are produced.
+ * The yielded value lives in the coroutine frame until the iterator is advanced again; it can be moved
+ * from. An exception thrown by the coroutine is rethrown from begin() or the increment that resumed it.
+ *
+ * A generator can only be iterated once and owns its coroutine: destroying it early destroys the frame
+ * and everything the coroutine holds.
+ *
+ * @tparam T the type of the yielded values
+ */
+template<typename T>
+class generator {
+public:
+
+    struct promise_type {
+        T* value = nullptr;
+        std::exception_ptr exception;
+
+        generator get_return_object() { return generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        std::suspend_always yield_value(T& v) noexcept {
+            value = std::addressof(v);
+            return {};
+        }
+        std::suspend_always yield_value(T&& v) noexcept {
+            value = std::addressof(v);
+            return {};
+        }
+
+        void return_void() noexcept {}
+        void unhandled_exception() { exception = std::current_exception(); }
+
+        // co_await is not supported in a generator
+        template<typename U>
+        std::suspend_never await_transform(U&&) = delete;
+    };
+
+    /**
+     * @brief An input iterator over the yielded values
+     *
+     */
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using reference = T&;
+        using pointer = T*;
+
+        iterator() = default;
+        explicit iterator(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+        reference operator*() const { return *m_handle.promise().value; }
+        pointer operator->() const { return m_handle.promise().value; }
+
+        iterator& operator++() {
+            resume(m_handle);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        bool operator==(std::default_sentinel_t) const { return !m_handle || m_handle.done(); }
+
+    private:
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    generator(generator&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+    generator& operator=(generator&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+    generator(const generator&) = delete;
+    generator& operator=(const generator&) = delete;
+
+    ~generator() { destroy(); }
+
+    /**
+     * @brief run the coroutine to its first value
+     *
+     * @return iterator the iterator at the first value
+     */
+    iterator begin() {
+        resume(m_handle);
+        return iterator(m_handle);
+    }
+    /**
+     * @brief the end of the sequence
+     *
+     * @return std::default_sentinel_t the sentinel
+     */
+    std::default_sentinel_t end() const noexcept { return std::default_sentinel; }
+
+private:
+
+    explicit generator(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+    static void resume(std::coroutine_handle<promise_type> handle) {
+        if (!handle || handle.done()) {
+            return;
+        }
+
+        handle.resume();
+        if (handle.promise().exception) {
+            std::rethrow_exception(std::exchange(handle.promise().exception, nullptr));
+        }
+    }
+
+    void destroy() {
+        if (m_handle) {
+            m_handle.destroy();
+            m_handle = nullptr;
+        }
+    }
+
+private:
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+}
+
+#endif // __PDIF_GENERATOR_HPP__
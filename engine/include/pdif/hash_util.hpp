@@ -0,0 +1,122 @@
+#ifndef __PDIF_HASH_UTIL_HPP__
+#define __PDIF_HASH_UTIL_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <pdif/errors.hpp>
+#include <pdif/logger.hpp>
+
+struct evp_md_ctx_st;
+
+namespace pdif {
+
+/**
+ * @brief An incremental SHA1 digest
+ *
+ * The digests that key caches, identify images and detect changed pages all go through this class, so
+ * the engine has one place that talks to OpenSSL.
+ *
+ */
+class sha1 {
+public:
+
+    /**
+     * @brief the size of a digest in bytes
+     *
+     */
+    static constexpr size_t DIGEST_SIZE = 20;
+
+    /**
+     * @brief Construct a new, empty digest
+     *
+     */
+    sha1();
+    ~sha1();
+
+    sha1(const sha1&) = delete;
+    sha1& operator=(const sha1&) = delete;
+
+    /**
+     * @brief add bytes to the digest
+     *
+     * @param data the bytes
+     * @param size the number of bytes
+     */
+    void update(const void* data, size_t size);
+    /**
+     * @brief add bytes to the digest
+     *
+     * @param data the bytes
+     */
+    inline void update(std::string_view data) { update(data.data(), data.size()); }
+
+    /**
+     * @brief finish the digest, after which no more bytes can be added
+     *
+     * @return std::string the DIGEST_SIZE raw digest bytes
+     */
+    std::string digest();
+
+    /**
+     * @brief the digest of a buffer
+     *
+     * @param data the bytes
+     * @param size the number of bytes
+     * @return std::string the DIGEST_SIZE raw digest bytes
+     */
+    static std::string of(const void* data, size_t size);
+    /**
+     * @brief the digest of a file's contents, read in blocks
+     *
+     * @throw pdif_invalid_argment if the file cannot be opened
+     *
+     * @param path the file
+     * @return std::string the DIGEST_SIZE raw digest bytes
+     */
+    static std::string of_file(const std::string& path);
+
+private:
+
+    evp_md_ctx_st* m_ctx;
+};
+
+/**
+ * @brief lower case hex encoding of bytes, two digits per byte
+ *
+ * @param data the bytes
+ * @param size the number of bytes
+ * @return std::string the hex string
+ */
+std::string to_hex(const void* data, size_t size);
+/**
+ * @brief lower case hex encoding of bytes, two digits per byte
+ *
+ * @param data the bytes
+ * @return std::string the hex string
+ */
+inline std::string to_hex(std::string_view data) { return to_hex(data.data(), data.size()); }
+/**
+ * @brief append the lowest digits of a value as lower case hex, most significant digit first
+ *
+ * @param out the string to append to
+ * @param value the value
+ * @param digits the number of hex digits (default: 16, the whole value)
+ */
+void append_hex(std::string& out, uint64_t value, int digits = 16);
+/**
+ * @brief decode a hex string (either case) into bytes
+ *
+ * @param hex the hex string, two digits per byte
+ * @param out the buffer to decode into
+ * @param size the number of bytes to decode, hex must be exactly 2 * size digits
+ * @return true if hex was valid and decoded
+ * @return false otherwise, out is then unspecified
+ */
+bool from_hex(std::string_view hex, unsigned char* out, size_t size);
+
+} // namespace pdif
+
+#endif // __PDIF_HASH_UTIL_HPP__
@@ -0,0 +1,77 @@
+#ifndef __PDIF_HIERARCHICAL_STREAM_DIFFER_HPP__
+#define __PDIF_HIERARCHICAL_STREAM_DIFFER_HPP__
+
+#include <pdif/stream_differ_base.hpp>
+#include <pdif/content_extractor.hpp>
+
+namespace pdif {
+
+/**
+ * @brief A multi-granularity stream differ
+ * 
+ * Takes streams extracted at sentence granularity and diffs them sentence by sentence. Only the hunks where
+ * sentences were both removed and added are split into words and diffed again, and, when the finest
+ * granularity is letter, only the changed word hunks are split into letters. Unchanged text stays as whole
+ * sentences, so the cost is close to a sentence level diff with word or letter precision where it matters.
+ * 
+ * The edit script applies to original_stream(), the partially refined copy of stream1.
+ * 
+ */
+class hierarchical_stream_differ : public stream_differ_base {
+public:
+
+    /**
+     * @brief Construct a new hierarchical stream differ
+     * 
+     * @param stream1 the first stream, extracted at sentence granularity
+     * @param stream2 the second stream, extracted at sentence granularity
+     * @param finest the finest granularity to refine changed regions to, word or letter (default: word)
+     */
+    hierarchical_stream_differ(pdif::stream_view stream1, pdif::stream_view stream2, granularity finest = granularity::word);
+    DELETE_TEMPORARY_STREAMS(hierarchical_stream_differ, granularity = granularity::word)
+    ~hierarchical_stream_differ() override = default;
+
+    /**
+     * @brief Implement the diff method to compare the two streams sentence first, refining changed regions
+     * 
+     * @param diff The diff object to populate with the differences between the two streams.
+     */
+    virtual void diff(pdif::diff&) override;
+
+    /**
+     * @brief stream1 with the changed regions split to the granularity they were diffed at
+     * 
+     * @return pdif::stream_view the stream the edit script applies to
+     */
+    virtual pdif::stream_view original_stream() const override { return m_refined; }
+
+    /**
+     * @brief split the text elements of a stream into words or letters, the way extract_content would
+     * 
+     * Non-text elements are kept as they are. Splitting to sentence granularity copies the stream.
+     * 
+     * @param s the stream to split
+     * @param g the granularity to split to
+     * @return pdif::stream the split stream
+     */
+    static pdif::stream split(pdif::stream_view s, granularity g);
+
+private:
+
+    /**
+     * @brief diff two runs of elements at a granularity, refining the changed hunks at the next granularity
+     * 
+     * @param a the elements removed from stream1
+     * @param b the elements added in stream2
+     * @param g the granularity to diff at
+     * @param d the diff to add the edit ops to
+     */
+    void refine(pdif::stream_view a, pdif::stream_view b, granularity g, pdif::diff& d);
+
+    granularity m_finest;
+    pdif::stream m_refined;
+};
+
+}
+
+#endif // __PDIF_HIERARCHICAL_STREAM_DIFFER_HPP__
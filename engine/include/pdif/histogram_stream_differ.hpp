@@ -0,0 +1,88 @@
+#ifndef __PDIF_HISTOGRAM_STREAM_DIFFER_HPP__
+#define __PDIF_HISTOGRAM_STREAM_DIFFER_HPP__
+
+#include <pdif/stream_differ_base.hpp>
+
+#include <vector>
+
+namespace pdif {
+
+/**
+ * @brief A histogram (patience style) stream differ
+ * 
+ * The streams are split on the lowest-occurrence common element (the anchor), and the regions either
+ * side of the anchor are diffed recursively. Small regions, and regions without a usable anchor, fall back
+ * to Myers' O(ND) algorithm. On prose this is near-linear and keeps reordered paragraphs as readable hunks.
+ * 
+ */
+class histogram_stream_differ : public stream_differ_base {
+public:
+
+    histogram_stream_differ(pdif::stream_view stream1, pdif::stream_view stream2) : stream_differ_base(stream1, stream2) {}
+    DELETE_TEMPORARY_STREAMS(histogram_stream_differ)
+    ~histogram_stream_differ() override = default;
+
+    /**
+     * @brief Implement the diff method to compare the two streams using histogram diff
+     * 
+     * @param diff The diff object to populate with the differences between the two streams.
+     */
+    virtual void diff(pdif::diff&) override;
+
+private:
+
+    /**
+     * @brief diff stream1[a0, a1) against stream2[b0, b1), anchoring on low-occurrence elements
+     * 
+     */
+    void diff_region(int a0, int a1, int b0, int b1, int depth);
+    /**
+     * @brief diff stream1[a0, a1) against stream2[b0, b1) with Myers' linear space algorithm
+     * 
+     */
+    void myers(int a0, int a1, int b0, int b1);
+    /**
+     * @brief find the Myers middle snake split point of stream1[a0, a1) and stream2[b0, b1)
+     * 
+     * @return true if a split point was found, false if the regions have nothing in common
+     */
+    bool bisect(int a0, int a1, int b0, int b1, int& split_a, int& split_b);
+
+    /**
+     * @brief check if stream1[i] equals stream2[j]
+     * 
+     */
+    bool eq(int i, int j);
+
+    void emit_eq(int count);
+    void emit_delete(int count);
+    void emit_insert(int b0, int b1);
+
+private:
+
+    std::vector<size_t> m_hash1;
+    std::vector<size_t> m_hash2;
+    std::vector<edit_op> m_ops;
+    // furthest reaching points evaluated by bisect, see stats::counter::dp_cells
+    uint64_t m_cells = 0;
+
+    /**
+     * @brief regions with at most this many elements (both sides) go straight to Myers
+     * 
+     */
+    static constexpr int SMALL_REGION = 32;
+    /**
+     * @brief elements occurring more often than this in a region are not used as anchors
+     * 
+     */
+    static constexpr size_t MAX_CHAIN = 64;
+    /**
+     * @brief the recursion depth after which regions fall back to Myers
+     * 
+     */
+    static constexpr int MAX_DEPTH = 64;
+};
+
+}
+
+#endif // __PDIF_HISTOGRAM_STREAM_DIFFER_HPP__
@@ -0,0 +1,93 @@
+#ifndef __PDIF_IMAGE_FINGERPRINT_HPP__
+#define __PDIF_IMAGE_FINGERPRINT_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include <pdif/errors.hpp>
+
+namespace pdif {
+
+/**
+ * @brief Perceptual image fingerprinting (dHash)
+ * 
+ * An image is converted to grayscale, box-downscaled to a GRID_WIDTH x GRID_HEIGHT grid and
+ * each row of the grid is reduced to a bit per horizontal gradient. Two images that only differ
+ * by resizing or re-encoding produce fingerprints with a small hamming distance.
+ */
+class image_fingerprint {
+public:
+
+    /**
+     * @brief the width of the downscaled grid (one more than the bits per row)
+     * 
+     */
+    static constexpr int GRID_WIDTH = 9;
+    /**
+     * @brief the height of the downscaled grid
+     * 
+     */
+    static constexpr int GRID_HEIGHT = 8;
+
+    /**
+     * @brief compute the dHash of a decoded 8 bit image
+     * 
+     * @param pixels the decoded samples, row major, interleaved components
+     * @param width the width of the image in pixels
+     * @param height the height of the image in pixels
+     * @param components the number of components per pixel (1 gray, 3 rgb, 4 cmyk)
+     * @return uint64_t the 64 bit fingerprint
+     */
+    static uint64_t dhash(const unsigned char* pixels, int width, int height, int components);
+
+    /**
+     * @brief box-downscale a decoded 8 bit image to a grayscale grid
+     * 
+     * @param pixels the decoded samples, row major, interleaved components
+     * @param width the width of the image in pixels
+     * @param height the height of the image in pixels
+     * @param components the number of components per pixel (1 gray, 3 rgb, 4 cmyk)
+     * @param grid_width the width of the output grid
+     * @param grid_height the height of the output grid
+     * @return std::vector<unsigned char> the grid, row major
+     */
+    static std::vector<unsigned char> downscale(const unsigned char* pixels, int width, int height, int components, int grid_width, int grid_height);
+
+    /**
+     * @brief the hamming distance between two fingerprints
+     * 
+     * @param a the first fingerprint
+     * @param b the second fingerprint
+     * @return int the number of differing bits (0-64)
+     */
+    static int distance(uint64_t a, uint64_t b);
+
+    /**
+     * @brief a coarse summary of a fingerprint, one majority bit per quadrant of the bit grid
+     * 
+     * Similar fingerprints usually share a bucket, so it can be hashed where fingerprints are matched
+     * by distance. The bucket is far coarser than any useful threshold, 16 buckets for all 2^64
+     * fingerprints, so matching by distance must also require equal buckets: two fingerprints a bit
+     * apart can straddle a quadrant's majority and land in different buckets.
+     * 
+     * @param fingerprint the fingerprint
+     * @return uint8_t the bucket (0-15)
+     */
+    static uint8_t bucket(uint64_t fingerprint);
+
+private:
+
+    /**
+     * @brief sum a run of bytes (vectorised where available)
+     * 
+     * @param data the bytes
+     * @param size the number of bytes
+     * @return uint64_t the sum
+     */
+    static uint64_t sum_u8(const unsigned char* data, size_t size);
+};
+
+} // namespace pdif
+
+#endif // __PDIF_IMAGE_FINGERPRINT_HPP__
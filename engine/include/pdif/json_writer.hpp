@@ -0,0 +1,164 @@
+#ifndef __PDIF_JSON_WRITER_HPP__
+#define __PDIF_JSON_WRITER_HPP__
+
+#include <pdif/diff.hpp>
+#include <pdif/stream.hpp>
+#include <pdif/stream_meta.hpp>
+#include <pdif/output_buffer.hpp>
+#include <pdif/stats.hpp>
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace pdif {
+
+/**
+ * @brief the output formats of the diff and extract commands
+ *
+ */
+enum class output_format {
+    text,
+    json,
+    ndjson,
+};
+
+/**
+ * @brief A streaming JSON / NDJSON writer for diffs and extracted content
+ *
+ * Every record (a metadata entry or change, a hunk, an element or a summary) is written on its own line.
+ * In NDJSON mode each line is a standalone JSON object; in JSON mode the records are wrapped in a single
+ * array, still one record per line, so both can be parsed incrementally.
+ *
+ * Records are appended directly into an output_buffer, which is written out whenever it grows past its
+ * capacity, so memory use does not depend on the size of the output.
+ *
+ * Record shapes:
+ *  - {"type":"meta","key":K,"value":V} for extracted metadata
+ *  - {"type":"meta_change","op":"add"|"delete"|"update","key":K[,"value":V]}
+ *  - {"type":"hunk","from_start":N,"from_count":N,"to_start":N,"to_count":N,"lines":[{"op":"eq"|"insert"|"delete"|"move_from"|"move_to"[,"move":N],"elem":E},...]}
+ *  - {"type":"elem","page":N,"index":N,"elem":E} for extracted content
+ *  - {"type":"summary","scope":"content"|"meta","insert":N,"delete":N,"eq"|"update":N[,"move":N]}
+ *
+ * where an element E is one of
+ *  - {"kind":"text","text":S}
+ *  - {"kind":"font","name":S,"size":N}
+ *  - {"kind":"text_color"|"stroke_color","r":F,"g":F,"b":F}
+ *  - {"kind":"image","hash":S,"width":N,"height":N}
+ *  - {"kind":"annotation","subtype":S,"rect":[F,F,F,F],"contents":S,"hash":S}
+ *  - {"kind":"form_field","name":S,"field_type":S,"value":S}
+ *
+ */
+class json_writer {
+public:
+
+    /**
+     * @brief the buffer size at which the buffer is written to the output stream
+     *
+     */
+    static constexpr size_t DEFAULT_FLUSH_THRESHOLD = output_buffer::DEFAULT_CAPACITY;
+
+    /**
+     * @brief Construct a new json writer
+     *
+     * @param os the output stream, must outlive the writer
+     * @param format json or ndjson
+     * @param flush_threshold the buffer size at which the buffer is written to the output stream
+     * @throws pdif_invalid_argment if the format is text
+     */
+    json_writer(std::ostream& os, output_format format, size_t flush_threshold = DEFAULT_FLUSH_THRESHOLD);
+    /**
+     * @brief Construct a new json writer
+     *
+     * @param out the output buffer, must outlive the writer
+     * @param format json or ndjson
+     * @throws pdif_invalid_argment if the format is text
+     */
+    json_writer(output_buffer& out, output_format format);
+    /**
+     * @brief finish the document and flush
+     *
+     */
+    ~json_writer();
+
+    json_writer(const json_writer&) = delete;
+    json_writer& operator=(const json_writer&) = delete;
+
+    /**
+     * @brief write one record per metadata entry
+     *
+     * @param meta the metadata
+     */
+    void write_meta(const stream_meta& meta);
+    /**
+     * @brief write one record per element of a stream
+     *
+     * @param page the page number to record against the elements
+     * @param s the stream
+     */
+    void write_stream(int page, const stream& s);
+
+    /**
+     * @brief write one record per meta edit op
+     *
+     * @param d the diff
+     */
+    void write_meta_edit_script(const diff& d);
+    /**
+     * @brief write one record per hunk, with the context configured on the diff
+     *
+     * @param d the diff
+     */
+    void write_edit_script(const diff& d);
+    /**
+     * @brief write the content summary record
+     *
+     * @param d the diff
+     */
+    void write_edit_summary(const diff& d);
+    /**
+     * @brief write the meta summary record
+     *
+     * @param d the diff
+     */
+    void write_meta_summary(const diff& d);
+    /**
+     * @brief write the stats record, with the time of each stage in nanoseconds, the counters and one
+     * entry per page
+     *
+     * @param s the stats
+     */
+    void write_stats(const stats& s);
+
+    /**
+     * @brief close the JSON array (if any) and write everything buffered. Further writes are an error
+     *
+     */
+    void finish();
+
+private:
+
+    void begin_document();
+    void begin_record();
+    void end_record();
+
+    void append(std::string_view raw);
+    void append_string(std::string_view s);
+    void append_int(long long v);
+    void append_float(float v);
+    void append_elem(const rstream_elem& elem);
+
+private:
+
+    std::unique_ptr<output_buffer> m_owned;
+    output_buffer* m_out;
+    output_format m_format;
+
+    bool m_first_record = true;
+    bool m_finished = false;
+};
+
+}
+
+#endif // __PDIF_JSON_WRITER_HPP__
@@ -8,7 +8,8 @@ namespace pdif {
 class lcs_stream_differ : public stream_differ_base {
 public:
 
-    lcs_stream_differ(const pdif::stream& stream1, const pdif::stream& stream2) : stream_differ_base(stream1, stream2) {}
+    lcs_stream_differ(pdif::stream_view stream1, pdif::stream_view stream2) : stream_differ_base(stream1, stream2) {}
+    DELETE_TEMPORARY_STREAMS(lcs_stream_differ)
     ~lcs_stream_differ() override = default;
 
     /**
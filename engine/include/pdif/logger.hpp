@@ -25,14 +25,6 @@ public:
      * 
      */
     pdif_logger() = delete;
-
-private:
-
-    /**
-     * @brief static instance of the logger
-     * 
-     */
-    static util::ref<util::logger> logger;
 };
 
 /**
@@ -0,0 +1,107 @@
+#ifndef __PDIF_MINHASH_HPP__
+#define __PDIF_MINHASH_HPP__
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <pdif/stream.hpp>
+
+namespace pdif {
+
+/**
+ * @brief MinHash sketches of extracted documents
+ *
+ * The text of a stream is split into lower cased words and every run of SHINGLE_SIZE words (a shingle)
+ * is hashed. A signature keeps, for each of SIGNATURE_SIZE seeded hash functions, the minimum hash over
+ * all the shingles, so the fraction of equal entries of two signatures estimates the Jaccard similarity
+ * of their shingle sets. Hashes are stable across platforms and runs, so signatures can be stored.
+ *
+ * The signature of a document is the entrywise minimum of its page signatures, i.e. the signature of
+ * the union of the pages' shingles. Shingles do not cross pages.
+ */
+class minhash {
+public:
+
+    /**
+     * @brief the number of hash functions (entries) in a signature
+     *
+     */
+    static constexpr size_t SIGNATURE_SIZE = 128;
+    /**
+     * @brief the number of consecutive words in a shingle
+     *
+     */
+    static constexpr size_t SHINGLE_SIZE = 4;
+
+    /**
+     * @brief a MinHash signature
+     *
+     */
+    using signature = std::array<uint32_t, SIGNATURE_SIZE>;
+
+    /**
+     * @brief the signature of a stream without any shingle
+     *
+     * @return signature every entry at its maximum
+     */
+    static signature empty();
+
+    /**
+     * @brief sketch the text of a stream (e.g. a page)
+     *
+     * Streams with fewer than SHINGLE_SIZE words are sketched as a single shingle of all their words.
+     * Word and sentence streams give the same signature, letter streams shingle letters instead of words.
+     *
+     * @param s the stream
+     * @return signature the signature
+     */
+    static signature sketch(stream_view s);
+    /**
+     * @brief sketch each page of a document
+     *
+     * @param pages the pages
+     * @return std::vector<signature> the signature of each page
+     */
+    static std::vector<signature> sketch_pages(const std::vector<stream>& pages);
+    /**
+     * @brief combine page signatures into the document signature
+     *
+     * @param pages the page signatures
+     * @return signature the entrywise minimum
+     */
+    static signature combine(const std::vector<signature>& pages);
+
+    /**
+     * @brief estimate the Jaccard similarity of the shingle sets of two signatures
+     *
+     * @param a the first signature
+     * @param b the second signature
+     * @return double the fraction of equal entries (0-1)
+     */
+    static double similarity(const signature& a, const signature& b);
+
+    /**
+     * @brief the stable 64 bit hash of a shingle of words
+     *
+     * @param words the words
+     * @param start the first word of the shingle
+     * @param count the number of words in the shingle
+     * @return uint64_t the hash
+     */
+    static uint64_t hash_shingle(const std::vector<std::string>& words, size_t start, size_t count);
+
+private:
+
+    /**
+     * @brief fold a shingle hash into a signature
+     *
+     */
+    static void add_shingle(signature& sig, uint64_t shingle);
+};
+
+} // namespace pdif
+
+#endif // __PDIF_MINHASH_HPP__
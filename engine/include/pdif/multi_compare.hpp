@@ -0,0 +1,139 @@
+#ifndef __PDIF_MULTI_COMPARE_HPP__
+#define __PDIF_MULTI_COMPARE_HPP__
+
+#include <pdif/stream.hpp>
+#include <pdif/stream_meta.hpp>
+#include <pdif/diff.hpp>
+#include <pdif/compare_session.hpp>
+#include <pdif/content_extractor.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pdif {
+
+/**
+ * @brief A comparison of one base document against many revisions of it
+ *
+ * The base is extracted once, along with the hash of each page's content streams and resources (see
+ * compare_session::page_hashes) and a fingerprint of each extracted page. For each revision only the pages
+ * whose raw hash differs from the base page are extracted, and only pages whose extracted content differs
+ * are diffed. An unchanged page reuses the diff of the base page against itself, which the differ computes
+ * the first time the page is found unchanged, so a refining differ's script and original stream are kept.
+ * A revision therefore costs one pass of hashing, the extraction of its changed pages and their diffs.
+ *
+ * Pages are matched by index and each diff is equal to what PDF::compare would return with page scope.
+ * compare() is const and revisions can be compared concurrently, each opening its own QPDF.
+ *
+ */
+class multi_compare {
+public:
+
+    /**
+     * @brief diffs one page into a diff, see compare_session::page_differ_f
+     *
+     */
+    using page_differ_f = compare_session::page_differ_f;
+
+    /**
+     * @brief make a page differ that uses the stream differ T, see compare_session::make_differ
+     *
+     */
+    template<typename T, typename... Args, typename = std::enable_if_t<std::is_base_of_v<stream_differ_base, T>>>
+    static page_differ_f make_differ(int max_edit_distance = -1, const Args&... args) {
+        return compare_session::make_differ<T>(max_edit_distance, args...);
+    }
+
+    /**
+     * @brief Construct a new multi compare and extract the base document
+     *
+     * @param base_path the path of the base PDF
+     * @param differ the page differ, called concurrently when several revisions are compared at once
+     * @param g the granularity of the extractor (default: word)
+     * @param write_console_colors flag to set whether the diffs write console colors (default: true)
+     * @param allow_state_set_nochange allow state elements to be added even if the state has not changed (default: true)
+     * @param image_similarity match images whose perceptual fingerprints differ by at most this many bits (default: -1 for exact matching only)
+     */
+    multi_compare(const std::string& base_path, page_differ_f differ, granularity g = granularity::word, bool write_console_colors = true, bool allow_state_set_nochange = true, int image_similarity = -1);
+
+    /**
+     * @brief compare the base against one revision
+     *
+     * @param revision_path the path of the revised PDF
+     * @return pdif::diff the differences from the base to the revision
+     */
+    pdif::diff compare(const std::string& revision_path) const;
+    /**
+     * @brief compare the base against each revision, in parallel
+     *
+     * If comparing a revision throws, the remaining revisions are still compared and the first exception
+     * (in revision order) is rethrown once all threads are done.
+     *
+     * @param revision_paths the paths of the revised PDFs
+     * @param threads the number of threads to use (default: 0 for the hardware concurrency)
+     * @return std::vector<pdif::diff> one diff per revision, in order
+     */
+    std::vector<pdif::diff> compare(const std::vector<std::string>& revision_paths, unsigned threads = 0) const;
+
+    /**
+     * @brief get the pages of the base PDF
+     *
+     * @return const std::vector<stream>& the pages
+     */
+    inline const std::vector<stream>& base_pages() const { return m_pages; }
+    /**
+     * @brief get the meta data of the base PDF
+     *
+     * @return const stream_meta& the meta data
+     */
+    inline const stream_meta& base_meta() const { return m_meta; }
+
+    /**
+     * @brief fingerprint the elements of a stream, equal streams have equal fingerprints
+     *
+     * @param s the stream
+     * @return uint64_t the fingerprint
+     */
+    static uint64_t fingerprint(stream_view s);
+
+private:
+
+    /**
+     * @brief check whether a revised page has the same content as a base page
+     *
+     * @param page the base page index
+     * @param revised the revised page
+     * @return true if every element compares equal
+     */
+    bool same_page(size_t page, const stream& revised) const;
+    /**
+     * @brief the diff of a base page against itself, computed on first use
+     *
+     * @param page the base page index
+     * @return const pdif::diff& the diff
+     */
+    const pdif::diff& unchanged_page(size_t page) const;
+
+private:
+
+    page_differ_f m_differ;
+    granularity m_granularity;
+    bool m_write_console_colors;
+    bool m_allow_state_set_nochange;
+    int m_image_similarity;
+
+    std::vector<stream> m_pages;
+    stream_meta m_meta;
+    std::vector<std::string> m_hashes;
+    std::vector<uint64_t> m_fingerprints;
+
+    // the diff of each base page against itself, see unchanged_page
+    mutable std::vector<std::once_flag> m_unchanged_once;
+    mutable std::vector<pdif::diff> m_unchanged;
+};
+
+}
+
+#endif // __PDIF_MULTI_COMPARE_HPP__
@@ -0,0 +1,110 @@
+#ifndef __PDIF_OUTPUT_BUFFER_HPP__
+#define __PDIF_OUTPUT_BUFFER_HPP__
+
+#include <pdif/errors.hpp>
+
+#include <charconv>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace pdif {
+
+/**
+ * @brief A large user-space output buffer, written out only when full or when flushed
+ * 
+ * All of pdif's text output goes through an output_buffer, so writing to a file or a pipe costs one
+ * write per buffer rather than one flush per line. The buffer either writes to a std::ostream, or
+ * directly to a file descriptor with write/writev (bypassing iostreams entirely).
+ * 
+ * Text can be appended with operator<<, or rendered straight into buffer() followed by commit().
+ * The destructor flushes, but errors are only reported by an explicit flush().
+ * 
+ */
+class output_buffer {
+public:
+
+    /**
+     * @brief the default buffer size
+     * 
+     */
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+    /**
+     * @brief Construct an output buffer writing to a stream
+     * 
+     * @param os the output stream, must outlive the buffer
+     * @param capacity the size at which the buffer is written out
+     */
+    output_buffer(std::ostream& os, size_t capacity = DEFAULT_CAPACITY);
+    /**
+     * @brief Construct an output buffer writing directly to a file descriptor
+     * 
+     * @param fd the file descriptor, not closed by the buffer
+     * @param capacity the size at which the buffer is written out
+     */
+    output_buffer(int fd, size_t capacity = DEFAULT_CAPACITY);
+    ~output_buffer();
+
+    output_buffer(const output_buffer&) = delete;
+    output_buffer& operator=(const output_buffer&) = delete;
+
+    /**
+     * @brief the pending output, text appended to it is written on the next commit() or flush()
+     * 
+     * @return std::string& 
+     */
+    inline std::string& buffer() { return m_buffer; }
+    /**
+     * @brief write the buffer out if it has reached capacity
+     * 
+     */
+    inline void commit() {
+        if (m_buffer.size() >= m_capacity) {
+            flush();
+        }
+    }
+    /**
+     * @brief write everything buffered
+     * 
+     * @throws pdif_io_error if the output cannot be written
+     */
+    void flush();
+
+    /**
+     * @brief append text. Text larger than the buffer is written straight through without copying
+     * 
+     * @param s the text
+     */
+    void append(std::string_view s);
+
+    inline output_buffer& operator<<(std::string_view s) { append(s); return *this; }
+    inline output_buffer& operator<<(const char* s) { append(s); return *this; }
+    inline output_buffer& operator<<(const std::string& s) { append(s); return *this; }
+    inline output_buffer& operator<<(char c) { m_buffer.push_back(c); commit(); return *this; }
+
+    template<typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, bool>>>
+    inline output_buffer& operator<<(T value) {
+        char buf[24];
+        auto result = std::to_chars(buf, buf + sizeof(buf), value);
+        m_buffer.append(buf, result.ptr - buf);
+        commit();
+        return *this;
+    }
+
+private:
+
+    void write_out(std::string_view first, std::string_view second);
+
+private:
+
+    std::ostream* m_os = nullptr;
+    int m_fd = -1;
+    size_t m_capacity;
+    std::string m_buffer;
+};
+
+}
+
+#endif // __PDIF_OUTPUT_BUFFER_HPP__
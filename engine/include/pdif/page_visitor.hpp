@@ -0,0 +1,86 @@
+#ifndef __PDIF_PAGE_VISITOR_HPP__
+#define __PDIF_PAGE_VISITOR_HPP__
+
+#include <pdif/stream.hpp>
+#include <pdif/content_extractor.hpp>
+#include <pdif/pdf_content_stream_filter.hpp>
+
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFObjectHandle.hh>
+#include <qpdf/QPDFPageObjectHelper.hh>
+
+#include <cstdint>
+#include <string>
+
+namespace pdif {
+
+/**
+ * @brief Extracts everything diffed on a page in one traversal of the page
+ *
+ * A page's stream holds the elements of its content streams (see pdif::pdf_content_stream_filter), followed
+ * by one element per entry of its /Annots array, in order:
+ *  - form field widgets give a form_field_elem with the field's fully qualified name, type and value. The
+ *    name, type and value are inherited through the field tree from the widget, so the document's
+ *    /AcroForm is never walked. A field with several widgets on a page (e.g. radio buttons) is listed once
+ *  - Popup annotations are skipped, they only display their parent's contents
+ *  - any other annotation gives an annotation_elem with its subtype, rectangle, contents and the
+ *    structural_hash of its dictionary
+ *
+ * Images and forms shared between the pages visited by one visitor are only decoded once.
+ *
+ */
+class page_visitor {
+public:
+
+    /**
+     * @brief Construct a new page visitor
+     *
+     * @param g the granularity to extract text at
+     * @param allow_state_set_nochange allow state elements to be added even if the state has not changed. Default is true
+     * @param image_similarity fingerprint images and match them within this many bits, negative to disable. Default is -1
+     */
+    page_visitor(granularity g, bool allow_state_set_nochange = true, int image_similarity = -1);
+
+    /**
+     * @brief extract a page, appending its elements to a stream
+     *
+     * @param page the page
+     * @param out the stream to append to
+     */
+    void visit(QPDFPageObjectHelper& page, stream& out);
+
+    /**
+     * @brief a stable 64 bit hash of the structure of a PDF object
+     *
+     * Dictionaries, arrays, strings, names and stream data are hashed directly rather than unparsed. Each
+     * indirect object is hashed once per call and cycles are cut. The /P (page), /Parent (tree) and /Popup
+     * links are not followed, and the /AP appearance streams and /M modification date, which are rewritten
+     * whenever an annotation is saved, are skipped. Other references to a page, e.g. the destination of a
+     * link, hash as the page's index, so editing the target page does not change the link's hash.
+     *
+     * @param obj the object
+     * @return uint64_t the hash
+     */
+    static uint64_t structural_hash(QPDFObjectHandle obj);
+
+private:
+
+    void visit_annotations(QPDFObjectHandle page, stream& out);
+
+    static QPDFObjectHandle inherited(QPDFObjectHandle field, const std::string& key);
+    static std::string field_name(QPDFObjectHandle field);
+    static std::string field_value(QPDFObjectHandle value);
+
+private:
+
+    granularity m_granularity;
+    bool m_allow_state_set_nochange;
+    int m_image_similarity;
+
+    image_cache m_images;
+    form_cache m_forms;
+};
+
+}
+
+#endif // __PDIF_PAGE_VISITOR_HPP__
@@ -5,6 +5,9 @@
 #include <pdif/diff.hpp>
 #include <pdif/stream_differ_base.hpp>
 #include <pdif/content_extractor.hpp>
+#include <pdif/extraction_cache.hpp>
+#include <pdif/json_writer.hpp>
+#include <pdif/output_buffer.hpp>
 
 #include <qpdf/QPDF.hh>
 
@@ -25,8 +28,13 @@ public:
      * @param s the scope of the extractor (default: page)
      * @param write_console_colors flag to set whether to write console colors (default: true)
      * @param pageno the page number to extract STARTING FROM 0 (default: -1 for all)
+     * @param allow_state_set_nochange allow state elements to be added even if the state has not changed (default: true)
+     * @param image_similarity match images whose perceptual fingerprints differ by at most this many bits (default: -1 for exact matching only)
+     * @param extraction_cache_path an extraction cache to load the content from instead of parsing the PDF. It is only
+     * used if it exists and was written for the same file content and options, otherwise the PDF is parsed (default: none)
+     * @param threads the number of threads to parse the pages on, see extract_content_parallel (default: 1, 0 for the hardware concurrency)
      */
-    PDF(const std::string& path, granularity g = granularity::word, scope s = scope::page, bool write_console_colors = true, int pageno = -1, bool allow_state_set_nochange = true);
+    PDF(const std::string& path, granularity g = granularity::word, scope s = scope::page, bool write_console_colors = true, int pageno = -1, bool allow_state_set_nochange = true, int image_similarity = -1, std::optional<std::string> extraction_cache_path = std::nullopt, unsigned threads = 1);
 
     /**
      * @brief Get the granularity object
@@ -41,8 +49,19 @@ public:
      */
     inline scope get_scope() const { return m_pdf_scope; }
 
-    template<typename T, typename = std::enable_if_t<std::is_base_of_v<stream_differ_base, T>>>
-    diff compare(const PDF& other) const {
+    /**
+     * @brief compare this PDF against another PDF
+     * 
+     * @tparam T the stream differ to use
+     * @tparam Args extra constructor arguments for the stream differ
+     * @param other the PDF to compare against
+     * @param max_edit_distance the maximum number of inserts and deletes per stream before the stream is reported
+     * as replaced wholesale (default: -1 for unbounded). See stream_differ_base::bounded_diff
+     * @param args extra arguments passed to each stream differ after the two streams
+     * @return diff the differences between the two PDFs
+     */
+    template<typename T, typename... Args, typename = std::enable_if_t<std::is_base_of_v<stream_differ_base, T>>>
+    diff compare(const PDF& other, int max_edit_distance = -1, const Args&... args) const {
         pdif::diff d(m_write_console_colors);
 
         // compare the meta
@@ -53,18 +72,8 @@ public:
 
         // compare the streams
         for (int i = 0; i < std::max(m, n); i++) {
-            if (i < m && i < n) {
-                T differ(m_streams[i], other.m_streams[i]);
-                d.add_original_stream(m_streams[i]);
-                differ.diff(d);
-            } else if (i < m) {
-                d.add_original_stream(m_streams[i]);
-                T differ(m_streams[i], stream());
-                differ.diff(d);
-            } else if (i < n) {
-                T differ(stream(), other.m_streams[i]);
-                differ.diff(d);
-            }
+            stats::page_timer timer(true, m_pageno >= 0 ? m_pageno : i);
+            stream_differ_base::diff_page<T>(d, i < m ? &m_streams[i] : nullptr, i < n ? &other.m_streams[i] : nullptr, max_edit_distance, args...);
         }
         
         return d;
@@ -76,6 +85,12 @@ public:
      * @param t_out the output stream
      */
     void dump_meta(std::ostream&) const;
+    /**
+     * @brief Dump the meta data of the PDF to the output buffer
+     * 
+     * @param t_out the output buffer
+     */
+    void dump_meta(output_buffer& t_out) const;
     /**
      * @brief Dump the content of the PDF to the output stream
      * 
@@ -84,6 +99,20 @@ public:
      * 
      */
     void dump_content(std::ostream& t_out, std::optional<std::string> spacing = std::nullopt) const;
+    /**
+     * @brief Dump the content of the PDF to the output buffer
+     * 
+     * @param t_out the output buffer
+     * @param spacing the spacing to use (default: none)
+     * 
+     */
+    void dump_content(output_buffer& t_out, std::optional<std::string> spacing = std::nullopt) const;
+    /**
+     * @brief Dump the content of the PDF as one JSON record per element
+     * 
+     * @param writer the json writer
+     */
+    void dump_content(json_writer& writer) const;
 
     /**
      * @brief Flag to set whether to write console colors
@@ -102,15 +131,28 @@ public:
     /**
      * @brief Get the meta object
      * 
-     * @return pdif::stream_meta 
+     * @return const pdif::stream_meta& 
      */
-    pdif::stream_meta get_meta() const { return m_meta; }
+    const pdif::stream_meta& get_meta() const { return m_meta; }
     /**
      * @brief Get the streams object
      * 
-     * @return std::vector<stream> 
+     * @return const std::vector<stream>& 
      */
-    std::vector<stream> get_streams() const { return m_streams; }
+    const std::vector<stream>& get_streams() const { return m_streams; }
+
+    /**
+     * @brief check if the content was loaded from an extraction cache rather than parsed
+     * 
+     * @return true if an extraction cache was used
+     */
+    inline bool from_extraction_cache() const { return m_from_extraction_cache; }
+    /**
+     * @brief write the extracted content to an extraction cache
+     * 
+     * @param path the file to write (default: extraction_cache::default_path of the PDF)
+     */
+    void write_extraction_cache(std::optional<std::string> path = std::nullopt) const;
 
 private:
 
@@ -118,9 +160,9 @@ private:
      * @brief get a console color code (if enabled)
      * 
      * @param code the code
-     * @return std::string returned color code
+     * @return std::string_view returned color code
      */
-    std::string cc(util::CONSOLE_COLOR_CODE code) const;
+    std::string_view cc(util::CONSOLE_COLOR_CODE code) const;
 
 private:
 
@@ -133,6 +175,10 @@ private:
 
     bool m_write_console_colors;
     int m_pageno;
+
+    std::string m_path;
+    extraction_options m_extraction_options;
+    bool m_from_extraction_cache = false;
 };
 
 }
@@ -4,11 +4,68 @@
 #include <pdif/stream.hpp>
 #include <pdif/content_extractor.hpp>
 #include <pdif/agl_map.hpp>
+#include <pdif/text_segmenter.hpp>
+#include <pdif/stats.hpp>
 #include <qpdf/QPDF.hh>
 #include <qpdf/QPDFObjectHandle.hh>
 
+#include <array>
+#include <tuple>
+#include <unordered_map>
+
 namespace pdif {
 
+/**
+ * @brief A cache of extracted image elements shared between the pages of a document,
+ * so each image is fingerprinted (and each image object hashed) once
+ * 
+ */
+struct image_cache {
+    /**
+     * @brief XObject images keyed by PDF object id
+     * 
+     */
+    std::map<QPDFObjGen, rxobject_img_elem> by_object;
+    /**
+     * @brief inline images keyed by data hash and dimensions
+     * 
+     */
+    std::map<std::string, rxobject_img_elem> by_hash;
+};
+
+/**
+ * @brief The key of an extracted Form XObject: the extraction depends on the resources the form is drawn with
+ * (its own, or those of the page or form it inherits them from) and the graphics state it inherits
+ * 
+ */
+struct form_key {
+    /**
+     * @brief the form's PDF object id
+     * 
+     */
+    QPDFObjGen form;
+    /**
+     * @brief the PDF object id of the page or form whose resources the form uses
+     * 
+     */
+    QPDFObjGen resources;
+    /**
+     * @brief the font and colours the form inherits, as rendered without console colors
+     * 
+     */
+    std::string inherited_state;
+
+    bool operator<(const form_key& other) const {
+        return std::tie(form, resources, inherited_state) < std::tie(other.form, other.resources, other.inherited_state);
+    }
+};
+
+/**
+ * @brief A cache of extracted Form XObject content, shared between the pages of a document so a form used on
+ * every page (headers, footers, stamps) is tokenized once and spliced into each page's stream
+ * 
+ */
+using form_cache = std::map<form_key, stream>;
 
 /**
  * @brief A class to parse through a PDF content stream and abstract the PDF as a series of stream_elems
@@ -17,7 +74,7 @@ namespace pdif {
 class pdf_content_stream_filter : public QPDFObjectHandle::TokenFilter {
 public:
 
-    pdf_content_stream_filter(stream& s, granularity g, QPDFObjectHandle root) : m_stream(s), m_g(g), m_root(root) {}
+    pdf_content_stream_filter(stream& s, granularity g, QPDFObjectHandle root) : m_stream(s), m_g(g), m_root(root), m_resources_owner(root.getObjGen()), m_segmenter(g) {}
     ~pdf_content_stream_filter() override = default;
 
     /**
@@ -39,8 +96,36 @@ public:
      */
     void setStateSetNoChange(bool b) { m_allow_state_set_nochange = b; }
 
+    /**
+     * @brief Set the image cache to share extracted images between filters (nullptr to disable)
+     * 
+     * @param cache the cache, must outlive the filter
+     */
+    void setImageCache(image_cache* cache) { m_image_cache = cache; }
+
+    /**
+     * @brief Enable perceptual fingerprints on images and set the similarity threshold used to compare them
+     * 
+     * @param threshold the max hamming distance between matching fingerprints, negative to disable (default)
+     */
+    void setImageSimilarity(int threshold) { m_image_similarity = threshold; }
+
+    /**
+     * @brief Set the form cache to share extracted Form XObjects between filters (nullptr to disable)
+     * 
+     * @param cache the cache, must outlive the filter
+     */
+    void setFormCache(form_cache* cache) { m_form_cache = cache; }
+
 private:
 
+    struct inline_image_params {
+        int width = 0;
+        int height = 0;
+        int bits_per_component = 0;
+        bool filtered = false;
+    };
+
     // handlers
     /**
      * @brief Handel what happens when an operator is encountered
@@ -73,6 +158,54 @@ private:
      * 
      */
     void handleXObject();
+    /**
+     * @brief Handle an image XObject
+     * 
+     * @param xobject_obj the image stream
+     */
+    void handleImageXObject(QPDFObjectHandle xobject_obj);
+    /**
+     * @brief Handle a Form XObject, extracting (or reusing the cached) form content and splicing it into the stream
+     * 
+     * @param xobject_obj the form stream
+     */
+    void handleFormXObject(QPDFObjectHandle xobject_obj);
+    /**
+     * @brief Extract the content of a Form XObject into its own stream, starting from the current state
+     * 
+     * @param xobject_obj the form stream
+     * @param resources_owner the PDF object id of the page or form whose resources the form uses
+     * @return stream the extracted form content
+     */
+    stream extractForm(QPDFObjectHandle xobject_obj, QPDFObjGen resources_owner);
+    /**
+     * @brief Set a state element saved before a form was drawn, if it differs from the state the form left
+     * 
+     * @param saved the state element before the form
+     * @param current the state element the form left
+     */
+    template<typename T>
+    void restoreStateElem(const std::optional<util::ref<T>>& saved, const std::optional<util::ref<T>>& current);
+
+    /**
+     * @brief Handle the end of an inline image dictionary (ID operator), capturing the image parameters
+     * 
+     */
+    void handleInlineImageDict();
+    /**
+     * @brief Parse the tokens of an inline image dictionary into the image parameters. Values can be
+     * single tokens, arrays or dictionaries; only the keys of the parameters are read
+     * 
+     * @param tokens the tokens between BI and ID, without whitespace
+     * @return std::optional<inline_image_params> the parameters, or nullopt (with a warning) if the dictionary is malformed
+     */
+    static std::optional<inline_image_params> parseInlineImageDict(const std::vector<QPDFTokenizer::Token>& tokens);
+    /**
+     * @brief Handle the data of an inline image, hashing it in place in the token
+     * 
+     * @param token the inline image token
+     */
+    void handleInlineImage(QPDFTokenizer::Token const& token);
 
     /**
      * @brief Hash an image buffer
@@ -83,10 +216,28 @@ private:
     std::string imageToHash(const unsigned char* data, size_t size);
 
     /**
-     * @brief Flush the string buffer
+     * @brief Decode an image XObject and compute its perceptual fingerprint
+     * 
+     * @param image the image stream
+     * @param width the width of the image
+     * @param height the height of the image
+     * @return std::optional<uint64_t> the fingerprint, or nullopt if the image cannot be decoded to 8 bit samples
+     */
+    std::optional<uint64_t> imageToFingerprint(QPDFObjectHandle image, int width, int height);
+
+    /**
+     * @brief Flush the text pending in the segmenter as a text element
      * 
      */
     void flushStringBuffer();
+    /**
+     * @brief Get the text element of a letter. Letter elements are immutable, so each distinct letter
+     * is created once and shared by every occurrence
+     * 
+     * @param letter the grapheme cluster
+     * @return pdif::rstream_elem the text element
+     */
+    pdif::rstream_elem letterElem(std::string_view letter);
 
     /**
      * @brief parse the cmap into the current font
@@ -123,6 +274,11 @@ private:
     struct state {
         bool in_array = false;
 
+        // parameters of the inline image being read (between ID and EI)
+        std::optional<inline_image_params> inline_image;
+        // the inline image being read has a malformed dictionary and is skipped
+        bool skip_inline_image = false;
+
         // current state of the stream
         std::optional<pdif::rfont_elem> current_font;
         std::optional<pdif::rtext_color_elem> current_text_color;
@@ -132,15 +288,37 @@ private:
     stream& m_stream;
     granularity m_g;
     QPDFObjectHandle m_root;
-    std::string m_string_buffer;
+    // the page or form whose resources are used, see form_key
+    QPDFObjGen m_resources_owner;
+    text_segmenter m_segmenter;
+    // the decoded text of the current operator, reused between operators
+    std::string m_text;
+    // shared letter elements, indexed by byte for ASCII
+    std::array<pdif::rstream_elem, 128> m_ascii_letters;
+    std::unordered_map<std::string, pdif::rstream_elem> m_letters;
 
     state m_state;
 
     std::vector<arg_type> m_arg_stack;
 
+    // the tokens of the inline image dictionary being read (between BI and ID)
+    bool m_in_inline_dict = false;
+    std::vector<QPDFTokenizer::Token> m_inline_dict;
+
     bool m_allow_state_set_nochange = true;
 
+    image_cache* m_image_cache = nullptr;
+    int m_image_similarity = -1;
+
+    form_cache* m_form_cache = nullptr;
+    int m_form_depth = 0;
+    // the forms being extracted, outermost first, so a form that draws itself is skipped
+    std::vector<QPDFObjGen> m_form_stack;
+    // tokens lexed since the last handleEOF, added to the stats once per content stream
+    uint64_t m_tokens = 0;
+
     static constexpr double SPACE_THRESHOLD = -70;
+    static constexpr int MAX_FORM_DEPTH = 16;
 };
 
 };
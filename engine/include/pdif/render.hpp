@@ -0,0 +1,52 @@
+#ifndef __PDIF_RENDER_HPP__
+#define __PDIF_RENDER_HPP__
+
+#include <util/colormod.hpp>
+
+#include <string>
+#include <string_view>
+
+namespace pdif {
+
+/**
+ * @brief get the escape sequence of a console color code
+ * 
+ * The sequences used by pdif are rendered once and cached, so this does not allocate.
+ * 
+ * @param code the console color code
+ * @return std::string_view the escape sequence
+ */
+std::string_view console_color(util::CONSOLE_COLOR_CODE code);
+
+/**
+ * @brief append the escape sequence of a console color code to a buffer (if enabled)
+ * 
+ * @param buffer the buffer to append to
+ * @param code the console color code
+ * @param console_colors flag to set whether to write console colors
+ */
+inline void render_color(std::string& buffer, util::CONSOLE_COLOR_CODE code, bool console_colors) {
+    if (console_colors) {
+        buffer.append(console_color(code));
+    }
+}
+
+/**
+ * @brief append an integer to a buffer
+ * 
+ * @param buffer the buffer to append to
+ * @param value the integer
+ */
+void render_int(std::string& buffer, long long value);
+
+/**
+ * @brief append a float to a buffer, formatted as a default std::ostream would (%g, 6 significant digits)
+ * 
+ * @param buffer the buffer to append to
+ * @param value the float
+ */
+void render_float(std::string& buffer, float value);
+
+}
+
+#endif // __PDIF_RENDER_HPP__
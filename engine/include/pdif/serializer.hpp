@@ -0,0 +1,118 @@
+#ifndef __PDIF_SERIALIZER_HPP__
+#define __PDIF_SERIALIZER_HPP__
+
+#include <pdif/stream.hpp>
+#include <pdif/stream_meta.hpp>
+#include <pdif/edit_op.hpp>
+#include <pdif/meta_edit_op.hpp>
+#include <pdif/diff.hpp>
+#include <pdif/errors.hpp>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace pdif {
+
+/**
+ * @brief Binary serialisation of streams, metadata and diffs
+ * 
+ * All integers are written little endian with a fixed width and strings are length prefixed, so the
+ * output is the same on every platform. Readers throw pdif_invalid_format on truncated or corrupt input.
+ * Font to_unicode maps are an extraction detail and are not serialised.
+ * 
+ */
+class serializer {
+public:
+
+    /**
+     * @brief the version written into serialised diffs, bumped whenever the layout changes
+     * 
+     */
+    static constexpr uint32_t FORMAT_VERSION = 3;
+
+    /**
+     * @brief write a fixed width little endian value, or a u32 length prefixed string
+     * 
+     */
+    static void write_u8(std::ostream& os, uint8_t v);
+    static void write_u32(std::ostream& os, uint32_t v);
+    static void write_u64(std::ostream& os, uint64_t v);
+    static void write_i32(std::ostream& os, int32_t v);
+    static void write_f32(std::ostream& os, float v);
+    static void write_string(std::ostream& os, const std::string& v);
+
+    /**
+     * @brief read a value written by the matching write function
+     * 
+     */
+    static uint8_t read_u8(std::istream& is);
+    static uint32_t read_u32(std::istream& is);
+    static uint64_t read_u64(std::istream& is);
+    static int32_t read_i32(std::istream& is);
+    static float read_f32(std::istream& is);
+    static std::string read_string(std::istream& is);
+
+    /**
+     * @brief write a stream element
+     * 
+     * @param os the output stream
+     * @param elem the element
+     */
+    static void write_elem(std::ostream& os, const rstream_elem& elem);
+    /**
+     * @brief read a stream element written by write_elem
+     * 
+     * @param is the input stream
+     * @return rstream_elem the element
+     */
+    static rstream_elem read_elem(std::istream& is);
+
+    /**
+     * @brief write / read a stream as a u64 count followed by its elements
+     * 
+     */
+    static void write_stream(std::ostream& os, const stream& s);
+    static stream read_stream(std::istream& is);
+
+    /**
+     * @brief write / read metadata as a u64 count followed by key value string pairs
+     * 
+     */
+    static void write_meta(std::ostream& os, const stream_meta& meta);
+    static stream_meta read_meta(std::istream& is);
+
+    /**
+     * @brief write / read an edit op, inserts are followed by their element
+     * 
+     */
+    static void write_edit_op(std::ostream& os, const edit_op& op);
+    static edit_op read_edit_op(std::istream& is);
+
+    /**
+     * @brief write / read a meta edit op
+     * 
+     */
+    static void write_meta_edit_op(std::ostream& os, const meta_edit_op& op);
+    static meta_edit_op read_meta_edit_op(std::istream& is);
+
+    /**
+     * @brief write a diff: its original streams, edit script and meta edit script
+     * 
+     * @param os the output stream
+     * @param d the diff
+     */
+    static void write_diff(std::ostream& os, const diff& d);
+    /**
+     * @brief read a diff written by write_diff
+     * 
+     * @param is the input stream
+     * @param write_console_colors whether the returned diff writes console colors
+     * @return diff the diff
+     */
+    static diff read_diff(std::istream& is, bool write_console_colors = true);
+};
+
+}
+
+#endif // __PDIF_SERIALIZER_HPP__
@@ -0,0 +1,199 @@
+#ifndef __PDIF_SIMILARITY_INDEX_HPP__
+#define __PDIF_SIMILARITY_INDEX_HPP__
+
+#include <pdif/minhash.hpp>
+#include <pdif/stream.hpp>
+#include <pdif/errors.hpp>
+#include <pdif/logger.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace pdif {
+
+/**
+ * @brief An on-disk locality sensitive hashing index of document MinHash signatures
+ *
+ * Finds the documents of a corpus that a new document is most likely a revision of, without diffing it
+ * against each of them. Each document's signature (see pdif::minhash) is cut into BANDS bands of ROWS
+ * entries, and the document is filed under the hash of each band. Documents sharing at least one band
+ * hash with a query are its candidates; a pair with Jaccard similarity s shares a band with probability
+ * 1 - (1 - s^ROWS)^BANDS: over 99% for s >= 0.7, about 87% at 0.5 and under 1% for s <= 0.1. Candidates
+ * are ranked by their estimated similarity.
+ *
+ * The directory holds
+ *  - documents.bin: one fixed size record per document (its signature and where its path and pages are)
+ *  - paths.bin and pages.bin: the paths and page signatures of the documents
+ *  - buckets/XX.bin: (band hash, document) pairs sorted by band hash, sharded by the top byte of the hash
+ *  - buckets/XX.log: the pairs added since the shard was last sorted, at most MERGE_ENTRIES of them
+ *
+ * A query binary searches at most BANDS sorted shards and scans their short logs, then reads the records
+ * of its candidates, so its cost grows with the logarithm of the corpus rather than its size. Writers
+ * append to the logs and merge a full log into its shard by writing the sorted result to a temporary
+ * file that replaces the shard, before emptying the log. A document is visible once its record is in
+ * documents.bin. Writers hold an exclusive lock on
+ * index.meta while adding (on POSIX systems), so several processes may add at once, and a partial record
+ * left by a writer that did not finish is dropped by the next one. Any number of readers may query
+ * concurrently. Documents without any text are stored but never returned as candidates.
+ *
+ */
+class similarity_index {
+public:
+
+    /**
+     * @brief the number of bands a signature is cut into
+     *
+     */
+    static constexpr size_t BANDS = 32;
+    /**
+     * @brief the number of signature entries per band
+     *
+     */
+    static constexpr size_t ROWS = minhash::SIGNATURE_SIZE / BANDS;
+    /**
+     * @brief the number of bucket files
+     *
+     */
+    static constexpr size_t SHARDS = 256;
+    /**
+     * @brief a query page matches a candidate page at this estimated similarity or above
+     *
+     */
+    static constexpr double PAGE_MATCH_SIMILARITY = 0.5;
+    /**
+     * @brief the version written into the index, bumped whenever the layout changes
+     *
+     */
+    static constexpr uint32_t FORMAT_VERSION = 2;
+    /**
+     * @brief the number of entries a shard's log holds before it is merged into the sorted shard
+     *
+     */
+    static constexpr size_t MERGE_ENTRIES = 512;
+
+    /**
+     * @brief a document found by a query
+     *
+     */
+    struct candidate {
+        /**
+         * @brief the path the document was added under
+         *
+         */
+        std::string path;
+        /**
+         * @brief the estimated Jaccard similarity of the documents' word shingles (0-1)
+         *
+         */
+        double similarity;
+        /**
+         * @brief the number of query pages with a similar page in the document
+         *
+         */
+        size_t matched_pages;
+        /**
+         * @brief the number of pages of the document
+         *
+         */
+        size_t pages;
+    };
+
+    /**
+     * @brief Open an index, creating the directory and an empty index if needed
+     *
+     * @param directory the index directory
+     * @throws pdif_invalid_argment if the directory cannot be created
+     * @throws pdif_invalid_format if the directory holds an index of another version
+     */
+    similarity_index(const std::string& directory);
+
+    /**
+     * @brief add a document from its extracted pages
+     *
+     * @param path the path to report the document under
+     * @param pages the extracted pages
+     * @return size_t the id of the document
+     */
+    size_t add(const std::string& path, const std::vector<stream>& pages);
+    /**
+     * @brief extract a PDF (at word granularity) and add it under its absolute path
+     *
+     * @param pdf_path the path of the PDF
+     * @return size_t the id of the document
+     */
+    size_t add(const std::string& pdf_path);
+
+    /**
+     * @brief find the indexed documents most similar to a document
+     *
+     * Documents sharing no band with the query are not considered, so dissimilar documents (similarity
+     * under about 0.3) are usually not found at all.
+     *
+     * @param pages the extracted pages of the document
+     * @param k the maximum number of candidates (default: 10)
+     * @return std::vector<candidate> the candidates, most similar first
+     */
+    std::vector<candidate> query(const std::vector<stream>& pages, size_t k = 10) const;
+    /**
+     * @brief extract a PDF (at word granularity) and find the indexed documents most similar to it
+     *
+     * @param pdf_path the path of the PDF
+     * @param k the maximum number of candidates (default: 10)
+     * @return std::vector<candidate> the candidates, most similar first
+     */
+    std::vector<candidate> query(const std::string& pdf_path, size_t k = 10) const;
+
+    /**
+     * @brief the number of documents in the index
+     *
+     * @return size_t the number of documents
+     */
+    size_t size() const;
+
+    /**
+     * @brief the hash a document is filed under for one band of its signature
+     *
+     * @param sig the signature
+     * @param band the band index
+     * @return uint64_t the band hash
+     */
+    static uint64_t band_hash(const minhash::signature& sig, size_t band);
+
+private:
+
+    /**
+     * @brief a record of documents.bin
+     *
+     */
+    struct document {
+        uint64_t path_offset;
+        uint64_t page_offset;
+        uint32_t page_count;
+        minhash::signature sig;
+    };
+
+    static constexpr size_t DOCUMENT_SIZE = 8 + 8 + 4 + 4 * minhash::SIGNATURE_SIZE;
+    static constexpr size_t BUCKET_ENTRY_SIZE = 8 + 4;
+
+    static std::vector<stream> extract(const std::string& pdf_path);
+
+    std::filesystem::path shard_path(uint64_t hash) const;
+    static std::filesystem::path log_path(const std::filesystem::path& shard);
+    void merge_shard(const std::filesystem::path& shard) const;
+    std::ifstream open_read(const std::filesystem::path& path) const;
+    std::ofstream open_append(const std::filesystem::path& path) const;
+
+    static void write_signature(std::ostream& os, const minhash::signature& sig);
+    static minhash::signature read_signature(std::istream& is);
+    document read_document(std::istream& is, size_t id) const;
+
+private:
+
+    std::filesystem::path m_directory;
+};
+
+}
+
+#endif // __PDIF_SIMILARITY_INDEX_HPP__
@@ -0,0 +1,260 @@
+#ifndef __PDIF_STATS_HPP__
+#define __PDIF_STATS_HPP__
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string_view>
+
+namespace pdif {
+
+/**
+ * @brief Timers and counters of the work done by each stage of a compare
+ *
+ * Stats are collected per thread: a stats::collect guard makes a stats object the collector of the
+ * calling thread, and the engine's timers and counters add to the current collector, if any. Without a
+ * collector a probe costs one thread local load and a branch, and with one a counter is a plain add, so
+ * the probes stay enabled in production. Counters that are hit per token or per DP cell are accumulated
+ * locally and added once per content stream or diff.
+ *
+ * Work the engine hands to other threads (extract_content_parallel, compare_pipeline) is collected into
+ * one stats object per thread and merged into the caller's collector when the threads are done, so a
+ * stats object is only ever written by one thread at a time.
+ *
+ * Stage times are inclusive: the extract stage of a page includes the fonts and images decoded for it.
+ * QPDF reads objects lazily, so the parse stage only covers opening the file and reading the cross
+ * reference table, and the rest of the parsing is part of extract.
+ *
+ */
+class stats {
+public:
+
+    /**
+     * @brief a timed stage
+     *
+     * parse: opening a PDF
+     * extract: the traversal of a page, see page_visitor
+     * fonts: decoding a font's ToUnicode CMap or font file encoding
+     * images: hashing and fingerprinting an image
+     * diff: diffing a page, see stream_differ_base::diff_page
+     * render: writing the output
+     */
+    enum class stage {
+        parse,
+        extract,
+        fonts,
+        images,
+        diff,
+        render,
+    };
+    static constexpr size_t STAGE_COUNT = 6;
+
+    /**
+     * @brief a counted quantity
+     *
+     * tokens: content stream tokens lexed
+     * elements: stream elements produced
+     * cmaps: ToUnicode CMaps and font file encodings parsed
+     * bytes_hashed: image bytes hashed
+     * dp_cells: cells of the diff's dynamic programming evaluated (LCS cells, or diagonals of the O(ND) diffs)
+     * ops: edit ops emitted
+     */
+    enum class counter {
+        tokens,
+        elements,
+        cmaps,
+        bytes_hashed,
+        dp_cells,
+        ops,
+    };
+    static constexpr size_t COUNTER_COUNT = 6;
+
+    /**
+     * @brief the time spent on a page and the counters added while it was extracted or diffed
+     *
+     */
+    struct page {
+        uint64_t extract_ns = 0;
+        uint64_t diff_ns = 0;
+        std::array<uint64_t, COUNTER_COUNT> counters{};
+    };
+
+    /**
+     * @brief the collector of the calling thread
+     *
+     * @return stats* the collector, nullptr if stats are not collected
+     */
+    static inline stats* current() { return s_current; }
+
+    /**
+     * @brief add to a counter of the calling thread's collector, if any
+     *
+     * @param c the counter
+     * @param n the amount
+     */
+    static inline void add(counter c, uint64_t n) {
+        if (stats* s = s_current) {
+            s->m_counters[(size_t)c] += n;
+        }
+    }
+
+    /**
+     * @brief makes a stats object the collector of the calling thread for the guard's lifetime
+     *
+     */
+    class collect {
+    public:
+        /**
+         * @brief Construct a new collect guard
+         *
+         * @param s the collector, nullptr to stop collecting
+         */
+        explicit collect(stats* s) : m_previous(s_current) { s_current = s; }
+        ~collect() { s_current = m_previous; }
+
+        collect(const collect&) = delete;
+        collect& operator=(const collect&) = delete;
+
+    private:
+        stats* m_previous;
+    };
+
+    /**
+     * @brief adds the time until it is stopped or destroyed to a stage of the current collector
+     *
+     */
+    class timer {
+    public:
+        explicit timer(stage st) : m_stats(s_current), m_stage(st) {
+            if (m_stats != nullptr) {
+                m_start = std::chrono::steady_clock::now();
+            }
+        }
+        ~timer() { stop(); }
+
+        timer(const timer&) = delete;
+        timer& operator=(const timer&) = delete;
+
+        /**
+         * @brief stop the timer early
+         *
+         */
+        void stop() {
+            if (m_stats != nullptr) {
+                m_stats->m_stage_ns[(size_t)m_stage] += elapsed_ns(m_start);
+                m_stats->m_stage_calls[(size_t)m_stage]++;
+                m_stats = nullptr;
+            }
+        }
+
+    private:
+        stats* m_stats;
+        stage m_stage;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    /**
+     * @brief records the time and counters of extracting or diffing one page
+     *
+     */
+    class page_timer {
+    public:
+        /**
+         * @brief Construct a new page timer
+         *
+         * @param diff true to time the diff of the page, false for its extraction
+         * @param page the page index, STARTING FROM 0
+         */
+        page_timer(bool diff, size_t page) : m_stats(s_current), m_diff(diff), m_page(page) {
+            if (m_stats != nullptr) {
+                m_counters = m_stats->m_counters;
+                m_start = std::chrono::steady_clock::now();
+            }
+        }
+        ~page_timer();
+
+        page_timer(const page_timer&) = delete;
+        page_timer& operator=(const page_timer&) = delete;
+
+    private:
+        stats* m_stats;
+        bool m_diff;
+        size_t m_page;
+        std::array<uint64_t, COUNTER_COUNT> m_counters;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    /**
+     * @brief add the stats collected by another thread
+     *
+     * @param other the stats to add
+     */
+    void merge(const stats& other);
+
+    /**
+     * @brief get the time spent in a stage
+     *
+     * @param st the stage
+     * @return uint64_t the time in nanoseconds
+     */
+    inline uint64_t stage_ns(stage st) const { return m_stage_ns[(size_t)st]; }
+    /**
+     * @brief get the number of times a stage was timed
+     *
+     * @param st the stage
+     * @return uint64_t the number of timers stopped
+     */
+    inline uint64_t stage_calls(stage st) const { return m_stage_calls[(size_t)st]; }
+    /**
+     * @brief get a counter
+     *
+     * @param c the counter
+     * @return uint64_t the count
+     */
+    inline uint64_t count(counter c) const { return m_counters[(size_t)c]; }
+    /**
+     * @brief get the pages that were extracted or diffed
+     *
+     * @return const std::map<size_t, page>& the pages by index, STARTING FROM 0
+     */
+    inline const std::map<size_t, page>& pages() const { return m_pages; }
+
+    /**
+     * @brief the name of a stage, as printed
+     *
+     */
+    static std::string_view name(stage st);
+    /**
+     * @brief the name of a counter, as printed
+     *
+     */
+    static std::string_view name(counter c);
+
+    /**
+     * @brief print the stats as text, one stage or counter per line followed by one line per page
+     *
+     * @param os the output stream
+     */
+    void output(std::ostream& os) const;
+
+private:
+
+    static uint64_t elapsed_ns(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+
+    inline static thread_local stats* s_current = nullptr;
+
+    std::array<uint64_t, STAGE_COUNT> m_stage_ns{};
+    std::array<uint64_t, STAGE_COUNT> m_stage_calls{};
+    std::array<uint64_t, COUNTER_COUNT> m_counters{};
+    std::map<size_t, page> m_pages;
+};
+
+}
+
+#endif // __PDIF_STATS_HPP__
@@ -12,12 +12,22 @@
 #include <map>
 #include <functional>
 #include <optional>
+#include <span>
 
 namespace pdif {
 
 // edit_op forward declare
 class edit_op;
 
+/**
+ * @brief a non-owning view over the elements of a stream (or any contiguous run of elements)
+ * 
+ * A stream converts to a view implicitly. The view does not keep the elements alive, so the stream must
+ * outlive it and must not be modified while it is in use.
+ * 
+ */
+using stream_view = std::span<const rstream_elem>;
+
 /**
  * @brief a stream is a container for stream_elem objects
  * 
@@ -41,6 +51,14 @@ public:
      * 
      */
     stream(const stream&) = default;
+    /**
+     * @brief Construct a new stream object holding a copy of the viewed elements
+     * 
+     * Explicit, so a view is never silently copied where a const stream& is expected
+     * 
+     * @param view the elements
+     */
+    explicit stream(stream_view view) : elems(view.begin(), view.end()) {}
 
     /**
      * @brief index operator
@@ -109,6 +127,23 @@ public:
      */
     bool empty() const;
 
+    /**
+     * @brief get a view of the elements
+     * 
+     * @return stream_view the view
+     */
+    inline stream_view view() const { return elems; }
+    /**
+     * @brief iterator to the first element
+     * 
+     */
+    inline std::vector<rstream_elem>::const_iterator begin() const { return elems.begin(); }
+    /**
+     * @brief iterator past the last element
+     * 
+     */
+    inline std::vector<rstream_elem>::const_iterator end() const { return elems.end(); }
+
     /**
      * @brief create the stream
      * 
@@ -3,15 +3,28 @@
 
 #include <functional>
 #include <string>
+#include <type_traits>
 
 #include <pdif/stream.hpp>
 #include <pdif/stream_meta.hpp>
 #include <pdif/errors.hpp>
 #include <pdif/edit_op.hpp>
 #include <pdif/diff.hpp>
+#include <pdif/stats.hpp>
 
 namespace pdif {
 
+/**
+ * @brief macro to delete the constructors of a stream differ that would view a temporary stream. A differ only
+ * views its streams, so a temporary would be destroyed before the differ uses it. Extra constructor parameters
+ * (with their defaults) follow the type
+ * 
+ */
+#define DELETE_TEMPORARY_STREAMS(type, ...) \
+    type(pdif::stream&&, pdif::stream_view __VA_OPT__(,) __VA_ARGS__) = delete; \
+    type(pdif::stream_view, pdif::stream&& __VA_OPT__(,) __VA_ARGS__) = delete; \
+    type(pdif::stream&&, pdif::stream&& __VA_OPT__(,) __VA_ARGS__) = delete;
+
 /**
  * @brief a base class for stream differ
  * 
@@ -24,10 +37,15 @@ public:
     /**
      * @brief Construct a new stream differ base object
      * 
+     * The differ only views the streams, it does not copy them. Streams convert to views implicitly, so a
+     * differ can be constructed from two streams as before, but both must outlive the differ. Constructing
+     * a differ from a temporary stream does not compile, see DELETE_TEMPORARY_STREAMS.
+     * 
      * @param stream1 the first stream
      * @param stream2 the second stream
      */
-    stream_differ_base(const pdif::stream& stream1, const pdif::stream& stream2) : stream1(stream1), stream2(stream2) {}
+    stream_differ_base(pdif::stream_view stream1, pdif::stream_view stream2) : stream1(stream1), stream2(stream2) {}
+    DELETE_TEMPORARY_STREAMS(stream_differ_base)
 
     /**
      * @brief Destroy the stream differ base object
@@ -43,6 +61,38 @@ public:
      */
     virtual void diff(pdif::diff& t_diff) = 0;
 
+    /**
+     * @brief diff two streams, giving up once more than max_edit_distance inserts and deletes are needed
+     * 
+     * The bound is checked first, see within_edit_distance. Within the bound the streams are diffed by the
+     * differ's own diff(). Past the bound the whole of stream1 is replaced by stream2 without running it.
+     * 
+     * @param t_diff the diff to be modified
+     * @param max_edit_distance the maximum number of inserts and deletes, negative to call diff() unbounded
+     * @return true if the streams were within the bound (or unbounded), false if they were replaced wholesale
+     */
+    bool bounded_diff(pdif::diff& t_diff, int max_edit_distance);
+
+    /**
+     * @brief check if the streams are within an edit distance of each other
+     * 
+     * Runs a banded (Ukkonen / Myers O(ND)) search for the number of inserts and deletes, stopping once it
+     * passes the bound. It costs O((m + n) * max_edit_distance) time and O(max_edit_distance) memory.
+     * 
+     * @param max_edit_distance the maximum number of inserts and deletes
+     * @return true if the streams differ by at most max_edit_distance inserts and deletes
+     */
+    bool within_edit_distance(int max_edit_distance) const;
+
+    /**
+     * @brief the stream the edit script applies to
+     * 
+     * This is stream1 unless the differ re-splits it while diffing.
+     * 
+     * @return pdif::stream_view the original stream
+     */
+    virtual pdif::stream_view original_stream() const { return stream1; }
+
     /**
      * @brief do the meta diff between one stream to another
      * 
@@ -52,10 +102,53 @@ public:
      */
     static void meta_diff(pdif::diff& d, const pdif::stream_meta& meta1, const pdif::stream_meta& meta2);
 
+    /**
+     * @brief diff one page of two documents, as PDF::compare does for each page
+     * 
+     * When both pages exist the diff is bounded by max_edit_distance and the differ's original stream is
+     * added to the diff. A page that only exists in the first document is deleted (and added as the
+     * original stream), a page that only exists in the second is inserted.
+     * 
+     * @tparam T the stream differ to use
+     * @tparam Args extra constructor arguments for the stream differ
+     * @param d the diff to be modified
+     * @param page1 the page of the first document, nullptr if it has no such page
+     * @param page2 the page of the second document, nullptr if it has no such page
+     * @param max_edit_distance see bounded_diff
+     * @param args extra arguments passed to the stream differ after the two streams
+     */
+    template<typename T, typename... Args, typename = std::enable_if_t<std::is_base_of_v<stream_differ_base, T>>>
+    static void diff_page(pdif::diff& d, const pdif::stream* page1, const pdif::stream* page2, int max_edit_distance, const Args&... args) {
+        stats::timer timer(stats::stage::diff);
+        size_t ops = d.edit_op_size();
+
+        if (page1 != nullptr && page2 != nullptr) {
+            T differ(*page1, *page2, args...);
+            differ.bounded_diff(d, max_edit_distance);
+            d.add_original_stream(stream(differ.original_stream()));
+        } else if (page1 != nullptr) {
+            d.add_original_stream(*page1);
+            T differ(*page1, stream_view(), args...);
+            differ.diff(d);
+        } else if (page2 != nullptr) {
+            T differ(stream_view(), *page2, args...);
+            differ.diff(d);
+        }
+
+        stats::add(stats::counter::ops, d.edit_op_size() - ops);
+    }
+
 protected:
 
-    pdif::stream stream1;
-    pdif::stream stream2;
+    /**
+     * @brief replace the whole of stream1 with stream2
+     * 
+     * @param t_diff the diff to be modified
+     */
+    void replace_all(pdif::diff& t_diff) const;
+
+    pdif::stream_view stream1;
+    pdif::stream_view stream2;
 
 };
 
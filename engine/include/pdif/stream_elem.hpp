@@ -3,12 +3,16 @@
 
 #include <util/memory.hpp>
 #include <util/colormod.hpp>
+#include <array>
 #include <string>
 #include <sstream>
 #include <vector>
+#include <optional>
+#include <cstdint>
 
 #include <pdif/errors.hpp>
 #include <pdif/logger.hpp>
+#include <pdif/render.hpp>
 
 namespace pdif {
 
@@ -22,6 +26,8 @@ enum class stream_type {
     text_color_set = 2,
     stroke_color_set = 3,
     xobject_image = 4,
+    annotation = 5,
+    form_field = 6,
 };
 
 /**
@@ -48,6 +54,12 @@ inline std::ostream& operator<<(std::ostream& os, const stream_type& type) {
         case stream_type::xobject_image:
             os << "xobject_image";
             break;
+        case stream_type::annotation:
+            os << "annotation";
+            break;
+        case stream_type::form_field:
+            os << "form_field";
+            break;
     }
     return os;
 }
@@ -73,6 +85,10 @@ inline std::istream& operator>>(std::istream& is, stream_type& type) {
         type = stream_type::stroke_color_set;
     } else if (str == "xobject_image") {
             type = stream_type::xobject_image;
+    } else if (str == "annotation") {
+        type = stream_type::annotation;
+    } else if (str == "form_field") {
+        type = stream_type::form_field;
     } else {
         PDIF_LOG_ERROR("stream_type::operator>> - invalid stream_type");
         throw pdif::pdif_invalid_argment("stream_type::operator>> - invalid stream_type");
@@ -88,6 +104,8 @@ class font_elem;
 class text_color_elem;
 class stroke_color_elem;
 class xobject_img_elem;
+class annotation_elem;
+class form_field_elem;
 
 // typedefs
 using rstream_elem = util::ref<stream_elem>;
@@ -96,6 +114,8 @@ using rfont_elem = util::ref<font_elem>;
 using rtext_color_elem = util::ref<text_color_elem>;
 using rstroke_color_elem = util::ref<stroke_color_elem>;
 using rxobject_img_elem = util::ref<xobject_img_elem>;
+using rannotation_elem = util::ref<annotation_elem>;
+using rform_field_elem = util::ref<form_field_elem>;
 
 /**
  * @brief macro to create a static type function for a stream_elem subclass
@@ -138,7 +158,14 @@ public:
      * @return true if the stream_elems are equal
      * @return false if the stream_elems are not equal
      */
-    virtual bool compare(rstream_elem t_other) = 0;
+    virtual bool compare(const rstream_elem& t_other) = 0;
+    /**
+     * @brief hash the stream_elem. Elements that compare equal have equal hashes, so the hash
+     * can be used to bucket elements before calling compare
+     * 
+     * @return size_t the hash
+     */
+    virtual size_t hash() const = 0;
     /**
      * @brief returns the type of the stream_elem
      * 
@@ -151,7 +178,14 @@ public:
      * 
      * @return std::string the stringified stream_elem
      */
-    virtual std::string to_string(bool console_colors = true) const = 0;
+    std::string to_string(bool console_colors = true) const;
+    /**
+     * @brief append the stringified stream_elem to a buffer
+     * 
+     * @param buffer the buffer to append to
+     * @param console_colors flag to set whether to write console colors
+     */
+    virtual void render_to(std::string& buffer, bool console_colors = true) const = 0;
 
     /**
      * @brief 
@@ -188,18 +222,6 @@ public:
         return std::dynamic_pointer_cast<T>(shared_from_this());
     }
 
-protected:
-
-    static inline std::string cc(util::CONSOLE_COLOR_CODE t_code, bool t_write_console_colors) {
-        if (t_write_console_colors) {
-            std::stringstream ss;
-            ss << t_code;
-            return ss.str();
-        } else {
-            return "";
-        }
-    }
-
 private:
 
     stream_type m_type;
@@ -239,14 +261,22 @@ public:
      * @return true if the stream_elems are of the same type and have the same text
      * @return false otherwise
      */
-    virtual bool compare(rstream_elem t_other) override;
+    virtual bool compare(const rstream_elem& t_other) override;
 
     /**
-     * @brief return the stringified text_elem
+     * @brief implementation of stream_elem::hash
      * 
-     * @return std::string the stringified text_elem
+     * @return size_t the hash
      */
-    virtual std::string to_string(bool console_colors = true) const override;
+    virtual size_t hash() const override;
+
+    /**
+     * @brief append the stringified text_elem to a buffer
+     * 
+     * @param buffer the buffer to append to
+     * @param console_colors flag to set whether to write console colors
+     */
+    virtual void render_to(std::string& buffer, bool console_colors = true) const override;
 
 private:
 
@@ -296,14 +326,22 @@ public:
      * @return true if the types are the same and the font name and size are equal
      * @return false otherwise
      */
-    virtual bool compare(rstream_elem t_other) override;
+    virtual bool compare(const rstream_elem& t_other) override;
+
+    /**
+     * @brief implementation of stream_elem::hash
+     * 
+     * @return size_t the hash
+     */
+    virtual size_t hash() const override;
 
     /**
-     * @brief return the stringified font_elem
+     * @brief append the stringified font_elem to a buffer
      * 
-     * @return std::string the stringified font_elem
+     * @param buffer the buffer to append to
+     * @param console_colors flag to set whether to write console colors
      */
-    virtual std::string to_string(bool console_colors = true) const override;
+    virtual void render_to(std::string& buffer, bool console_colors = true) const override;
 
     /**
      * @brief Set the to unicode map
@@ -409,14 +447,22 @@ public:
      * @return true if the types are the same and the colors are equal
      * @return false otherwise
      */
-    virtual bool compare(rstream_elem t_other) override;
+    virtual bool compare(const rstream_elem& t_other) override;
+
+    /**
+     * @brief implementation of stream_elem::hash
+     * 
+     * @return size_t the hash
+     */
+    virtual size_t hash() const override;
 
     /**
-     * @brief return the stringified text_color_elem
+     * @brief append the stringified text_color_elem to a buffer
      * 
-     * @return std::string the stringified text_color_elem
+     * @param buffer the buffer to append to
+     * @param console_colors flag to set whether to write console colors
      */
-    virtual std::string to_string(bool console_colors = true) const override;
+    virtual void render_to(std::string& buffer, bool console_colors = true) const override;
 };
 
 /**
@@ -449,14 +495,22 @@ public:
      * @return true if the types are the same and the colors are equal
      * @return false otherwise
      */
-    virtual bool compare(rstream_elem t_other) override;
+    virtual bool compare(const rstream_elem& t_other) override;
+
+    /**
+     * @brief implementation of stream_elem::hash
+     * 
+     * @return size_t the hash
+     */
+    virtual size_t hash() const override;
 
     /**
-     * @brief return the stringified stroke_color_elem
+     * @brief append the stringified stroke_color_elem to a buffer
      * 
-     * @return std::string the stringified stroke_color_elem
+     * @param buffer the buffer to append to
+     * @param console_colors flag to set whether to write console colors
      */
-    virtual std::string to_string(bool console_colors = true) const override;
+    virtual void render_to(std::string& buffer, bool console_colors = true) const override;
 };
 
 /**
@@ -501,21 +555,80 @@ public:
      */
     inline int height() const { return m_height; }
 
+    /**
+     * @brief Set the perceptual fingerprint of the image (see pdif::image_fingerprint)
+     * 
+     * @param t_fingerprint the 64 bit dHash
+     */
+    inline void set_fingerprint(uint64_t t_fingerprint) { m_fingerprint = t_fingerprint; }
+    /**
+     * @brief check if the image has a perceptual fingerprint
+     * 
+     * @return true if a fingerprint has been set
+     * @return false otherwise
+     */
+    inline bool has_fingerprint() const { return m_fingerprint.has_value(); }
+    /**
+     * @brief get the perceptual fingerprint
+     * 
+     * @return uint64_t 
+     */
+    uint64_t fingerprint() const;
+
+    /**
+     * @brief Set the similarity threshold. When both images have a fingerprint and a threshold >= 0,
+     * images whose fingerprints share a bucket (see image_fingerprint::bucket) and differ by at most
+     * the threshold bits compare equal. This equality is not transitive: a can match b and b match c
+     * while a and c are too far apart.
+     * 
+     * @param t_threshold the max hamming distance, negative to disable (default)
+     */
+    inline void set_similarity_threshold(int t_threshold) { m_similarity_threshold = t_threshold; }
+    /**
+     * @brief get the similarity threshold
+     * 
+     * @return int the max hamming distance, negative if disabled
+     */
+    inline int similarity_threshold() const { return m_similarity_threshold; }
+    /**
+     * @brief check if the image is matched by similarity, i.e. it has a fingerprint and a threshold >= 0
+     * 
+     * @return true if the image is compared by fingerprint and hashed by its fingerprint's bucket
+     * @return false if it is only equal to an identical image
+     */
+    inline bool matches_similar() const { return m_similarity_threshold >= 0 && has_fingerprint(); }
+
     /**
      * @brief Compare this xobject_img_elem to another stream_elem
      * 
+     * Images are equal if both or neither match by similarity (see matches_similar) and either the hash
+     * and dimensions match, or both match by similarity and their fingerprints share a bucket and are
+     * within the threshold. An image that matches by similarity never equals one that does not, as the
+     * two hash differently
+     * 
      * @param t_other the other
      * @return true 
      * @return false 
      */
-    virtual bool compare(rstream_elem t_other) override;
+    virtual bool compare(const rstream_elem& t_other) override;
 
     /**
-     * @brief Convert this xobject_img_elem to a string
+     * @brief implementation of stream_elem::hash. Images that match by similarity hash only their
+     * fingerprint's bucket, as similar images can have different stream hashes and dimensions. The
+     * bucket is much coarser than the threshold: every image equal to this one shares its bucket, but
+     * so do many images that are not, which compare tells apart
      * 
-     * @return std::string
+     * @return size_t the hash
      */
-    virtual std::string to_string(bool console_colors = true) const override;
+    virtual size_t hash() const override;
+
+    /**
+     * @brief append this xobject_img_elem as a string to a buffer
+     * 
+     * @param buffer the buffer to append to
+     * @param console_colors flag to set whether to write console colors
+     */
+    virtual void render_to(std::string& buffer, bool console_colors = true) const override;
 
 private:
 
@@ -523,6 +636,164 @@ private:
     int m_width;
     int m_height;
 
+    std::optional<uint64_t> m_fingerprint;
+    int m_similarity_threshold = -1;
+
+};
+
+/**
+ * @brief A concrete subclass of stream_elem that represents a page annotation (other than a form field widget)
+ * 
+ */
+class annotation_elem : public stream_elem {
+public:
+
+    /**
+     * @brief A static type method for annotation_elem
+     * 
+     */
+    STATIC_TYPE(stream_type::annotation)
+
+    /**
+     * @brief Construct a new annotation elem object
+     * 
+     * @param t the private_tag to allow construction
+     * @param t_subtype the annotation subtype (e.g. Text, Highlight, Link), without the leading /
+     * @param t_rect the annotation rectangle (llx, lly, urx, ury)
+     * @param t_contents the text of the annotation
+     * @param t_dict_hash the structural hash of the annotation dictionary (see pdif::page_visitor)
+     */
+    annotation_elem(stream_elem::private_tag t, const std::string& t_subtype, const std::array<float, 4>& t_rect, const std::string& t_contents, uint64_t t_dict_hash);
+
+    /**
+     * @brief get the subtype
+     * 
+     * @return const std::string& 
+     */
+    inline const std::string& subtype() const { return m_subtype; }
+    /**
+     * @brief get the rectangle
+     * 
+     * @return const std::array<float, 4>& llx, lly, urx, ury
+     */
+    inline const std::array<float, 4>& rect() const { return m_rect; }
+    /**
+     * @brief get the text of the annotation
+     * 
+     * @return const std::string& 
+     */
+    inline const std::string& contents() const { return m_contents; }
+    /**
+     * @brief get the structural hash of the annotation dictionary, covering the entries not held above
+     * (colour, author, flags, actions...)
+     * 
+     * @return uint64_t 
+     */
+    inline uint64_t dict_hash() const { return m_dict_hash; }
+
+    /**
+     * @brief the implementation of stream_elem::compare
+     * 
+     * @param t_other the other stream_elem to compare to
+     * @return true if the types are the same and the subtype, rectangle, contents and dictionary hash are equal
+     * @return false otherwise
+     */
+    virtual bool compare(const rstream_elem& t_other) override;
+
+    /**
+     * @brief implementation of stream_elem::hash
+     * 
+     * @return size_t the hash
+     */
+    virtual size_t hash() const override;
+
+    /**
+     * @brief append this annotation_elem as a string to a buffer
+     * 
+     * @param buffer the buffer to append to
+     * @param console_colors flag to set whether to write console colors
+     */
+    virtual void render_to(std::string& buffer, bool console_colors = true) const override;
+
+private:
+
+    std::string m_subtype;
+    std::array<float, 4> m_rect;
+    std::string m_contents;
+    uint64_t m_dict_hash;
+};
+
+/**
+ * @brief A concrete subclass of stream_elem that represents the value of an interactive form field
+ * 
+ */
+class form_field_elem : public stream_elem {
+public:
+
+    /**
+     * @brief A static type method for form_field_elem
+     * 
+     */
+    STATIC_TYPE(stream_type::form_field)
+
+    /**
+     * @brief Construct a new form field elem object
+     * 
+     * @param t the private_tag to allow construction
+     * @param t_name the fully qualified field name
+     * @param t_field_type the field type (Tx, Btn, Ch or Sig), without the leading /
+     * @param t_value the field value
+     */
+    form_field_elem(stream_elem::private_tag t, const std::string& t_name, const std::string& t_field_type, const std::string& t_value);
+
+    /**
+     * @brief get the fully qualified field name
+     * 
+     * @return const std::string& 
+     */
+    inline const std::string& name() const { return m_name; }
+    /**
+     * @brief get the field type
+     * 
+     * @return const std::string& 
+     */
+    inline const std::string& field_type() const { return m_field_type; }
+    /**
+     * @brief get the field value
+     * 
+     * @return const std::string& 
+     */
+    inline const std::string& value() const { return m_value; }
+
+    /**
+     * @brief the implementation of stream_elem::compare
+     * 
+     * @param t_other the other stream_elem to compare to
+     * @return true if the types are the same and the name, field type and value are equal
+     * @return false otherwise
+     */
+    virtual bool compare(const rstream_elem& t_other) override;
+
+    /**
+     * @brief implementation of stream_elem::hash
+     * 
+     * @return size_t the hash
+     */
+    virtual size_t hash() const override;
+
+    /**
+     * @brief append this form_field_elem as a string to a buffer
+     * 
+     * @param buffer the buffer to append to
+     * @param console_colors flag to set whether to write console colors
+     */
+    virtual void render_to(std::string& buffer, bool console_colors = true) const override;
+
+private:
+
+    std::string m_name;
+    std::string m_field_type;
+    std::string m_value;
 };
 
 }
@@ -67,9 +67,9 @@ public:
     /**
      * @brief Get the metadata object
      * 
-     * @return std::map<std::string, std::string> 
+     * @return const std::map<std::string, std::string>& the metadata, sorted by key
      */
-    inline std::map<std::string, std::string> get_metadata() const { return m_metadata; }
+    inline const std::map<std::string, std::string>& get_metadata() const { return m_metadata; }
 
     /**
      * @brief Set the meta callback object
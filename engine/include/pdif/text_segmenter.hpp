@@ -0,0 +1,116 @@
+#ifndef __PDIF_TEXT_SEGMENTER_HPP__
+#define __PDIF_TEXT_SEGMENTER_HPP__
+
+#include <pdif/content_extractor.hpp>
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace pdif {
+
+/**
+ * @brief Splits the text of string-showing operators into the text elements of a granularity
+ *
+ * Text is pushed one operator at a time and each segment is passed to a callback as a view, so no
+ * intermediate strings are built. Consecutive operators are separated by a single space.
+ *
+ * letter: every extended grapheme cluster (a user-perceived character, e.g. a letter and its combining accents)
+ * except ' ' is a segment. Bytes that are not valid UTF-8 are segments on their own
+ * word: maximal runs of non-whitespace are segments, an operator always ends a word
+ * sentence: text up to and including a '.' is a segment, with one leading space removed. The text after
+ * the last '.' is kept pending and carried into the next operator without being scanned again
+ *
+ * The whitespace and non-ASCII scans are vectorised where SSE2 is available, and runs of ASCII are split
+ * into letters without decoding.
+ */
+class text_segmenter {
+public:
+
+    /**
+     * @brief the callback a segment is passed to. The view is only valid for the duration of the call
+     *
+     */
+    using segment_callback = std::function<void(std::string_view)>;
+
+    /**
+     * @brief Construct a new text segmenter
+     *
+     * @param g the granularity to segment at
+     */
+    text_segmenter(granularity g) : m_g(g) {}
+
+    /**
+     * @brief segment the text of one operator
+     *
+     * @param text the text
+     * @param emit the callback each completed segment is passed to
+     */
+    void push(std::string_view text, const segment_callback& emit);
+    /**
+     * @brief pass the pending text (if any) to the callback as a segment
+     *
+     * @param emit the callback
+     */
+    void flush(const segment_callback& emit);
+
+    /**
+     * @brief get the text carried over to the next operator
+     *
+     * @return std::string_view the pending text
+     */
+    inline std::string_view pending() const { return m_pending; }
+    /**
+     * @brief check if there is no pending text
+     *
+     * @return true if nothing is pending
+     */
+    inline bool empty() const { return m_pending.empty(); }
+
+    /**
+     * @brief find the first whitespace character (as std::isspace in the C locale) at or after pos
+     *
+     * @param s the text
+     * @param pos the position to start at
+     * @return size_t the position, or std::string_view::npos
+     */
+    static size_t find_space(std::string_view s, size_t pos);
+    /**
+     * @brief find the first non-whitespace character at or after pos
+     *
+     * @param s the text
+     * @param pos the position to start at
+     * @return size_t the position, or std::string_view::npos
+     */
+    static size_t find_non_space(std::string_view s, size_t pos);
+    /**
+     * @brief find the end of the extended grapheme cluster starting at pos
+     * 
+     * @param text the UTF-8 text
+     * @param pos the start of the cluster
+     * @return size_t the position one past the end of the cluster
+     */
+    static size_t grapheme_end(std::string_view text, size_t pos);
+
+private:
+
+    void push_letters(std::string_view text, const segment_callback& emit);
+    void push_words(std::string_view text, const segment_callback& emit);
+    void push_sentences(std::string_view text, const segment_callback& emit);
+
+    /**
+     * @brief emit the sentences of buffer from start, scanning for full stops from scan
+     *
+     * @return size_t the start of the unterminated remainder
+     */
+    static size_t emit_sentences(std::string_view buffer, size_t start, size_t scan, const segment_callback& emit);
+
+private:
+
+    granularity m_g;
+    std::string m_pending;
+};
+
+}
+
+#endif // __PDIF_TEXT_SEGMENTER_HPP__
@@ -0,0 +1,91 @@
+#ifndef __PDIF_XMP_PARSER_HPP__
+#define __PDIF_XMP_PARSER_HPP__
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <pdif/errors.hpp>
+#include <pdif/logger.hpp>
+
+namespace pdif {
+
+/**
+ * @brief A streaming parser flattening an XMP packet into key value pairs
+ *
+ * The packet is scanned once, without building a tree; only the properties currently open are kept.
+ * Each simple property is reported under its path of qualified names, as written in the packet:
+ *  - <dc:format>application/pdf</dc:format> and dc:format="application/pdf" give "dc:format"
+ *  - rdf:Seq and rdf:Bag items are numbered from 1: "dc:creator[1]", "dc:creator[2]"
+ *  - rdf:Alt items are keyed by their xml:lang when given: "dc:title[x-default]"
+ *  - struct fields are joined with '/': "xmpMM:History[1]/stEvt:action"
+ *  - qualifiers (attributes of property elements) likewise: "xmpMM:DerivedFrom/stRef:documentID"
+ *
+ * rdf:resource values are reported as the value of their property. The x:xmpmeta, rdf:RDF and
+ * rdf:Description elements do not appear in keys. Entities, character references and CDATA sections
+ * are decoded, comments, processing instructions (e.g. the xpacket wrapper) and DOCTYPEs are skipped.
+ * Namespaces are not resolved, so a packet binding a namespace to an unusual prefix gives other keys.
+ */
+class xmp_parser {
+public:
+
+    /**
+     * @brief the callback receiving each flattened property
+     *
+     */
+    using property_callback_f = std::function<void(const std::string& key, const std::string& value)>;
+
+    /**
+     * @brief parse an XMP packet
+     *
+     * @param packet the packet (e.g. the data of the document's /Metadata stream)
+     * @param callback called with each property, in document order
+     * @throws pdif_invalid_format if the packet is not well formed
+     */
+    static void parse(std::string_view packet, const property_callback_f& callback);
+
+private:
+
+    /**
+     * @brief an open element
+     *
+     */
+    struct frame {
+        std::string name;
+        std::string path;
+        std::string text;
+        bool container = false;
+        bool has_children = false;
+        size_t items = 0;
+    };
+
+    xmp_parser(std::string_view packet, const property_callback_f& callback);
+
+    void run();
+
+    void skip_until(std::string_view terminator);
+    void parse_start_tag();
+    void parse_end_tag();
+    void parse_text();
+    void close_element();
+
+    std::string parse_name();
+    void skip_space();
+    [[noreturn]] void fail(const std::string& what) const;
+
+    static bool is_container(std::string_view name);
+    static std::string join(const std::string& path, std::string_view name);
+    static void decode(std::string_view raw, std::string& out);
+
+private:
+
+    std::string_view m_packet;
+    size_t m_pos = 0;
+    const property_callback_f& m_callback;
+    std::vector<frame> m_stack;
+};
+
+} // namespace pdif
+
+#endif // __PDIF_XMP_PARSER_HPP__
@@ -2,8 +2,8 @@
 
 namespace pdif {
 
-std::map<std::string, std::string> pdif::agl_map::m_agl_map;
 std::set<std::string> pdif::agl_map::m_warnings;
+std::mutex pdif::agl_map::m_warnings_mutex;
 
 std::string agl_map::normalizeUTF8(std::string hexInput, int add) {
     std::string decoded;
@@ -32,25 +32,38 @@ std::string agl_map::normalizeUTF8(std::string hexInput, int add) {
     return decoded;
 }
 
+const std::map<std::string, std::string>& agl_map::agl() {
+    // function-local static: initialised exactly once even when several
+    // extraction threads decode their first glyph at the same time
+    static const std::map<std::string, std::string> map = [] {
+        std::map<std::string, std::string> m;
+        load_agl_map("/agl_map.txt", m);
+        load_agl_map("/agl_latex_extention.txt", m);
+        return m;
+    }();
+    return map;
+}
+
 std::string agl_map::glyph_to_utf8(const std::string& glyph) {
-    if (m_agl_map.empty()) {
-        load_agl_map("/agl_map.txt");
-        load_agl_map("/agl_latex_extention.txt");
+    const auto& map = agl();
+    auto it = map.find(glyph);
+    if (it != map.end()) {
+        return it->second;
     }
 
-    if (m_agl_map.find(glyph) != m_agl_map.end()) {
-        return m_agl_map[glyph];
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(m_warnings_mutex);
+        first = m_warnings.insert(glyph).second;
     }
-
-    if (m_warnings.find(glyph) == m_warnings.end()) {
-        m_warnings.insert(glyph);
+    if (first) {
         PDIF_LOG_WARN("Glyph {} not found in AGL map", glyph);
     }
 
     return glyph;
 }
 
-void agl_map::load_agl_map(const std::string& file_path) {
+void agl_map::load_agl_map(const std::string& file_path, std::map<std::string, std::string>& map) {
     std::ifstream file(std::string(PDIF_RES_PATH) + file_path);
 
     if (!file.is_open()) {
@@ -79,7 +92,7 @@ void agl_map::load_agl_map(const std::string& file_path) {
         std::string value = line.substr(pos + 1);
         std::string utf8_value = normalizeUTF8(value);
 
-        m_agl_map[key] = utf8_value;
+        map[key] = utf8_value;
     }
 
     file.close();
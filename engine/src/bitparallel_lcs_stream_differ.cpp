@@ -0,0 +1,211 @@
+#include <pdif/bitparallel_lcs_stream_differ.hpp>
+#include <pdif/histogram_stream_differ.hpp>
+#include <pdif/logger.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+
+// the AVX2 kernel is compiled for its own function only and picked at run time, so the library runs on any x86-64
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PDIF_BITPARALLEL_AVX2
+#include <immintrin.h>
+#endif
+
+namespace pdif {
+
+int bitparallel_lcs_stream_differ::intern() {
+    int m = stream1.size();
+    int n = stream2.size();
+
+    // hash -> symbols with that hash, symbol -> first index in stream1
+    std::unordered_map<size_t, std::vector<int>> buckets;
+    std::vector<int> representative;
+
+    m_symbols1.resize(m);
+    for (int i = 0; i < m; i++) {
+        std::vector<int>& bucket = buckets[stream1[i]->hash()];
+
+        int symbol = -1;
+        for (int s : bucket) {
+            if (stream1[representative[s]]->compare(stream1[i])) {
+                symbol = s;
+                break;
+            }
+        }
+
+        if (symbol < 0) {
+            symbol = representative.size();
+            representative.push_back(i);
+            bucket.push_back(symbol);
+        }
+
+        m_symbols1[i] = symbol;
+    }
+
+    m_symbols2.resize(n);
+    for (int j = 0; j < n; j++) {
+        m_symbols2[j] = -1;
+
+        auto it = buckets.find(stream2[j]->hash());
+        if (it == buckets.end()) {
+            continue;
+        }
+
+        for (int s : it->second) {
+            if (stream1[representative[s]]->compare(stream2[j])) {
+                m_symbols2[j] = s;
+                break;
+            }
+        }
+    }
+
+    return representative.size();
+}
+
+namespace {
+
+// advance words [w, words) of a row given the carry into word w
+void advance_words(uint64_t* row, const uint64_t* peq, size_t w, size_t words, uint64_t carry) {
+    for (; w < words; w++) {
+        uint64_t v = row[w];
+        uint64_t u = v & peq[w];
+
+        uint64_t t = v + carry;
+        uint64_t c1 = t < v;
+        uint64_t s = t + u;
+        uint64_t c2 = s < t;
+        carry = c1 | c2;
+
+        row[w] = s | (v & ~peq[w]);
+    }
+}
+
+#if defined(PDIF_BITPARALLEL_AVX2)
+__attribute__((target("avx2"))) void advance_row_avx2(uint64_t* row, const uint64_t* peq, size_t words) {
+    size_t w = 0;
+    uint64_t carry = 0;
+
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i ones = _mm256_set1_epi64x(-1);
+
+    for (; w + 4 <= words; w += 4) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + w));
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(peq + w));
+        __m256i sum = _mm256_add_epi64(v, _mm256_and_si256(v, p));
+
+        // lanes that overflowed (sum < v, unsigned) generate a carry, all-ones lanes propagate one
+        int generate = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_xor_si256(v, sign), _mm256_xor_si256(sum, sign))));
+        int propagate = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(sum, ones)));
+
+        int carries = 0;
+        for (int k = 0; k < 4; k++) {
+            carries |= (int)carry << k;
+            carry = ((generate >> k) & 1) | (((propagate >> k) & 1) & carry);
+        }
+
+        sum = _mm256_add_epi64(sum, _mm256_set_epi64x((carries >> 3) & 1, (carries >> 2) & 1, (carries >> 1) & 1, carries & 1));
+        v = _mm256_or_si256(sum, _mm256_andnot_si256(p, v));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + w), v);
+    }
+
+    advance_words(row, peq, w, words, carry);
+}
+
+bool has_avx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+}
+
+void bitparallel_lcs_stream_differ::advance_row(uint64_t* row, const uint64_t* peq, size_t words) {
+#if defined(PDIF_BITPARALLEL_AVX2)
+    if (words >= 4 && has_avx2()) {
+        advance_row_avx2(row, peq, words);
+        return;
+    }
+#endif
+
+    advance_words(row, peq, 0, words, 0);
+}
+
+void bitparallel_lcs_stream_differ::diff(pdif::diff& diff) {
+    // store the diff start pointer
+    int size = diff.edit_op_size();
+
+    int m = stream1.size();
+    int n = stream2.size();
+
+    int sigma = intern();
+    size_t words = (m + 63) / 64;
+
+    if ((size_t)sigma * words + (size_t)(n + 1) * words > MAX_WORDS) {
+        PDIF_LOG_DEBUG("bitparallel_lcs_stream_differ::diff - {} symbols over {}x{} elements exceeds the memory budget, using histogram diff", sigma, m, n);
+        histogram_stream_differ fallback(stream1, stream2);
+        fallback.diff(diff);
+        return;
+    }
+
+    // Step 1: the match mask of each symbol over stream1
+    std::vector<uint64_t> peq((size_t)sigma * words, 0);
+    for (int i = 0; i < m; i++) {
+        peq[(size_t)m_symbols1[i] * words + i / 64] |= uint64_t(1) << (i % 64);
+    }
+
+    // Step 2: one bit vector per row, bit i of row j is clear when L[j][i+1] = L[j][i] + 1
+    std::vector<uint64_t> rows((size_t)(n + 1) * words, ~uint64_t(0));
+    uint64_t cells = 0;
+    for (int j = 0; j < n; j++) {
+        uint64_t* row = rows.data() + (size_t)(j + 1) * words;
+        std::copy(row - words, row, row);
+
+        if (m_symbols2[j] >= 0) {
+            advance_row(row, peq.data() + (size_t)m_symbols2[j] * words, words);
+            cells += m;
+        }
+    }
+    stats::add(stats::counter::dp_cells, cells);
+
+    auto bit = [&](int j, int i) {
+        return (rows[(size_t)j * words + i / 64] >> (i % 64)) & 1;
+    };
+
+    // Step 3: backtrace through the stored rows
+    int i = m;
+    int j = n;
+
+    while (i > 0 && j > 0) {
+        if (bit(j, i - 1)) {
+            // L[j][i] == L[j][i-1]
+            diff.add_edit_op(edit_op(edit_op_type::DELETE));
+            --i;
+        } else {
+            --j;
+            if (!bit(j, i - 1)) {
+                // L[j][i] == L[j+1][i], stream2[j] is not part of the LCS
+                diff.add_edit_op(edit_op(edit_op_type::INSERT, stream2[j]));
+            } else {
+                diff.add_edit_op(edit_op(edit_op_type::EQ));
+                --i;
+            }
+        }
+    }
+
+    while (i > 0) {
+        diff.add_edit_op(edit_op(edit_op_type::DELETE));
+        --i;
+    }
+
+    while (j > 0) {
+        diff.add_edit_op(edit_op(edit_op_type::INSERT, stream2[j-1]));
+        --j;
+    }
+
+    auto start = std::next(diff.begin(), size);
+    auto end = diff.end();
+    // reverse the diff from where it started
+    diff.reverse_edit_ops(start, end);
+}
+
+}
@@ -0,0 +1,176 @@
+#include <pdif/chunked_stream_differ.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace pdif {
+
+namespace {
+
+// splitmix64 finaliser, spreads the element hashes over all 64 bits
+inline uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+}
+
+std::vector<content_chunker::chunk> content_chunker::split(stream_view s) {
+    std::vector<chunk> chunks;
+
+    uint64_t rolling = 0;
+    uint64_t hash = 0;
+    size_t start = 0;
+
+    for (size_t i = 0; i < s.size(); i++) {
+        uint64_t h = mix(s[i]->hash());
+
+        // gear hash: each element shifts the older ones up, so bit k depends on the last k + 1 elements
+        rolling = (rolling << 1) + h;
+        hash = mix(hash ^ h);
+
+        size_t size = i + 1 - start;
+        if ((size >= MIN_CHUNK && (rolling & CUT_MASK) == 0) || size >= MAX_CHUNK) {
+            chunks.push_back({start, size, hash});
+            start = i + 1;
+            hash = 0;
+        }
+    }
+
+    if (start < s.size()) {
+        chunks.push_back({start, s.size() - start, hash});
+    }
+
+    return chunks;
+}
+
+bool content_chunker::chunks_equal(stream_view a, const chunk& ca, stream_view b, const chunk& cb) {
+    if (ca.hash != cb.hash || ca.size != cb.size) {
+        return false;
+    }
+
+    for (size_t k = 0; k < ca.size; k++) {
+        if (!a[ca.start + k]->compare(b[cb.start + k])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<content_chunker::aligned_range> content_chunker::align(stream_view a, stream_view b) {
+    std::vector<chunk> ca = split(a);
+    std::vector<chunk> cb = split(b);
+
+    // Step 1: the chunks that occur exactly once in both streams
+    struct occurrence {
+        int count_a = 0;
+        int count_b = 0;
+        size_t index_b = 0;
+    };
+
+    std::unordered_map<uint64_t, occurrence> occurrences;
+    for (const chunk& c : ca) {
+        occurrences[c.hash].count_a++;
+    }
+    for (size_t j = 0; j < cb.size(); j++) {
+        auto it = occurrences.find(cb[j].hash);
+        if (it != occurrences.end()) {
+            it->second.count_b++;
+            it->second.index_b = j;
+        }
+    }
+
+    std::vector<std::pair<size_t, size_t>> candidates;
+    for (size_t i = 0; i < ca.size(); i++) {
+        const occurrence& o = occurrences[ca[i].hash];
+        if (o.count_a == 1 && o.count_b == 1) {
+            candidates.push_back({i, o.index_b});
+        }
+    }
+
+    // Step 2: the longest run of candidates in order in both streams (patience sorting)
+    std::vector<size_t> tails;
+    std::vector<long> prev(candidates.size(), -1);
+    for (size_t k = 0; k < candidates.size(); k++) {
+        auto it = std::lower_bound(tails.begin(), tails.end(), candidates[k].second, [&](size_t t, size_t value) {
+            return candidates[t].second < value;
+        });
+
+        if (it != tails.begin()) {
+            prev[k] = *(it - 1);
+        }
+
+        if (it == tails.end()) {
+            tails.push_back(k);
+        } else {
+            *it = k;
+        }
+    }
+
+    std::vector<std::pair<size_t, size_t>> anchors;
+    for (long k = tails.empty() ? -1 : (long)tails.back(); k >= 0; k = prev[k]) {
+        if (chunks_equal(a, ca[candidates[k].first], b, cb[candidates[k].second])) {
+            anchors.push_back(candidates[k]);
+        }
+    }
+    std::reverse(anchors.begin(), anchors.end());
+    anchors.push_back({ca.size(), cb.size()});
+
+    // Step 3: extend each anchor to the equal chunks around it
+    std::vector<std::pair<size_t, size_t>> matches;
+    size_t next_a = 0;
+    size_t next_b = 0;
+    for (auto [x, y] : anchors) {
+        while (next_a < x && next_b < y && chunks_equal(a, ca[next_a], b, cb[next_b])) {
+            matches.push_back({next_a++, next_b++});
+        }
+
+        size_t back = matches.size();
+        size_t i = x;
+        size_t j = y;
+        while (i > next_a && j > next_b && chunks_equal(a, ca[i - 1], b, cb[j - 1])) {
+            matches.push_back({--i, --j});
+        }
+        std::reverse(matches.begin() + back, matches.end());
+
+        if (x < ca.size()) {
+            matches.push_back({x, y});
+        }
+
+        next_a = x + 1;
+        next_b = y + 1;
+    }
+
+    // Step 4: turn the matched chunks into element ranges, with the gaps between them unmatched
+    std::vector<aligned_range> ranges;
+    size_t pos_a = 0;
+    size_t pos_b = 0;
+    for (auto [i, j] : matches) {
+        if (pos_a < ca[i].start || pos_b < cb[j].start) {
+            ranges.push_back({pos_a, ca[i].start, pos_b, cb[j].start, false});
+        }
+
+        if (!ranges.empty() && ranges.back().equal && ranges.back().a1 == ca[i].start && ranges.back().b1 == cb[j].start) {
+            ranges.back().a1 += ca[i].size;
+            ranges.back().b1 += cb[j].size;
+        } else {
+            ranges.push_back({ca[i].start, ca[i].start + ca[i].size, cb[j].start, cb[j].start + cb[j].size, true});
+        }
+
+        pos_a = ca[i].start + ca[i].size;
+        pos_b = cb[j].start + cb[j].size;
+    }
+
+    if (pos_a < a.size() || pos_b < b.size()) {
+        ranges.push_back({pos_a, a.size(), pos_b, b.size(), false});
+    }
+
+    return ranges;
+}
+
+}
@@ -0,0 +1,227 @@
+#include <pdif/compare_cache.hpp>
+#include <pdif/serializer.hpp>
+#include <pdif/extraction_cache.hpp>
+#include <pdif/pdif_engine_config.hpp>
+#include <pdif/hash_util.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <vector>
+
+namespace pdif {
+
+static std::string granularity_name(granularity g) {
+    switch (g) {
+        case granularity::letter:
+            return "letter";
+        case granularity::word:
+            return "word";
+        case granularity::sentence:
+            return "sentence";
+    }
+    return "";
+}
+
+std::string compare_options::to_string() const {
+    std::stringstream ss;
+    ss << "granularity=" << granularity_name(g)
+       << ";scope=" << (s == scope::page ? "page" : "document")
+       << ";page=" << pageno
+       << ";state_set_nochange=" << (allow_state_set_nochange ? 1 : 0)
+       << ";image_similarity=" << image_similarity
+       << ";max_edit_distance=" << max_edit_distance
+       << ";differ=" << differ;
+    return ss.str();
+}
+
+compare_cache::compare_cache(const std::string& directory, uintmax_t max_bytes) : m_directory(directory), m_max_bytes(max_bytes) {
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory, ec);
+
+    if (!std::filesystem::is_directory(m_directory, ec)) {
+        PDIF_LOG_ERROR("compare_cache::compare_cache - cannot create cache directory {}", directory);
+        throw pdif::pdif_invalid_argment("compare_cache::compare_cache - cannot create cache directory " + directory);
+    }
+}
+
+std::string compare_cache::file_hash(const std::string& path) {
+    return to_hex(sha1::of_file(path));
+}
+
+std::string compare_cache::make_key(const std::string& path1, const std::string& path2, const compare_options& options) {
+    std::string material = std::string(PDIF_ENGINE_VERSION) + "." + std::to_string(RESULT_VERSION) + "." + std::to_string(serializer::FORMAT_VERSION) + "." + std::to_string(extraction_cache::FORMAT_VERSION) + "\n" + file_hash(path1) + "\n" + file_hash(path2) + "\n" + options.to_string();
+    return to_hex(sha1::of(material.data(), material.size()));
+}
+
+std::filesystem::path compare_cache::entry_path(const std::string& key) const {
+    return m_directory / (key + ENTRY_EXTENSION);
+}
+
+std::optional<diff> compare_cache::load(const std::string& key, bool write_console_colors) {
+    std::filesystem::path path = entry_path(key);
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        m_stats.misses++;
+        return std::nullopt;
+    }
+
+    try {
+        diff d = serializer::read_diff(file, write_console_colors);
+
+        // refresh the entry's recency, it may have been evicted by another process meanwhile
+        std::error_code ec;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+        m_stats.hits++;
+        return d;
+    } catch (const std::exception& e) {
+        PDIF_LOG_WARN("compare_cache::load - discarding unreadable entry {}: {}", path.string(), e.what());
+
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+
+        m_stats.misses++;
+        return std::nullopt;
+    }
+}
+
+void compare_cache::store(const std::string& key, const diff& d) {
+    std::filesystem::path path = entry_path(key);
+
+    // a unique temporary name per writer, renamed into place once complete
+    std::random_device rd;
+    uint64_t unique = ((uint64_t)rd() << 32) | rd();
+    std::filesystem::path tmp = m_directory / (key + ".tmp." + std::to_string(unique));
+
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            PDIF_LOG_WARN("compare_cache::store - cannot write {}", tmp.string());
+            return;
+        }
+
+        serializer::write_diff(file, d);
+        file.flush();
+
+        if (!file.good()) {
+            PDIF_LOG_WARN("compare_cache::store - failed writing {}", tmp.string());
+            file.close();
+
+            std::error_code ec;
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        PDIF_LOG_WARN("compare_cache::store - cannot move entry into place: {}", ec.message());
+        std::filesystem::remove(tmp, ec);
+        return;
+    }
+
+    m_stats.stores++;
+    evict();
+}
+
+void compare_cache::evict() {
+    struct entry {
+        std::filesystem::file_time_type time;
+        uintmax_t size;
+        std::filesystem::path path;
+    };
+
+    std::vector<entry> cached;
+    uintmax_t total = 0;
+
+    auto now = std::filesystem::file_time_type::clock::now();
+
+    std::error_code ec;
+    for (auto it = std::filesystem::directory_iterator(m_directory, ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+        std::error_code entry_ec;
+        auto time = it->last_write_time(entry_ec);
+        uintmax_t size = it->file_size(entry_ec);
+        if (entry_ec) {
+            // removed by another process
+            continue;
+        }
+
+        std::string name = it->path().filename().string();
+
+        // temporary files left behind by writers that died
+        if (name.find(".tmp.") != std::string::npos) {
+            if (now - time > std::chrono::hours(1)) {
+                std::filesystem::remove(it->path(), entry_ec);
+            }
+            continue;
+        }
+
+        if (it->path().extension() != ENTRY_EXTENSION) {
+            continue;
+        }
+
+        cached.push_back({time, size, it->path()});
+        total += size;
+    }
+
+    if (total <= m_max_bytes) {
+        return;
+    }
+
+    std::sort(cached.begin(), cached.end(), [](const entry& a, const entry& b) { return a.time < b.time; });
+
+    for (const entry& e : cached) {
+        if (total <= m_max_bytes) {
+            break;
+        }
+
+        std::error_code remove_ec;
+        if (std::filesystem::remove(e.path, remove_ec)) {
+            m_stats.evictions++;
+        }
+
+        // removed either by us or by another process evicting concurrently
+        total -= e.size;
+    }
+}
+
+size_t compare_cache::entries() const {
+    size_t count = 0;
+
+    std::error_code ec;
+    for (auto it = std::filesystem::directory_iterator(m_directory, ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+        if (it->path().extension() == ENTRY_EXTENSION) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+uintmax_t compare_cache::size_bytes() const {
+    uintmax_t total = 0;
+
+    std::error_code ec;
+    for (auto it = std::filesystem::directory_iterator(m_directory, ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+        std::error_code entry_ec;
+        if (it->path().extension() == ENTRY_EXTENSION) {
+            uintmax_t size = it->file_size(entry_ec);
+            if (!entry_ec) {
+                total += size;
+            }
+        }
+    }
+
+    return total;
+}
+
+void compare_cache::output_stats(std::ostream& os) const {
+    os << "Cache: " << m_stats.hits << " hits, " << m_stats.misses << " misses, "
+       << m_stats.stores << " stores, " << m_stats.evictions << " evictions, "
+       << entries() << " entries (" << size_bytes() << " bytes)" << std::endl;
+}
+
+}
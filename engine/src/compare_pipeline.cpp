@@ -0,0 +1,182 @@
+#include <pdif/compare_pipeline.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace pdif {
+
+namespace {
+
+/**
+ * @brief a thread that runs one step each time it is started, for the lifetime of a pipeline run
+ *
+ * Starting a thread per page pair costs more than tokenizing a short page, so a single worker is kept and
+ * handed each step with a condition variable. The worker is stopped and joined when it is destroyed, also
+ * when the caller unwinds with an exception.
+ *
+ */
+class prefetch_worker {
+public:
+
+    prefetch_worker(std::function<void()> step, stats* collector) : m_step(std::move(step)) {
+        m_thread = std::thread([this, collector]() {
+            stats::collect collect(collector);
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (true) {
+                m_cv.wait(lock, [this]() { return m_running || m_stop; });
+                if (m_stop) {
+                    return;
+                }
+
+                lock.unlock();
+                try {
+                    m_step();
+                } catch (...) {
+                    m_error = std::current_exception();
+                }
+                lock.lock();
+
+                m_running = false;
+                m_cv.notify_all();
+            }
+        });
+    }
+
+    ~prefetch_worker() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+
+    prefetch_worker(const prefetch_worker&) = delete;
+    prefetch_worker& operator=(const prefetch_worker&) = delete;
+
+    /**
+     * @brief run the step once on the worker
+     *
+     */
+    void start() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = true;
+        }
+        m_cv.notify_all();
+    }
+
+    /**
+     * @brief wait for the step started last, and rethrow what it threw
+     *
+     */
+    void wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this]() { return !m_running; });
+        if (m_error) {
+            std::exception_ptr error = std::exchange(m_error, nullptr);
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+
+    std::function<void()> m_step;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_running = false;
+    bool m_stop = false;
+    std::exception_ptr m_error;
+    std::thread m_thread;
+};
+
+} // namespace
+
+compare_pipeline::compare_pipeline(const std::string& path1, const std::string& path2, page_differ_f differ, granularity g, bool write_console_colors, int pageno, bool allow_state_set_nochange, int image_similarity)
+    : m_differ(differ), m_granularity(g), m_write_console_colors(write_console_colors), m_pageno(pageno), m_allow_state_set_nochange(allow_state_set_nochange), m_image_similarity(image_similarity) {
+    if (!m_differ) {
+        PDIF_LOG_ERROR("compare_pipeline::compare_pipeline - no page differ given");
+        throw pdif::pdif_invalid_argment("compare_pipeline::compare_pipeline - no page differ given");
+    }
+
+    // only the trailer and cross reference table are read here, pages are parsed when they are pulled
+    stats::timer timer(stats::stage::parse);
+    m_pdf1 = QPDF::create();
+    m_pdf1->processFile(path1.c_str());
+
+    m_pdf2 = QPDF::create();
+    m_pdf2->processFile(path2.c_str());
+}
+
+pdif::diff compare_pipeline::run(const page_callback_f& on_page) const {
+    pdif::diff d(m_write_console_colors);
+    stream_differ_base::meta_diff(d, extract_meta(m_pdf1), extract_meta(m_pdf2));
+
+    generator<stream> pages1 = extract_content_lazily(m_pdf1, m_granularity, scope::page, m_pageno, m_allow_state_set_nochange, m_image_similarity);
+    generator<stream> pages2 = extract_content_lazily(m_pdf2, m_granularity, scope::page, m_pageno, m_allow_state_set_nochange, m_image_similarity);
+
+    auto it1 = pages1.begin();
+    auto it2 = pages2.begin();
+
+    // the worker collects its own stats, merged into the caller's at the end
+    stats* collector = stats::current();
+    stats worker_stats;
+
+    {
+        // tokenize the next page of both documents while this one is diffed. The differ only reads the extracted
+        // streams, and the generators (and so both QPDFs) are only advanced on the worker while it runs
+        prefetch_worker worker([&]() {
+            if (it1 != pages1.end()) {
+                ++it1;
+            }
+            if (it2 != pages2.end()) {
+                ++it2;
+            }
+        }, collector != nullptr ? &worker_stats : nullptr);
+
+        for (size_t page = 0; it1 != pages1.end() || it2 != pages2.end(); page++) {
+            // take the pages out of the generators, whose frames are reused for the next page
+            std::optional<stream> page1;
+            std::optional<stream> page2;
+            if (it1 != pages1.end()) {
+                page1 = std::move(*it1);
+            }
+            if (it2 != pages2.end()) {
+                page2 = std::move(*it2);
+            }
+
+            worker.start();
+
+            size_t index = m_pageno >= 0 ? m_pageno : page;
+
+            pdif::diff page_diff(m_write_console_colors);
+            {
+                stats::page_timer timer(true, index);
+                m_differ(page_diff, page1.has_value() ? &page1.value() : nullptr, page2.has_value() ? &page2.value() : nullptr);
+            }
+
+            // append the page to the aggregated diff
+            d.replace_edit_ops(d.edit_op_size(), 0, page_diff);
+            for (const stream& original : page_diff.original_streams()) {
+                d.add_original_stream(original);
+            }
+
+            if (on_page) {
+                on_page(index, page_diff);
+            }
+
+            worker.wait();
+        }
+    }
+
+    if (collector != nullptr) {
+        collector->merge(worker_stats);
+    }
+
+    return d;
+}
+
+}
@@ -0,0 +1,252 @@
+#include <pdif/compare_session.hpp>
+#include <pdif/hash_util.hpp>
+
+#include <algorithm>
+#include <map>
+
+namespace pdif {
+
+namespace {
+
+using digest_memo = std::map<QPDFObjGen, std::string>;
+
+void hash_object(sha1& ctx, QPDFObjectHandle obj, digest_memo& memo);
+
+void hash_direct(sha1& ctx, QPDFObjectHandle obj, digest_memo& memo) {
+    if (obj.isStream()) {
+        hash_object(ctx, obj.getDict(), memo);
+
+        auto data = obj.getRawStreamData();
+        if (data) {
+            ctx.update(data->getBuffer(), data->getSize());
+        }
+    } else if (obj.isDictionary()) {
+        ctx.update("<<", 2);
+        for (auto& [key, value] : obj.ditems()) {
+            // the page tree links back up to the pages, which would pull in the whole document. Annotations
+            // link to their page and popup, and their appearance and modification date are regenerated by
+            // viewers, see structural_hasher in page_visitor.cpp
+            if (key == "/P" || key == "/Parent" || key == "/Popup" || key == "/AP" || key == "/M") {
+                continue;
+            }
+
+            ctx.update(key.data(), key.size());
+            hash_object(ctx, value, memo);
+        }
+        ctx.update(">>", 2);
+    } else if (obj.isArray()) {
+        ctx.update("[", 1);
+        for (auto& item : obj.aitems()) {
+            hash_object(ctx, item, memo);
+        }
+        ctx.update("]", 1);
+    } else {
+        std::string value = obj.unparse();
+        ctx.update(value.data(), value.size());
+        ctx.update(" ", 1);
+    }
+}
+
+void hash_page_reference(sha1& ctx, QPDFObjectHandle page) {
+    // the page index, or the object id of a page outside the page tree
+    std::string reference;
+    QPDF* pdf = page.getOwningQPDF();
+    if (pdf != nullptr) {
+        try {
+            reference = "p" + std::to_string(pdf->findPage(page));
+        } catch (std::exception const&) {
+            reference.clear();
+        }
+    }
+    if (reference.empty()) {
+        reference = page.unparse();
+    }
+
+    ctx.update(reference.data(), reference.size());
+    ctx.update(" ", 1);
+}
+
+void hash_object(sha1& ctx, QPDFObjectHandle obj, digest_memo& memo) {
+    if (!obj.isIndirect()) {
+        hash_direct(ctx, obj, memo);
+        return;
+    }
+
+    // a page is referenced by destinations and actions, its content is not part of the referrer
+    if (obj.isPageObject()) {
+        hash_page_reference(ctx, obj);
+        return;
+    }
+
+    // indirect objects are hashed once and referenced by their digest. The placeholder breaks cycles
+    QPDFObjGen og = obj.getObjGen();
+    auto it = memo.find(og);
+    if (it == memo.end()) {
+        memo[og] = "";
+
+        sha1 sub;
+        hash_direct(sub, obj, memo);
+        it = memo.insert_or_assign(og, sub.digest()).first;
+    }
+
+    ctx.update(it->second);
+}
+
+}
+
+compare_session::compare_session(const std::string& path1, const std::string& path2, page_differ_f differ, granularity g, bool write_console_colors, bool allow_state_set_nochange, int image_similarity)
+    : m_path2(path2), m_differ(differ), m_granularity(g), m_allow_state_set_nochange(allow_state_set_nochange), m_image_similarity(image_similarity), m_diff(write_console_colors) {
+    if (!m_differ) {
+        PDIF_LOG_ERROR("compare_session::compare_session - no page differ given");
+        throw pdif::pdif_invalid_argment("compare_session::compare_session - no page differ given");
+    }
+
+    stats::timer parse(stats::stage::parse);
+    auto pdf1 = QPDF::create();
+    pdf1->processFile(path1.c_str());
+    parse.stop();
+
+    m_meta1 = extract_meta(pdf1);
+    m_pages1 = extract_content(pdf1, m_granularity, scope::page, -1, m_allow_state_set_nochange, m_image_similarity);
+
+    load(path2, true);
+}
+
+std::vector<std::string> compare_session::page_hashes(std::shared_ptr<QPDF> pdf) {
+    std::vector<std::string> hashes;
+    digest_memo memo;
+
+    for (auto& page : QPDFPageDocumentHelper(*pdf).getAllPages()) {
+        sha1 ctx;
+
+        QPDFObjectHandle page_obj = page.getObjectHandle();
+        hash_object(ctx, page_obj.getKey("/Contents"), memo);
+        hash_object(ctx, page.getAttribute("/Resources", false), memo);
+
+        QPDFObjectHandle annots = page_obj.getKey("/Annots");
+        hash_object(ctx, annots, memo);
+
+        // form field names, types and values are inherited through /Parent, which hashing does not follow
+        if (annots.isArray()) {
+            for (auto& annot : annots.aitems()) {
+                QPDFObjectHandle field = annot;
+                for (int depth = 0; depth < 32 && field.isDictionary(); depth++) {
+                    for (const char* key : {"/T", "/FT", "/V"}) {
+                        hash_object(ctx, field.getKey(key), memo);
+                    }
+                    field = field.getKey("/Parent");
+                }
+            }
+        }
+
+        hashes.push_back(to_hex(ctx.digest()));
+    }
+
+    return hashes;
+}
+
+size_t compare_session::update() {
+    return load(m_path2, false);
+}
+
+size_t compare_session::update(const std::string& path2) {
+    m_path2 = path2;
+    return load(m_path2, false);
+}
+
+const pdif::diff& compare_session::page_diff(size_t page) const {
+    if (page >= m_page_diffs.size()) {
+        PDIF_LOG_ERROR("compare_session::page_diff - page {} out of range", page);
+        throw pdif::pdif_out_of_bounds("compare_session::page_diff - page " + std::to_string(page) + " out of range");
+    }
+
+    return m_page_diffs[page];
+}
+
+pdif::diff compare_session::diff_page(size_t page) const {
+    pdif::diff d;
+    m_differ(d, page < m_pages1.size() ? &m_pages1[page] : nullptr, page < m_pages2.size() ? &m_pages2[page] : nullptr);
+    return d;
+}
+
+size_t compare_session::load(const std::string& path2, bool full) {
+    stats::timer parse(stats::stage::parse);
+    auto pdf2 = QPDF::create();
+    pdf2->processFile(path2.c_str());
+    parse.stop();
+
+    std::vector<std::string> hashes = page_hashes(pdf2);
+
+    size_t m = m_pages1.size();
+    size_t old_n = m_pages2.size();
+    size_t n = hashes.size();
+
+    // extract the pages whose content changed
+    std::vector<int> changed;
+    for (size_t i = 0; i < n; i++) {
+        if (full || i >= old_n || hashes[i] != m_hashes2[i]) {
+            changed.push_back(i);
+        }
+    }
+
+    std::vector<stream> extracted = extract_pages(pdf2, changed, m_granularity, m_allow_state_set_nochange, m_image_similarity);
+    m_pages2.resize(n);
+    for (size_t k = 0; k < changed.size(); k++) {
+        m_pages2[changed[k]] = extracted[k];
+    }
+    m_hashes2 = std::move(hashes);
+
+    // the meta is small, diff it again in full
+    m_meta2 = extract_meta(pdf2);
+    m_diff.clear_meta_edit_ops();
+    stream_differ_base::meta_diff(m_diff, m_meta1, m_meta2);
+
+    // the start of each page's ops in the aggregated diff before the update
+    std::vector<size_t> offsets(m_page_diffs.size() + 1, 0);
+    for (size_t i = 0; i < m_page_diffs.size(); i++) {
+        offsets[i + 1] = offsets[i] + m_page_diffs[i].edit_op_size();
+    }
+
+    // pages removed from the revision are diffed again too, as deleted (or dropped)
+    size_t pages = std::max({m, n, m_page_diffs.size()});
+    size_t rediffed = 0;
+    long long shift = 0;
+
+    for (size_t i = 0, c = 0; i < pages; i++) {
+        bool is_changed = c < changed.size() && (size_t)changed[c] == i;
+        if (is_changed) {
+            c++;
+        }
+
+        if (!full && !is_changed && !(i >= n && i < old_n)) {
+            continue;
+        }
+
+        pdif::diff d = diff_page(i);
+
+        size_t old_size = i < m_page_diffs.size() ? m_page_diffs[i].edit_op_size() : 0;
+        size_t offset = (i < m_page_diffs.size() ? offsets[i] : offsets.back()) + shift;
+        m_diff.replace_edit_ops(offset, old_size, d);
+        shift += (long long)d.edit_op_size() - (long long)old_size;
+
+        if (i < m && !d.original_streams().empty()) {
+            if (i < m_diff.original_streams().size()) {
+                m_diff.set_original_stream(i, d.original_streams()[0]);
+            } else {
+                m_diff.add_original_stream(d.original_streams()[0]);
+            }
+        }
+
+        if (i >= m_page_diffs.size()) {
+            m_page_diffs.resize(i + 1);
+        }
+        m_page_diffs[i] = std::move(d);
+        rediffed++;
+    }
+
+    m_page_diffs.resize(std::max(m, n));
+
+    return rediffed;
+}
+
+}
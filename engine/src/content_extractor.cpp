@@ -1,5 +1,12 @@
 #include <pdif/content_extractor.hpp>
-#include <pdif/pdf_content_stream_filter.hpp>
+#include <pdif/page_visitor.hpp>
+#include <pdif/xmp_parser.hpp>
+#include <pdif/stats.hpp>
+#include <pdif/hash_util.hpp>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
 #include <vector>
 
 namespace pdif {
@@ -17,7 +24,12 @@ extern pdif::stream_meta extract_meta(std::shared_ptr<QPDF> pdf) {
                 val = it.second.getStringValue();
             } else if (it.second.isName()) {
                 val = it.second.getName();
+            } else if (it.second.isArray() || it.second.isDictionary() || it.second.isStream()) {
+                // containers are compared by their structure, which does not depend on the object
+                // numbers a rewrite of the file assigns, and is not expanded however large it is
+                append_hex(val, page_visitor::structural_hash(it.second));
             } else {
+                // numbers, booleans and null, resolved when they are indirect
                 val = it.second.unparseResolved();
             }
 
@@ -26,19 +38,49 @@ extern pdif::stream_meta extract_meta(std::shared_ptr<QPDF> pdf) {
         }
     }
 
+    // Access the XMP metadata stream
+    QPDFObjectHandle xmp = pdf->getRoot().getKey("/Metadata");
+
+    if (xmp.isStream()) {
+        std::vector<std::pair<std::string, std::string>> properties;
+        try {
+            std::shared_ptr<Buffer> data = xmp.getStreamData(qpdf_dl_generalized);
+            std::string_view packet(reinterpret_cast<const char*>(data->getBuffer()), data->getSize());
+
+            xmp_parser::parse(packet, [&](const std::string& key, const std::string& value) {
+                properties.emplace_back("XMP/" + key, value);
+            });
+        } catch (const std::exception& e) {
+            PDIF_LOG_WARN("Skipping unreadable XMP metadata: {}", e.what());
+            properties.clear();
+        }
+
+        for (auto& [key, value] : properties) {
+            // a property repeated in the packet keeps its first value
+            if (!meta.has_key(key)) {
+                meta.add_metadata(key, value);
+            }
+        }
+    }
+
     return meta;
 }
 
-extern std::vector<pdif::stream> extract_content(std::shared_ptr<QPDF> pdf, granularity g, scope s, int pageno, bool allow_state_set_nochange) {
-    using T_filter = pdf_content_stream_filter;
+extern std::vector<pdif::stream> extract_content(std::shared_ptr<QPDF> pdf, granularity g, scope s, int pageno, bool allow_state_set_nochange, int image_similarity) {
     std::vector<pdif::stream> streams;
 
-    std::vector<QPDFPageObjectHelper> pages = QPDFPageDocumentHelper(*pdf).getAllPages();
-
-    if (s == scope::document) {
-        streams.push_back(pdif::stream());
+    for (pdif::stream& stream : extract_content_lazily(pdf, g, s, pageno, allow_state_set_nochange, image_similarity)) {
+        streams.push_back(std::move(stream));
     }
 
+    return streams;
+}
+
+extern generator<pdif::stream> extract_content_lazily(std::shared_ptr<QPDF> pdf, granularity g, scope s, int pageno, bool allow_state_set_nochange, int image_similarity) {
+    page_visitor visitor(g, allow_state_set_nochange, image_similarity);
+
+    std::vector<QPDFPageObjectHelper> pages = QPDFPageDocumentHelper(*pdf).getAllPages();
+
     if (pageno >= (int)pages.size()) {
         throw std::runtime_error("Page number out of range");
     }
@@ -47,20 +89,129 @@ extern std::vector<pdif::stream> extract_content(std::shared_ptr<QPDF> pdf, gran
         pages = {pages[pageno]};
     }
 
-    for (auto& page : pages) {
+    pdif::stream stream;
+    for (size_t i = 0; i < pages.size(); i++) {
+        // the page is timed up to the yield, not while the consumer holds it
+        {
+            stats::page_timer timer(false, pageno >= 0 ? pageno : i);
+            visitor.visit(pages[i], stream);
+        }
+
         if (s == scope::page) {
-            pdif::stream s = pdif::stream();
-            T_filter tf(s, g, page.getObjectHandle());
-            tf.setStateSetNoChange(allow_state_set_nochange);
+            co_yield std::move(stream);
+            stream = pdif::stream();
+        }
+    }
+
+    if (s == scope::document) {
+        co_yield std::move(stream);
+    }
+}
+
+extern std::vector<pdif::stream> extract_content_parallel(std::shared_ptr<QPDF> pdf, const std::string& path, granularity g, scope s, int pageno, bool allow_state_set_nochange, int image_similarity, unsigned threads) {
+    size_t page_count = QPDFPageDocumentHelper(*pdf).getAllPages().size();
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min<size_t>(threads, page_count);
+
+    if (pageno >= 0 || threads <= 1) {
+        return extract_content(pdf, g, s, pageno, allow_state_set_nochange, image_similarity);
+    }
 
-            page.filterContents(&tf);
-            streams.push_back(s);
-        } else if (s == scope::document) {
-            T_filter tf(streams[0], g, page.getObjectHandle());
-            tf.setStateSetNoChange(allow_state_set_nochange);
+    // a few shards per thread balance uneven pages, while keeping neighbouring pages (which tend to share
+    // fonts and images) on one worker's caches
+    size_t shard_size = std::max<size_t>(1, page_count / (threads * 4));
+    size_t shards = (page_count + shard_size - 1) / shard_size;
+
+    std::vector<pdif::stream> pages(page_count);
+    std::vector<std::exception_ptr> errors(threads);
+
+    // workers collect their own stats, merged into the caller's once they are done
+    stats* collector = stats::current();
+    std::vector<stats> worker_stats(threads);
+
+    // each worker takes the next shard until none are left
+    std::atomic<size_t> next = 0;
+    auto worker = [&](unsigned t) {
+        stats::collect collect(collector != nullptr ? &worker_stats[t] : nullptr);
+
+        try {
+            std::shared_ptr<QPDF> own = pdf;
+            if (t > 0) {
+                stats::timer timer(stats::stage::parse);
+                own = QPDF::create();
+                own->processFile(path.c_str());
+            }
+
+            std::vector<QPDFPageObjectHelper> all = QPDFPageDocumentHelper(*own).getAllPages();
+            if (all.size() != page_count) {
+                PDIF_LOG_ERROR("extract_content_parallel - {} changed while it was extracted", path);
+                throw pdif::pdif_invalid_format("extract_content_parallel - " + path + " changed while it was extracted");
+            }
 
-            page.filterContents(&tf);
+            page_visitor visitor(g, allow_state_set_nochange, image_similarity);
+            for (size_t shard = next++; shard < shards; shard = next++) {
+                for (size_t i = shard * shard_size; i < std::min(page_count, (shard + 1) * shard_size); i++) {
+                    stats::page_timer timer(false, i);
+                    visitor.visit(all[i], pages[i]);
+                }
+            }
+        } catch (...) {
+            errors[t] = std::current_exception();
         }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+
+    for (std::thread& t : pool) {
+        t.join();
+    }
+
+    if (collector != nullptr) {
+        for (const stats& ws : worker_stats) {
+            collector->merge(ws);
+        }
+    }
+
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    if (s == scope::document) {
+        pdif::stream document;
+        for (const pdif::stream& page : pages) {
+            for (size_t i = 0; i < page.size(); i++) {
+                document.push_back(page[i]);
+            }
+        }
+        return {document};
+    }
+
+    return pages;
+}
+
+extern std::vector<pdif::stream> extract_pages(std::shared_ptr<QPDF> pdf, const std::vector<int>& pagenos, granularity g, bool allow_state_set_nochange, int image_similarity) {
+    std::vector<pdif::stream> streams;
+    page_visitor visitor(g, allow_state_set_nochange, image_similarity);
+
+    std::vector<QPDFPageObjectHelper> pages = QPDFPageDocumentHelper(*pdf).getAllPages();
+
+    for (int pageno : pagenos) {
+        if (pageno < 0 || pageno >= (int)pages.size()) {
+            PDIF_LOG_ERROR("extract_pages - page number {} out of range", pageno);
+            throw pdif::pdif_out_of_bounds("extract_pages - page number " + std::to_string(pageno) + " out of range");
+        }
+
+        streams.push_back(pdif::stream());
+        visitor.visit(pages[pageno], streams.back());
     }
 
     return streams;
@@ -1,11 +1,40 @@
 #include <pdif/diff.hpp>
 
+#include <unordered_map>
+
 namespace pdif {
 
 void diff::add_edit_op(const edit_op& op) {
     m_edit_script.push_back(op);
 }
 
+void diff::set_original_stream(size_t index, const stream& s) {
+    if (index >= m_original_streams.size()) {
+        PDIF_LOG_ERROR("pdif::diff - original stream index out of range");
+        throw pdif_out_of_bounds("pdif::diff - original stream index out of range");
+    }
+
+    m_original_streams[index] = s;
+}
+
+void diff::replace_edit_ops(size_t index, size_t count, const diff& source) {
+    if (index > m_edit_script.size() || count > m_edit_script.size() - index) {
+        PDIF_LOG_ERROR("pdif::diff - replaced range out of range");
+        throw pdif_out_of_bounds("pdif::diff - replaced range out of range");
+    }
+
+    // overwrite the common prefix, then grow or shrink the range in one move of the tail
+    const std::vector<edit_op>& ops = source.m_edit_script;
+    size_t common = std::min(count, ops.size());
+    std::copy(ops.begin(), ops.begin() + common, m_edit_script.begin() + index);
+
+    if (ops.size() > count) {
+        m_edit_script.insert(m_edit_script.begin() + index + count, ops.begin() + common, ops.end());
+    } else {
+        m_edit_script.erase(m_edit_script.begin() + index + common, m_edit_script.begin() + index + count);
+    }
+}
+
 void diff::check_edit_index(size_t index) const {
     if (index >= m_edit_script.size()) {
         PDIF_LOG_ERROR("pdif::diff - index out of range");
@@ -79,30 +108,34 @@ void diff::apply_meta_edit_script(stream_meta& stream) const {
     }
 }
 
-std::vector<diff::edit_chunk> diff::edit_chunk_summary() const {
-    std::vector<edit_chunk> chunks;
-
+void diff::for_each_edit_hunk(const std::function<void(const edit_hunk&)>& callback) const {
     bool in_chunk = false;
-    edit_chunk chunk;
+    edit_hunk hunk;
 
     int from_file_pointer = 0;
     int to_file_pointer = 0;
     int context_remaining = m_allowed_context;
 
+    auto finish_hunk = [&]() {
+        callback(hunk);
+        hunk.lines.clear();
+        hunk.from_count = 0;
+        hunk.to_count = 0;
+        in_chunk = false;
+    };
+
     for (size_t i = 0; i < m_edit_script.size(); i++) {
-        auto op = m_edit_script[i];
+        const edit_op& op = m_edit_script[i];
 
         if (op.get_type() == edit_op_type::EQ) {
             if (in_chunk) {
                 if (context_remaining > 0) {
-                    chunk.from_count++;
-                    chunk.to_count++;
-                    chunk.lines.push_back(get_original_line(from_file_pointer));
+                    hunk.from_count++;
+                    hunk.to_count++;
+                    hunk.lines.push_back({edit_op_type::EQ, get_original_elem(from_file_pointer)});
                     context_remaining--;
                 } else {
-                    chunks.push_back(chunk);
-                    chunk = edit_chunk();
-                    in_chunk = false;
+                    finish_hunk();
                 }
             }
 
@@ -120,51 +153,67 @@ std::vector<diff::edit_chunk> diff::edit_chunk_summary() const {
                     }
 
                     pre_context_lines++;
-                    chunk.from_count++;
-                    chunk.to_count++;
-                    chunk.lines.push_back(get_original_line(from_file_pointer - j));
+                    hunk.from_count++;
+                    hunk.to_count++;
+                    hunk.lines.push_back({edit_op_type::EQ, get_original_elem(from_file_pointer - j)});
                 }
 
                 in_chunk = true;
-                chunk.from_file_start = from_file_pointer - pre_context_lines;
-                chunk.to_file_start = to_file_pointer - pre_context_lines;
-
-            }
-
-            if (op.get_type() == edit_op_type::INSERT) {
-                chunk.to_count++;
-
-                std::stringstream new_line_ss;
-                new_line_ss << cc(util::CONSOLE_COLOR_CODE::FG_GREEN) << "+" << op.get_arg()->to_string(m_write_console_colors) << cc(util::CONSOLE_COLOR_CODE::FG_DEFAULT);
-                chunk.lines.push_back(new_line_ss.str());
-            } else if (op.get_type() == edit_op_type::DELETE) {
-                chunk.from_count++;
-
-                std::stringstream new_line_ss;
-                new_line_ss << cc(util::CONSOLE_COLOR_CODE::FG_RED) << "-" << get_original_line(from_file_pointer) << cc(util::CONSOLE_COLOR_CODE::FG_DEFAULT);
-                chunk.lines.push_back(new_line_ss.str());
+                hunk.from_file_start = from_file_pointer - pre_context_lines;
+                hunk.to_file_start = to_file_pointer - pre_context_lines;
             }
 
-            // update the pointers
-            if (op.get_type() == edit_op_type::DELETE) {
-                from_file_pointer++;
-            } else if (op.get_type() == edit_op_type::INSERT) {
+            if (op.get_type() == edit_op_type::INSERT || op.get_type() == edit_op_type::MOVE_TO) {
+                hunk.to_count++;
+                hunk.lines.push_back({op.get_type(), op.get_arg(), op.get_move()});
                 to_file_pointer++;
+            } else if (op.get_type() == edit_op_type::DELETE || op.get_type() == edit_op_type::MOVE_FROM) {
+                hunk.from_count++;
+                hunk.lines.push_back({op.get_type(), get_original_elem(from_file_pointer), op.get_move()});
+                from_file_pointer++;
             }
         }
     }
 
     if (in_chunk) {
-        chunks.push_back(chunk);
+        finish_hunk();
     }
+}
+
+std::vector<diff::edit_chunk> diff::edit_chunk_summary() const {
+    std::vector<edit_chunk> chunks;
+
+    for_each_edit_hunk([&](const edit_hunk& hunk) {
+        edit_chunk chunk;
+        chunk.from_file_start = hunk.from_file_start;
+        chunk.to_file_start = hunk.to_file_start;
+        chunk.from_count = hunk.from_count;
+        chunk.to_count = hunk.to_count;
+
+        chunk.lines.reserve(hunk.lines.size());
+        for (const edit_hunk::line& line : hunk.lines) {
+            chunk.lines.emplace_back();
+            render_hunk_line(chunk.lines.back(), line);
+        }
+
+        chunks.push_back(chunk);
+    });
 
     return chunks;
 }
 
 void diff::count_edit_op_types(int& plus, int& minus, int&eq) const {
+    int moved;
+    count_edit_op_types(plus, minus, eq, moved);
+    plus += moved;
+    minus += moved;
+}
+
+void diff::count_edit_op_types(int& plus, int& minus, int&eq, int& moved) const {
     plus = 0;
     minus = 0;
     eq = 0;
+    moved = 0;
 
     for (const edit_op& op : m_edit_script) {
         if (op.get_type() == edit_op_type::INSERT) {
@@ -173,10 +222,176 @@ void diff::count_edit_op_types(int& plus, int& minus, int&eq) const {
             minus++;
         } else if (op.get_type() == edit_op_type::EQ) {
             eq++;
+        } else if (op.get_type() == edit_op_type::MOVE_TO) {
+            moved++;
         }
     }
 }
 
+size_t diff::detect_moves(size_t min_length) {
+    if (min_length == 0) {
+        PDIF_LOG_ERROR("pdif::diff::detect_moves - min_length must be at least 1");
+        throw pdif_invalid_argment("pdif::diff::detect_moves - min_length must be at least 1");
+    }
+
+    // a changed element, its op and the run of consecutive changes (between EQs) it belongs to
+    struct change {
+        size_t op;
+        rstream_elem elem;
+        size_t run;
+    };
+
+    std::vector<change> deleted;
+    std::vector<change> inserted;
+    size_t run = 0;
+    size_t next_move = 0;
+
+    // walk the original streams alongside the script, rather than looking every deleted element up
+    size_t stream_index = 0;
+    size_t elem_index = 0;
+    auto next_original = [&]() -> const rstream_elem& {
+        while (stream_index < m_original_streams.size() && elem_index >= m_original_streams[stream_index].size()) {
+            stream_index++;
+            elem_index = 0;
+        }
+
+        if (stream_index >= m_original_streams.size()) {
+            PDIF_LOG_ERROR("pdif::diff::detect_moves - original streams do not cover the edit script");
+            throw pdif_out_of_bounds("pdif::diff::detect_moves - original streams do not cover the edit script");
+        }
+
+        return m_original_streams[stream_index][elem_index++];
+    };
+
+    for (size_t i = 0; i < m_edit_script.size(); i++) {
+        const edit_op& op = m_edit_script[i];
+
+        switch (op.get_type()) {
+            case edit_op_type::DELETE:
+                deleted.push_back({i, next_original(), run});
+                break;
+            case edit_op_type::INSERT:
+                inserted.push_back({i, op.get_arg(), run});
+                break;
+            case edit_op_type::EQ:
+                next_original();
+                run++;
+                break;
+            case edit_op_type::MOVE_FROM:
+                next_original();
+                run++;
+                next_move = std::max(next_move, op.get_move() + 1);
+                break;
+            case edit_op_type::MOVE_TO:
+                run++;
+                next_move = std::max(next_move, op.get_move() + 1);
+                break;
+        }
+    }
+
+    size_t k = min_length;
+    if (deleted.size() < k || inserted.size() < k) {
+        return 0;
+    }
+
+    // polynomial hash of every k element window, the window may cross runs and is checked when used
+    auto gram_hashes = [k](const std::vector<change>& changes) {
+        static constexpr uint64_t BASE = 0x100000001b3ull;
+
+        uint64_t top = 1;
+        for (size_t i = 1; i < k; i++) {
+            top *= BASE;
+        }
+
+        std::vector<uint64_t> grams(changes.size() - k + 1);
+        uint64_t h = 0;
+        for (size_t i = 0; i < changes.size(); i++) {
+            if (i >= k) {
+                h -= (uint64_t)changes[i - k].elem->hash() * top;
+            }
+            h = h * BASE + (uint64_t)changes[i].elem->hash();
+
+            if (i + 1 >= k) {
+                grams[i + 1 - k] = h;
+            }
+        }
+        return grams;
+    };
+
+    auto in_one_run = [k](const std::vector<change>& changes, size_t start) {
+        return changes[start].run == changes[start + k - 1].run;
+    };
+
+    std::unordered_map<uint64_t, std::vector<size_t>> index;
+    std::vector<uint64_t> deleted_grams = gram_hashes(deleted);
+    for (size_t p = 0; p < deleted_grams.size(); p++) {
+        if (in_one_run(deleted, p)) {
+            index[deleted_grams[p]].push_back(p);
+        }
+    }
+
+    // a k-gram repeated across many deleted blocks only has its first few candidates checked
+    static constexpr size_t MAX_CANDIDATES = 8;
+
+    std::vector<bool> consumed(deleted.size(), false);
+    std::vector<uint64_t> inserted_grams = gram_hashes(inserted);
+    size_t moves = 0;
+
+    size_t i = 0;
+    while (i < inserted_grams.size()) {
+        auto it = index.end();
+        if (in_one_run(inserted, i)) {
+            it = index.find(inserted_grams[i]);
+        }
+
+        size_t best = 0;
+        size_t best_length = 0;
+
+        if (it != index.end()) {
+            size_t checked = 0;
+            for (size_t p : it->second) {
+                if (consumed[p] || deleted[p].run == inserted[i].run) {
+                    continue;
+                }
+                if (checked++ == MAX_CANDIDATES) {
+                    break;
+                }
+
+                size_t length = 0;
+                while (i + length < inserted.size() && p + length < deleted.size()
+                       && !consumed[p + length]
+                       && inserted[i + length].run == inserted[i].run
+                       && deleted[p + length].run == deleted[p].run
+                       && deleted[p + length].elem->compare(inserted[i + length].elem)) {
+                    length++;
+                }
+
+                if (length > best_length) {
+                    best = p;
+                    best_length = length;
+                }
+            }
+        }
+
+        if (best_length < k) {
+            i++;
+            continue;
+        }
+
+        size_t move = next_move++;
+        for (size_t j = 0; j < best_length; j++) {
+            consumed[best + j] = true;
+            m_edit_script[deleted[best + j].op] = edit_op(edit_op_type::MOVE_FROM, std::nullopt, move);
+            m_edit_script[inserted[i + j].op] = edit_op(edit_op_type::MOVE_TO, inserted[i + j].elem, move);
+        }
+
+        moves++;
+        i += best_length;
+    }
+
+    return moves;
+}
+
 void diff::count_meta_op_types(int& update, int& add, int&del) const {
     update = 0;
     add = 0;
@@ -194,44 +409,60 @@ void diff::count_meta_op_types(int& update, int& add, int&del) const {
 }
 
 void diff::output_edit_script(std::ostream& os) const {
-    os << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "Content Differences" << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET) << std::endl;
-    os << std::endl;
+    output_buffer out(os);
+    output_edit_script(out);
+    out.flush();
+}
+
+void diff::output_edit_script(output_buffer& os) const {
+    os << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "Content Differences" << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET) << '\n';
+    os << '\n';
 
 
     if (m_edit_script.size() == 0) {
-        os << "No differences" << std::endl;
+        os << "No differences\n";
     } else {
-        auto chunks = edit_chunk_summary();
-        for (const edit_chunk& chunk : chunks) {
-            write_edit_chunk(os, chunk);
-        }
+        for_each_edit_hunk([&](const edit_hunk& hunk) {
+            write_edit_hunk(os.buffer(), hunk);
+            os.commit();
+        });
     }
     
-    os << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "End of Content Differences" << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET) << std::endl;
+    os << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "End of Content Differences" << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET) << '\n';
 }
 
 std::string diff::get_original_line(int index) const {
+    return get_original_elem(index)->to_string(m_write_console_colors);
+}
+
+const rstream_elem& diff::get_original_elem(int index) const {
     int i = index;
     for (size_t y = 0; y < m_original_streams.size(); y++) {
         if (m_original_streams[y].size() <= (size_t)i) {
             i -= m_original_streams[y].size();
             if (i < 0) {
-                throw pdif_out_of_bounds("pdif::diff::get_original_line - index out of range");
+                throw pdif_out_of_bounds("pdif::diff::get_original_elem - index out of range");
             }
         } else {
-            return m_original_streams[y][i]->to_string(m_write_console_colors);
+            return m_original_streams[y][i];
         }
     }
 
-    throw pdif_out_of_bounds("pdif::diff::get_original_line - index out of range");
+    throw pdif_out_of_bounds("pdif::diff::get_original_elem - index out of range");
 }
 
 void diff::output_meta_edit_script(std::ostream& os) const {
-    os << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "Meta Differences" << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET) << std::endl;
-    os << std::endl;
+    output_buffer out(os);
+    output_meta_edit_script(out);
+    out.flush();
+}
+
+void diff::output_meta_edit_script(output_buffer& os) const {
+    os << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "Meta Differences" << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET) << '\n';
+    os << '\n';
     
     if (m_meta_edit_script.size() == 0) {
-        os << "\tNo differences" << std::endl;
+        os << "\tNo differences\n";
     } else {
         for (const meta_edit_op& op : m_meta_edit_script) {
             switch (op.get_type()) {
@@ -241,13 +472,13 @@ void diff::output_meta_edit_script(std::ostream& os) const {
                     os << cc(util::CONSOLE_COLOR_CODE::FG_DEFAULT) << " ==> " << cc(util::CONSOLE_COLOR_CODE::FG_GREEN);
                     os << op.get_meta_val();
                     os << cc(util::CONSOLE_COLOR_CODE::FG_DEFAULT);
-                    os << std::endl;
+                    os << '\n';
                     break;
                 case meta_edit_op_type::META_DELETE:
                     os << "\t" << cc(util::CONSOLE_COLOR_CODE::FG_RED) << "- ";
                     os << op.get_meta_key();
                     os << cc(util::CONSOLE_COLOR_CODE::FG_DEFAULT);
-                    os << std::endl;
+                    os << '\n';
                     break;
                 case meta_edit_op_type::META_UPDATE:
                     os << "\t" << cc(util::CONSOLE_COLOR_CODE::FG_YELLOW) << "~ ";
@@ -255,7 +486,7 @@ void diff::output_meta_edit_script(std::ostream& os) const {
                     os << cc(util::CONSOLE_COLOR_CODE::FG_DEFAULT) << " ==> " << cc(util::CONSOLE_COLOR_CODE::FG_YELLOW);
                     os << op.get_meta_val();
                     os << cc(util::CONSOLE_COLOR_CODE::FG_DEFAULT);
-                    os << std::endl;
+                    os << '\n';
                     break;
                 default:
                     break;
@@ -263,48 +494,92 @@ void diff::output_meta_edit_script(std::ostream& os) const {
         }
     }
 
-    os << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "End of Meta Differences" << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET) << std::endl;
+    os << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "End of Meta Differences" << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET) << '\n';
 }
 
-void diff::output_summary(std::ostream& os, int plus, int minus, int last, std::string last_char, util::CONSOLE_COLOR_CODE last_color) const {
-    os << std::endl;
+void diff::output_summary(output_buffer& os, int plus, int minus, int last, std::string last_char, util::CONSOLE_COLOR_CODE last_color, int moved) const {
+    os << '\n';
     os << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "Summary: " << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET);
     os << cc(util::CONSOLE_COLOR_CODE::FG_GREEN) << "+" << plus << " ";
     os << cc(util::CONSOLE_COLOR_CODE::FG_RED) << "-" << minus << " ";
+    if (moved > 0) {
+        os << cc(util::CONSOLE_COLOR_CODE::FG_YELLOW) << ">" << moved << " ";
+    }
     os << cc(last_color) << last_char << last;
     os << cc(util::CONSOLE_COLOR_CODE::FG_DEFAULT);
-    os << std::endl;
+    os << '\n';
 }
 
-std::string diff::cc(util::CONSOLE_COLOR_CODE code) const {
+std::string_view diff::cc(util::CONSOLE_COLOR_CODE code) const {
     if (m_write_console_colors) {
-        std::stringstream ss;
-        ss << code;
-        return ss.str();
+        return console_color(code);
     }
     return "";
 }
 
-void diff::write_edit_chunk(std::ostream& os, const edit_chunk& chunk) const {
+void diff::render_hunk_line(std::string& buffer, const edit_hunk::line& line) const {
+    if (line.type == edit_op_type::INSERT) {
+        render_color(buffer, util::CONSOLE_COLOR_CODE::FG_GREEN, m_write_console_colors);
+        buffer.push_back('+');
+        line.elem->render_to(buffer, m_write_console_colors);
+        render_color(buffer, util::CONSOLE_COLOR_CODE::FG_DEFAULT, m_write_console_colors);
+    } else if (line.type == edit_op_type::DELETE) {
+        render_color(buffer, util::CONSOLE_COLOR_CODE::FG_RED, m_write_console_colors);
+        buffer.push_back('-');
+        line.elem->render_to(buffer, m_write_console_colors);
+        render_color(buffer, util::CONSOLE_COLOR_CODE::FG_DEFAULT, m_write_console_colors);
+    } else if (line.type == edit_op_type::MOVE_FROM || line.type == edit_op_type::MOVE_TO) {
+        // moved away (<) and moved here (>), both in the same color so the pair stands out from real changes
+        render_color(buffer, util::CONSOLE_COLOR_CODE::FG_YELLOW, m_write_console_colors);
+        buffer.push_back(line.type == edit_op_type::MOVE_FROM ? '<' : '>');
+        line.elem->render_to(buffer, m_write_console_colors);
+        render_color(buffer, util::CONSOLE_COLOR_CODE::FG_DEFAULT, m_write_console_colors);
+    } else {
+        line.elem->render_to(buffer, m_write_console_colors);
+    }
+}
+
+void diff::write_edit_hunk(std::string& buffer, const edit_hunk& hunk) const {
     // print chunk header
-    os << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD);
-    os << "@@ -" << chunk.from_file_start << "," << chunk.from_count << " +" << chunk.to_file_start << "," << chunk.to_count << " @@" << std::endl;
-    os << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET);
-    
+    render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_BOLD, m_write_console_colors);
+    buffer.append("@@ -");
+    render_int(buffer, hunk.from_file_start);
+    buffer.push_back(',');
+    render_int(buffer, hunk.from_count);
+    buffer.append(" +");
+    render_int(buffer, hunk.to_file_start);
+    buffer.push_back(',');
+    render_int(buffer, hunk.to_count);
+    buffer.append(" @@\n");
+    render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_RESET, m_write_console_colors);
+
     // print chunk content
-    for (const std::string& line : chunk.lines) {
-        os << line << std::endl;
+    for (const edit_hunk::line& line : hunk.lines) {
+        render_hunk_line(buffer, line);
+        buffer.push_back('\n');
     }
 }
 
 void diff::output_edit_summary(std::ostream& os) const {
-    int plus_count, minus_count, eq_count;
-    count_edit_op_types(plus_count, minus_count, eq_count);
+    output_buffer out(os);
+    output_edit_summary(out);
+    out.flush();
+}
 
-    output_summary(os, plus_count, minus_count, eq_count, "=", util::CONSOLE_COLOR_CODE::FG_DEFAULT);
+void diff::output_edit_summary(output_buffer& os) const {
+    int plus_count, minus_count, eq_count, moved_count;
+    count_edit_op_types(plus_count, minus_count, eq_count, moved_count);
+
+    output_summary(os, plus_count, minus_count, eq_count, "=", util::CONSOLE_COLOR_CODE::FG_DEFAULT, moved_count);
 }
 
 void diff::output_meta_summary(std::ostream& os) const {
+    output_buffer out(os);
+    output_meta_summary(out);
+    out.flush();
+}
+
+void diff::output_meta_summary(output_buffer& os) const {
     int add, update, del;
     count_meta_op_types(update, add, del);
 
@@ -314,12 +589,12 @@ void diff::output_meta_summary(std::ostream& os) const {
 std::ostream& operator<<(std::ostream& os, const diff::edit_chunk& chunk) {
     // print chunk header
     os << util::CONSOLE_COLOR_CODE::TEXT_BOLD;
-    os << "@@ -" << chunk.from_file_start << "," << chunk.from_count << " +" << chunk.to_file_start << "," << chunk.to_count << " @@" << std::endl;
+    os << "@@ -" << chunk.from_file_start << "," << chunk.from_count << " +" << chunk.to_file_start << "," << chunk.to_count << " @@" << '\n';
     os << util::CONSOLE_COLOR_CODE::TEXT_RESET;
     
     // print chunk content
     for (const std::string& line : chunk.lines) {
-        os << line << std::endl;
+        os << line << '\n';
     }
 
     return os;
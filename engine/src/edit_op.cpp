@@ -2,22 +2,30 @@
 
 namespace pdif {
 
-edit_op::edit_op(edit_op_type type, std::optional<pdif::rstream_elem> t_arg) : type(type), arg(t_arg) {
-    if (type != edit_op_type::INSERT && has_arg()) {
-        PDIF_LOG_ERROR("edit_op::edit_op - arg is only valid for INSERT edit_op");
-        throw pdif::pdif_invalid_argment("edit_op::edit_op - arg is only valid for INSERT edit_op");
+edit_op::edit_op(edit_op_type type, std::optional<pdif::rstream_elem> t_arg, size_t t_move) : type(type), arg(t_arg), move(t_move) {
+    bool inserts = type == edit_op_type::INSERT || type == edit_op_type::MOVE_TO;
+
+    if (!inserts && has_arg()) {
+        PDIF_LOG_ERROR("edit_op::edit_op - arg is only valid for INSERT and MOVE_TO edit_op");
+        throw pdif::pdif_invalid_argment("edit_op::edit_op - arg is only valid for INSERT and MOVE_TO edit_op");
+    }
+
+    if (inserts && !has_arg()) {
+        PDIF_LOG_ERROR("edit_op::edit_op - arg is required for INSERT and MOVE_TO edit_op");
+        throw pdif::pdif_invalid_argment("edit_op::edit_op - arg is required for INSERT and MOVE_TO edit_op");
     }
 
-    if (type == edit_op_type::INSERT && !has_arg()) {
-        PDIF_LOG_ERROR("edit_op::edit_op - arg is required for INSERT edit_op");
-        throw pdif::pdif_invalid_argment("edit_op::edit_op - arg is required for INSERT edit_op");
+    if (!is_move() && move != 0) {
+        PDIF_LOG_ERROR("edit_op::edit_op - move id is only valid for MOVE_FROM and MOVE_TO edit_op");
+        throw pdif::pdif_invalid_argment("edit_op::edit_op - move id is only valid for MOVE_FROM and MOVE_TO edit_op");
     }
 }
 
 void edit_op::execute(pdif::stream& t_stream, size_t& t_index) const {
     // switch on the edit_op type
     switch (type) {
-        case edit_op_type::INSERT: {
+        case edit_op_type::INSERT:
+        case edit_op_type::MOVE_TO: {
             // try push to the stream
             try {
                 PDIF_LOG_INFO("edit_op::execute - (INSERT) inserting element into stream at index {}", t_index);
@@ -30,7 +38,8 @@ void edit_op::execute(pdif::stream& t_stream, size_t& t_index) const {
             }
             break;
         }
-        case edit_op_type::DELETE: {
+        case edit_op_type::DELETE:
+        case edit_op_type::MOVE_FROM: {
             // try to delete from the stream
             try {
                 PDIF_LOG_INFO("edit_op::execute - (DELETE) deleting element from stream at index {}", t_index);
@@ -0,0 +1,541 @@
+#include <pdif/extraction_cache.hpp>
+#include <pdif/hash_util.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <unordered_map>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pdif {
+
+static constexpr char MAGIC[8] = {'P', 'D', 'I', 'F', 'X', 'T', 'R', 'C'};
+// written in the writer's byte order, the records are read in place so the reader's must match
+static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+static constexpr size_t HASH_SIZE = sha1::DIGEST_SIZE;
+
+struct extraction_cache::header {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t version;
+    unsigned char file_hash[HASH_SIZE];
+    uint8_t granularity;
+    uint8_t scope;
+    uint8_t allow_state_set_nochange;
+    uint8_t reserved0;
+    int32_t pageno;
+    int32_t image_similarity;
+    uint32_t reserved1;
+    uint64_t meta_count;
+    uint64_t meta_offset;
+    uint64_t stream_count;
+    uint64_t stream_offset;
+    uint64_t elem_count;
+    uint64_t elem_offset;
+    uint64_t index_count;
+    uint64_t index_offset;
+    uint64_t strings_size;
+    uint64_t strings_offset;
+};
+
+struct extraction_cache::elem_record {
+    uint8_t type;
+    uint8_t has_fingerprint;
+    uint16_t reserved;
+    uint32_t text_size;
+    uint64_t text_offset;
+    uint64_t fingerprint;
+    int32_t values[3];
+    float color[3];
+    uint32_t detail_size[2];
+    uint64_t detail_offset[2];
+    float rect[4];
+};
+
+struct extraction_cache::meta_record {
+    uint64_t key_offset;
+    uint64_t value_offset;
+    uint32_t key_size;
+    uint32_t value_size;
+};
+
+struct extraction_cache::stream_record {
+    uint64_t first_index;
+    uint64_t count;
+};
+
+static uint64_t align8(uint64_t v) {
+    return (v + 7) & ~uint64_t(7);
+}
+
+void extraction_cache::write(const std::string& path, const std::string& file_hash, const extraction_options& options, const stream_meta& meta, const std::vector<stream>& streams) {
+    header head{};
+    std::memcpy(head.magic, MAGIC, sizeof(MAGIC));
+    head.byte_order = BYTE_ORDER_MARK;
+    head.version = FORMAT_VERSION;
+    if (!from_hex(file_hash, head.file_hash, HASH_SIZE)) {
+        PDIF_LOG_ERROR("extraction_cache::write - invalid file hash '{}'", file_hash);
+        throw pdif::pdif_invalid_argment("extraction_cache::write - invalid file hash '" + file_hash + "'");
+    }
+    head.granularity = (uint8_t)options.g;
+    head.scope = (uint8_t)options.s;
+    head.allow_state_set_nochange = options.allow_state_set_nochange ? 1 : 0;
+    head.pageno = options.pageno;
+    head.image_similarity = options.image_similarity;
+
+    // strings and elements are stored once
+    std::string strings;
+    std::unordered_map<std::string, uint64_t> string_offsets;
+    auto intern_string = [&](const std::string& s) {
+        auto it = string_offsets.find(s);
+        if (it != string_offsets.end()) {
+            return it->second;
+        }
+
+        uint64_t offset = strings.size();
+        strings.append(s);
+        string_offsets.emplace(s, offset);
+        return offset;
+    };
+
+    std::vector<meta_record> metas;
+    for (auto& [key, value] : meta.get_metadata()) {
+        meta_record record{};
+        record.key_offset = intern_string(key);
+        record.key_size = key.size();
+        record.value_offset = intern_string(value);
+        record.value_size = value.size();
+        metas.push_back(record);
+    }
+
+    std::vector<elem_record> elems;
+    std::map<std::string, uint32_t> elem_ids;
+    std::vector<stream_record> stream_records;
+    std::vector<uint32_t> indices;
+
+    for (const stream& s : streams) {
+        stream_record sr{};
+        sr.first_index = indices.size();
+        sr.count = s.size();
+        stream_records.push_back(sr);
+
+        for (size_t i = 0; i < s.size(); i++) {
+            const rstream_elem& e = s[i];
+
+            elem_record record{};
+            record.type = (uint8_t)e->type();
+
+            auto set_text = [&](const std::string& text) {
+                record.text_offset = intern_string(text);
+                record.text_size = text.size();
+            };
+            auto set_detail = [&](size_t i, const std::string& detail) {
+                record.detail_offset[i] = intern_string(detail);
+                record.detail_size[i] = detail.size();
+            };
+
+            switch (e->type()) {
+                case stream_type::text:
+                    set_text(e->as<text_elem>()->text());
+                    break;
+                case stream_type::font_set:
+                    set_text(e->as<font_elem>()->font_name());
+                    record.values[0] = e->as<font_elem>()->font_size();
+                    break;
+                case stream_type::text_color_set: {
+                    auto color = e->as<text_color_elem>();
+                    record.color[0] = color->red();
+                    record.color[1] = color->green();
+                    record.color[2] = color->blue();
+                    break;
+                }
+                case stream_type::stroke_color_set: {
+                    auto color = e->as<stroke_color_elem>();
+                    record.color[0] = color->red();
+                    record.color[1] = color->green();
+                    record.color[2] = color->blue();
+                    break;
+                }
+                case stream_type::xobject_image: {
+                    auto img = e->as<xobject_img_elem>();
+                    set_text(img->image_hash());
+                    record.values[0] = img->width();
+                    record.values[1] = img->height();
+                    record.values[2] = img->similarity_threshold();
+                    record.has_fingerprint = img->has_fingerprint() ? 1 : 0;
+                    record.fingerprint = img->has_fingerprint() ? img->fingerprint() : 0;
+                    break;
+                }
+                case stream_type::annotation: {
+                    auto annot = e->as<annotation_elem>();
+                    set_text(annot->subtype());
+                    set_detail(0, annot->contents());
+                    std::copy(annot->rect().begin(), annot->rect().end(), record.rect);
+                    record.has_fingerprint = 1;
+                    record.fingerprint = annot->dict_hash();
+                    break;
+                }
+                case stream_type::form_field: {
+                    auto field = e->as<form_field_elem>();
+                    set_text(field->name());
+                    set_detail(0, field->field_type());
+                    set_detail(1, field->value());
+                    break;
+                }
+            }
+
+            // records are zero initialised, so equal elements have equal bytes
+            std::string bytes(reinterpret_cast<const char*>(&record), sizeof(record));
+            auto [it, inserted] = elem_ids.emplace(bytes, (uint32_t)elems.size());
+            if (inserted) {
+                elems.push_back(record);
+            }
+            indices.push_back(it->second);
+        }
+    }
+
+    head.meta_count = metas.size();
+    head.meta_offset = align8(sizeof(header));
+    head.stream_count = stream_records.size();
+    head.stream_offset = align8(head.meta_offset + metas.size() * sizeof(meta_record));
+    head.elem_count = elems.size();
+    head.elem_offset = align8(head.stream_offset + stream_records.size() * sizeof(stream_record));
+    head.index_count = indices.size();
+    head.index_offset = align8(head.elem_offset + elems.size() * sizeof(elem_record));
+    head.strings_size = strings.size();
+    head.strings_offset = align8(head.index_offset + indices.size() * sizeof(uint32_t));
+
+    // write next to the destination under a unique name per writer and rename, so readers never map a
+    // partial file and concurrent writers never rename each other's
+    std::random_device rd;
+    uint64_t unique = ((uint64_t)rd() << 32) | rd();
+    std::string tmp = path + ".tmp." + std::to_string(unique);
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            PDIF_LOG_ERROR("extraction_cache::write - cannot write {}", tmp);
+            throw pdif::pdif_invalid_argment("extraction_cache::write - cannot write " + tmp);
+        }
+
+        uint64_t written = 0;
+        auto put = [&](uint64_t offset, const void* data, size_t size) {
+            static const char zeros[8] = {};
+            file.write(zeros, offset - written);
+            file.write(reinterpret_cast<const char*>(data), size);
+            written = offset + size;
+        };
+
+        put(0, &head, sizeof(head));
+        put(head.meta_offset, metas.data(), metas.size() * sizeof(meta_record));
+        put(head.stream_offset, stream_records.data(), stream_records.size() * sizeof(stream_record));
+        put(head.elem_offset, elems.data(), elems.size() * sizeof(elem_record));
+        put(head.index_offset, indices.data(), indices.size() * sizeof(uint32_t));
+        put(head.strings_offset, strings.data(), strings.size());
+
+        if (!file.good()) {
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(tmp, ec);
+
+            PDIF_LOG_ERROR("extraction_cache::write - failed writing {}", tmp);
+            throw pdif::pdif_invalid_argment("extraction_cache::write - failed writing " + tmp);
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        PDIF_LOG_ERROR("extraction_cache::write - cannot move cache to {}", path);
+        throw pdif::pdif_invalid_argment("extraction_cache::write - cannot move cache to " + path);
+    }
+}
+
+extraction_cache::extraction_cache(const std::string& path) {
+#if !defined(_WIN32)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        PDIF_LOG_ERROR("extraction_cache::extraction_cache - cannot open {}", path);
+        throw pdif::pdif_invalid_format("extraction_cache::extraction_cache - cannot open " + path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        PDIF_LOG_ERROR("extraction_cache::extraction_cache - cannot read {}", path);
+        throw pdif::pdif_invalid_format("extraction_cache::extraction_cache - cannot read " + path);
+    }
+
+    void* mapped = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (mapped == MAP_FAILED) {
+        PDIF_LOG_ERROR("extraction_cache::extraction_cache - cannot map {}", path);
+        throw pdif::pdif_invalid_format("extraction_cache::extraction_cache - cannot map " + path);
+    }
+
+    m_data = static_cast<const unsigned char*>(mapped);
+    m_size = st.st_size;
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        PDIF_LOG_ERROR("extraction_cache::extraction_cache - cannot open {}", path);
+        throw pdif::pdif_invalid_format("extraction_cache::extraction_cache - cannot open " + path);
+    }
+
+    m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+#endif
+
+    try {
+        validate();
+    } catch (...) {
+#if !defined(_WIN32)
+        ::munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+        throw;
+    }
+}
+
+extraction_cache::~extraction_cache() {
+#if !defined(_WIN32)
+    if (m_data != nullptr) {
+        ::munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+#endif
+}
+
+static void invalid(const std::string& reason) {
+    PDIF_LOG_ERROR("extraction_cache - {}", reason);
+    throw pdif::pdif_invalid_format("extraction_cache - " + reason);
+}
+
+void extraction_cache::validate() const {
+    if (m_size < sizeof(header)) {
+        invalid("file is too small");
+    }
+
+    const header& h = head();
+    if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        invalid("not an extraction cache");
+    }
+    if (h.byte_order != BYTE_ORDER_MARK) {
+        invalid("written with a different byte order");
+    }
+    if (h.version != FORMAT_VERSION) {
+        invalid("unsupported version " + std::to_string(h.version));
+    }
+
+    auto check_table = [&](uint64_t offset, uint64_t count, size_t size, const char* name) {
+        if (offset % 8 != 0 || offset > m_size || count > (m_size - offset) / size) {
+            invalid(std::string(name) + " table out of bounds");
+        }
+    };
+
+    check_table(h.meta_offset, h.meta_count, sizeof(meta_record), "meta");
+    check_table(h.stream_offset, h.stream_count, sizeof(stream_record), "stream");
+    check_table(h.elem_offset, h.elem_count, sizeof(elem_record), "element");
+    check_table(h.index_offset, h.index_count, sizeof(uint32_t), "index");
+    check_table(h.strings_offset, h.strings_size, 1, "string");
+
+    auto check_string = [&](uint64_t offset, uint32_t size) {
+        if (offset > h.strings_size || size > h.strings_size - offset) {
+            invalid("string out of bounds");
+        }
+    };
+
+    auto metas = reinterpret_cast<const meta_record*>(m_data + h.meta_offset);
+    for (uint64_t i = 0; i < h.meta_count; i++) {
+        check_string(metas[i].key_offset, metas[i].key_size);
+        check_string(metas[i].value_offset, metas[i].value_size);
+    }
+
+    auto elems = reinterpret_cast<const elem_record*>(m_data + h.elem_offset);
+    for (uint64_t i = 0; i < h.elem_count; i++) {
+        if (elems[i].type > (uint8_t)stream_type::form_field) {
+            invalid("unknown element type " + std::to_string(elems[i].type));
+        }
+        check_string(elems[i].text_offset, elems[i].text_size);
+        check_string(elems[i].detail_offset[0], elems[i].detail_size[0]);
+        check_string(elems[i].detail_offset[1], elems[i].detail_size[1]);
+    }
+
+    auto streams = reinterpret_cast<const stream_record*>(m_data + h.stream_offset);
+    for (uint64_t i = 0; i < h.stream_count; i++) {
+        if (streams[i].first_index > h.index_count || streams[i].count > h.index_count - streams[i].first_index) {
+            invalid("stream out of bounds");
+        }
+    }
+
+    auto indices = reinterpret_cast<const uint32_t*>(m_data + h.index_offset);
+    for (uint64_t i = 0; i < h.index_count; i++) {
+        if (indices[i] >= h.elem_count) {
+            invalid("element index out of bounds");
+        }
+    }
+}
+
+const extraction_cache::header& extraction_cache::head() const {
+    return *reinterpret_cast<const header*>(m_data);
+}
+
+std::string_view extraction_cache::string_at(uint64_t offset, uint32_t size) const {
+    return std::string_view(reinterpret_cast<const char*>(m_data + head().strings_offset + offset), size);
+}
+
+bool extraction_cache::matches(const std::string& file_hash, const extraction_options& options) const {
+    return this->file_hash() == file_hash && this->options() == options;
+}
+
+std::string extraction_cache::file_hash() const {
+    return to_hex(head().file_hash, HASH_SIZE);
+}
+
+extraction_options extraction_cache::options() const {
+    const header& h = head();
+
+    extraction_options options;
+    options.g = (granularity)h.granularity;
+    options.s = (scope)h.scope;
+    options.pageno = h.pageno;
+    options.allow_state_set_nochange = h.allow_state_set_nochange != 0;
+    options.image_similarity = h.image_similarity;
+    return options;
+}
+
+size_t extraction_cache::stream_count() const {
+    return head().stream_count;
+}
+
+size_t extraction_cache::stream_size(size_t s) const {
+    if (s >= head().stream_count) {
+        PDIF_LOG_ERROR("extraction_cache::stream_size - stream {} out of bounds", s);
+        throw pdif::pdif_out_of_bounds("extraction_cache::stream_size - stream out of bounds");
+    }
+
+    return reinterpret_cast<const stream_record*>(m_data + head().stream_offset)[s].count;
+}
+
+extraction_cache::elem_view extraction_cache::unique_elem(uint32_t id) const {
+    const elem_record& record = reinterpret_cast<const elem_record*>(m_data + head().elem_offset)[id];
+
+    elem_view view;
+    view.type = (stream_type)record.type;
+    view.text = string_at(record.text_offset, record.text_size);
+    view.detail[0] = string_at(record.detail_offset[0], record.detail_size[0]);
+    view.detail[1] = string_at(record.detail_offset[1], record.detail_size[1]);
+    std::memcpy(view.rect, record.rect, sizeof(view.rect));
+    std::memcpy(view.values, record.values, sizeof(view.values));
+    std::memcpy(view.color, record.color, sizeof(view.color));
+    view.has_fingerprint = record.has_fingerprint != 0;
+    view.fingerprint = record.fingerprint;
+    return view;
+}
+
+extraction_cache::elem_view extraction_cache::elem(size_t s, size_t i) const {
+    if (i >= stream_size(s)) {
+        PDIF_LOG_ERROR("extraction_cache::elem - element {} of stream {} out of bounds", i, s);
+        throw pdif::pdif_out_of_bounds("extraction_cache::elem - element out of bounds");
+    }
+
+    const stream_record& record = reinterpret_cast<const stream_record*>(m_data + head().stream_offset)[s];
+    uint32_t id = reinterpret_cast<const uint32_t*>(m_data + head().index_offset)[record.first_index + i];
+    return unique_elem(id);
+}
+
+size_t extraction_cache::meta_count() const {
+    return head().meta_count;
+}
+
+std::pair<std::string_view, std::string_view> extraction_cache::meta(size_t i) const {
+    if (i >= head().meta_count) {
+        PDIF_LOG_ERROR("extraction_cache::meta - entry {} out of bounds", i);
+        throw pdif::pdif_out_of_bounds("extraction_cache::meta - entry out of bounds");
+    }
+
+    const meta_record& record = reinterpret_cast<const meta_record*>(m_data + head().meta_offset)[i];
+    return {string_at(record.key_offset, record.key_size), string_at(record.value_offset, record.value_size)};
+}
+
+std::vector<stream> extraction_cache::load_streams() const {
+    const header& h = head();
+
+    // one element per distinct record, shared by every position it occurs at
+    std::vector<rstream_elem> unique(h.elem_count);
+    auto materialise = [&](uint32_t id) -> const rstream_elem& {
+        if (unique[id]) {
+            return unique[id];
+        }
+
+        elem_view view = unique_elem(id);
+        std::string text(view.text);
+
+        switch (view.type) {
+            case stream_type::text:
+                unique[id] = stream_elem::create<text_elem>(text);
+                break;
+            case stream_type::font_set:
+                unique[id] = stream_elem::create<font_elem>(text, view.values[0]);
+                break;
+            case stream_type::text_color_set:
+                unique[id] = stream_elem::create<text_color_elem>(view.color[0], view.color[1], view.color[2]);
+                break;
+            case stream_type::stroke_color_set:
+                unique[id] = stream_elem::create<stroke_color_elem>(view.color[0], view.color[1], view.color[2]);
+                break;
+            case stream_type::xobject_image: {
+                unique[id] = stream_elem::create<xobject_img_elem>(text, view.values[0], view.values[1]);
+                auto img = unique[id]->as<xobject_img_elem>();
+                if (view.has_fingerprint) {
+                    img->set_fingerprint(view.fingerprint);
+                }
+                img->set_similarity_threshold(view.values[2]);
+                break;
+            }
+            case stream_type::annotation: {
+                std::array<float, 4> rect;
+                std::copy(view.rect, view.rect + 4, rect.begin());
+                unique[id] = stream_elem::create<annotation_elem>(text, rect, std::string(view.detail[0]), view.fingerprint);
+                break;
+            }
+            case stream_type::form_field:
+                unique[id] = stream_elem::create<form_field_elem>(text, std::string(view.detail[0]), std::string(view.detail[1]));
+                break;
+        }
+
+        return unique[id];
+    };
+
+    auto records = reinterpret_cast<const stream_record*>(m_data + h.stream_offset);
+    auto indices = reinterpret_cast<const uint32_t*>(m_data + h.index_offset);
+
+    std::vector<stream> streams(h.stream_count);
+    for (uint64_t s = 0; s < h.stream_count; s++) {
+        for (uint64_t i = 0; i < records[s].count; i++) {
+            streams[s].push_back(materialise(indices[records[s].first_index + i]));
+        }
+    }
+
+    return streams;
+}
+
+stream_meta extraction_cache::load_meta() const {
+    stream_meta result;
+    for (size_t i = 0; i < meta_count(); i++) {
+        auto [key, value] = meta(i);
+        result.add_metadata(std::string(key), std::string(value));
+    }
+    return result;
+}
+
+}
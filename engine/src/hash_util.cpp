@@ -0,0 +1,92 @@
+#include <pdif/hash_util.hpp>
+
+#include <openssl/evp.h>
+
+#include <fstream>
+
+namespace pdif {
+
+static const char* HEX_DIGITS = "0123456789abcdef";
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+sha1::sha1() : m_ctx(EVP_MD_CTX_new()) {
+    EVP_DigestInit_ex(m_ctx, EVP_sha1(), nullptr);
+}
+
+sha1::~sha1() {
+    EVP_MD_CTX_free(m_ctx);
+}
+
+void sha1::update(const void* data, size_t size) {
+    EVP_DigestUpdate(m_ctx, data, size);
+}
+
+std::string sha1::digest() {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int size = 0;
+    EVP_DigestFinal_ex(m_ctx, digest, &size);
+    return std::string(reinterpret_cast<char*>(digest), size);
+}
+
+std::string sha1::of(const void* data, size_t size) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_size = 0;
+    EVP_Digest(data, size, digest, &digest_size, EVP_sha1(), nullptr);
+    return std::string(reinterpret_cast<char*>(digest), digest_size);
+}
+
+std::string sha1::of_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        PDIF_LOG_ERROR("sha1::of_file - cannot open {}", path);
+        throw pdif::pdif_invalid_argment("sha1::of_file - cannot open " + path);
+    }
+
+    sha1 ctx;
+    char buffer[1 << 16];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+        ctx.update(buffer, file.gcount());
+    }
+    return ctx.digest();
+}
+
+std::string to_hex(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    std::string hex(size * 2, '0');
+    for (size_t i = 0; i < size; i++) {
+        hex[2 * i] = HEX_DIGITS[bytes[i] >> 4];
+        hex[2 * i + 1] = HEX_DIGITS[bytes[i] & 0xf];
+    }
+    return hex;
+}
+
+void append_hex(std::string& out, uint64_t value, int digits) {
+    for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4) {
+        out.push_back(HEX_DIGITS[(value >> shift) & 0xf]);
+    }
+}
+
+bool from_hex(std::string_view hex, unsigned char* out, size_t size) {
+    if (hex.size() != size * 2) {
+        return false;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        int hi = hex_value(hex[2 * i]);
+        int lo = hex_value(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        out[i] = (unsigned char)((hi << 4) | lo);
+    }
+    return true;
+}
+
+} // namespace pdif
@@ -0,0 +1,91 @@
+#include <pdif/hierarchical_stream_differ.hpp>
+#include <pdif/histogram_stream_differ.hpp>
+#include <pdif/text_segmenter.hpp>
+
+namespace pdif {
+
+hierarchical_stream_differ::hierarchical_stream_differ(pdif::stream_view stream1, pdif::stream_view stream2, granularity finest)
+    : stream_differ_base(stream1, stream2), m_finest(finest), m_refined(stream1) {
+    if (finest == granularity::sentence) {
+        PDIF_LOG_ERROR("hierarchical_stream_differ::hierarchical_stream_differ - finest granularity must be word or letter");
+        throw pdif::pdif_invalid_argment("hierarchical_stream_differ::hierarchical_stream_differ - finest granularity must be word or letter");
+    }
+}
+
+pdif::stream hierarchical_stream_differ::split(pdif::stream_view s, granularity g) {
+    pdif::stream out;
+    text_segmenter segmenter(g);
+
+    for (size_t i = 0; i < s.size(); i++) {
+        if (g == granularity::sentence || s[i]->type() != stream_type::text) {
+            out.push_back(s[i]);
+            continue;
+        }
+
+        segmenter.push(s[i]->as<text_elem>()->text(), [&out](std::string_view segment) {
+            out.push_back(stream_elem::create<text_elem>(std::string(segment)));
+        });
+    }
+
+    return out;
+}
+
+void hierarchical_stream_differ::diff(pdif::diff& diff) {
+    m_refined = pdif::stream();
+    refine(stream1, stream2, granularity::sentence, diff);
+}
+
+void hierarchical_stream_differ::refine(pdif::stream_view a, pdif::stream_view b, granularity g, pdif::diff& d) {
+    pdif::stream split_a = split(a, g);
+    pdif::stream split_b = split(b, g);
+
+    pdif::diff level;
+    histogram_stream_differ differ(split_a, split_b);
+    differ.diff(level);
+
+    // the next granularity to refine changed hunks to, if any
+    bool can_refine = g != m_finest;
+    granularity next = g == granularity::sentence ? granularity::word : granularity::letter;
+
+    size_t i = 0;
+    auto it = level.begin();
+    while (it != level.end()) {
+        if (it->get_type() == edit_op_type::EQ) {
+            d.add_edit_op(*it);
+            m_refined.push_back(split_a[i++]);
+            ++it;
+            continue;
+        }
+
+        // collect the hunk
+        auto hunk_end = it;
+        pdif::stream removed;
+        pdif::stream added;
+        size_t hunk_start = i;
+        while (hunk_end != level.end() && hunk_end->get_type() != edit_op_type::EQ) {
+            if (hunk_end->get_type() == edit_op_type::DELETE) {
+                removed.push_back(split_a[hunk_start + removed.size()]);
+            } else {
+                added.push_back(hunk_end->get_arg());
+            }
+            ++hunk_end;
+        }
+
+        if (can_refine && removed.size() > 0 && added.size() > 0) {
+            refine(removed, added, next, d);
+        } else {
+            for (; it != hunk_end; ++it) {
+                d.add_edit_op(*it);
+            }
+
+            for (size_t r = 0; r < removed.size(); r++) {
+                m_refined.push_back(removed[r]);
+            }
+        }
+
+        i += removed.size();
+        it = hunk_end;
+    }
+}
+
+}
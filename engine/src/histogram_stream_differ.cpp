@@ -0,0 +1,275 @@
+#include <pdif/histogram_stream_differ.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace pdif {
+
+void histogram_stream_differ::diff(pdif::diff& diff) {
+    int m = stream1.size();
+    int n = stream2.size();
+
+    m_hash1.resize(m);
+    m_hash2.resize(n);
+
+    for (int i = 0; i < m; i++) {
+        m_hash1[i] = stream1[i]->hash();
+    }
+
+    for (int j = 0; j < n; j++) {
+        m_hash2[j] = stream2[j]->hash();
+    }
+
+    // hunks are emitted as inserts followed by deletes, matching lcs_stream_differ
+    m_ops.clear();
+    m_cells = 0;
+    diff_region(0, m, 0, n, 0);
+    stats::add(stats::counter::dp_cells, m_cells);
+
+    for (const edit_op& op : m_ops) {
+        diff.add_edit_op(op);
+    }
+}
+
+bool histogram_stream_differ::eq(int i, int j) {
+    return m_hash1[i] == m_hash2[j] && stream1[i]->compare(stream2[j]);
+}
+
+void histogram_stream_differ::emit_eq(int count) {
+    for (int i = 0; i < count; i++) {
+        m_ops.push_back(edit_op(edit_op_type::EQ));
+    }
+}
+
+void histogram_stream_differ::emit_delete(int count) {
+    for (int i = 0; i < count; i++) {
+        m_ops.push_back(edit_op(edit_op_type::DELETE));
+    }
+}
+
+void histogram_stream_differ::emit_insert(int b0, int b1) {
+    for (int j = b0; j < b1; j++) {
+        m_ops.push_back(edit_op(edit_op_type::INSERT, stream2[j]));
+    }
+}
+
+void histogram_stream_differ::diff_region(int a0, int a1, int b0, int b1, int depth) {
+    // strip the common prefix
+    int prefix = 0;
+    while (a0 + prefix < a1 && b0 + prefix < b1 && eq(a0 + prefix, b0 + prefix)) {
+        prefix++;
+    }
+    emit_eq(prefix);
+    a0 += prefix;
+    b0 += prefix;
+
+    // strip the common suffix (emitted last)
+    int suffix = 0;
+    while (a0 < a1 - suffix && b0 < b1 - suffix && eq(a1 - suffix - 1, b1 - suffix - 1)) {
+        suffix++;
+    }
+    a1 -= suffix;
+    b1 -= suffix;
+
+    if (a0 == a1 || b0 == b1) {
+        emit_insert(b0, b1);
+        emit_delete(a1 - a0);
+        emit_eq(suffix);
+        return;
+    }
+
+    if ((a1 - a0) + (b1 - b0) <= SMALL_REGION || depth >= MAX_DEPTH) {
+        myers(a0, a1, b0, b1);
+        emit_eq(suffix);
+        return;
+    }
+
+    // histogram of the elements in the first region
+    std::unordered_map<size_t, std::vector<int>> occurrences;
+    for (int i = a0; i < a1; i++) {
+        occurrences[m_hash1[i]].push_back(i);
+    }
+
+    // find the lowest-occurrence common element, preferring the longest run on ties
+    size_t best_count = MAX_CHAIN + 1;
+    int best_a = -1, best_b = -1, best_len = 0;
+
+    int j = b0;
+    while (j < b1) {
+        int next_j = j + 1;
+
+        auto it = occurrences.find(m_hash2[j]);
+        if (it != occurrences.end() && it->second.size() <= best_count) {
+            for (int i : it->second) {
+                if (!eq(i, j)) {
+                    continue;
+                }
+
+                // extend the match in both directions
+                int sa = i, sb = j;
+                while (sa > a0 && sb > b0 && eq(sa - 1, sb - 1)) {
+                    sa--;
+                    sb--;
+                }
+
+                int ea = i + 1, eb = j + 1;
+                while (ea < a1 && eb < b1 && eq(ea, eb)) {
+                    ea++;
+                    eb++;
+                }
+
+                // runs are not rescanned from the inside
+                next_j = std::max(next_j, eb);
+
+                if (it->second.size() < best_count || (ea - sa) > best_len) {
+                    best_count = it->second.size();
+                    best_a = sa;
+                    best_b = sb;
+                    best_len = ea - sa;
+                }
+            }
+        }
+
+        j = next_j;
+    }
+
+    if (best_len == 0) {
+        myers(a0, a1, b0, b1);
+        emit_eq(suffix);
+        return;
+    }
+
+    diff_region(a0, best_a, b0, best_b, depth + 1);
+    emit_eq(best_len);
+    diff_region(best_a + best_len, a1, best_b + best_len, b1, depth + 1);
+    emit_eq(suffix);
+}
+
+void histogram_stream_differ::myers(int a0, int a1, int b0, int b1) {
+    int prefix = 0;
+    while (a0 + prefix < a1 && b0 + prefix < b1 && eq(a0 + prefix, b0 + prefix)) {
+        prefix++;
+    }
+    emit_eq(prefix);
+    a0 += prefix;
+    b0 += prefix;
+
+    int suffix = 0;
+    while (a0 < a1 - suffix && b0 < b1 - suffix && eq(a1 - suffix - 1, b1 - suffix - 1)) {
+        suffix++;
+    }
+    a1 -= suffix;
+    b1 -= suffix;
+
+    if (a0 == a1 || b0 == b1) {
+        emit_insert(b0, b1);
+        emit_delete(a1 - a0);
+        emit_eq(suffix);
+        return;
+    }
+
+    int split_a, split_b;
+    if (bisect(a0, a1, b0, b1, split_a, split_b)) {
+        myers(a0, split_a, b0, split_b);
+        myers(split_a, a1, split_b, b1);
+    } else {
+        emit_insert(b0, b1);
+        emit_delete(a1 - a0);
+    }
+
+    emit_eq(suffix);
+}
+
+bool histogram_stream_differ::bisect(int a0, int a1, int b0, int b1, int& split_a, int& split_b) {
+    const int n = a1 - a0;
+    const int m = b1 - b0;
+    const int max_d = (n + m + 1) / 2;
+    const int v_offset = max_d;
+    const int v_length = 2 * max_d + 2;
+
+    std::vector<int> v1(v_length, -1);
+    std::vector<int> v2(v_length, -1);
+    v1[v_offset + 1] = 0;
+    v2[v_offset + 1] = 0;
+
+    const int delta = n - m;
+    // if the total number of elements is odd, the forward path collides with the reverse path
+    const bool front = (delta % 2 != 0);
+
+    int k1start = 0, k1end = 0, k2start = 0, k2end = 0;
+
+    for (int d = 0; d < max_d; d++) {
+        // walk the forward path one step
+        for (int k1 = -d + k1start; k1 <= d - k1end; k1 += 2) {
+            int k1_offset = v_offset + k1;
+            int x1;
+            if (k1 == -d || (k1 != d && v1[k1_offset - 1] < v1[k1_offset + 1])) {
+                x1 = v1[k1_offset + 1];
+            } else {
+                x1 = v1[k1_offset - 1] + 1;
+            }
+            int y1 = x1 - k1;
+            m_cells++;
+            while (x1 < n && y1 < m && eq(a0 + x1, b0 + y1)) {
+                x1++;
+                y1++;
+            }
+            v1[k1_offset] = x1;
+
+            if (x1 > n) {
+                k1end += 2;
+            } else if (y1 > m) {
+                k1start += 2;
+            } else if (front) {
+                int k2_offset = v_offset + delta - k1;
+                if (k2_offset >= 0 && k2_offset < v_length && v2[k2_offset] != -1) {
+                    int x2 = n - v2[k2_offset];
+                    if (x1 >= x2) {
+                        split_a = a0 + x1;
+                        split_b = b0 + y1;
+                        return true;
+                    }
+                }
+            }
+        }
+
+        // walk the reverse path one step
+        for (int k2 = -d + k2start; k2 <= d - k2end; k2 += 2) {
+            int k2_offset = v_offset + k2;
+            int x2;
+            if (k2 == -d || (k2 != d && v2[k2_offset - 1] < v2[k2_offset + 1])) {
+                x2 = v2[k2_offset + 1];
+            } else {
+                x2 = v2[k2_offset - 1] + 1;
+            }
+            int y2 = x2 - k2;
+            m_cells++;
+            while (x2 < n && y2 < m && eq(a1 - x2 - 1, b1 - y2 - 1)) {
+                x2++;
+                y2++;
+            }
+            v2[k2_offset] = x2;
+
+            if (x2 > n) {
+                k2end += 2;
+            } else if (y2 > m) {
+                k2start += 2;
+            } else if (!front) {
+                int k1_offset = v_offset + delta - k2;
+                if (k1_offset >= 0 && k1_offset < v_length && v1[k1_offset] != -1) {
+                    int x1 = v1[k1_offset];
+                    int y1 = v_offset + x1 - k1_offset;
+                    if (x1 >= n - x2) {
+                        split_a = a0 + x1;
+                        split_b = b0 + y1;
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+}
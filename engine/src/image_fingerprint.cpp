@@ -0,0 +1,136 @@
+#include <pdif/image_fingerprint.hpp>
+#include <pdif/logger.hpp>
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace pdif {
+
+uint64_t image_fingerprint::sum_u8(const unsigned char* data, size_t size) {
+    uint64_t total = 0;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // _mm_sad_epu8 against zero sums each 8 byte half into a 64 bit lane
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= size; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+    }
+
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    total = lanes[0] + lanes[1];
+#elif defined(__ARM_NEON)
+    // widen pairwise u8 -> u16 -> u32 and accumulate into u64 lanes
+    uint64x2_t acc = vdupq_n_u64(0);
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t v = vld1q_u8(data + i);
+        acc = vpadalq_u32(acc, vpaddlq_u16(vpaddlq_u8(v)));
+    }
+
+    total = vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+#endif
+
+    for (; i < size; i++) {
+        total += data[i];
+    }
+
+    return total;
+}
+
+std::vector<unsigned char> image_fingerprint::downscale(const unsigned char* pixels, int width, int height, int components, int grid_width, int grid_height) {
+    if (pixels == nullptr || width <= 0 || height <= 0 || grid_width <= 0 || grid_height <= 0) {
+        PDIF_LOG_ERROR("image_fingerprint::downscale - invalid image dimensions");
+        throw pdif::pdif_invalid_argment("image_fingerprint::downscale - invalid image dimensions");
+    }
+
+    if (components != 1 && components != 3 && components != 4) {
+        PDIF_LOG_ERROR("image_fingerprint::downscale - unsupported component count {}", components);
+        throw pdif::pdif_invalid_argment("image_fingerprint::downscale - unsupported component count " + std::to_string(components));
+    }
+
+    // convert to a single grayscale plane first so the box sums run over contiguous bytes
+    const unsigned char* gray = pixels;
+    std::vector<unsigned char> gray_buffer;
+    if (components != 1) {
+        size_t count = (size_t)width * (size_t)height;
+        gray_buffer.resize(count);
+        for (size_t p = 0; p < count; p++) {
+            const unsigned char* px = pixels + p * components;
+            unsigned int luma = (77u * px[0] + 150u * px[1] + 29u * px[2]) >> 8;
+            if (components == 4) {
+                // cmyk: ink reduces brightness
+                luma = 255u - std::min(255u, luma + px[3]);
+            }
+            gray_buffer[p] = (unsigned char)luma;
+        }
+        gray = gray_buffer.data();
+    }
+
+    std::vector<unsigned char> grid((size_t)grid_width * (size_t)grid_height);
+
+    for (int cy = 0; cy < grid_height; cy++) {
+        int y0 = std::min(cy * height / grid_height, height - 1);
+        int y1 = std::max((cy + 1) * height / grid_height, y0 + 1);
+
+        for (int cx = 0; cx < grid_width; cx++) {
+            int x0 = std::min(cx * width / grid_width, width - 1);
+            int x1 = std::max((cx + 1) * width / grid_width, x0 + 1);
+
+            uint64_t sum = 0;
+            for (int y = y0; y < y1; y++) {
+                sum += sum_u8(gray + (size_t)y * width + x0, x1 - x0);
+            }
+
+            uint64_t area = (uint64_t)(x1 - x0) * (uint64_t)(y1 - y0);
+            grid[(size_t)cy * grid_width + cx] = (unsigned char)(sum / area);
+        }
+    }
+
+    return grid;
+}
+
+uint64_t image_fingerprint::dhash(const unsigned char* pixels, int width, int height, int components) {
+    std::vector<unsigned char> grid = downscale(pixels, width, height, components, GRID_WIDTH, GRID_HEIGHT);
+
+    uint64_t hash = 0;
+    for (int y = 0; y < GRID_HEIGHT; y++) {
+        for (int x = 0; x < GRID_WIDTH - 1; x++) {
+            hash <<= 1;
+            if (grid[y * GRID_WIDTH + x] > grid[y * GRID_WIDTH + x + 1]) {
+                hash |= 1;
+            }
+        }
+    }
+
+    return hash;
+}
+
+int image_fingerprint::distance(uint64_t a, uint64_t b) {
+    return std::popcount(a ^ b);
+}
+
+uint8_t image_fingerprint::bucket(uint64_t fingerprint) {
+    // the fingerprint is 8 rows of 8 bits, most significant row first. Each quadrant is 4 rows of 4 bits
+    constexpr uint64_t LEFT = 0xF0F0F0F000000000ULL;
+
+    uint8_t b = 0;
+    for (int q = 0; q < 4; q++) {
+        uint64_t mask = LEFT >> ((q / 2) * 32 + (q % 2) * 4);
+        if (std::popcount(fingerprint & mask) > 8) {
+            b |= 1 << q;
+        }
+    }
+
+    return b;
+}
+
+} // namespace pdif
@@ -0,0 +1,383 @@
+#include <pdif/json_writer.hpp>
+#include <pdif/render.hpp>
+#include <pdif/hash_util.hpp>
+
+#include <charconv>
+
+namespace pdif {
+
+json_writer::json_writer(std::ostream& os, output_format format, size_t flush_threshold) : m_owned(std::make_unique<output_buffer>(os, flush_threshold)), m_out(m_owned.get()), m_format(format) {
+    begin_document();
+}
+
+json_writer::json_writer(output_buffer& out, output_format format) : m_out(&out), m_format(format) {
+    begin_document();
+}
+
+void json_writer::begin_document() {
+    if (m_format == output_format::text) {
+        PDIF_LOG_ERROR("json_writer::json_writer - text is not a json format");
+        throw pdif::pdif_invalid_argment("json_writer::json_writer - text is not a json format");
+    }
+
+    if (m_format == output_format::json) {
+        append("[");
+    }
+}
+
+json_writer::~json_writer() {
+    if (!m_finished) {
+        try {
+            finish();
+        } catch (const pdif::pdif_io_error&) {
+            // already logged, destructors do not throw
+        }
+    }
+}
+
+void json_writer::finish() {
+    if (m_finished) {
+        return;
+    }
+
+    if (m_format == output_format::json) {
+        append(m_first_record ? "]\n" : "\n]\n");
+    }
+
+    m_finished = true;
+    m_out->flush();
+}
+
+void json_writer::begin_record() {
+    if (m_finished) {
+        PDIF_LOG_ERROR("json_writer - write after finish");
+        throw pdif::pdif_invalid_operation("json_writer - write after finish");
+    }
+
+    if (m_format == output_format::json) {
+        append(m_first_record ? "\n" : ",\n");
+    }
+
+    m_first_record = false;
+}
+
+void json_writer::end_record() {
+    if (m_format == output_format::ndjson) {
+        append("\n");
+    }
+
+    m_out->commit();
+}
+
+void json_writer::append(std::string_view raw) {
+    m_out->buffer().append(raw);
+}
+
+void json_writer::append_string(std::string_view s) {
+    std::string& buffer = m_out->buffer();
+
+    buffer.push_back('"');
+
+    // copy runs of characters that need no escaping in one go
+    size_t run = 0;
+    for (size_t i = 0; i < s.size(); i++) {
+        unsigned char c = s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        buffer.append(s.data() + run, i - run);
+        run = i + 1;
+
+        switch (c) {
+            case '"': buffer.append("\\\""); break;
+            case '\\': buffer.append("\\\\"); break;
+            case '\n': buffer.append("\\n"); break;
+            case '\r': buffer.append("\\r"); break;
+            case '\t': buffer.append("\\t"); break;
+            case '\b': buffer.append("\\b"); break;
+            case '\f': buffer.append("\\f"); break;
+            default:
+                buffer.append("\\u00");
+                append_hex(buffer, c, 2);
+                break;
+        }
+    }
+    buffer.append(s.data() + run, s.size() - run);
+
+    buffer.push_back('"');
+}
+
+void json_writer::append_int(long long v) {
+    render_int(m_out->buffer(), v);
+}
+
+void json_writer::append_float(float v) {
+    char buf[32];
+    auto result = std::to_chars(buf, buf + sizeof(buf), v);
+    m_out->buffer().append(buf, result.ptr - buf);
+}
+
+void json_writer::append_elem(const rstream_elem& elem) {
+    switch (elem->type()) {
+        case stream_type::text:
+            append("{\"kind\":\"text\",\"text\":");
+            append_string(elem->as<text_elem>()->text());
+            break;
+        case stream_type::font_set: {
+            auto font = elem->as<font_elem>();
+            append("{\"kind\":\"font\",\"name\":");
+            append_string(font->font_name());
+            append(",\"size\":");
+            append_int(font->font_size());
+            break;
+        }
+        case stream_type::text_color_set: {
+            auto color = elem->as<text_color_elem>();
+            append("{\"kind\":\"text_color\",\"r\":");
+            append_float(color->red());
+            append(",\"g\":");
+            append_float(color->green());
+            append(",\"b\":");
+            append_float(color->blue());
+            break;
+        }
+        case stream_type::stroke_color_set: {
+            auto color = elem->as<stroke_color_elem>();
+            append("{\"kind\":\"stroke_color\",\"r\":");
+            append_float(color->red());
+            append(",\"g\":");
+            append_float(color->green());
+            append(",\"b\":");
+            append_float(color->blue());
+            break;
+        }
+        case stream_type::xobject_image: {
+            auto img = elem->as<xobject_img_elem>();
+            append("{\"kind\":\"image\",\"hash\":");
+            append_string(img->image_hash());
+            append(",\"width\":");
+            append_int(img->width());
+            append(",\"height\":");
+            append_int(img->height());
+            break;
+        }
+        case stream_type::annotation: {
+            auto annot = elem->as<annotation_elem>();
+            append("{\"kind\":\"annotation\",\"subtype\":");
+            append_string(annot->subtype());
+            append(",\"rect\":[");
+            for (size_t i = 0; i < annot->rect().size(); i++) {
+                if (i > 0) {
+                    append(",");
+                }
+                append_float(annot->rect()[i]);
+            }
+            append("],\"contents\":");
+            append_string(annot->contents());
+
+            // as a string, JSON numbers cannot hold 64 bits
+            std::string hash;
+            append_hex(hash, annot->dict_hash());
+            append(",\"hash\":");
+            append_string(hash);
+            break;
+        }
+        case stream_type::form_field: {
+            auto field = elem->as<form_field_elem>();
+            append("{\"kind\":\"form_field\",\"name\":");
+            append_string(field->name());
+            append(",\"field_type\":");
+            append_string(field->field_type());
+            append(",\"value\":");
+            append_string(field->value());
+            break;
+        }
+    }
+
+    append("}");
+}
+
+void json_writer::write_meta(const stream_meta& meta) {
+    for (auto& [key, value] : meta.get_metadata()) {
+        begin_record();
+        append("{\"type\":\"meta\",\"key\":");
+        append_string(key);
+        append(",\"value\":");
+        append_string(value);
+        append("}");
+        end_record();
+    }
+}
+
+void json_writer::write_stream(int page, const stream& s) {
+    for (size_t i = 0; i < s.size(); i++) {
+        begin_record();
+        append("{\"type\":\"elem\",\"page\":");
+        append_int(page);
+        append(",\"index\":");
+        append_int(i);
+        append(",\"elem\":");
+        append_elem(s[i]);
+        append("}");
+        end_record();
+    }
+}
+
+void json_writer::write_meta_edit_script(const diff& d) {
+    for (size_t i = 0; i < d.meta_edit_op_size(); i++) {
+        meta_edit_op op = d.get_meta_edit_op(i);
+
+        begin_record();
+        append("{\"type\":\"meta_change\",\"op\":");
+        switch (op.get_type()) {
+            case meta_edit_op_type::META_ADD:
+                append("\"add\"");
+                break;
+            case meta_edit_op_type::META_DELETE:
+                append("\"delete\"");
+                break;
+            case meta_edit_op_type::META_UPDATE:
+                append("\"update\"");
+                break;
+        }
+        append(",\"key\":");
+        append_string(op.get_meta_key());
+        if (op.has_meta_val()) {
+            append(",\"value\":");
+            append_string(op.get_meta_val());
+        }
+        append("}");
+        end_record();
+    }
+}
+
+void json_writer::write_edit_script(const diff& d) {
+    d.for_each_edit_hunk([&](const diff::edit_hunk& hunk) {
+        begin_record();
+        append("{\"type\":\"hunk\",\"from_start\":");
+        append_int(hunk.from_file_start);
+        append(",\"from_count\":");
+        append_int(hunk.from_count);
+        append(",\"to_start\":");
+        append_int(hunk.to_file_start);
+        append(",\"to_count\":");
+        append_int(hunk.to_count);
+        append(",\"lines\":[");
+
+        for (size_t i = 0; i < hunk.lines.size(); i++) {
+            if (i > 0) {
+                append(",");
+            }
+
+            switch (hunk.lines[i].type) {
+                case edit_op_type::EQ:
+                    append("{\"op\":\"eq\",\"elem\":");
+                    break;
+                case edit_op_type::INSERT:
+                    append("{\"op\":\"insert\",\"elem\":");
+                    break;
+                case edit_op_type::DELETE:
+                    append("{\"op\":\"delete\",\"elem\":");
+                    break;
+                case edit_op_type::MOVE_FROM:
+                    append("{\"op\":\"move_from\",\"move\":");
+                    append_int(hunk.lines[i].move);
+                    append(",\"elem\":");
+                    break;
+                case edit_op_type::MOVE_TO:
+                    append("{\"op\":\"move_to\",\"move\":");
+                    append_int(hunk.lines[i].move);
+                    append(",\"elem\":");
+                    break;
+            }
+            append_elem(hunk.lines[i].elem);
+            append("}");
+        }
+
+        append("]}");
+        end_record();
+    });
+}
+
+void json_writer::write_edit_summary(const diff& d) {
+    int plus, minus, eq, moved;
+    d.count_edit_op_types(plus, minus, eq, moved);
+
+    begin_record();
+    append("{\"type\":\"summary\",\"scope\":\"content\",\"insert\":");
+    append_int(plus);
+    append(",\"delete\":");
+    append_int(minus);
+    append(",\"eq\":");
+    append_int(eq);
+    append(",\"move\":");
+    append_int(moved);
+    append("}");
+    end_record();
+}
+
+void json_writer::write_meta_summary(const diff& d) {
+    int update, add, del;
+    d.count_meta_op_types(update, add, del);
+
+    begin_record();
+    append("{\"type\":\"summary\",\"scope\":\"meta\",\"insert\":");
+    append_int(add);
+    append(",\"delete\":");
+    append_int(del);
+    append(",\"update\":");
+    append_int(update);
+    append("}");
+    end_record();
+}
+
+void json_writer::write_stats(const stats& s) {
+    begin_record();
+    append("{\"type\":\"stats\",\"stages\":{");
+    for (size_t st = 0; st < stats::STAGE_COUNT; st++) {
+        if (st > 0) {
+            append(",");
+        }
+        append_string(stats::name((stats::stage)st));
+        append(":{\"ns\":");
+        append_int(s.stage_ns((stats::stage)st));
+        append(",\"calls\":");
+        append_int(s.stage_calls((stats::stage)st));
+        append("}");
+    }
+
+    append("},\"counters\":{");
+    for (size_t c = 0; c < stats::COUNTER_COUNT; c++) {
+        if (c > 0) {
+            append(",");
+        }
+        append_string(stats::name((stats::counter)c));
+        append(":");
+        append_int(s.count((stats::counter)c));
+    }
+
+    append("},\"pages\":[");
+    bool first = true;
+    for (const auto& [index, page] : s.pages()) {
+        append(first ? "{\"page\":" : ",{\"page\":");
+        first = false;
+
+        append_int(index + 1);
+        append(",\"extract_ns\":");
+        append_int(page.extract_ns);
+        append(",\"diff_ns\":");
+        append_int(page.diff_ns);
+        for (size_t c = 0; c < stats::COUNTER_COUNT; c++) {
+            append(",");
+            append_string(stats::name((stats::counter)c));
+            append(":");
+            append_int(page.counters[c]);
+        }
+        append("}");
+    }
+    append("]}");
+    end_record();
+}
+
+}
@@ -46,6 +46,8 @@ void lcs_stream_differ::diff(pdif::diff& diff) {
         }
     }
 
+    stats::add(stats::counter::dp_cells, (uint64_t)m * n);
+
     // Step 2: backtrace to find the LCS
     i = m;
     j = n;
@@ -3,16 +3,17 @@
 
 namespace pdif {
 
-util::ref<util::logger> pdif_logger::logger = nullptr;
-
 util::ref<util::logger> pdif_logger::instance() {
-    if (logger == nullptr) {
+    // function-local static: initialised exactly once even when the first
+    // log call happens on several extraction threads at the same time
+    static const util::ref<util::logger> logger = [] {
         // initialize logger
-        logger = util::create_ref<util::logger>();
+        auto l = util::create_ref<util::logger>();
 
         // add logger sinks
-        logger->addSink<util::logger_console_sink>("pdif_console");
-    }
+        l->addSink<util::logger_console_sink>("pdif_console");
+        return l;
+    }();
 
     return logger;
 }
@@ -0,0 +1,118 @@
+#include <pdif/minhash.hpp>
+#include <pdif/stream_elem.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace pdif {
+
+// splitmix64 finaliser, used to derive the seeded hash functions from one shingle hash
+static inline uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+static inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static inline char to_lower(char c) {
+    return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+minhash::signature minhash::empty() {
+    signature sig;
+    sig.fill(std::numeric_limits<uint32_t>::max());
+    return sig;
+}
+
+uint64_t minhash::hash_shingle(const std::vector<std::string>& words, size_t start, size_t count) {
+    // FNV-1a over the words, separated by a byte that cannot appear in a word
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = start; i < start + count; i++) {
+        for (unsigned char c : words[i]) {
+            h = (h ^ c) * 0x100000001b3ull;
+        }
+        h = (h ^ 0xff) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+void minhash::add_shingle(signature& sig, uint64_t shingle) {
+    for (size_t i = 0; i < SIGNATURE_SIZE; i++) {
+        uint32_t h = (uint32_t)mix(shingle + 0x9e3779b97f4a7c15ull * (i + 1));
+        sig[i] = std::min(sig[i], h);
+    }
+}
+
+minhash::signature minhash::sketch(stream_view s) {
+    // words are split from the text itself, so word and sentence streams give the same words
+    std::vector<std::string> words;
+    std::string word;
+    for (const rstream_elem& elem : s) {
+        if (elem->type() != stream_type::text) {
+            continue;
+        }
+
+        for (char c : elem->as<text_elem>()->text()) {
+            if (is_space(c)) {
+                if (!word.empty()) {
+                    words.push_back(std::move(word));
+                    word.clear();
+                }
+            } else {
+                word.push_back(to_lower(c));
+            }
+        }
+
+        // words never span elements (letter elements are shingled as one letter words)
+        if (!word.empty()) {
+            words.push_back(std::move(word));
+            word.clear();
+        }
+    }
+
+    signature sig = empty();
+    if (words.empty()) {
+        return sig;
+    }
+
+    size_t k = std::min(SHINGLE_SIZE, words.size());
+    for (size_t i = 0; i + k <= words.size(); i++) {
+        add_shingle(sig, hash_shingle(words, i, k));
+    }
+    return sig;
+}
+
+std::vector<minhash::signature> minhash::sketch_pages(const std::vector<stream>& pages) {
+    std::vector<signature> sigs;
+    sigs.reserve(pages.size());
+    for (const stream& page : pages) {
+        sigs.push_back(sketch(page));
+    }
+    return sigs;
+}
+
+minhash::signature minhash::combine(const std::vector<signature>& pages) {
+    signature sig = empty();
+    for (const signature& page : pages) {
+        for (size_t i = 0; i < SIGNATURE_SIZE; i++) {
+            sig[i] = std::min(sig[i], page[i]);
+        }
+    }
+    return sig;
+}
+
+double minhash::similarity(const signature& a, const signature& b) {
+    size_t equal = 0;
+    for (size_t i = 0; i < SIGNATURE_SIZE; i++) {
+        equal += a[i] == b[i];
+    }
+    return (double)equal / SIGNATURE_SIZE;
+}
+
+} // namespace pdif
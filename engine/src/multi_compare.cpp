@@ -0,0 +1,168 @@
+#include <pdif/multi_compare.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+namespace pdif {
+
+multi_compare::multi_compare(const std::string& base_path, page_differ_f differ, granularity g, bool write_console_colors, bool allow_state_set_nochange, int image_similarity)
+    : m_differ(differ), m_granularity(g), m_write_console_colors(write_console_colors), m_allow_state_set_nochange(allow_state_set_nochange), m_image_similarity(image_similarity) {
+    if (!m_differ) {
+        PDIF_LOG_ERROR("multi_compare::multi_compare - no page differ given");
+        throw pdif::pdif_invalid_argment("multi_compare::multi_compare - no page differ given");
+    }
+
+    stats::timer parse(stats::stage::parse);
+    auto pdf = QPDF::create();
+    pdf->processFile(base_path.c_str());
+    parse.stop();
+
+    m_meta = extract_meta(pdf);
+    m_pages = extract_content(pdf, m_granularity, scope::page, -1, m_allow_state_set_nochange, m_image_similarity);
+    m_hashes = compare_session::page_hashes(pdf);
+
+    m_fingerprints.reserve(m_pages.size());
+    for (const stream& page : m_pages) {
+        m_fingerprints.push_back(fingerprint(page));
+    }
+
+    m_unchanged_once = std::vector<std::once_flag>(m_pages.size());
+    m_unchanged.resize(m_pages.size());
+}
+
+uint64_t multi_compare::fingerprint(stream_view s) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (const rstream_elem& elem : s) {
+        h = (h ^ (uint64_t)elem->hash()) * 0x100000001b3ull;
+    }
+    return h ^ s.size();
+}
+
+bool multi_compare::same_page(size_t page, const stream& revised) const {
+    const stream& base = m_pages[page];
+    if (base.size() != revised.size() || m_fingerprints[page] != fingerprint(revised)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < base.size(); i++) {
+        if (!base[i]->compare(revised[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const pdif::diff& multi_compare::unchanged_page(size_t page) const {
+    std::call_once(m_unchanged_once[page], [&]() {
+        m_differ(m_unchanged[page], &m_pages[page], &m_pages[page]);
+    });
+    return m_unchanged[page];
+}
+
+pdif::diff multi_compare::compare(const std::string& revision_path) const {
+    stats::timer parse(stats::stage::parse);
+    auto pdf = QPDF::create();
+    pdf->processFile(revision_path.c_str());
+    parse.stop();
+
+    std::vector<std::string> hashes = compare_session::page_hashes(pdf);
+
+    size_t m = m_pages.size();
+    size_t n = hashes.size();
+
+    // pages with the same raw content as the base page extract to the base page, skip them
+    std::vector<int> changed;
+    for (size_t i = 0; i < n; i++) {
+        if (i >= m || hashes[i] != m_hashes[i]) {
+            changed.push_back(i);
+        }
+    }
+
+    std::vector<stream> extracted = extract_pages(pdf, changed, m_granularity, m_allow_state_set_nochange, m_image_similarity);
+
+    pdif::diff d(m_write_console_colors);
+    stream_differ_base::meta_diff(d, m_meta, extract_meta(pdf));
+
+    for (size_t i = 0, c = 0; i < std::max(m, n); i++) {
+        const stream* revised = nullptr;
+        bool unchanged = false;
+
+        if (c < changed.size() && (size_t)changed[c] == i) {
+            revised = &extracted[c++];
+            unchanged = i < m && same_page(i, *revised);
+        } else if (i < n) {
+            revised = &m_pages[i];
+            unchanged = true;
+        }
+
+        // an unchanged page diffs as the base page against itself
+        if (unchanged) {
+            const pdif::diff& page_diff = unchanged_page(i);
+            d.replace_edit_ops(d.edit_op_size(), 0, page_diff);
+            for (const stream& original : page_diff.original_streams()) {
+                d.add_original_stream(original);
+            }
+            continue;
+        }
+
+        m_differ(d, i < m ? &m_pages[i] : nullptr, revised);
+    }
+
+    return d;
+}
+
+std::vector<pdif::diff> multi_compare::compare(const std::vector<std::string>& revision_paths, unsigned threads) const {
+    std::vector<pdif::diff> diffs(revision_paths.size());
+    std::vector<std::exception_ptr> errors(revision_paths.size());
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min<size_t>(threads, revision_paths.size());
+
+    // workers collect their own stats, merged into the caller's once they are done
+    stats* collector = stats::current();
+    std::vector<stats> worker_stats(std::max(1u, threads));
+
+    // each worker takes the next revision until none are left
+    std::atomic<size_t> next = 0;
+    auto worker = [&](unsigned t) {
+        stats::collect collect(collector != nullptr ? &worker_stats[t] : nullptr);
+
+        for (size_t i = next++; i < revision_paths.size(); i = next++) {
+            try {
+                diffs[i] = compare(revision_paths[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+
+    for (std::thread& t : pool) {
+        t.join();
+    }
+
+    if (collector != nullptr) {
+        for (const stats& ws : worker_stats) {
+            collector->merge(ws);
+        }
+    }
+
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    return diffs;
+}
+
+}
@@ -0,0 +1,93 @@
+#include <pdif/output_buffer.hpp>
+#include <pdif/logger.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+namespace pdif {
+
+output_buffer::output_buffer(std::ostream& os, size_t capacity) : m_os(&os), m_capacity(capacity) {
+}
+
+output_buffer::output_buffer(int fd, size_t capacity) : m_fd(fd), m_capacity(capacity) {
+}
+
+output_buffer::~output_buffer() {
+    try {
+        flush();
+    } catch (const pdif::pdif_io_error&) {
+        // already logged, destructors do not throw
+    }
+}
+
+void output_buffer::append(std::string_view s) {
+    if (m_buffer.size() + s.size() < m_capacity) {
+        m_buffer.append(s);
+        return;
+    }
+
+    // large text is written together with the pending buffer, without copying it in
+    write_out(m_buffer, s);
+    m_buffer.clear();
+}
+
+void output_buffer::flush() {
+    if (!m_buffer.empty()) {
+        write_out(m_buffer, {});
+        m_buffer.clear();
+    }
+
+    if (m_os != nullptr) {
+        m_os->flush();
+    }
+}
+
+void output_buffer::write_out(std::string_view first, std::string_view second) {
+    if (m_os != nullptr) {
+        m_os->write(first.data(), first.size());
+        m_os->write(second.data(), second.size());
+
+        if (!m_os->good()) {
+            PDIF_LOG_ERROR("output_buffer::write_out - failed writing to the output stream");
+            throw pdif::pdif_io_error("output_buffer::write_out - failed writing to the output stream");
+        }
+        return;
+    }
+
+    while (!first.empty() || !second.empty()) {
+#if !defined(_WIN32)
+        struct iovec iov[2] = {
+            {const_cast<char*>(first.data()), first.size()},
+            {const_cast<char*>(second.data()), second.size()},
+        };
+        ssize_t written = first.empty() ? ::write(m_fd, second.data(), second.size()) : ::writev(m_fd, iov, second.empty() ? 1 : 2);
+#else
+        std::string_view& part = first.empty() ? second : first;
+        long written = ::_write(m_fd, part.data(), (unsigned int)part.size());
+#endif
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            PDIF_LOG_ERROR("output_buffer::write_out - failed writing to fd {}: {}", m_fd, std::strerror(errno));
+            throw pdif::pdif_io_error("output_buffer::write_out - failed writing to fd " + std::to_string(m_fd) + ": " + std::strerror(errno));
+        }
+
+        // advance past what was written, which may end part way through either view
+        size_t n = written;
+        size_t from_first = std::min(n, first.size());
+        first.remove_prefix(from_first);
+        second.remove_prefix(n - from_first);
+    }
+}
+
+}
@@ -0,0 +1,254 @@
+#include <pdif/page_visitor.hpp>
+#include <pdif/hash_util.hpp>
+
+#include <map>
+#include <set>
+
+namespace pdif {
+
+namespace {
+
+// a field tree deeper than this is taken to be cyclic
+constexpr int MAX_FIELD_DEPTH = 32;
+
+// a name without its leading /, or "" for anything else
+std::string name_of(QPDFObjectHandle obj) {
+    if (!obj.isName()) {
+        return "";
+    }
+
+    std::string name = obj.getName();
+    return name.empty() ? name : name.substr(1);
+}
+
+// FNV-1a, with every value length or type prefixed so different structures cannot hash the same bytes
+struct structural_hasher {
+    std::map<QPDFObjGen, uint64_t> memo;
+
+    static void update(uint64_t& h, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            h = (h ^ bytes[i]) * 0x100000001b3ull;
+        }
+    }
+
+    static void update(uint64_t& h, char tag, const std::string& value) {
+        uint64_t size = value.size();
+        update(h, &tag, 1);
+        update(h, &size, sizeof(size));
+        update(h, value.data(), value.size());
+    }
+
+    uint64_t hash(QPDFObjectHandle obj) {
+        if (!obj.isIndirect()) {
+            return hash_direct(obj);
+        }
+
+        // a page is referenced by destinations and actions, its content is not part of the referrer
+        if (obj.isPageObject()) {
+            return hash_page_reference(obj);
+        }
+
+        // the placeholder cuts cycles
+        QPDFObjGen og = obj.getObjGen();
+        auto it = memo.find(og);
+        if (it == memo.end()) {
+            memo[og] = 0;
+            it = memo.insert_or_assign(og, hash_direct(obj)).first;
+        }
+        return it->second;
+    }
+
+    static uint64_t hash_page_reference(QPDFObjectHandle page) {
+        uint64_t h = 0xcbf29ce484222325ull;
+
+        // the page index, or the object id of a page outside the page tree
+        std::string reference;
+        QPDF* pdf = page.getOwningQPDF();
+        if (pdf != nullptr) {
+            try {
+                reference = std::to_string(pdf->findPage(page));
+            } catch (std::exception const&) {
+                reference.clear();
+            }
+        }
+        if (reference.empty()) {
+            reference = page.unparse();
+        }
+
+        update(h, 'p', reference);
+        return h;
+    }
+
+    uint64_t hash_direct(QPDFObjectHandle obj) {
+        uint64_t h = 0xcbf29ce484222325ull;
+
+        if (obj.isStream()) {
+            uint64_t dict = hash(obj.getDict());
+            update(h, 's', "");
+            update(h, &dict, sizeof(dict));
+
+            auto data = obj.getRawStreamData();
+            if (data) {
+                update(h, data->getBuffer(), data->getSize());
+            }
+        } else if (obj.isDictionary()) {
+            update(h, 'd', "");
+            for (auto& [key, value] : obj.ditems()) {
+                if (key == "/P" || key == "/Parent" || key == "/Popup" || key == "/AP" || key == "/M") {
+                    continue;
+                }
+
+                uint64_t v = hash(value);
+                update(h, 'k', key);
+                update(h, &v, sizeof(v));
+            }
+        } else if (obj.isArray()) {
+            update(h, 'a', "");
+            for (auto& item : obj.aitems()) {
+                uint64_t v = hash(item);
+                update(h, &v, sizeof(v));
+            }
+        } else if (obj.isString()) {
+            update(h, 't', obj.getStringValue());
+        } else if (obj.isName()) {
+            update(h, 'n', obj.getName());
+        } else {
+            // numbers, booleans and null
+            update(h, 'v', obj.unparse());
+        }
+
+        return h;
+    }
+};
+
+}
+
+page_visitor::page_visitor(granularity g, bool allow_state_set_nochange, int image_similarity)
+    : m_granularity(g), m_allow_state_set_nochange(allow_state_set_nochange), m_image_similarity(image_similarity) {}
+
+void page_visitor::visit(QPDFPageObjectHelper& page, stream& out) {
+    stats::timer timer(stats::stage::extract);
+    size_t elements = out.size();
+
+    pdf_content_stream_filter tf(out, m_granularity, page.getObjectHandle());
+    tf.setStateSetNoChange(m_allow_state_set_nochange);
+    tf.setImageCache(&m_images);
+    tf.setImageSimilarity(m_image_similarity);
+    tf.setFormCache(&m_forms);
+
+    page.filterContents(&tf);
+
+    visit_annotations(page.getObjectHandle(), out);
+
+    stats::add(stats::counter::elements, out.size() - elements);
+}
+
+uint64_t page_visitor::structural_hash(QPDFObjectHandle obj) {
+    structural_hasher hasher;
+    return hasher.hash(obj);
+}
+
+void page_visitor::visit_annotations(QPDFObjectHandle page, stream& out) {
+    QPDFObjectHandle annots = page.getKey("/Annots");
+    if (!annots.isArray()) {
+        return;
+    }
+
+    std::set<std::string> fields;
+    for (auto& annot : annots.aitems()) {
+        if (!annot.isDictionary()) {
+            continue;
+        }
+
+        std::string subtype = name_of(annot.getKey("/Subtype"));
+        if (subtype == "Popup") {
+            continue;
+        }
+
+        if (subtype == "Widget") {
+            std::string name = field_name(annot);
+            if (!fields.insert(name).second) {
+                continue;
+            }
+
+            std::string field_type = name_of(inherited(annot, "/FT"));
+            out.push_back(stream_elem::create<form_field_elem>(name, field_type, field_value(inherited(annot, "/V"))));
+            continue;
+        }
+
+        std::array<float, 4> rect = {0, 0, 0, 0};
+        QPDFObjectHandle rect_obj = annot.getKey("/Rect");
+        if (rect_obj.isArray() && rect_obj.getArrayNItems() == 4) {
+            for (int i = 0; i < 4; i++) {
+                QPDFObjectHandle v = rect_obj.getArrayItem(i);
+                rect[i] = v.isNumber() ? (float)v.getNumericValue() : 0;
+            }
+
+            // any two opposite corners may be given
+            if (rect[0] > rect[2]) {
+                std::swap(rect[0], rect[2]);
+            }
+            if (rect[1] > rect[3]) {
+                std::swap(rect[1], rect[3]);
+            }
+        }
+
+        QPDFObjectHandle contents = annot.getKey("/Contents");
+        out.push_back(stream_elem::create<annotation_elem>(subtype, rect, contents.isString() ? contents.getUTF8Value() : "", structural_hash(annot)));
+    }
+}
+
+QPDFObjectHandle page_visitor::inherited(QPDFObjectHandle field, const std::string& key) {
+    for (int depth = 0; depth < MAX_FIELD_DEPTH && field.isDictionary(); depth++) {
+        if (field.hasKey(key)) {
+            return field.getKey(key);
+        }
+        field = field.getKey("/Parent");
+    }
+    return QPDFObjectHandle();
+}
+
+std::string page_visitor::field_name(QPDFObjectHandle field) {
+    std::string name;
+    for (int depth = 0; depth < MAX_FIELD_DEPTH && field.isDictionary(); depth++) {
+        QPDFObjectHandle partial = field.getKey("/T");
+        if (partial.isString()) {
+            name = name.empty() ? partial.getUTF8Value() : partial.getUTF8Value() + "." + name;
+        }
+        field = field.getKey("/Parent");
+    }
+    return name;
+}
+
+std::string page_visitor::field_value(QPDFObjectHandle value) {
+    if (value.isString()) {
+        return value.getUTF8Value();
+    }
+    if (value.isName()) {
+        return name_of(value);
+    }
+    if (value.isArray()) {
+        // the selected options of a multiple selection choice field
+        std::string joined;
+        for (auto& item : value.aitems()) {
+            if (!joined.empty()) {
+                joined.append(", ");
+            }
+            joined.append(field_value(item));
+        }
+        return joined;
+    }
+    if (value.isDictionary() || value.isStream()) {
+        // signature values, identified by their hash
+        std::string hash;
+        append_hex(hash, structural_hash(value));
+        return hash;
+    }
+    if (value.isNull()) {
+        return "";
+    }
+    return value.unparse();
+}
+
+}
@@ -1,74 +1,128 @@
 #include <pdif/pdf.hpp>
+#include <pdif/compare_cache.hpp>
+
+#include <filesystem>
 
 namespace pdif {
 
-PDF::PDF(const std::string& path, granularity g, scope s, bool write_console_colors, int pageno, bool allow_state_set_nochange) : m_extractor_granularity(g), m_pdf_scope(s), m_write_console_colors(write_console_colors), m_pageno(pageno) {
-    m_pdf = QPDF::create();
+PDF::PDF(const std::string& path, granularity g, scope s, bool write_console_colors, int pageno, bool allow_state_set_nochange, int image_similarity, std::optional<std::string> extraction_cache_path, unsigned threads) : m_extractor_granularity(g), m_pdf_scope(s), m_write_console_colors(write_console_colors), m_pageno(pageno), m_path(path) {
+    m_extraction_options = {g, s, pageno, allow_state_set_nochange, image_similarity};
+
+    if (extraction_cache_path.has_value() && std::filesystem::exists(extraction_cache_path.value())) {
+        try {
+            extraction_cache cache(extraction_cache_path.value());
+            if (cache.matches(compare_cache::file_hash(path), m_extraction_options)) {
+                m_meta = cache.load_meta();
+                m_streams = cache.load_streams();
+                m_from_extraction_cache = true;
+                return;
+            }
+
+            PDIF_LOG_INFO("PDF::PDF - extraction cache {} is stale, parsing {}", extraction_cache_path.value(), path);
+        } catch (const pdif::pdif_invalid_format& e) {
+            PDIF_LOG_WARN("PDF::PDF - ignoring extraction cache {}: {}", extraction_cache_path.value(), e.what());
+        }
+    }
 
-    m_pdf->processFile(path.c_str());
+    {
+        stats::timer timer(stats::stage::parse);
+        m_pdf = QPDF::create();
+        m_pdf->processFile(path.c_str());
+    }
 
     m_meta = extract_meta(m_pdf);
-    m_streams = extract_content(m_pdf, m_extractor_granularity, m_pdf_scope, m_pageno, allow_state_set_nochange);
+    if (threads == 1) {
+        m_streams = extract_content(m_pdf, m_extractor_granularity, m_pdf_scope, m_pageno, allow_state_set_nochange, image_similarity);
+    } else {
+        m_streams = extract_content_parallel(m_pdf, path, m_extractor_granularity, m_pdf_scope, m_pageno, allow_state_set_nochange, image_similarity, threads);
+    }
+}
+
+void PDF::write_extraction_cache(std::optional<std::string> path) const {
+    extraction_cache::write(path.value_or(extraction_cache::default_path(m_path)), compare_cache::file_hash(m_path), m_extraction_options, m_meta, m_streams);
 }
 
-std::string PDF::cc(util::CONSOLE_COLOR_CODE code) const {
+std::string_view PDF::cc(util::CONSOLE_COLOR_CODE code) const {
     if (m_write_console_colors) {
-        std::stringstream ss;
-        ss << code;
-        return ss.str();
+        return console_color(code);
     }
 
     return "";
 }
 
 void PDF::dump_meta(std::ostream& t_out) const {
-    t_out << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "Meta:" << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET) << std::endl;
-    t_out << std::endl;
+    output_buffer out(t_out);
+    dump_meta(out);
+    out.flush();
+}
+
+void PDF::dump_meta(output_buffer& t_out) const {
+    t_out << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "Meta:" << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET) << '\n';
+    t_out << '\n';
 
     for (auto& [key, value] : m_meta.get_metadata()) {
-        t_out << key << ": " << value << std::endl;
+        t_out << key << ": " << value << '\n';
     }
 
-    t_out << std::endl;
-    t_out << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "== Meta Finished ==" << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET) << std::endl;
+    t_out << '\n';
+    t_out << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "== Meta Finished ==" << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET) << '\n';
 }
 
 void PDF::dump_content(std::ostream& t_out, std::optional<std::string> spacing) const {
+    output_buffer out(t_out);
+    dump_content(out, spacing);
+    out.flush();
+}
+
+void PDF::dump_content(output_buffer& t_out, std::optional<std::string> spacing) const {
+    // elements are rendered straight into the output buffer
+    std::string& buffer = t_out.buffer();
+
     for (size_t y = 0; y < m_streams.size(); y++) {
-        if (m_pageno >= 0) {
-            t_out << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "Page " << m_pageno + 1<< ":";
-        } else {
-            t_out << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "Page " << y + 1 << ":";
-        }
+        render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_BOLD, m_write_console_colors);
+        buffer.append("Page ");
+        render_int(buffer, m_pageno >= 0 ? m_pageno + 1 : y + 1);
+        buffer.push_back(':');
+        render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_RESET, m_write_console_colors);
+        buffer.append("\n\n");
 
-        t_out << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET) << std::endl;
-        t_out << std::endl;
-        auto stream = m_streams[y];
+        const stream& stream = m_streams[y];
         for (size_t i = 0; i < stream.size(); i++) {
-            t_out << stream[i]->to_string(m_write_console_colors);
+            stream[i]->render_to(buffer, m_write_console_colors);
 
             if (spacing.has_value()) {
-                t_out << spacing.value();
+                buffer.append(spacing.value());
             } else {
                 switch (m_extractor_granularity) {
                     case granularity::letter:
                         break;
                     case granularity::sentence:
-                        t_out << " ";
+                        buffer.push_back(' ');
                         break;
                     case granularity::word:
-                        t_out << " ";
+                        buffer.push_back(' ');
                         break;
                 }
             }
+
+            t_out.commit();
         }
-        t_out << std::endl;
-        if (m_pageno >= 0) {
-            t_out << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "== Page " << m_pageno + 1 << " Finished ==";
-        } else {
-            t_out << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD) << "== Page " << y + 1 << " Finished ==";
-        }
-        t_out << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET) << std::endl;
+        buffer.push_back('\n');
+
+        render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_BOLD, m_write_console_colors);
+        buffer.append("== Page ");
+        render_int(buffer, m_pageno >= 0 ? m_pageno + 1 : y + 1);
+        buffer.append(" Finished ==");
+        render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_RESET, m_write_console_colors);
+        buffer.push_back('\n');
+
+        t_out.commit();
+    }
+}
+
+void PDF::dump_content(json_writer& writer) const {
+    for (size_t y = 0; y < m_streams.size(); y++) {
+        writer.write_stream(m_pageno >= 0 ? m_pageno + 1 : y + 1, m_streams[y]);
     }
 }
 
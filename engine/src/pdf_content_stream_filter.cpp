@@ -1,6 +1,9 @@
 #include <pdif/pdf_content_stream_filter.hpp>
-#include <openssl/sha.h>
+#include <pdif/image_fingerprint.hpp>
+#include <pdif/hash_util.hpp>
 #include <iomanip>
+#include <algorithm>
+#include <charconv>
 #include <qpdf/QUtil.hh>
 
 namespace pdif {
@@ -60,8 +63,25 @@ std::string pdf_content_stream_filter::arg_visitor::operator()(std::vector<QPDFT
 }
 
 void pdf_content_stream_filter::handleToken(QPDFTokenizer::Token const& token) {
+    m_tokens++;
+
     auto type = token.getType();
-    if (type == QPDFTokenizer::tt_word) {
+    if (m_in_inline_dict) {
+        // the inline image dictionary is collected whole, as its values can be arrays and dictionaries
+        if (type == QPDFTokenizer::tt_word && token.getValue() == "ID") {
+            m_in_inline_dict = false;
+            handleInlineImageDict();
+            m_inline_dict.clear();
+        } else if (type != QPDFTokenizer::tt_space && type != QPDFTokenizer::tt_comment) {
+            m_inline_dict.push_back(token);
+        }
+        return;
+    }
+
+    if (type == QPDFTokenizer::tt_inline_image) {
+        // inline image data is hashed directly from the token, never copied onto the arg stack
+        handleInlineImage(token);
+    } else if (type == QPDFTokenizer::tt_word) {
         handleOperator(token);
         m_arg_stack.clear();
     } else if (
@@ -69,8 +89,7 @@ void pdf_content_stream_filter::handleToken(QPDFTokenizer::Token const& token) {
         type == QPDFTokenizer::tt_integer ||
         type == QPDFTokenizer::tt_real ||
         type == QPDFTokenizer::tt_name ||
-        type == QPDFTokenizer::tt_bool ||
-        type ==QPDFTokenizer::tt_inline_image
+        type == QPDFTokenizer::tt_bool
     ) {
         if (m_state.in_array) {
             try {
@@ -117,72 +136,56 @@ void pdf_content_stream_filter::handleOperator(QPDFTokenizer::Token const& token
         handleXObject();
     }
 
-    // TODO: Handel inline image (BI, ID, EI)
-    // OR: use QPDF to convert inline images to XObjects
+    // the tokens up to ID are the inline image dictionary, see handleToken
+    if (token.getValue() == "BI") {
+        flushStringBuffer();
+        m_in_inline_dict = true;
+    }
 }
 
 void pdf_content_stream_filter::handleStringWrite() {
-    if (!m_string_buffer.empty()) {
-        m_string_buffer.push_back(' ');
-    }
-
+    m_text.clear();
     for (auto& arg : m_arg_stack) {
         arg_visitor visitor;
         visitor.current_font = m_state.current_font;
 
-        std::string val = std::visit(visitor, arg);
-        m_string_buffer.append(val);
+        m_text.append(std::visit(visitor, arg));
     }
 
-    switch (m_g) {
-        case granularity::letter:
-            for (auto c : m_string_buffer) {
-                if (c == ' ') {
-                    continue;
-                }
+    if (m_g == granularity::letter) {
+        m_segmenter.push(m_text, [this](std::string_view segment) {
+            m_stream.push_back(letterElem(segment));
+        });
+        return;
+    }
 
-                std::string s;
-                s.push_back(c);
-                m_stream.push_back(stream_elem::create<text_elem>(s));
-                m_string_buffer.clear();
-            }
-            break;
-        case granularity::word: {
-            std::istringstream iss(m_string_buffer);
-            std::string word;
-            while (iss >> word) {
-                m_stream.push_back(stream_elem::create<text_elem>(word));
-            }
-            m_string_buffer.clear();
-            break;
+    m_segmenter.push(m_text, [this](std::string_view segment) {
+        m_stream.push_back(stream_elem::create<text_elem>(std::string(segment)));
+    });
+}
+
+pdif::rstream_elem pdf_content_stream_filter::letterElem(std::string_view letter) {
+    if (letter.size() == 1 && static_cast<unsigned char>(letter[0]) < m_ascii_letters.size()) {
+        auto& elem = m_ascii_letters[static_cast<unsigned char>(letter[0])];
+        if (!elem) {
+            elem = stream_elem::create<text_elem>(std::string(letter));
         }
-        case granularity::sentence: {
-            size_t fullstop_pos = m_string_buffer.find('.');
-            while (fullstop_pos != std::string::npos) {
-                std::string sentence = m_string_buffer.substr(0, fullstop_pos + 1);
-                m_stream.push_back(stream_elem::create<text_elem>(sentence));
-                m_string_buffer.erase(0, fullstop_pos + 1);
-                if (m_string_buffer.empty()) {
-                    break;
-                }
 
-                if (m_string_buffer[0] == ' ') {
-                    m_string_buffer.erase(0, 1);
-                }
+        return elem;
+    }
 
-                fullstop_pos = m_string_buffer.find('.');
-            }
-            break;
-        }
+    auto [it, inserted] = m_letters.try_emplace(std::string(letter));
+    if (inserted) {
+        it->second = stream_elem::create<text_elem>(it->first);
     }
+
+    return it->second;
 }
 
 void pdf_content_stream_filter::flushStringBuffer() {
-    // flush the string buffer if it's not empty
-    if (m_string_buffer.size() > 0) {
-        m_stream.push_back(stream_elem::create<text_elem>(m_string_buffer));
-        m_string_buffer.clear();
-    }
+    m_segmenter.flush([this](std::string_view segment) {
+        m_stream.push_back(stream_elem::create<text_elem>(std::string(segment)));
+    });
 }
 
 void pdf_content_stream_filter::setStateElem(pdif::rstream_elem elem) {
@@ -262,6 +265,8 @@ void pdf_content_stream_filter::handleFontChange() {
     setStateElem(f);
     
 
+    stats::timer timer(stats::stage::fonts);
+
     // now that the state is set, we can extract the ToUnicode stream
     if (font_obj.hasKey("/ToUnicode")) {
         QPDFObjectHandle to_unicode_obj = font_obj.getKey("/ToUnicode");
@@ -332,35 +337,349 @@ void pdf_content_stream_filter::handleXObject() {
     QPDFObjectHandle resources = m_root.getKey("/Resources");
     QPDFObjectHandle xobject = resources.getKey("/XObject");
     QPDFObjectHandle xobject_obj = xobject.getKey(xobject_name);
-    QPDFObjectHandle xobject_dict = xobject_obj.getDict();
 
     if (!xobject_obj.isStream()) {
         throw std::runtime_error("XObject not found");
     }
 
+    QPDFObjectHandle subtype = xobject_obj.getDict().getKey("/Subtype");
+
+    if (subtype.isName() && subtype.getName() == "/Form") {
+        handleFormXObject(xobject_obj);
+    } else if (subtype.isName() && subtype.getName() == "/Image") {
+        handleImageXObject(xobject_obj);
+    } else if (xobject_obj.getDict().hasKey("/Width")) {
+        // no (or unknown) subtype, but shaped like an image
+        handleImageXObject(xobject_obj);
+    } else {
+        PDIF_LOG_WARN("Skipping unsupported XObject {}", xobject_name);
+    }
+}
+
+void pdf_content_stream_filter::handleImageXObject(QPDFObjectHandle xobject_obj) {
+    QPDFObjectHandle xobject_dict = xobject_obj.getDict();
+
+    // images used on several pages are only hashed once per document
+    if (m_image_cache != nullptr) {
+        auto cached = m_image_cache->by_object.find(xobject_obj.getObjGen());
+        if (cached != m_image_cache->by_object.end()) {
+            m_stream.push_back(cached->second);
+            return;
+        }
+    }
+
+    stats::timer timer(stats::stage::images);
     auto stream_data = xobject_obj.getRawStreamData();
 
     std::string image_hash = imageToHash(stream_data->getBuffer(), stream_data->getSize());
     int width = xobject_dict.getKey("/Width").getIntValue();
     int height = xobject_dict.getKey("/Height").getIntValue();
 
-    m_stream.push_back(stream_elem::create<xobject_img_elem>(image_hash, width, height));
+    rxobject_img_elem img = stream_elem::create<xobject_img_elem>(image_hash, width, height)->as<xobject_img_elem>();
+
+    if (m_image_similarity >= 0) {
+        img->set_similarity_threshold(m_image_similarity);
+        std::optional<uint64_t> fingerprint = imageToFingerprint(xobject_obj, width, height);
+        if (fingerprint.has_value()) {
+            img->set_fingerprint(fingerprint.value());
+        }
+    }
+
+    if (m_image_cache != nullptr) {
+        m_image_cache->by_object.emplace(xobject_obj.getObjGen(), img);
+    }
+
+    m_stream.push_back(img);
 }
 
-std::string pdf_content_stream_filter::imageToHash(const unsigned char* data, size_t size) {
-    unsigned char hash[SHA_DIGEST_LENGTH];
+void pdf_content_stream_filter::handleFormXObject(QPDFObjectHandle xobject_obj) {
+    if (std::find(m_form_stack.begin(), m_form_stack.end(), xobject_obj.getObjGen()) != m_form_stack.end()) {
+        PDIF_LOG_WARN("Form XObject draws itself, skipping form");
+        return;
+    }
+
+    if (m_form_depth >= MAX_FORM_DEPTH) {
+        PDIF_LOG_WARN("Form XObject nesting too deep, skipping form");
+        return;
+    }
 
-    SHA1(data, size, hash);
+    // a form without its own resources uses the resources of the page or form it is drawn on
+    QPDFObjGen resources_owner = xobject_obj.getDict().hasKey("/Resources") ? xobject_obj.getObjGen() : m_resources_owner;
+
+    stream uncached;
+    const stream* form = &uncached;
+
+    // forms used on several pages are only tokenized once per document
+    if (m_form_cache != nullptr) {
+        form_key key{xobject_obj.getObjGen(), resources_owner, ""};
+        for (const auto& elem : {
+            m_state.current_font.has_value() ? rstream_elem(m_state.current_font.value()) : nullptr,
+            m_state.current_text_color.has_value() ? rstream_elem(m_state.current_text_color.value()) : nullptr,
+            m_state.current_stroke_color.has_value() ? rstream_elem(m_state.current_stroke_color.value()) : nullptr,
+        }) {
+            if (elem) {
+                elem->render_to(key.inherited_state, false);
+            }
+            key.inherited_state.push_back('\n');
+        }
 
-    std::stringstream ss;
-    for (int i = 0; i < SHA_DIGEST_LENGTH; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
+        auto cached = m_form_cache->find(key);
+        if (cached == m_form_cache->end()) {
+            cached = m_form_cache->emplace(std::move(key), extractForm(xobject_obj, resources_owner)).first;
+        }
+        form = &cached->second;
+    } else {
+        uncached = extractForm(xobject_obj, resources_owner);
     }
 
-    return ss.str();
+    // the form runs inside its own graphics state, so the page state is restored afterwards
+    state saved = m_state;
+
+    for (size_t i = 0; i < form->size(); i++) {
+        const rstream_elem& elem = (*form)[i];
+        switch (elem->type()) {
+            case stream_type::font_set:
+            case stream_type::text_color_set:
+            case stream_type::stroke_color_set:
+                setStateElem(elem);
+                break;
+            default:
+                m_stream.push_back(elem);
+                break;
+        }
+    }
+
+    // the text after the form is drawn with the page's font and colours again
+    restoreStateElem(saved.current_font, m_state.current_font);
+    restoreStateElem(saved.current_text_color, m_state.current_text_color);
+    restoreStateElem(saved.current_stroke_color, m_state.current_stroke_color);
+
+    m_state = saved;
+}
+
+template<typename T>
+void pdf_content_stream_filter::restoreStateElem(const std::optional<util::ref<T>>& saved, const std::optional<util::ref<T>>& current) {
+    if (!saved.has_value()) {
+        return;
+    }
+
+    if (!current.has_value() || !saved.value()->compare(current.value())) {
+        setStateElem(saved.value());
+    }
+}
+
+stream pdf_content_stream_filter::extractForm(QPDFObjectHandle xobject_obj, QPDFObjGen resources_owner) {
+    stream form;
+
+    QPDFObjectHandle root = xobject_obj.getDict();
+    if (!root.hasKey("/Resources")) {
+        root = m_root;
+    }
+
+    pdf_content_stream_filter tf(form, m_g, root);
+    tf.setStateSetNoChange(m_allow_state_set_nochange);
+    tf.setImageCache(m_image_cache);
+    tf.setImageSimilarity(m_image_similarity);
+    tf.setFormCache(m_form_cache);
+    tf.m_resources_owner = resources_owner;
+    tf.m_form_depth = m_form_depth + 1;
+    tf.m_form_stack = m_form_stack;
+    tf.m_form_stack.push_back(xobject_obj.getObjGen());
+
+    // the form inherits the graphics state it is drawn with, e.g. a font set by the page
+    tf.m_state.current_font = m_state.current_font;
+    tf.m_state.current_text_color = m_state.current_text_color;
+    tf.m_state.current_stroke_color = m_state.current_stroke_color;
+
+    xobject_obj.filterAsContents(&tf);
+
+    return form;
+}
+
+std::optional<uint64_t> pdf_content_stream_filter::imageToFingerprint(QPDFObjectHandle image, int width, int height) {
+    QPDFObjectHandle dict = image.getDict();
+    QPDFObjectHandle bpc = dict.getKey("/BitsPerComponent");
+
+    if (!bpc.isInteger() || bpc.getIntValue() != 8 || width <= 0 || height <= 0) {
+        return std::nullopt;
+    }
+
+    // fully decode (including DCT) to raw samples
+    std::shared_ptr<Buffer> data;
+    try {
+        data = image.getStreamData(qpdf_dl_all);
+    } catch (std::exception const& e) {
+        PDIF_LOG_WARN("Cannot decode image for fingerprinting: {}", e.what());
+        return std::nullopt;
+    }
+
+    size_t pixels = (size_t)width * (size_t)height;
+    if (data == nullptr || data->getSize() == 0 || data->getSize() % pixels != 0) {
+        return std::nullopt;
+    }
+
+    int components = data->getSize() / pixels;
+    if (components != 1 && components != 3 && components != 4) {
+        return std::nullopt;
+    }
+
+    return image_fingerprint::dhash(data->getBuffer(), width, height, components);
+}
+
+void pdf_content_stream_filter::handleInlineImageDict() {
+    std::optional<inline_image_params> params = parseInlineImageDict(m_inline_dict);
+    if (!params.has_value()) {
+        m_state.skip_inline_image = true;
+        return;
+    }
+
+    m_state.inline_image = params;
+}
+
+std::optional<pdf_content_stream_filter::inline_image_params> pdf_content_stream_filter::parseInlineImageDict(const std::vector<QPDFTokenizer::Token>& tokens) {
+    inline_image_params params;
+
+    auto int_value = [](const QPDFTokenizer::Token& token, int& out) {
+        if (token.getType() != QPDFTokenizer::tt_integer) {
+            return false;
+        }
+        const std::string& value = token.getValue();
+        auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), out);
+        return ec == std::errc() && end == value.data() + value.size() && out >= 0;
+    };
+
+    size_t i = 0;
+    while (i < tokens.size()) {
+        if (tokens[i].getType() != QPDFTokenizer::tt_name) {
+            PDIF_LOG_WARN("Skipping malformed inline image - expected a name key but got {}", tokens[i].getValue());
+            return std::nullopt;
+        }
+        std::string key = tokens[i].getValue();
+        i++;
+
+        if (i >= tokens.size()) {
+            PDIF_LOG_WARN("Skipping malformed inline image - key {} has no value", key);
+            return std::nullopt;
+        }
+
+        // a value is one token, or an array or dictionary running to its matching close
+        const QPDFTokenizer::Token& value = tokens[i];
+        size_t end = i + 1;
+        if (value.getType() == QPDFTokenizer::tt_array_open || value.getType() == QPDFTokenizer::tt_dict_open) {
+            int depth = 0;
+            for (end = i; end < tokens.size(); end++) {
+                auto type = tokens[end].getType();
+                if (type == QPDFTokenizer::tt_array_open || type == QPDFTokenizer::tt_dict_open) {
+                    depth++;
+                } else if (type == QPDFTokenizer::tt_array_close || type == QPDFTokenizer::tt_dict_close) {
+                    depth--;
+                }
+                if (depth == 0) {
+                    break;
+                }
+            }
+            if (depth != 0) {
+                PDIF_LOG_WARN("Skipping malformed inline image - unbalanced value for key {}", key);
+                return std::nullopt;
+            }
+            end++;
+        }
+
+        // inline images allow abbreviated keys
+        bool valid = true;
+        if (key == "/W" || key == "/Width") {
+            valid = int_value(value, params.width);
+        } else if (key == "/H" || key == "/Height") {
+            valid = int_value(value, params.height);
+        } else if (key == "/BPC" || key == "/BitsPerComponent") {
+            valid = int_value(value, params.bits_per_component);
+        } else if (key == "/IM" || key == "/ImageMask") {
+            if (value.getType() == QPDFTokenizer::tt_bool && value.getValue() == "true") {
+                params.bits_per_component = 1;
+            }
+        } else if (key == "/F" || key == "/Filter") {
+            // a filter name, or a non empty array of them
+            params.filtered = value.getType() == QPDFTokenizer::tt_name || (value.getType() == QPDFTokenizer::tt_array_open && end - i > 2);
+        }
+
+        if (!valid) {
+            PDIF_LOG_WARN("Skipping malformed inline image - invalid value {} for key {}", value.getValue(), key);
+            return std::nullopt;
+        }
+
+        i = end;
+    }
+
+    return params;
+}
+
+void pdf_content_stream_filter::handleInlineImage(QPDFTokenizer::Token const& token) {
+    if (m_state.skip_inline_image) {
+        // the dictionary was malformed and has already been reported
+        m_state.skip_inline_image = false;
+        return;
+    }
+
+    if (!m_state.inline_image.has_value()) {
+        PDIF_LOG_WARN("Inline image data found without an inline image dictionary");
+        return;
+    }
+
+    inline_image_params params = m_state.inline_image.value();
+    m_state.inline_image.reset();
+
+    // the token ends before the EI operator, which follows as its own word token, so only the
+    // whitespace delimiter in front of EI is stripped from the data
+    const std::string& value = token.getValue();
+    size_t size = value.size();
+    if (size > 0 && std::isspace((unsigned char)value[size - 1])) {
+        size--;
+    }
+
+    stats::timer timer(stats::stage::images);
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(value.data());
+    std::string image_hash = imageToHash(data, size);
+
+    std::string key;
+    if (m_image_cache != nullptr) {
+        key = image_hash + "/" + std::to_string(params.width) + "x" + std::to_string(params.height);
+        auto cached = m_image_cache->by_hash.find(key);
+        if (cached != m_image_cache->by_hash.end()) {
+            m_stream.push_back(cached->second);
+            return;
+        }
+    }
+
+    rxobject_img_elem img = stream_elem::create<xobject_img_elem>(image_hash, params.width, params.height)->as<xobject_img_elem>();
+
+    if (m_image_similarity >= 0) {
+        img->set_similarity_threshold(m_image_similarity);
+
+        // only unfiltered 8 bit samples can be fingerprinted without a decode pipeline
+        size_t pixels = (size_t)params.width * (size_t)params.height;
+        if (!params.filtered && params.bits_per_component == 8 && pixels > 0) {
+            size_t components = size / pixels;
+            if (components == 1 || components == 3 || components == 4) {
+                img->set_fingerprint(image_fingerprint::dhash(data, params.width, params.height, components));
+            }
+        }
+    }
+
+    if (m_image_cache != nullptr) {
+        m_image_cache->by_hash.emplace(key, img);
+    }
+
+    m_stream.push_back(img);
+}
+
+std::string pdf_content_stream_filter::imageToHash(const unsigned char* data, size_t size) {
+    stats::add(stats::counter::bytes_hashed, size);
+    return to_hex(sha1::of(data, size));
 }
 
 void pdf_content_stream_filter::parseCMap(const std::string& cmap) {
+    stats::add(stats::counter::cmaps, 1);
+
     std::stringstream ss;
     ss << cmap;
 
@@ -491,6 +810,8 @@ void pdf_content_stream_filter::parseCMap(const std::string& cmap) {
 }
 
 void pdf_content_stream_filter::getPostScriptFontEncoding(const std::string& postscript_font) {
+    stats::add(stats::counter::cmaps, 1);
+
     std::stringstream ss;
     ss << postscript_font;
 
@@ -530,9 +851,10 @@ void pdf_content_stream_filter::getPostScriptFontEncoding(const std::string& pos
 }
 
 void pdf_content_stream_filter::handleEOF() {
-    if (m_string_buffer.size() > 0) {
-        m_stream.push_back(stream_elem::create<text_elem>(m_string_buffer));
-    }
+    flushStringBuffer();
+
+    stats::add(stats::counter::tokens, m_tokens);
+    m_tokens = 0;
 
     if (m_state.in_array) {
         throw std::runtime_error("Unbalanced array - EOF found");
@@ -0,0 +1,52 @@
+#include <pdif/render.hpp>
+
+#include <array>
+#include <charconv>
+#include <sstream>
+
+namespace pdif {
+
+std::string_view console_color(util::CONSOLE_COLOR_CODE code) {
+    static constexpr size_t TABLE_SIZE = 128;
+
+    static const std::array<std::string, TABLE_SIZE> table = [] {
+        std::array<std::string, TABLE_SIZE> t;
+        for (auto c : {util::CONSOLE_COLOR_CODE::TEXT_RESET, util::CONSOLE_COLOR_CODE::TEXT_BOLD,
+                       util::CONSOLE_COLOR_CODE::FG_RED, util::CONSOLE_COLOR_CODE::FG_GREEN,
+                       util::CONSOLE_COLOR_CODE::FG_YELLOW, util::CONSOLE_COLOR_CODE::FG_BLUE,
+                       util::CONSOLE_COLOR_CODE::FG_DEFAULT, util::CONSOLE_COLOR_CODE::FG_LIGHT_MAGENTA}) {
+            if (static_cast<size_t>(c) < TABLE_SIZE) {
+                std::stringstream ss;
+                ss << c;
+                t[static_cast<size_t>(c)] = ss.str();
+            }
+        }
+        return t;
+    }();
+
+    size_t index = static_cast<size_t>(code);
+    if (index < TABLE_SIZE && !table[index].empty()) {
+        return table[index];
+    }
+
+    // codes pdif does not use are rendered on demand
+    thread_local std::string other;
+    std::stringstream ss;
+    ss << code;
+    other = ss.str();
+    return other;
+}
+
+void render_int(std::string& buffer, long long value) {
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    buffer.append(buf, result.ptr - buf);
+}
+
+void render_float(std::string& buffer, float value) {
+    char buf[32];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::general, 6);
+    buffer.append(buf, result.ptr - buf);
+}
+
+}
@@ -0,0 +1,373 @@
+#include <pdif/serializer.hpp>
+
+#include <algorithm>
+#include <bit>
+
+namespace pdif {
+
+static void check_read(std::istream& is, const char* what) {
+    if (!is) {
+        PDIF_LOG_ERROR("serializer - unexpected end of input reading {}", what);
+        throw pdif::pdif_invalid_format(std::string("serializer - unexpected end of input reading ") + what);
+    }
+}
+
+void serializer::write_u8(std::ostream& os, uint8_t v) {
+    os.put((char)v);
+}
+
+void serializer::write_u32(std::ostream& os, uint32_t v) {
+    char bytes[4];
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (char)((v >> (8 * i)) & 0xff);
+    }
+    os.write(bytes, 4);
+}
+
+void serializer::write_u64(std::ostream& os, uint64_t v) {
+    char bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (char)((v >> (8 * i)) & 0xff);
+    }
+    os.write(bytes, 8);
+}
+
+void serializer::write_i32(std::ostream& os, int32_t v) {
+    write_u32(os, (uint32_t)v);
+}
+
+void serializer::write_f32(std::ostream& os, float v) {
+    write_u32(os, std::bit_cast<uint32_t>(v));
+}
+
+void serializer::write_string(std::ostream& os, const std::string& v) {
+    write_u32(os, (uint32_t)v.size());
+    os.write(v.data(), v.size());
+}
+
+uint8_t serializer::read_u8(std::istream& is) {
+    char c = 0;
+    is.get(c);
+    check_read(is, "u8");
+    return (uint8_t)c;
+}
+
+uint32_t serializer::read_u32(std::istream& is) {
+    unsigned char bytes[4];
+    is.read(reinterpret_cast<char*>(bytes), 4);
+    check_read(is, "u32");
+
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        v |= (uint32_t)bytes[i] << (8 * i);
+    }
+    return v;
+}
+
+uint64_t serializer::read_u64(std::istream& is) {
+    unsigned char bytes[8];
+    is.read(reinterpret_cast<char*>(bytes), 8);
+    check_read(is, "u64");
+
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) {
+        v |= (uint64_t)bytes[i] << (8 * i);
+    }
+    return v;
+}
+
+int32_t serializer::read_i32(std::istream& is) {
+    return (int32_t)read_u32(is);
+}
+
+float serializer::read_f32(std::istream& is) {
+    return std::bit_cast<float>(read_u32(is));
+}
+
+std::string serializer::read_string(std::istream& is) {
+    uint32_t size = read_u32(is);
+
+    // read in chunks so a corrupt length fails at end of input instead of allocating up to 4GB
+    std::string v;
+    char chunk[4096];
+    while (v.size() < size) {
+        size_t count = std::min<size_t>(sizeof(chunk), size - v.size());
+        is.read(chunk, count);
+        check_read(is, "string");
+        v.append(chunk, count);
+    }
+    return v;
+}
+
+void serializer::write_elem(std::ostream& os, const rstream_elem& elem) {
+    write_u8(os, (uint8_t)elem->type());
+
+    switch (elem->type()) {
+        case stream_type::text:
+            write_string(os, elem->as<text_elem>()->text());
+            break;
+        case stream_type::font_set: {
+            auto font = elem->as<font_elem>();
+            write_string(os, font->font_name());
+            write_i32(os, font->font_size());
+            break;
+        }
+        case stream_type::text_color_set: {
+            auto color = elem->as<text_color_elem>();
+            write_f32(os, color->red());
+            write_f32(os, color->green());
+            write_f32(os, color->blue());
+            break;
+        }
+        case stream_type::stroke_color_set: {
+            auto color = elem->as<stroke_color_elem>();
+            write_f32(os, color->red());
+            write_f32(os, color->green());
+            write_f32(os, color->blue());
+            break;
+        }
+        case stream_type::xobject_image: {
+            auto img = elem->as<xobject_img_elem>();
+            write_string(os, img->image_hash());
+            write_i32(os, img->width());
+            write_i32(os, img->height());
+            write_u8(os, img->has_fingerprint() ? 1 : 0);
+            write_u64(os, img->has_fingerprint() ? img->fingerprint() : 0);
+            write_i32(os, img->similarity_threshold());
+            break;
+        }
+        case stream_type::annotation: {
+            auto annot = elem->as<annotation_elem>();
+            write_string(os, annot->subtype());
+            for (float v : annot->rect()) {
+                write_f32(os, v);
+            }
+            write_string(os, annot->contents());
+            write_u64(os, annot->dict_hash());
+            break;
+        }
+        case stream_type::form_field: {
+            auto field = elem->as<form_field_elem>();
+            write_string(os, field->name());
+            write_string(os, field->field_type());
+            write_string(os, field->value());
+            break;
+        }
+    }
+}
+
+rstream_elem serializer::read_elem(std::istream& is) {
+    uint8_t type = read_u8(is);
+
+    switch ((stream_type)type) {
+        case stream_type::text:
+            return stream_elem::create<text_elem>(read_string(is));
+        case stream_type::font_set: {
+            std::string name = read_string(is);
+            int size = read_i32(is);
+            return stream_elem::create<font_elem>(name, size);
+        }
+        case stream_type::text_color_set: {
+            float r = read_f32(is);
+            float g = read_f32(is);
+            float b = read_f32(is);
+            return stream_elem::create<text_color_elem>(r, g, b);
+        }
+        case stream_type::stroke_color_set: {
+            float r = read_f32(is);
+            float g = read_f32(is);
+            float b = read_f32(is);
+            return stream_elem::create<stroke_color_elem>(r, g, b);
+        }
+        case stream_type::xobject_image: {
+            std::string hash = read_string(is);
+            int width = read_i32(is);
+            int height = read_i32(is);
+            bool has_fingerprint = read_u8(is) != 0;
+            uint64_t fingerprint = read_u64(is);
+            int threshold = read_i32(is);
+
+            auto elem = stream_elem::create<xobject_img_elem>(hash, width, height);
+            auto img = elem->as<xobject_img_elem>();
+            if (has_fingerprint) {
+                img->set_fingerprint(fingerprint);
+            }
+            img->set_similarity_threshold(threshold);
+            return elem;
+        }
+        case stream_type::annotation: {
+            std::string subtype = read_string(is);
+            std::array<float, 4> rect;
+            for (float& v : rect) {
+                v = read_f32(is);
+            }
+            std::string contents = read_string(is);
+            uint64_t dict_hash = read_u64(is);
+            return stream_elem::create<annotation_elem>(subtype, rect, contents, dict_hash);
+        }
+        case stream_type::form_field: {
+            std::string name = read_string(is);
+            std::string field_type = read_string(is);
+            std::string value = read_string(is);
+            return stream_elem::create<form_field_elem>(name, field_type, value);
+        }
+    }
+
+    PDIF_LOG_ERROR("serializer::read_elem - unknown stream type {}", type);
+    throw pdif::pdif_invalid_format("serializer::read_elem - unknown stream type " + std::to_string(type));
+}
+
+void serializer::write_stream(std::ostream& os, const stream& s) {
+    write_u64(os, s.size());
+    for (size_t i = 0; i < s.size(); i++) {
+        write_elem(os, s[i]);
+    }
+}
+
+stream serializer::read_stream(std::istream& is) {
+    uint64_t size = read_u64(is);
+
+    stream s;
+    for (uint64_t i = 0; i < size; i++) {
+        s.push_back(read_elem(is));
+    }
+    return s;
+}
+
+void serializer::write_meta(std::ostream& os, const stream_meta& meta) {
+    const auto& metadata = meta.get_metadata();
+
+    write_u64(os, metadata.size());
+    for (auto& [key, value] : metadata) {
+        write_string(os, key);
+        write_string(os, value);
+    }
+}
+
+stream_meta serializer::read_meta(std::istream& is) {
+    uint64_t size = read_u64(is);
+
+    stream_meta meta;
+    for (uint64_t i = 0; i < size; i++) {
+        std::string key = read_string(is);
+        std::string value = read_string(is);
+        meta.add_metadata(key, value);
+    }
+    return meta;
+}
+
+void serializer::write_edit_op(std::ostream& os, const edit_op& op) {
+    write_u8(os, (uint8_t)op.get_type());
+    if (op.has_arg()) {
+        write_elem(os, op.get_arg());
+    }
+    if (op.is_move()) {
+        write_u64(os, op.get_move());
+    }
+}
+
+edit_op serializer::read_edit_op(std::istream& is) {
+    uint8_t type = read_u8(is);
+
+    switch ((edit_op_type)type) {
+        case edit_op_type::INSERT:
+            return edit_op(edit_op_type::INSERT, read_elem(is));
+        case edit_op_type::DELETE:
+        case edit_op_type::EQ:
+            return edit_op((edit_op_type)type);
+        case edit_op_type::MOVE_FROM:
+            return edit_op(edit_op_type::MOVE_FROM, std::nullopt, read_u64(is));
+        case edit_op_type::MOVE_TO: {
+            rstream_elem elem = read_elem(is);
+            return edit_op(edit_op_type::MOVE_TO, elem, read_u64(is));
+        }
+    }
+
+    PDIF_LOG_ERROR("serializer::read_edit_op - unknown edit op type {}", type);
+    throw pdif::pdif_invalid_format("serializer::read_edit_op - unknown edit op type " + std::to_string(type));
+}
+
+void serializer::write_meta_edit_op(std::ostream& os, const meta_edit_op& op) {
+    write_u8(os, (uint8_t)op.get_type());
+    write_string(os, op.get_meta_key());
+    write_u8(os, op.has_meta_val() ? 1 : 0);
+    if (op.has_meta_val()) {
+        write_string(os, op.get_meta_val());
+    }
+}
+
+meta_edit_op serializer::read_meta_edit_op(std::istream& is) {
+    uint8_t type = read_u8(is);
+    if (type > (uint8_t)meta_edit_op_type::META_UPDATE) {
+        PDIF_LOG_ERROR("serializer::read_meta_edit_op - unknown meta edit op type {}", type);
+        throw pdif::pdif_invalid_format("serializer::read_meta_edit_op - unknown meta edit op type " + std::to_string(type));
+    }
+
+    std::string key = read_string(is);
+    std::optional<std::string> val;
+    if (read_u8(is) != 0) {
+        val = read_string(is);
+    }
+
+    return meta_edit_op((meta_edit_op_type)type, key, val);
+}
+
+static constexpr char DIFF_MAGIC[8] = {'P', 'D', 'I', 'F', 'D', 'I', 'F', 'F'};
+
+void serializer::write_diff(std::ostream& os, const diff& d) {
+    os.write(DIFF_MAGIC, sizeof(DIFF_MAGIC));
+    write_u32(os, FORMAT_VERSION);
+
+    write_u64(os, d.original_streams().size());
+    for (const stream& s : d.original_streams()) {
+        write_stream(os, s);
+    }
+
+    write_u64(os, d.edit_op_size());
+    for (size_t i = 0; i < d.edit_op_size(); i++) {
+        write_edit_op(os, d.get_edit_op(i));
+    }
+
+    write_u64(os, d.meta_edit_op_size());
+    for (size_t i = 0; i < d.meta_edit_op_size(); i++) {
+        write_meta_edit_op(os, d.get_meta_edit_op(i));
+    }
+}
+
+diff serializer::read_diff(std::istream& is, bool write_console_colors) {
+    char magic[sizeof(DIFF_MAGIC)];
+    is.read(magic, sizeof(magic));
+    check_read(is, "diff header");
+
+    if (!std::equal(magic, magic + sizeof(magic), DIFF_MAGIC)) {
+        PDIF_LOG_ERROR("serializer::read_diff - not a serialised diff");
+        throw pdif::pdif_invalid_format("serializer::read_diff - not a serialised diff");
+    }
+
+    uint32_t version = read_u32(is);
+    if (version != FORMAT_VERSION) {
+        PDIF_LOG_ERROR("serializer::read_diff - unsupported version {}", version);
+        throw pdif::pdif_invalid_format("serializer::read_diff - unsupported version " + std::to_string(version));
+    }
+
+    diff d(write_console_colors);
+
+    uint64_t streams = read_u64(is);
+    for (uint64_t i = 0; i < streams; i++) {
+        d.add_original_stream(read_stream(is));
+    }
+
+    uint64_t ops = read_u64(is);
+    for (uint64_t i = 0; i < ops; i++) {
+        d.add_edit_op(read_edit_op(is));
+    }
+
+    uint64_t meta_ops = read_u64(is);
+    for (uint64_t i = 0; i < meta_ops; i++) {
+        d.add_meta_edit_op(read_meta_edit_op(is));
+    }
+
+    return d;
+}
+
+}
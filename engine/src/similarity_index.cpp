@@ -0,0 +1,440 @@
+#include <pdif/similarity_index.hpp>
+#include <pdif/serializer.hpp>
+#include <pdif/pdf.hpp>
+#include <pdif/hash_util.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+#include <tuple>
+#include <unordered_set>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace pdif {
+
+static constexpr char INDEX_MAGIC[8] = {'P', 'D', 'I', 'F', 'S', 'I', 'M', 'X'};
+
+namespace {
+
+/**
+ * @brief an entry of a bucket shard or its log
+ *
+ */
+struct bucket_entry {
+    uint64_t hash;
+    uint32_t id;
+
+    bool operator<(const bucket_entry& other) const {
+        return std::tie(hash, id) < std::tie(other.hash, other.id);
+    }
+
+    bool operator==(const bucket_entry& other) const {
+        return hash == other.hash && id == other.id;
+    }
+};
+
+// the whole entries of a bucket file, which may be shortened (or missing) while it is read
+std::vector<bucket_entry> read_entries(const std::filesystem::path& path) {
+    std::vector<bucket_entry> entries;
+    std::ifstream is(path, std::ios::binary);
+    if (!is.is_open()) {
+        return entries;
+    }
+
+    std::string bytes((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    std::istringstream data(bytes);
+    for (size_t e = 0; e < bytes.size() / (8 + 4); e++) {
+        bucket_entry entry;
+        entry.hash = serializer::read_u64(data);
+        entry.id = serializer::read_u32(data);
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+/**
+ * @brief an exclusive lock on a file, held by one writer process at a time
+ * 
+ */
+class file_lock {
+public:
+    explicit file_lock(const std::filesystem::path& path) {
+#if !defined(_WIN32)
+        m_fd = ::open(path.c_str(), O_RDWR);
+        if (m_fd < 0 || ::flock(m_fd, LOCK_EX) != 0) {
+            if (m_fd >= 0) {
+                ::close(m_fd);
+            }
+            PDIF_LOG_ERROR("similarity_index - cannot lock {}", path.string());
+            throw pdif::pdif_invalid_argment("similarity_index - cannot lock " + path.string());
+        }
+#endif
+    }
+
+    ~file_lock() {
+#if !defined(_WIN32)
+        ::flock(m_fd, LOCK_UN);
+        ::close(m_fd);
+#endif
+    }
+
+    file_lock(const file_lock&) = delete;
+    file_lock& operator=(const file_lock&) = delete;
+
+private:
+    int m_fd = -1;
+};
+
+}
+
+// drop a partial record left at the end of a file by a writer that did not finish
+static void truncate_to_records(const std::filesystem::path& path, size_t record_size) {
+    std::error_code ec;
+    uintmax_t bytes = std::filesystem::file_size(path, ec);
+    if (!ec && bytes % record_size != 0) {
+        PDIF_LOG_WARN("similarity_index - dropping a partial record at the end of {}", path.string());
+        std::filesystem::resize_file(path, bytes - bytes % record_size, ec);
+    }
+}
+
+similarity_index::similarity_index(const std::string& directory) : m_directory(directory) {
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory / "buckets", ec);
+
+    if (!std::filesystem::is_directory(m_directory / "buckets", ec)) {
+        PDIF_LOG_ERROR("similarity_index::similarity_index - cannot create index directory {}", directory);
+        throw pdif::pdif_invalid_argment("similarity_index::similarity_index - cannot create index directory " + directory);
+    }
+
+    std::filesystem::path header = m_directory / "index.meta";
+    if (!std::filesystem::exists(header, ec)) {
+        std::ofstream os(header, std::ios::binary | std::ios::trunc);
+        os.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        serializer::write_u32(os, FORMAT_VERSION);
+        serializer::write_u32(os, minhash::SIGNATURE_SIZE);
+        serializer::write_u32(os, BANDS);
+        return;
+    }
+
+    std::ifstream is = open_read(header);
+    char magic[sizeof(INDEX_MAGIC)];
+    is.read(magic, sizeof(magic));
+    if (!is || !std::equal(magic, magic + sizeof(magic), INDEX_MAGIC)) {
+        PDIF_LOG_ERROR("similarity_index::similarity_index - {} is not a similarity index", directory);
+        throw pdif::pdif_invalid_format("similarity_index::similarity_index - " + directory + " is not a similarity index");
+    }
+
+    uint32_t version = serializer::read_u32(is);
+    uint32_t signature_size = serializer::read_u32(is);
+    uint32_t bands = serializer::read_u32(is);
+    if (version != FORMAT_VERSION || signature_size != minhash::SIGNATURE_SIZE || bands != BANDS) {
+        PDIF_LOG_ERROR("similarity_index::similarity_index - unsupported index version {}", version);
+        throw pdif::pdif_invalid_format("similarity_index::similarity_index - unsupported index version " + std::to_string(version));
+    }
+}
+
+uint64_t similarity_index::band_hash(const minhash::signature& sig, size_t band) {
+    uint64_t h = 0xcbf29ce484222325ull ^ band;
+    for (size_t i = band * ROWS; i < (band + 1) * ROWS; i++) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            h = (h ^ ((sig[i] >> shift) & 0xff)) * 0x100000001b3ull;
+        }
+    }
+    return h;
+}
+
+std::filesystem::path similarity_index::shard_path(uint64_t hash) const {
+    size_t shard = (hash >> 56) % SHARDS;
+    std::string name;
+    append_hex(name, shard, 2);
+    return m_directory / "buckets" / (name + ".bin");
+}
+
+std::filesystem::path similarity_index::log_path(const std::filesystem::path& shard) {
+    std::filesystem::path log = shard;
+    return log.replace_extension(".log");
+}
+
+void similarity_index::merge_shard(const std::filesystem::path& shard) const {
+    std::vector<bucket_entry> entries = read_entries(shard);
+    std::vector<bucket_entry> log = read_entries(log_path(shard));
+    entries.insert(entries.end(), log.begin(), log.end());
+
+    // a merge interrupted after replacing the shard leaves its log behind, merging it again is harmless
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    // readers keep the shard they opened, and see the new one whole once it is renamed over it. Writers hold
+    // the lock, so the temporary name is not shared
+    std::filesystem::path tmp = shard;
+    tmp += ".tmp";
+    {
+        std::ofstream os(tmp, std::ios::binary | std::ios::trunc);
+        for (const bucket_entry& entry : entries) {
+            serializer::write_u64(os, entry.hash);
+            serializer::write_u32(os, entry.id);
+        }
+        os.flush();
+        if (!os) {
+            std::error_code ec;
+            std::filesystem::remove(tmp, ec);
+            PDIF_LOG_ERROR("similarity_index - cannot write {}", tmp.string());
+            throw pdif::pdif_invalid_argment("similarity_index - cannot write " + tmp.string());
+        }
+    }
+    std::filesystem::rename(tmp, shard);
+
+    // emptied only once the shard holds its entries, so a query reading the log and then the shard sees them
+    std::filesystem::resize_file(log_path(shard), 0);
+}
+
+std::ifstream similarity_index::open_read(const std::filesystem::path& path) const {
+    std::ifstream is(path, std::ios::binary);
+    if (!is.is_open()) {
+        PDIF_LOG_ERROR("similarity_index - cannot read {}", path.string());
+        throw pdif::pdif_invalid_argment("similarity_index - cannot read " + path.string());
+    }
+    return is;
+}
+
+std::ofstream similarity_index::open_append(const std::filesystem::path& path) const {
+    std::ofstream os(path, std::ios::binary | std::ios::app);
+    if (!os.is_open()) {
+        PDIF_LOG_ERROR("similarity_index - cannot write {}", path.string());
+        throw pdif::pdif_invalid_argment("similarity_index - cannot write " + path.string());
+    }
+    return os;
+}
+
+void similarity_index::write_signature(std::ostream& os, const minhash::signature& sig) {
+    for (uint32_t v : sig) {
+        serializer::write_u32(os, v);
+    }
+}
+
+minhash::signature similarity_index::read_signature(std::istream& is) {
+    minhash::signature sig;
+    for (uint32_t& v : sig) {
+        v = serializer::read_u32(is);
+    }
+    return sig;
+}
+
+similarity_index::document similarity_index::read_document(std::istream& is, size_t id) const {
+    is.seekg(id * DOCUMENT_SIZE);
+
+    document doc;
+    doc.path_offset = serializer::read_u64(is);
+    doc.page_offset = serializer::read_u64(is);
+    doc.page_count = serializer::read_u32(is);
+    doc.sig = read_signature(is);
+    return doc;
+}
+
+size_t similarity_index::size() const {
+    std::error_code ec;
+    uintmax_t bytes = std::filesystem::file_size(m_directory / "documents.bin", ec);
+    return ec ? 0 : bytes / DOCUMENT_SIZE;
+}
+
+std::vector<stream> similarity_index::extract(const std::string& pdf_path) {
+    PDF pdf(pdf_path, granularity::word, scope::page, false);
+    return pdf.get_streams();
+}
+
+size_t similarity_index::add(const std::string& pdf_path) {
+    return add(std::filesystem::absolute(pdf_path).string(), extract(pdf_path));
+}
+
+size_t similarity_index::add(const std::string& path, const std::vector<stream>& pages) {
+    std::vector<minhash::signature> page_sigs = minhash::sketch_pages(pages);
+    minhash::signature sig = minhash::combine(page_sigs);
+
+    // writers take turns, so each gets its own id and the records of two documents never interleave
+    file_lock lock(m_directory / "index.meta");
+
+    truncate_to_records(m_directory / "documents.bin", DOCUMENT_SIZE);
+    size_t id = size();
+
+    auto end_of = [](const std::filesystem::path& path) -> uint64_t {
+        std::error_code ec;
+        uintmax_t bytes = std::filesystem::file_size(path, ec);
+        return ec ? 0 : bytes;
+    };
+
+    // the path and pages are written before the record that points at them
+    document doc;
+    doc.path_offset = end_of(m_directory / "paths.bin");
+    doc.page_offset = end_of(m_directory / "pages.bin");
+    doc.page_count = page_sigs.size();
+
+    {
+        std::ofstream os = open_append(m_directory / "paths.bin");
+        serializer::write_string(os, path);
+    }
+    {
+        std::ofstream os = open_append(m_directory / "pages.bin");
+        for (const minhash::signature& page : page_sigs) {
+            write_signature(os, page);
+        }
+    }
+    {
+        std::ofstream os = open_append(m_directory / "documents.bin");
+        serializer::write_u64(os, doc.path_offset);
+        serializer::write_u64(os, doc.page_offset);
+        serializer::write_u32(os, doc.page_count);
+        write_signature(os, sig);
+    }
+
+    // documents without any text all have the empty signature, they are kept but not filed under a band
+    if (sig == minhash::empty()) {
+        return id;
+    }
+
+    std::set<std::filesystem::path> shards;
+    for (size_t band = 0; band < BANDS; band++) {
+        uint64_t hash = band_hash(sig, band);
+        shards.insert(shard_path(hash));
+
+        std::filesystem::path log = log_path(shard_path(hash));
+        truncate_to_records(log, BUCKET_ENTRY_SIZE);
+        std::ofstream os = open_append(log);
+        serializer::write_u64(os, hash);
+        serializer::write_u32(os, id);
+    }
+
+    // keep the logs short, so that queries only scan a bounded number of unsorted entries
+    for (const std::filesystem::path& shard : shards) {
+        std::error_code ec;
+        uintmax_t bytes = std::filesystem::file_size(log_path(shard), ec);
+        if (!ec && bytes / BUCKET_ENTRY_SIZE >= MERGE_ENTRIES) {
+            merge_shard(shard);
+        }
+    }
+
+    return id;
+}
+
+std::vector<similarity_index::candidate> similarity_index::query(const std::string& pdf_path, size_t k) const {
+    return query(extract(pdf_path), k);
+}
+
+std::vector<similarity_index::candidate> similarity_index::query(const std::vector<stream>& pages, size_t k) const {
+    size_t documents = size();
+    if (documents == 0 || k == 0) {
+        return {};
+    }
+
+    std::vector<minhash::signature> page_sigs = minhash::sketch_pages(pages);
+    minhash::signature sig = minhash::combine(page_sigs);
+
+    // a document without any text is similar to nothing
+    if (sig == minhash::empty()) {
+        return {};
+    }
+
+    // the band hashes to look for, grouped by the shard holding them
+    std::map<std::filesystem::path, std::vector<uint64_t>> shards;
+    for (size_t band = 0; band < BANDS; band++) {
+        uint64_t hash = band_hash(sig, band);
+        shards[shard_path(hash)].push_back(hash);
+    }
+
+    // documents still being added have no record yet
+    std::unordered_set<uint32_t> hits;
+    auto hit = [&](uint32_t id) {
+        if (id < documents) {
+            hits.insert(id);
+        }
+    };
+
+    for (const auto& [path, hashes] : shards) {
+        // the log is read first: a merge empties it only after the shard holds its entries
+        for (const bucket_entry& entry : read_entries(log_path(path))) {
+            if (std::find(hashes.begin(), hashes.end(), entry.hash) != hashes.end()) {
+                hit(entry.id);
+            }
+        }
+
+        // sized through the open file, a merge may replace the shard under its name meanwhile
+        std::ifstream is(path, std::ios::binary | std::ios::ate);
+        if (!is.is_open()) {
+            continue;
+        }
+        uintmax_t entries = (uintmax_t)is.tellg() / BUCKET_ENTRY_SIZE;
+
+        auto hash_at = [&](uintmax_t e) {
+            is.seekg(e * BUCKET_ENTRY_SIZE);
+            return serializer::read_u64(is);
+        };
+
+        // the shard is sorted by hash: find the first entry of each hash and read its run
+        for (uint64_t hash : hashes) {
+            uintmax_t lo = 0;
+            uintmax_t hi = entries;
+            while (lo < hi) {
+                uintmax_t mid = lo + (hi - lo) / 2;
+                if (hash_at(mid) < hash) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+
+            for (uintmax_t e = lo; e < entries && hash_at(e) == hash; e++) {
+                hit(serializer::read_u32(is));
+            }
+        }
+    }
+
+    std::ifstream document_file = open_read(m_directory / "documents.bin");
+
+    std::vector<std::pair<double, uint32_t>> ranked;
+    for (uint32_t id : hits) {
+        document doc = read_document(document_file, id);
+        ranked.push_back({minhash::similarity(sig, doc.sig), id});
+    }
+
+    std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    ranked.resize(std::min(ranked.size(), k));
+
+    std::ifstream path_file = open_read(m_directory / "paths.bin");
+    std::ifstream page_file = open_read(m_directory / "pages.bin");
+
+    std::vector<candidate> candidates;
+    for (const auto& [similarity, id] : ranked) {
+        document doc = read_document(document_file, id);
+
+        path_file.seekg(doc.path_offset);
+        std::string path = serializer::read_string(path_file);
+
+        page_file.seekg(doc.page_offset);
+        std::vector<minhash::signature> doc_pages;
+        for (uint32_t p = 0; p < doc.page_count; p++) {
+            doc_pages.push_back(read_signature(page_file));
+        }
+
+        size_t matched = 0;
+        for (const minhash::signature& page : page_sigs) {
+            bool found = std::any_of(doc_pages.begin(), doc_pages.end(), [&](const minhash::signature& other) {
+                return minhash::similarity(page, other) >= PAGE_MATCH_SIMILARITY;
+            });
+            matched += found;
+        }
+
+        candidates.push_back({path, similarity, matched, doc.page_count});
+    }
+
+    return candidates;
+}
+
+}
@@ -0,0 +1,102 @@
+#include <pdif/stats.hpp>
+
+#include <cstdio>
+
+namespace pdif {
+
+stats::page_timer::~page_timer() {
+    if (m_stats == nullptr) {
+        return;
+    }
+
+    page& p = m_stats->m_pages[m_page];
+    (m_diff ? p.diff_ns : p.extract_ns) += elapsed_ns(m_start);
+    for (size_t c = 0; c < COUNTER_COUNT; c++) {
+        p.counters[c] += m_stats->m_counters[c] - m_counters[c];
+    }
+}
+
+void stats::merge(const stats& other) {
+    for (size_t st = 0; st < STAGE_COUNT; st++) {
+        m_stage_ns[st] += other.m_stage_ns[st];
+        m_stage_calls[st] += other.m_stage_calls[st];
+    }
+
+    for (size_t c = 0; c < COUNTER_COUNT; c++) {
+        m_counters[c] += other.m_counters[c];
+    }
+
+    for (const auto& [index, other_page] : other.m_pages) {
+        page& p = m_pages[index];
+        p.extract_ns += other_page.extract_ns;
+        p.diff_ns += other_page.diff_ns;
+        for (size_t c = 0; c < COUNTER_COUNT; c++) {
+            p.counters[c] += other_page.counters[c];
+        }
+    }
+}
+
+std::string_view stats::name(stage st) {
+    switch (st) {
+        case stage::parse:
+            return "parse";
+        case stage::extract:
+            return "extract";
+        case stage::fonts:
+            return "fonts";
+        case stage::images:
+            return "images";
+        case stage::diff:
+            return "diff";
+        case stage::render:
+            return "render";
+    }
+    return "";
+}
+
+std::string_view stats::name(counter c) {
+    switch (c) {
+        case counter::tokens:
+            return "tokens";
+        case counter::elements:
+            return "elements";
+        case counter::cmaps:
+            return "cmaps";
+        case counter::bytes_hashed:
+            return "bytes_hashed";
+        case counter::dp_cells:
+            return "dp_cells";
+        case counter::ops:
+            return "ops";
+    }
+    return "";
+}
+
+void stats::output(std::ostream& os) const {
+    char ms[32];
+    auto format_ms = [&](uint64_t ns) {
+        snprintf(ms, sizeof(ms), "%.3f ms", ns / 1e6);
+        return ms;
+    };
+
+    os << "Stats:\n";
+    for (size_t st = 0; st < STAGE_COUNT; st++) {
+        os << "  " << name((stage)st) << ": " << format_ms(m_stage_ns[st]) << " (" << m_stage_calls[st] << " calls)\n";
+    }
+    for (size_t c = 0; c < COUNTER_COUNT; c++) {
+        os << "  " << name((counter)c) << ": " << m_counters[c] << '\n';
+    }
+
+    for (const auto& [index, p] : m_pages) {
+        os << "  page " << index + 1 << ": extract " << format_ms(p.extract_ns);
+        os << ", diff " << format_ms(p.diff_ns);
+        for (size_t c = 0; c < COUNTER_COUNT; c++) {
+            os << ", " << name((counter)c) << ' ' << p.counters[c];
+        }
+        os << '\n';
+    }
+
+    os.flush();
+}
+
+}
@@ -1,32 +1,116 @@
 #include <pdif/stream_differ_base.hpp>
 
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
 namespace pdif {
 
 void stream_differ_base::meta_diff(pdif::diff& d, const pdif::stream_meta& meta1, const pdif::stream_meta& meta2) {
-    auto stream1_metadata = meta1.get_metadata();
-    auto stream2_metadata = meta2.get_metadata();    
+    const auto& stream1_metadata = meta1.get_metadata();
+    const auto& stream2_metadata = meta2.get_metadata();
+
+    // both maps are sorted by key, so one merge pass pairs up the keys. deletes are emitted after the
+    // adds and updates
+    std::vector<std::string> deleted;
 
-    for (auto& meta : stream2_metadata) {
-        if (!meta1.has_key(meta.first)) {
+    auto it1 = stream1_metadata.begin();
+    auto it2 = stream2_metadata.begin();
+    while (it1 != stream1_metadata.end() || it2 != stream2_metadata.end()) {
+        if (it2 == stream2_metadata.end() || (it1 != stream1_metadata.end() && it1->first < it2->first)) {
+            // meta is in stream 1 but not in stream 2
+            deleted.push_back(it1->first);
+            ++it1;
+        } else if (it1 == stream1_metadata.end() || it2->first < it1->first) {
             // meta is in stream 2 but not in stream 1. add op to diff
-            d.add_meta_edit_op(meta_edit_op(meta_edit_op_type::META_ADD, meta.first, meta.second));
-        }
-        
-        if (meta1.has_key(meta.first)) {
-            // meta is in both streams. compare values
-            if (meta1.get_metadata(meta.first) != meta2.get_metadata(meta.first)) {
+            d.add_meta_edit_op(meta_edit_op(meta_edit_op_type::META_ADD, it2->first, it2->second));
+            ++it2;
+        } else {
+            if (it1->second != it2->second) {
                 // meta is in both streams but values are different. add op to diff
-                d.add_meta_edit_op(meta_edit_op(meta_edit_op_type::META_UPDATE, meta.first, meta.second));
+                d.add_meta_edit_op(meta_edit_op(meta_edit_op_type::META_UPDATE, it2->first, it2->second));
             }
+            ++it1;
+            ++it2;
         }
     }
 
-    for (auto &meta : stream1_metadata) {
-        if (!meta2.has_key(meta.first)) {
-            // meta is in stream 1 but not in stream 2. add op to diff
-            d.add_meta_edit_op(meta_edit_op(meta_edit_op_type::META_DELETE, meta.first));
+    for (const std::string& key : deleted) {
+        d.add_meta_edit_op(meta_edit_op(meta_edit_op_type::META_DELETE, key));
+    }
+}
+
+void stream_differ_base::replace_all(pdif::diff& d) const {
+    for (size_t j = 0; j < stream2.size(); j++) {
+        d.add_edit_op(edit_op(edit_op_type::INSERT, stream2[j]));
+    }
+
+    for (size_t i = 0; i < stream1.size(); i++) {
+        d.add_edit_op(edit_op(edit_op_type::DELETE));
+    }
+}
+
+bool stream_differ_base::bounded_diff(pdif::diff& d, int max_edit_distance) {
+    if (max_edit_distance < 0) {
+        diff(d);
+        return true;
+    }
+
+    if (!within_edit_distance(max_edit_distance)) {
+        PDIF_LOG_INFO("stream_differ_base::bounded_diff - streams differ by more than {} edits, replacing", max_edit_distance);
+        replace_all(d);
+        return false;
+    }
+
+    diff(d);
+    return true;
+}
+
+bool stream_differ_base::within_edit_distance(int max_edit_distance) const {
+    int m = stream1.size();
+    int n = stream2.size();
+
+    // the edit distance is at least the difference in length
+    if (std::abs(m - n) > max_edit_distance) {
+        return false;
+    }
+
+    int max_d = std::min(max_edit_distance, m + n);
+
+    // v[k + offset] is the furthest x reached on diagonal k = x - y. Only the distance is needed, so no
+    // trace is kept and round d only reads the values of round d - 1
+    int offset = max_d + 1;
+    std::vector<int> v(2 * max_d + 3, 0);
+
+    uint64_t cells = 0;
+    bool found = false;
+    for (int d = 0; d <= max_d && !found; d++) {
+        for (int k = -d; k <= d; k += 2) {
+            int x;
+            if (k == -d || (k != d && v[k - 1 + offset] < v[k + 1 + offset])) {
+                x = v[k + 1 + offset];
+            } else {
+                x = v[k - 1 + offset] + 1;
+            }
+
+            int y = x - k;
+            cells++;
+            while (x < m && y < n && stream1[x]->compare(stream2[y])) {
+                x++;
+                y++;
+            }
+
+            v[k + offset] = x;
+
+            if (x >= m && y >= n) {
+                found = true;
+                break;
+            }
         }
     }
+
+    stats::add(stats::counter::dp_cells, cells);
+    return found;
 }
 
-}
\ No newline at end of file
+}
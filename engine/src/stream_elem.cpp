@@ -1,11 +1,26 @@
 #include <pdif/stream_elem.hpp>
 #include <pdif/errors.hpp>
+#include <pdif/image_fingerprint.hpp>
+#include <pdif/hash_util.hpp>
+
+#include <functional>
 
 namespace pdif {
 
+// boost style hash combine
+static inline size_t hash_combine(size_t t_seed, size_t t_value) {
+    return t_seed ^ (t_value + 0x9e3779b97f4a7c15ULL + (t_seed << 6) + (t_seed >> 2));
+}
+
 stream_elem::stream_elem(private_tag, stream_type t_type) : m_type(t_type){}
 stream_type stream_elem::type() const { return m_type; }
 
+std::string stream_elem::to_string(bool console_colors) const {
+    std::string s;
+    render_to(s, console_colors);
+    return s;
+}
+
 text_elem::text_elem(stream_elem::private_tag t, const std::string& t_text) :
     stream_elem(t, stream_type::text),
     m_text(t_text) {}
@@ -14,7 +29,12 @@ const std::string& text_elem::text() const {
     return m_text;
 }
 
-bool text_elem::compare(rstream_elem t_other) {
+bool text_elem::compare(const rstream_elem& t_other) {
+    // letters are shared between occurrences
+    if (t_other.get() == this) {
+        return true;
+    }
+
     if (t_other->type() != stream_type::text) {
         return false;
     }
@@ -22,8 +42,12 @@ bool text_elem::compare(rstream_elem t_other) {
     return m_text == t_other->as<text_elem>()->text();
 }
 
-std::string text_elem::to_string(bool) const {
-    return m_text;
+size_t text_elem::hash() const {
+    return hash_combine(static_cast<size_t>(stream_type::text), std::hash<std::string>{}(m_text));
+}
+
+void text_elem::render_to(std::string& buffer, bool) const {
+    buffer.append(m_text);
 }
 
 // ** ====== FONT ELEM ====== ** //
@@ -41,7 +65,7 @@ int font_elem::font_size() const {
     return m_font_size;
 }
 
-bool font_elem::compare(rstream_elem t_other) {
+bool font_elem::compare(const rstream_elem& t_other) {
     if (t_other->type() != stream_type::font_set) {
         return false;
     }
@@ -50,14 +74,21 @@ bool font_elem::compare(rstream_elem t_other) {
     return m_font_name == other->font_name() && m_font_size == other->font_size();
 }
 
-std::string font_elem::to_string(bool console_colors) const {
-    std::stringstream ss;
-    ss << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD, console_colors);
-    ss << cc(util::CONSOLE_COLOR_CODE::FG_BLUE, console_colors);
-    ss << "[Font set: " << m_font_name << ", " << m_font_size << "pt]";
-    ss << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET, console_colors);
-    ss << cc(util::CONSOLE_COLOR_CODE::FG_DEFAULT, console_colors);
-    return ss.str();
+size_t font_elem::hash() const {
+    size_t h = hash_combine(static_cast<size_t>(stream_type::font_set), std::hash<std::string>{}(m_font_name));
+    return hash_combine(h, std::hash<int>{}(m_font_size));
+}
+
+void font_elem::render_to(std::string& buffer, bool console_colors) const {
+    render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_BOLD, console_colors);
+    render_color(buffer, util::CONSOLE_COLOR_CODE::FG_BLUE, console_colors);
+    buffer.append("[Font set: ");
+    buffer.append(m_font_name);
+    buffer.append(", ");
+    render_int(buffer, m_font_size);
+    buffer.append("pt]");
+    render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_RESET, console_colors);
+    render_color(buffer, util::CONSOLE_COLOR_CODE::FG_DEFAULT, console_colors);
 }
 
 void font_elem::set_to_unicode(std::map<int, std::string> t_to_unicode) {
@@ -88,7 +119,7 @@ std::string font_elem::to_unicode(int t_char) const {
 text_color_elem::text_color_elem(stream_elem::private_tag t, float t_r, float t_g, float t_b) :
     color_elem(t, stream_type::text_color_set, t_r, t_g, t_b) {}
 
-bool text_color_elem::compare(rstream_elem t_other) {
+bool text_color_elem::compare(const rstream_elem& t_other) {
     if (t_other->type() != stream_type::text_color_set) {
         return false;
     }
@@ -97,21 +128,31 @@ bool text_color_elem::compare(rstream_elem t_other) {
     return r == other->red() && g == other->green() && b == other->blue();
 }
 
-std::string text_color_elem::to_string(bool console_colors) const {
-    std::stringstream ss;
-    ss << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD, console_colors);
-    ss << cc(util::CONSOLE_COLOR_CODE::FG_BLUE, console_colors);
-    ss << "[Text color set: " << r << "r, " << g << "g, " << b << "b]";
-    ss << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET, console_colors);
-    ss << cc(util::CONSOLE_COLOR_CODE::FG_DEFAULT, console_colors);
-    return ss.str();
+size_t text_color_elem::hash() const {
+    size_t h = hash_combine(static_cast<size_t>(stream_type::text_color_set), std::hash<float>{}(r));
+    h = hash_combine(h, std::hash<float>{}(g));
+    return hash_combine(h, std::hash<float>{}(b));
+}
+
+void text_color_elem::render_to(std::string& buffer, bool console_colors) const {
+    render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_BOLD, console_colors);
+    render_color(buffer, util::CONSOLE_COLOR_CODE::FG_BLUE, console_colors);
+    buffer.append("[Text color set: ");
+    render_float(buffer, r);
+    buffer.append("r, ");
+    render_float(buffer, g);
+    buffer.append("g, ");
+    render_float(buffer, b);
+    buffer.append("b]");
+    render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_RESET, console_colors);
+    render_color(buffer, util::CONSOLE_COLOR_CODE::FG_DEFAULT, console_colors);
 }
 
 // ** ====== STROKE COLOR ELEM ====== ** //
 stroke_color_elem::stroke_color_elem(stream_elem::private_tag t, float t_r, float t_g, float t_b) :
     color_elem(t, stream_type::stroke_color_set, t_r, t_g, t_b) {}
 
-bool stroke_color_elem::compare(rstream_elem t_other) {
+bool stroke_color_elem::compare(const rstream_elem& t_other) {
     if (t_other->type() != stream_type::stroke_color_set) {
         return false;
     }
@@ -120,14 +161,24 @@ bool stroke_color_elem::compare(rstream_elem t_other) {
     return r == other->red() && g == other->green() && b == other->blue();
 }
 
-std::string stroke_color_elem::to_string(bool console_colors) const {
-    std::stringstream ss;
-    ss << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD, console_colors);
-    ss << cc(util::CONSOLE_COLOR_CODE::FG_BLUE, console_colors);
-    ss << "[Stroke color set: " << r << "r, " << g << "g, " << b << "b]";
-    ss << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET, console_colors);
-    ss << cc(util::CONSOLE_COLOR_CODE::FG_DEFAULT, console_colors);
-    return ss.str();
+size_t stroke_color_elem::hash() const {
+    size_t h = hash_combine(static_cast<size_t>(stream_type::stroke_color_set), std::hash<float>{}(r));
+    h = hash_combine(h, std::hash<float>{}(g));
+    return hash_combine(h, std::hash<float>{}(b));
+}
+
+void stroke_color_elem::render_to(std::string& buffer, bool console_colors) const {
+    render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_BOLD, console_colors);
+    render_color(buffer, util::CONSOLE_COLOR_CODE::FG_BLUE, console_colors);
+    buffer.append("[Stroke color set: ");
+    render_float(buffer, r);
+    buffer.append("r, ");
+    render_float(buffer, g);
+    buffer.append("g, ");
+    render_float(buffer, b);
+    buffer.append("b]");
+    render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_RESET, console_colors);
+    render_color(buffer, util::CONSOLE_COLOR_CODE::FG_DEFAULT, console_colors);
 }
 
 // ** ====== XOBJECT ELEM ====== ** //
@@ -138,23 +189,156 @@ xobject_img_elem::xobject_img_elem(stream_elem::private_tag t, const std::string
     m_width(t_width),
     m_height(t_height) {}
 
-bool xobject_img_elem::compare(rstream_elem t_other) {
+bool xobject_img_elem::compare(const rstream_elem& t_other) {
     if (t_other->type() != stream_type::xobject_image) {
         return false;
     }
 
     auto other = t_other->as<xobject_img_elem>();
-    return m_image_hash == other->image_hash() && m_width == other->width() && m_height == other->height();
+
+    // images that hash by bucket only equal images that do too, so that equal images hash the same
+    if (matches_similar() != other->matches_similar()) {
+        return false;
+    }
+
+    if (m_image_hash == other->image_hash() && m_width == other->width() && m_height == other->height()) {
+        return true;
+    }
+
+    if (!matches_similar()) {
+        return false;
+    }
+
+    // similar images must share a bucket, which is all hash() looks at
+    if (image_fingerprint::bucket(m_fingerprint.value()) != image_fingerprint::bucket(other->fingerprint())) {
+        return false;
+    }
+
+    int threshold = std::min(m_similarity_threshold, other->similarity_threshold());
+    return image_fingerprint::distance(m_fingerprint.value(), other->fingerprint()) <= threshold;
 };
 
-std::string xobject_img_elem::to_string(bool console_colors) const {
-    std::stringstream ss;
-    ss << cc(util::CONSOLE_COLOR_CODE::TEXT_BOLD, console_colors);
-    ss << cc(util::CONSOLE_COLOR_CODE::FG_LIGHT_MAGENTA, console_colors);
-    ss << "[Image: (sha1)" << m_image_hash << ", " << m_width << "x" << m_height << "px]";
-    ss << cc(util::CONSOLE_COLOR_CODE::TEXT_RESET, console_colors);
-    ss << cc(util::CONSOLE_COLOR_CODE::FG_DEFAULT, console_colors);
-    return ss.str();
+size_t xobject_img_elem::hash() const {
+    size_t h = static_cast<size_t>(stream_type::xobject_image);
+    if (matches_similar()) {
+        return hash_combine(h, image_fingerprint::bucket(m_fingerprint.value()));
+    }
+
+    h = hash_combine(h, std::hash<std::string>{}(m_image_hash));
+    h = hash_combine(h, std::hash<int>{}(m_width));
+    return hash_combine(h, std::hash<int>{}(m_height));
+}
+
+uint64_t xobject_img_elem::fingerprint() const {
+    if (!has_fingerprint()) {
+        PDIF_LOG_ERROR("xobject_img_elem::fingerprint - image has no fingerprint");
+        throw pdif::pdif_invalid_operation("xobject_img_elem::fingerprint - image has no fingerprint");
+    }
+
+    return m_fingerprint.value();
+}
+
+void xobject_img_elem::render_to(std::string& buffer, bool console_colors) const {
+    render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_BOLD, console_colors);
+    render_color(buffer, util::CONSOLE_COLOR_CODE::FG_LIGHT_MAGENTA, console_colors);
+    buffer.append("[Image: (sha1)");
+    buffer.append(m_image_hash);
+    buffer.append(", ");
+    render_int(buffer, m_width);
+    buffer.append("x");
+    render_int(buffer, m_height);
+    buffer.append("px]");
+    render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_RESET, console_colors);
+    render_color(buffer, util::CONSOLE_COLOR_CODE::FG_DEFAULT, console_colors);
+}
+
+// ** ====== ANNOTATION ELEM ====== ** //
+
+annotation_elem::annotation_elem(stream_elem::private_tag t, const std::string& t_subtype, const std::array<float, 4>& t_rect, const std::string& t_contents, uint64_t t_dict_hash) :
+    stream_elem(t, stream_type::annotation),
+    m_subtype(t_subtype),
+    m_rect(t_rect),
+    m_contents(t_contents),
+    m_dict_hash(t_dict_hash) {}
+
+bool annotation_elem::compare(const rstream_elem& t_other) {
+    if (t_other->type() != stream_type::annotation) {
+        return false;
+    }
+
+    auto other = t_other->as<annotation_elem>();
+    return m_subtype == other->subtype() && m_rect == other->rect() && m_contents == other->contents() && m_dict_hash == other->dict_hash();
+}
+
+size_t annotation_elem::hash() const {
+    size_t h = hash_combine(static_cast<size_t>(stream_type::annotation), std::hash<std::string>{}(m_subtype));
+    for (float v : m_rect) {
+        h = hash_combine(h, std::hash<float>{}(v));
+    }
+    h = hash_combine(h, std::hash<std::string>{}(m_contents));
+    return hash_combine(h, std::hash<uint64_t>{}(m_dict_hash));
+}
+
+void annotation_elem::render_to(std::string& buffer, bool console_colors) const {
+    render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_BOLD, console_colors);
+    render_color(buffer, util::CONSOLE_COLOR_CODE::FG_LIGHT_MAGENTA, console_colors);
+    buffer.append("[Annotation: ");
+    buffer.append(m_subtype);
+    buffer.append(", (");
+    for (size_t i = 0; i < m_rect.size(); i++) {
+        if (i > 0) {
+            buffer.append(", ");
+        }
+        render_float(buffer, m_rect[i]);
+    }
+    buffer.append("), ");
+    if (!m_contents.empty()) {
+        buffer.append("\"");
+        buffer.append(m_contents);
+        buffer.append("\", ");
+    }
+    buffer.append("(hash)");
+    append_hex(buffer, m_dict_hash);
+    buffer.append("]");
+    render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_RESET, console_colors);
+    render_color(buffer, util::CONSOLE_COLOR_CODE::FG_DEFAULT, console_colors);
+}
+
+// ** ====== FORM FIELD ELEM ====== ** //
+
+form_field_elem::form_field_elem(stream_elem::private_tag t, const std::string& t_name, const std::string& t_field_type, const std::string& t_value) :
+    stream_elem(t, stream_type::form_field),
+    m_name(t_name),
+    m_field_type(t_field_type),
+    m_value(t_value) {}
+
+bool form_field_elem::compare(const rstream_elem& t_other) {
+    if (t_other->type() != stream_type::form_field) {
+        return false;
+    }
+
+    auto other = t_other->as<form_field_elem>();
+    return m_name == other->name() && m_field_type == other->field_type() && m_value == other->value();
+}
+
+size_t form_field_elem::hash() const {
+    size_t h = hash_combine(static_cast<size_t>(stream_type::form_field), std::hash<std::string>{}(m_name));
+    h = hash_combine(h, std::hash<std::string>{}(m_field_type));
+    return hash_combine(h, std::hash<std::string>{}(m_value));
+}
+
+void form_field_elem::render_to(std::string& buffer, bool console_colors) const {
+    render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_BOLD, console_colors);
+    render_color(buffer, util::CONSOLE_COLOR_CODE::FG_LIGHT_MAGENTA, console_colors);
+    buffer.append("[Form field: ");
+    buffer.append(m_name);
+    buffer.append(", ");
+    buffer.append(m_field_type);
+    buffer.append(", \"");
+    buffer.append(m_value);
+    buffer.append("\"]");
+    render_color(buffer, util::CONSOLE_COLOR_CODE::TEXT_RESET, console_colors);
+    render_color(buffer, util::CONSOLE_COLOR_CODE::FG_DEFAULT, console_colors);
 }
 
 } // namespace pdif
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include <pdif/text_segmenter.hpp>
+
+#include <utf8proc.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace pdif {
+
+namespace {
+
+inline bool is_space(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+#if defined(__SSE2__)
+// a bit per byte of the 16 at p, set where the byte is whitespace
+inline int space_mask(const char* p) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    // '\t'..'\r' is the range 9..13, v - 9 saturating-minus 4 is zero only inside it
+    const __m128i shifted = _mm_subs_epu8(_mm_sub_epi8(v, _mm_set1_epi8('\t')), _mm_set1_epi8('\r' - '\t'));
+    const __m128i control = _mm_cmpeq_epi8(shifted, _mm_setzero_si128());
+    return _mm_movemask_epi8(_mm_or_si128(space, control));
+}
+#endif
+
+// the first byte at or after pos with the high bit set, i.e. the first non-ASCII byte
+size_t find_non_ascii(std::string_view s, size_t pos) {
+    size_t i = pos;
+
+#if defined(__SSE2__)
+    for (; i + 16 <= s.size(); i += 16) {
+        int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s.data() + i)));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+    for (; i < s.size(); i++) {
+        if (static_cast<unsigned char>(s[i]) >= 0x80) {
+            return i;
+        }
+    }
+
+    return s.size();
+}
+
+template<bool want_space>
+size_t find_class(std::string_view s, size_t pos) {
+    size_t i = pos;
+
+#if defined(__SSE2__)
+    for (; i + 16 <= s.size(); i += 16) {
+        int mask = space_mask(s.data() + i);
+        if constexpr (!want_space) {
+            mask = ~mask & 0xffff;
+        }
+
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+    for (; i < s.size(); i++) {
+        if (is_space(s[i]) == want_space) {
+            return i;
+        }
+    }
+
+    return std::string_view::npos;
+}
+
+}
+
+size_t text_segmenter::find_space(std::string_view s, size_t pos) {
+    return find_class<true>(s, pos);
+}
+
+size_t text_segmenter::find_non_space(std::string_view s, size_t pos) {
+    return find_class<false>(s, pos);
+}
+
+void text_segmenter::push(std::string_view text, const segment_callback& emit) {
+    switch (m_g) {
+        case granularity::letter:
+            push_letters(text, emit);
+            break;
+        case granularity::word:
+            push_words(text, emit);
+            break;
+        case granularity::sentence:
+            push_sentences(text, emit);
+            break;
+    }
+}
+
+void text_segmenter::flush(const segment_callback& emit) {
+    if (!m_pending.empty()) {
+        emit(m_pending);
+        m_pending.clear();
+    }
+}
+
+void text_segmenter::push_letters(std::string_view text, const segment_callback& emit) {
+    size_t i = 0;
+
+    while (i < text.size()) {
+        // an ASCII byte followed by another ASCII byte is a cluster on its own (except CR LF), so runs of
+        // ASCII are emitted without decoding. The last byte of a run may be extended by what follows it
+        size_t ascii_end = find_non_ascii(text, i);
+        size_t run_end = (ascii_end == text.size() || ascii_end == i) ? ascii_end : ascii_end - 1;
+        for (; i < run_end; i++) {
+            if (text[i] == '\r' && i + 1 < text.size() && text[i + 1] == '\n') {
+                emit(text.substr(i, 2));
+                i++;
+            } else if (text[i] != ' ') {
+                emit(text.substr(i, 1));
+            }
+        }
+
+        if (i == text.size()) {
+            break;
+        }
+
+        size_t end = grapheme_end(text, i);
+        if (end - i != 1 || text[i] != ' ') {
+            emit(text.substr(i, end - i));
+        }
+        i = end;
+    }
+}
+
+size_t text_segmenter::grapheme_end(std::string_view text, size_t pos) {
+    const utf8proc_uint8_t* data = reinterpret_cast<const utf8proc_uint8_t*>(text.data());
+
+    utf8proc_int32_t prev;
+    utf8proc_ssize_t len = utf8proc_iterate(data + pos, text.size() - pos, &prev);
+    if (len <= 0) {
+        // invalid UTF-8 is kept byte by byte
+        return pos + 1;
+    }
+
+    utf8proc_int32_t state = 0;
+    size_t end = pos + len;
+    while (end < text.size()) {
+        utf8proc_int32_t next;
+        len = utf8proc_iterate(data + end, text.size() - end, &next);
+        if (len <= 0 || utf8proc_grapheme_break_stateful(prev, next, &state)) {
+            break;
+        }
+
+        prev = next;
+        end += len;
+    }
+
+    return end;
+}
+
+void text_segmenter::push_words(std::string_view text, const segment_callback& emit) {
+    size_t start = find_non_space(text, 0);
+    while (start != std::string_view::npos) {
+        size_t end = find_space(text, start);
+        if (end == std::string_view::npos) {
+            emit(text.substr(start));
+            break;
+        }
+
+        emit(text.substr(start, end - start));
+        start = find_non_space(text, end);
+    }
+}
+
+void text_segmenter::push_sentences(std::string_view text, const segment_callback& emit) {
+    if (m_pending.empty()) {
+        // nothing carried over, segment the text in place and keep only the remainder
+        size_t rest = emit_sentences(text, 0, 0, emit);
+        m_pending.assign(text.substr(rest));
+        return;
+    }
+
+    // the pending text has no full stop, so only the new text needs scanning
+    m_pending.push_back(' ');
+    size_t scan = m_pending.size();
+    m_pending.append(text);
+
+    size_t rest = emit_sentences(m_pending, 0, scan, emit);
+    m_pending.erase(0, rest);
+}
+
+size_t text_segmenter::emit_sentences(std::string_view buffer, size_t start, size_t scan, const segment_callback& emit) {
+    size_t fullstop_pos = buffer.find('.', scan);
+    while (fullstop_pos != std::string_view::npos) {
+        emit(buffer.substr(start, fullstop_pos + 1 - start));
+        start = fullstop_pos + 1;
+        if (start == buffer.size()) {
+            break;
+        }
+
+        if (buffer[start] == ' ') {
+            start++;
+        }
+
+        fullstop_pos = buffer.find('.', start);
+    }
+
+    return start;
+}
+
+}
@@ -0,0 +1,315 @@
+#include <pdif/xmp_parser.hpp>
+
+#include <cstdlib>
+
+namespace pdif {
+
+static inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool starts_with(std::string_view s, size_t pos, std::string_view prefix) {
+    return s.compare(pos, prefix.size(), prefix) == 0;
+}
+
+static void append_utf8(std::string& out, unsigned long cp) {
+    if (cp < 0x80) {
+        out.push_back((char)cp);
+    } else if (cp < 0x800) {
+        out.push_back((char)(0xc0 | (cp >> 6)));
+        out.push_back((char)(0x80 | (cp & 0x3f)));
+    } else if (cp < 0x10000) {
+        out.push_back((char)(0xe0 | (cp >> 12)));
+        out.push_back((char)(0x80 | ((cp >> 6) & 0x3f)));
+        out.push_back((char)(0x80 | (cp & 0x3f)));
+    } else {
+        out.push_back((char)(0xf0 | (cp >> 18)));
+        out.push_back((char)(0x80 | ((cp >> 12) & 0x3f)));
+        out.push_back((char)(0x80 | ((cp >> 6) & 0x3f)));
+        out.push_back((char)(0x80 | (cp & 0x3f)));
+    }
+}
+
+static std::string_view trim(std::string_view s) {
+    size_t begin = 0;
+    size_t end = s.size();
+    while (begin < end && is_space(s[begin])) {
+        begin++;
+    }
+    while (end > begin && is_space(s[end - 1])) {
+        end--;
+    }
+    return s.substr(begin, end - begin);
+}
+
+void xmp_parser::parse(std::string_view packet, const property_callback_f& callback) {
+    xmp_parser parser(packet, callback);
+    parser.run();
+}
+
+xmp_parser::xmp_parser(std::string_view packet, const property_callback_f& callback) : m_packet(packet), m_callback(callback) {
+    // the document itself, the parent of the outermost element
+    frame root;
+    root.container = true;
+    m_stack.push_back(std::move(root));
+}
+
+void xmp_parser::run() {
+    while (m_pos < m_packet.size()) {
+        if (m_packet[m_pos] != '<') {
+            parse_text();
+        } else if (starts_with(m_packet, m_pos, "<!--")) {
+            skip_until("-->");
+        } else if (starts_with(m_packet, m_pos, "<![CDATA[")) {
+            size_t begin = m_pos + 9;
+            skip_until("]]>");
+            m_stack.back().text.append(m_packet.substr(begin, m_pos - 3 - begin));
+        } else if (starts_with(m_packet, m_pos, "<?")) {
+            skip_until("?>");
+        } else if (starts_with(m_packet, m_pos, "<!")) {
+            // a DOCTYPE, skipping its internal subset if any
+            int depth = 0;
+            for (; m_pos < m_packet.size(); m_pos++) {
+                char c = m_packet[m_pos];
+                if (c == '[') {
+                    depth++;
+                } else if (c == ']') {
+                    depth--;
+                } else if (c == '>' && depth <= 0) {
+                    break;
+                }
+            }
+            if (m_pos == m_packet.size()) {
+                fail("unterminated declaration");
+            }
+            m_pos++;
+        } else if (starts_with(m_packet, m_pos, "</")) {
+            parse_end_tag();
+        } else {
+            parse_start_tag();
+        }
+    }
+
+    if (m_stack.size() != 1) {
+        fail("unclosed element " + m_stack.back().name);
+    }
+}
+
+void xmp_parser::skip_until(std::string_view terminator) {
+    size_t end = m_packet.find(terminator, m_pos);
+    if (end == std::string_view::npos) {
+        fail("missing " + std::string(terminator));
+    }
+    m_pos = end + terminator.size();
+}
+
+void xmp_parser::skip_space() {
+    while (m_pos < m_packet.size() && is_space(m_packet[m_pos])) {
+        m_pos++;
+    }
+}
+
+std::string xmp_parser::parse_name() {
+    size_t begin = m_pos;
+    while (m_pos < m_packet.size()) {
+        char c = m_packet[m_pos];
+        if (is_space(c) || c == '/' || c == '>' || c == '<' || c == '=' || c == '"' || c == '\'') {
+            break;
+        }
+        m_pos++;
+    }
+
+    if (m_pos == begin) {
+        fail("expected a name");
+    }
+    return std::string(m_packet.substr(begin, m_pos - begin));
+}
+
+void xmp_parser::parse_text() {
+    size_t end = m_packet.find('<', m_pos);
+    if (end == std::string_view::npos) {
+        end = m_packet.size();
+    }
+
+    decode(m_packet.substr(m_pos, end - m_pos), m_stack.back().text);
+    m_pos = end;
+}
+
+void xmp_parser::parse_start_tag() {
+    m_pos++;
+    std::string name = parse_name();
+
+    std::vector<std::pair<std::string, std::string>> attributes;
+    bool self_closing = false;
+    while (true) {
+        skip_space();
+        if (m_pos >= m_packet.size()) {
+            fail("unterminated tag " + name);
+        }
+
+        if (m_packet[m_pos] == '>') {
+            m_pos++;
+            break;
+        }
+        if (starts_with(m_packet, m_pos, "/>")) {
+            m_pos += 2;
+            self_closing = true;
+            break;
+        }
+
+        std::string attribute = parse_name();
+        skip_space();
+        if (m_pos >= m_packet.size() || m_packet[m_pos] != '=') {
+            fail("expected '=' after attribute " + attribute);
+        }
+        m_pos++;
+        skip_space();
+
+        char quote = m_pos < m_packet.size() ? m_packet[m_pos] : '\0';
+        if (quote != '"' && quote != '\'') {
+            fail("expected a quoted value for attribute " + attribute);
+        }
+        size_t end = m_packet.find(quote, m_pos + 1);
+        if (end == std::string_view::npos) {
+            fail("unterminated value of attribute " + attribute);
+        }
+
+        std::string value;
+        decode(m_packet.substr(m_pos + 1, end - m_pos - 1), value);
+        attributes.emplace_back(std::move(attribute), std::move(value));
+        m_pos = end + 1;
+    }
+
+    frame& parent = m_stack.back();
+    parent.has_children = true;
+
+    frame f;
+    f.name = name;
+
+    if (name == "rdf:li") {
+        parent.items++;
+
+        std::string item = std::to_string(parent.items);
+        for (auto& [attribute, value] : attributes) {
+            if (attribute == "xml:lang") {
+                item = value;
+            }
+        }
+        f.path = parent.path + "[" + item + "]";
+    } else if (is_container(name)) {
+        f.container = true;
+        f.path = parent.path;
+    } else {
+        f.path = join(parent.path, name);
+    }
+
+    // only rdf:Description and property elements carry properties as attributes
+    if (!f.container || name == "rdf:Description") {
+        for (auto& [attribute, value] : attributes) {
+            if (attribute == "rdf:resource") {
+                f.text = value;
+            } else if (attribute == "xml:lang" || attribute.rfind("xmlns", 0) == 0 || attribute.rfind("rdf:", 0) == 0) {
+                continue;
+            } else {
+                m_callback(join(f.path, attribute), value);
+                f.has_children = !f.container;
+            }
+        }
+    }
+
+    m_stack.push_back(std::move(f));
+    if (self_closing) {
+        close_element();
+    }
+}
+
+void xmp_parser::parse_end_tag() {
+    m_pos += 2;
+    std::string name = parse_name();
+    skip_space();
+    if (m_pos >= m_packet.size() || m_packet[m_pos] != '>') {
+        fail("unterminated end tag " + name);
+    }
+    m_pos++;
+
+    if (m_stack.size() == 1 || m_stack.back().name != name) {
+        fail("unexpected end tag " + name);
+    }
+    close_element();
+}
+
+void xmp_parser::close_element() {
+    frame f = std::move(m_stack.back());
+    m_stack.pop_back();
+
+    // elements with fields or items are structures or arrays, their own text is only indentation
+    if (!f.container && !f.has_children) {
+        m_callback(f.path, std::string(trim(f.text)));
+    }
+}
+
+void xmp_parser::fail(const std::string& what) const {
+    PDIF_LOG_ERROR("xmp_parser::parse - {} at offset {}", what, m_pos);
+    throw pdif::pdif_invalid_format("xmp_parser::parse - " + what + " at offset " + std::to_string(m_pos));
+}
+
+bool xmp_parser::is_container(std::string_view name) {
+    return name == "x:xmpmeta" || name == "x:xapmeta" || name == "rdf:RDF" || name == "rdf:Description" ||
+           name == "rdf:Seq" || name == "rdf:Bag" || name == "rdf:Alt";
+}
+
+std::string xmp_parser::join(const std::string& path, std::string_view name) {
+    if (path.empty()) {
+        return std::string(name);
+    }
+    return path + "/" + std::string(name);
+}
+
+void xmp_parser::decode(std::string_view raw, std::string& out) {
+    size_t pos = 0;
+    while (pos < raw.size()) {
+        size_t amp = raw.find('&', pos);
+        if (amp == std::string_view::npos) {
+            out.append(raw.substr(pos));
+            return;
+        }
+        out.append(raw.substr(pos, amp - pos));
+
+        size_t semi = raw.find(';', amp);
+        if (semi == std::string_view::npos) {
+            out.append(raw.substr(amp));
+            return;
+        }
+
+        std::string_view entity = raw.substr(amp + 1, semi - amp - 1);
+        if (entity == "lt") {
+            out.push_back('<');
+        } else if (entity == "gt") {
+            out.push_back('>');
+        } else if (entity == "amp") {
+            out.push_back('&');
+        } else if (entity == "quot") {
+            out.push_back('"');
+        } else if (entity == "apos") {
+            out.push_back('\'');
+        } else if (entity.size() > 1 && entity[0] == '#') {
+            bool hex = entity[1] == 'x' || entity[1] == 'X';
+            std::string digits(entity.substr(hex ? 2 : 1));
+
+            char* end = nullptr;
+            unsigned long cp = std::strtoul(digits.c_str(), &end, hex ? 16 : 10);
+            if (digits.empty() || *end != '\0' || cp > 0x10ffff) {
+                out.append(raw.substr(amp, semi - amp + 1));
+            } else {
+                append_utf8(out, cp);
+            }
+        } else {
+            // unknown entities are kept as written
+            out.append(raw.substr(amp, semi - amp + 1));
+        }
+
+        pos = semi + 1;
+    }
+}
+
+} // namespace pdif
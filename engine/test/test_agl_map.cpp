@@ -1,6 +1,29 @@
 #include <gtest/gtest.h>
 #include <pdif/agl_map.hpp>
 
+#include <thread>
+#include <vector>
+
+// declared first so that the threads race on loading the map; run under PDIF_SANITIZE_THREAD
+TEST(PDIFAglMap, GlyphToUnicodeConcurrentFirstUse) {
+    std::vector<std::thread> threads;
+    std::vector<std::string> results(8);
+    for (size_t t = 0; t < results.size(); t++) {
+        threads.emplace_back([&results, t] {
+            for (int i = 0; i < 100; i++) {
+                results[t] = pdif::agl_map::glyph_to_utf8(t % 2 ? "comma" : "not_a_glyph_name");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (size_t t = 0; t < results.size(); t++) {
+        EXPECT_EQ(results[t], t % 2 ? "," : "not_a_glyph_name");
+    }
+}
+
 TEST(PDIFAglMap, GlyphToUnicodeA) {
     std::string glyph = "A";
     std::string unicode = pdif::agl_map::glyph_to_utf8(glyph);
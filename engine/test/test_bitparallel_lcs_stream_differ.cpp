@@ -0,0 +1,438 @@
+#include <gtest/gtest.h>
+#include <pdif/bitparallel_lcs_stream_differ.hpp>
+#include <pdif/stream.hpp>
+#include <pdif/stream_elem.hpp>
+#include <pdif/lcs_stream_differ.hpp>
+
+#include <random>
+
+TEST(PDIFBitparallelLcsStreamDiffer, TestAdd) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+
+    pdif::bitparallel_lcs_stream_differ differ(stream1, stream2);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 2);
+
+    auto edit_op = diff.get_edit_op(0);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+    ASSERT_EQ(edit_op.has_arg(), false);
+
+    edit_op = diff.get_edit_op(1);
+
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(edit_op.has_arg(), true);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::text_elem>()->text(), "World");
+}
+
+TEST(PDIFBitparallelLcsStreamDiffer, TestDelete) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+
+    pdif::bitparallel_lcs_stream_differ differ(stream1, stream2);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 2);
+
+    auto edit_op = diff.get_edit_op(0);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+    ASSERT_EQ(edit_op.has_arg(), false);
+
+    edit_op = diff.get_edit_op(1);
+
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::DELETE);
+    ASSERT_EQ(edit_op.has_arg(), false);
+}
+
+TEST(PDIFBitparallelLcsStreamDiffer, TestReplace) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("World!"));
+
+    pdif::bitparallel_lcs_stream_differ differ(stream1, stream2);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 3);
+
+    auto edit_op = diff.get_edit_op(0);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+    ASSERT_EQ(edit_op.has_arg(), false);
+
+    edit_op = diff.get_edit_op(1);
+
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(edit_op.has_arg(), true);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::text_elem>()->text(), "World!");
+
+    edit_op = diff.get_edit_op(2);
+
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::DELETE);
+    ASSERT_EQ(edit_op.has_arg(), false);
+}
+
+TEST(PDIFBitparallelLcsStreamDiffer, TestEmpty) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    pdif::bitparallel_lcs_stream_differ differ(stream1, stream2);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 0);
+}
+
+TEST(PDIFBitparallelLcsStreamDiffer, TestNoChange) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+
+    pdif::bitparallel_lcs_stream_differ differ(stream1, stream2);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 1);
+
+    auto edit_op = diff.get_edit_op(0);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+    ASSERT_EQ(edit_op.has_arg(), false);
+}
+
+TEST(PDIFBitparallelLcsStreamDiffer, TestBigChange) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("The"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("quick"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("brown"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("fox"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("jumps"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("over"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("the"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("lazy"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("dog")); 
+
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("The"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("fast"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("brown"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("cat"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("over"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("the"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("lazy"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("mouse"));
+
+    pdif::bitparallel_lcs_stream_differ differ(stream1, stream2);
+
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 12);
+
+    auto edit_op = diff.get_edit_op(0);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+    
+    edit_op = diff.get_edit_op(1);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(edit_op.has_arg(), true);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::text_elem>()->text(), "fast");
+
+    edit_op = diff.get_edit_op(2);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::DELETE);
+
+    edit_op = diff.get_edit_op(3);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+
+    edit_op = diff.get_edit_op(4);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(edit_op.has_arg(), true);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::text_elem>()->text(), "cat");
+
+    edit_op = diff.get_edit_op(5);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::DELETE);
+
+    edit_op = diff.get_edit_op(6);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::DELETE);
+
+    edit_op = diff.get_edit_op(7);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+
+    edit_op = diff.get_edit_op(8);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+
+    edit_op = diff.get_edit_op(9);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+
+    edit_op = diff.get_edit_op(10);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(edit_op.has_arg(), true);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::text_elem>()->text(), "mouse");
+
+    edit_op = diff.get_edit_op(11);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::DELETE);
+}
+
+TEST(PDIFBitparallelLcsStreamDiffer, TestAddFont) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::font_elem>("Arial", 12));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+
+    stream2.push_back(pdif::stream_elem::create<pdif::font_elem>("Arial", 12));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream2.push_back(pdif::stream_elem::create<pdif::font_elem>("CM10", 12));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+
+    pdif::bitparallel_lcs_stream_differ differ(stream1, stream2);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 4);
+
+    auto edit_op = diff.get_edit_op(0);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+    ASSERT_EQ(edit_op.has_arg(), false);
+
+    edit_op = diff.get_edit_op(1);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+    ASSERT_EQ(edit_op.has_arg(), false);
+
+    edit_op = diff.get_edit_op(2);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(edit_op.has_arg(), true);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::font_elem>()->font_name(), "CM10");
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::font_elem>()->font_size(), 12);
+
+    edit_op = diff.get_edit_op(3);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+    ASSERT_EQ(edit_op.has_arg(), false);
+}
+
+TEST(PDIFBitparallelLcsStreamDiffer, TestAddTextColor) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_color_elem>(0, 0, 0));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+
+    stream2.push_back(pdif::stream_elem::create<pdif::text_color_elem>(0, 0, 0));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_color_elem>(0, 1, 0));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+
+    pdif::bitparallel_lcs_stream_differ differ(stream1, stream2);
+
+    pdif::diff diff;
+    
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 4);
+
+    auto edit_op = diff.get_edit_op(0);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+
+    edit_op = diff.get_edit_op(1);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+
+    edit_op = diff.get_edit_op(2);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(edit_op.has_arg(), true);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::text_color_elem>()->red(), 0);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::text_color_elem>()->green(), 1);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::text_color_elem>()->blue(), 0);
+
+    edit_op = diff.get_edit_op(3);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+}
+
+TEST(PDIFBitparallelLcsStreamDiffer, TestAddStrokeColor) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::stroke_color_elem>(0, 0, 0));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+
+    stream2.push_back(pdif::stream_elem::create<pdif::stroke_color_elem>(0, 0, 0));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream2.push_back(pdif::stream_elem::create<pdif::stroke_color_elem>(0, 1, 0));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+
+    pdif::bitparallel_lcs_stream_differ differ(stream1, stream2);
+
+    pdif::diff diff;
+    
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 4);
+
+    auto edit_op = diff.get_edit_op(0);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+
+    edit_op = diff.get_edit_op(1);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+
+    edit_op = diff.get_edit_op(2);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(edit_op.has_arg(), true);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::stroke_color_elem>()->red(), 0);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::stroke_color_elem>()->green(), 1);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::stroke_color_elem>()->blue(), 0);
+
+    edit_op = diff.get_edit_op(3);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+}
+
+TEST(PDIFBitparallelLcsStreamDiffer, TestAddXObjectImg) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::xobject_img_elem>("img1", 300, 300));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+
+    stream2.push_back(pdif::stream_elem::create<pdif::xobject_img_elem>("img1", 300, 300));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream2.push_back(pdif::stream_elem::create<pdif::xobject_img_elem>("img2", 200, 200));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+
+    pdif::bitparallel_lcs_stream_differ differ(stream1, stream2);
+
+    pdif::diff diff;
+    
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 4);
+
+    auto edit_op = diff.get_edit_op(0);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+
+    edit_op = diff.get_edit_op(1);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+
+    edit_op = diff.get_edit_op(2);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(edit_op.has_arg(), true);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::xobject_img_elem>()->image_hash(), "img2");
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::xobject_img_elem>()->width(), 200);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::xobject_img_elem>()->height(), 200);
+
+    edit_op = diff.get_edit_op(3);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+}
+
+TEST(PDIFBitparallelLcsStreamDiffer, TestMatchesLcs) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> letter('a', 'h');
+    std::uniform_int_distribution<int> length(0, 700);
+
+    for (int round = 0; round < 30; round++) {
+        pdif::stream stream1;
+        pdif::stream stream2;
+
+        int m = length(rng);
+        int n = length(rng);
+        for (int i = 0; i < m; i++) {
+            stream1.push_back(pdif::stream_elem::create<pdif::text_elem>(std::string(1, (char)letter(rng))));
+        }
+        for (int j = 0; j < n; j++) {
+            stream2.push_back(pdif::stream_elem::create<pdif::text_elem>(std::string(1, (char)letter(rng))));
+        }
+
+        pdif::bitparallel_lcs_stream_differ differ(stream1, stream2);
+        pdif::diff diff;
+        ASSERT_NO_THROW(differ.diff(diff));
+
+        pdif::lcs_stream_differ reference(stream1, stream2);
+        pdif::diff expected;
+        ASSERT_NO_THROW(reference.diff(expected));
+
+        int plus, minus, eq;
+        diff.count_edit_op_types(plus, minus, eq);
+
+        int expected_plus, expected_minus, expected_eq;
+        expected.count_edit_op_types(expected_plus, expected_minus, expected_eq);
+
+        // both scripts are optimal, so the LCS lengths match
+        ASSERT_EQ(eq, expected_eq);
+        ASSERT_EQ(eq + minus, m);
+        ASSERT_EQ(eq + plus, n);
+
+        pdif::stream result = stream1;
+        ASSERT_NO_THROW(diff.apply_edit_script(result));
+        ASSERT_EQ((int)result.size(), n);
+        for (int j = 0; j < n; j++) {
+            ASSERT_TRUE(result[j]->compare(stream2[j]));
+        }
+    }
+}
+
+TEST(PDIFBitparallelLcsStreamDiffer, TestMatchesLcsLongRuns) {
+    // long runs of one symbol make all-ones words, whose carries ripple across vector lanes
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> length(256, 700);
+    std::uniform_int_distribution<int> rare(0, 40);
+
+    for (int round = 0; round < 10; round++) {
+        pdif::stream stream1;
+        pdif::stream stream2;
+
+        int m = length(rng);
+        int n = length(rng);
+        for (int i = 0; i < m; i++) {
+            stream1.push_back(pdif::stream_elem::create<pdif::text_elem>(rare(rng) == 0 ? "b" : "a"));
+        }
+        for (int j = 0; j < n; j++) {
+            stream2.push_back(pdif::stream_elem::create<pdif::text_elem>(rare(rng) == 0 ? "b" : "a"));
+        }
+
+        pdif::bitparallel_lcs_stream_differ differ(stream1, stream2);
+        pdif::diff diff;
+        ASSERT_NO_THROW(differ.diff(diff));
+
+        pdif::lcs_stream_differ reference(stream1, stream2);
+        pdif::diff expected;
+        ASSERT_NO_THROW(reference.diff(expected));
+
+        int plus, minus, eq;
+        diff.count_edit_op_types(plus, minus, eq);
+
+        int expected_plus, expected_minus, expected_eq;
+        expected.count_edit_op_types(expected_plus, expected_minus, expected_eq);
+
+        ASSERT_EQ(eq, expected_eq);
+        ASSERT_EQ(eq + minus, m);
+        ASSERT_EQ(eq + plus, n);
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
\ No newline at end of file
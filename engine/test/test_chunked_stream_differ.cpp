@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <pdif/chunked_stream_differ.hpp>
+#include <pdif/histogram_stream_differ.hpp>
+#include <pdif/stream.hpp>
+#include <pdif/stream_elem.hpp>
+
+#include <random>
+
+static pdif::stream random_words(std::mt19937& rng, int count) {
+    std::uniform_int_distribution<int> word(0, 500);
+
+    pdif::stream s;
+    for (int i = 0; i < count; i++) {
+        s.push_back(pdif::stream_elem::create<pdif::text_elem>("w" + std::to_string(word(rng))));
+    }
+    return s;
+}
+
+static void assert_applies(const pdif::diff& diff, const pdif::stream& stream1, const pdif::stream& stream2) {
+    pdif::stream result = stream1;
+    ASSERT_NO_THROW(diff.apply_edit_script(result));
+    ASSERT_EQ(result.size(), stream2.size());
+    for (size_t j = 0; j < stream2.size(); j++) {
+        ASSERT_TRUE(result[j]->compare(stream2[j]));
+    }
+}
+
+TEST(PDIFChunkedStreamDiffer, TestSplitCoversStream) {
+    std::mt19937 rng(1);
+    pdif::stream s = random_words(rng, 5000);
+
+    auto chunks = pdif::content_chunker::split(s);
+    ASSERT_GT(chunks.size(), 1);
+
+    size_t pos = 0;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        ASSERT_EQ(chunks[i].start, pos);
+        ASSERT_LE(chunks[i].size, pdif::content_chunker::MAX_CHUNK);
+        if (i + 1 < chunks.size()) {
+            ASSERT_GE(chunks[i].size, pdif::content_chunker::MIN_CHUNK);
+        }
+        pos += chunks[i].size;
+    }
+    ASSERT_EQ(pos, s.size());
+
+    ASSERT_EQ(pdif::content_chunker::split(pdif::stream()).size(), 0);
+}
+
+TEST(PDIFChunkedStreamDiffer, TestCutPointsAreContentDefined) {
+    std::mt19937 rng(2);
+    pdif::stream s1 = random_words(rng, 5000);
+    pdif::stream s2 = s1;
+    s2.push(10, pdif::stream_elem::create<pdif::text_elem>("inserted"));
+
+    auto c1 = pdif::content_chunker::split(s1);
+    auto c2 = pdif::content_chunker::split(s2);
+
+    // the chunks after the edit are the same, shifted by one element
+    ASSERT_EQ(c1.back().hash, c2.back().hash);
+    ASSERT_EQ(c1.back().start + 1, c2.back().start);
+}
+
+TEST(PDIFChunkedStreamDiffer, TestAlignSmallEdit) {
+    std::mt19937 rng(3);
+    pdif::stream s1 = random_words(rng, 5000);
+    pdif::stream s2 = s1;
+    s2.pop(2500);
+    s2.push(2500, pdif::stream_elem::create<pdif::text_elem>("changed"));
+
+    auto ranges = pdif::content_chunker::align(s1, s2);
+
+    size_t unmatched = 0;
+    for (const auto& r : ranges) {
+        if (!r.equal) {
+            unmatched += r.a1 - r.a0;
+        }
+    }
+
+    // only the chunks around the edit are left to diff
+    ASSERT_GT(unmatched, 0);
+    ASSERT_LE(unmatched, 3 * pdif::content_chunker::MAX_CHUNK);
+}
+
+TEST(PDIFChunkedStreamDiffer, TestDiffAppliesToSecondStream) {
+    std::mt19937 rng(4);
+
+    for (int round = 0; round < 20; round++) {
+        pdif::stream stream1 = random_words(rng, 2000);
+        pdif::stream stream2 = stream1;
+
+        std::uniform_int_distribution<int> edits(1, 10);
+        int count = edits(rng);
+        for (int e = 0; e < count; e++) {
+            std::uniform_int_distribution<size_t> at(0, stream2.size() - 1);
+            size_t pos = at(rng);
+            switch (rng() % 3) {
+                case 0:
+                    stream2.pop(pos);
+                    break;
+                case 1:
+                    stream2.push(pos, pdif::stream_elem::create<pdif::text_elem>("new"));
+                    break;
+                default:
+                    stream2[pos] = pdif::stream_elem::create<pdif::text_elem>("swapped");
+                    break;
+            }
+        }
+
+        pdif::chunked_stream_differ<pdif::histogram_stream_differ> differ(stream1, stream2);
+        pdif::diff diff;
+        ASSERT_NO_THROW(differ.diff(diff));
+
+        int plus, minus, eq;
+        diff.count_edit_op_types(plus, minus, eq);
+        ASSERT_LE(plus + minus, 4 * count);
+
+        assert_applies(diff, stream1, stream2);
+    }
+}
+
+TEST(PDIFChunkedStreamDiffer, TestEmptyStreams) {
+    std::mt19937 rng(5);
+    pdif::stream words = random_words(rng, 100);
+    pdif::stream empty;
+
+    pdif::diff inserted;
+    pdif::chunked_stream_differ<> insert_all(empty, words);
+    insert_all.diff(inserted);
+    assert_applies(inserted, empty, words);
+
+    pdif::diff deleted;
+    pdif::chunked_stream_differ<> delete_all(words, empty);
+    delete_all.diff(deleted);
+    assert_applies(deleted, words, empty);
+
+    pdif::diff none;
+    pdif::chunked_stream_differ<> both_empty(empty, empty);
+    both_empty.diff(none);
+    ASSERT_EQ(none.edit_op_size(), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <pdif/compare_cache.hpp>
+
+#include <filesystem>
+#include <fstream>
+
+class PDIFCompareCache : public ::testing::Test {
+protected:
+
+    void SetUp() override {
+        m_dir = std::filesystem::temp_directory_path() / ("pdif_compare_cache_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(m_dir);
+
+        write_file(m_dir / "a.pdf", "first document");
+        write_file(m_dir / "b.pdf", "second document");
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(m_dir);
+    }
+
+    static void write_file(const std::filesystem::path& path, const std::string& content) {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream file(path, std::ios::binary);
+        file << content;
+    }
+
+    static pdif::diff make_diff() {
+        pdif::stream original;
+        original.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+
+        pdif::diff d(false);
+        d.add_original_stream(original);
+        d.add_edit_op(pdif::edit_op(pdif::edit_op_type::INSERT, pdif::stream_elem::create<pdif::text_elem>("World")));
+        d.add_edit_op(pdif::edit_op(pdif::edit_op_type::DELETE));
+        return d;
+    }
+
+    std::filesystem::path m_dir;
+};
+
+TEST_F(PDIFCompareCache, TestKeyDependsOnContentAndOptions) {
+    pdif::compare_options options;
+    std::string a = (m_dir / "a.pdf").string();
+    std::string b = (m_dir / "b.pdf").string();
+
+    std::string key = pdif::compare_cache::make_key(a, b, options);
+    ASSERT_EQ(key, pdif::compare_cache::make_key(a, b, options));
+    ASSERT_NE(key, pdif::compare_cache::make_key(b, a, options));
+
+    pdif::compare_options letter = options;
+    letter.g = pdif::granularity::letter;
+    ASSERT_NE(key, pdif::compare_cache::make_key(a, b, letter));
+
+    pdif::compare_options histogram = options;
+    histogram.differ = "histogram";
+    ASSERT_NE(key, pdif::compare_cache::make_key(a, b, histogram));
+
+    write_file(m_dir / "b.pdf", "second document, revised");
+    ASSERT_NE(key, pdif::compare_cache::make_key(a, b, options));
+}
+
+TEST_F(PDIFCompareCache, TestMissingFile) {
+    ASSERT_THROW(pdif::compare_cache::file_hash((m_dir / "missing.pdf").string()), pdif::pdif_invalid_argment);
+}
+
+TEST_F(PDIFCompareCache, TestHitMiss) {
+    pdif::compare_cache cache((m_dir / "cache").string());
+    std::string key = pdif::compare_cache::make_key((m_dir / "a.pdf").string(), (m_dir / "b.pdf").string(), pdif::compare_options());
+
+    ASSERT_FALSE(cache.load(key).has_value());
+    ASSERT_EQ(cache.stats().misses, 1);
+
+    cache.store(key, make_diff());
+    ASSERT_EQ(cache.stats().stores, 1);
+    ASSERT_EQ(cache.entries(), 1);
+
+    auto hit = cache.load(key, false);
+    ASSERT_TRUE(hit.has_value());
+    ASSERT_EQ(cache.stats().hits, 1);
+    ASSERT_EQ(hit->edit_op_size(), 2);
+    ASSERT_EQ(hit->get_edit_op(0).get_arg()->as<pdif::text_elem>()->text(), "World");
+
+    // a second cache object on the same directory sees the entry
+    pdif::compare_cache other((m_dir / "cache").string());
+    ASSERT_TRUE(other.load(key).has_value());
+}
+
+TEST_F(PDIFCompareCache, TestCorruptEntryIsMiss) {
+    pdif::compare_cache cache((m_dir / "cache").string());
+
+    cache.store("corrupt", make_diff());
+    write_file(m_dir / "cache" / "corrupt.pdifc", "garbage");
+
+    ASSERT_FALSE(cache.load("corrupt").has_value());
+    ASSERT_EQ(cache.stats().misses, 1);
+    ASSERT_EQ(cache.entries(), 0);
+}
+
+TEST_F(PDIFCompareCache, TestEviction) {
+    pdif::compare_cache probe((m_dir / "probe").string());
+    probe.store("probe", make_diff());
+    uintmax_t entry_size = probe.size_bytes();
+
+    // room for two entries
+    pdif::compare_cache cache((m_dir / "cache").string(), entry_size * 2);
+
+    cache.store("first", make_diff());
+    cache.store("second", make_diff());
+
+    // make first the oldest, then use it so second becomes least recently used
+    std::filesystem::last_write_time(m_dir / "cache" / "first.pdifc", std::filesystem::file_time_type::clock::now() - std::chrono::hours(2));
+    std::filesystem::last_write_time(m_dir / "cache" / "second.pdifc", std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+    ASSERT_TRUE(cache.load("first").has_value());
+
+    cache.store("third", make_diff());
+
+    ASSERT_EQ(cache.entries(), 2);
+    ASSERT_EQ(cache.stats().evictions, 1);
+    ASSERT_TRUE(cache.load("first").has_value());
+    ASSERT_FALSE(cache.load("second").has_value());
+    ASSERT_TRUE(cache.load("third").has_value());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
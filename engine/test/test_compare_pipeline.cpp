@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include <pdif/compare_pipeline.hpp>
+#include <pdif/lcs_stream_differ.hpp>
+
+#include "test_compare_util.hpp"
+
+TEST(PDIFComparePipeline, TestMatchesCompare) {
+    for (const auto& revision : REVISIONS) {
+        pdif::compare_pipeline pipeline("test_pdfs/multi_page.pdf", revision, pdif::compare_pipeline::make_differ<pdif::lcs_stream_differ>());
+        assert_same_diff(pipeline.run(), full_compare("test_pdfs/multi_page.pdf", revision));
+    }
+}
+
+TEST(PDIFComparePipeline, TestPageCallback) {
+    pdif::compare_pipeline pipeline("test_pdfs/multi_page.pdf", "test_pdfs/multi_page_added.pdf", pdif::compare_pipeline::make_differ<pdif::lcs_stream_differ>());
+
+    std::vector<size_t> pages;
+    size_t ops = 0;
+    pdif::diff d = pipeline.run([&](size_t page, const pdif::diff& page_diff) {
+        pages.push_back(page);
+        ops += page_diff.edit_op_size();
+        ASSERT_EQ(page_diff.meta_edit_op_size(), 0);
+    });
+
+    ASSERT_EQ(pages.size(), std::max(pdif::PDF("test_pdfs/multi_page.pdf").get_streams().size(), pdif::PDF("test_pdfs/multi_page_added.pdf").get_streams().size()));
+    for (size_t i = 0; i < pages.size(); i++) {
+        ASSERT_EQ(pages[i], i);
+    }
+    ASSERT_EQ(ops, d.edit_op_size());
+}
+
+TEST(PDIFComparePipeline, TestSinglePage) {
+    pdif::compare_pipeline pipeline("test_pdfs/multi_page.pdf", "test_pdfs/multi_page_2_text_add.pdf", pdif::compare_pipeline::make_differ<pdif::lcs_stream_differ>(), pdif::granularity::word, true, 1);
+
+    std::vector<size_t> pages;
+    pdif::diff d = pipeline.run([&](size_t page, const pdif::diff&) {
+        pages.push_back(page);
+    });
+
+    ASSERT_EQ(pages, std::vector<size_t>({1}));
+    assert_same_diff(d, full_compare("test_pdfs/multi_page.pdf", "test_pdfs/multi_page_2_text_add.pdf", pdif::granularity::word, 1));
+}
+
+TEST(PDIFComparePipeline, TestNoDiffer) {
+    ASSERT_THROW(pdif::compare_pipeline("test_pdfs/multi_page.pdf", "test_pdfs/multi_page.pdf", nullptr), pdif::pdif_invalid_argment);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <pdif/compare_session.hpp>
+#include <pdif/lcs_stream_differ.hpp>
+
+#include "test_compare_util.hpp"
+
+#include <filesystem>
+
+class PDIFCompareSession : public ::testing::Test {
+protected:
+
+    void SetUp() override {
+        m_revision = (std::filesystem::temp_directory_path() / "pdif_compare_session_revision.pdf").string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(m_revision);
+    }
+
+    void revise(const std::string& path) {
+        std::filesystem::copy_file(path, m_revision, std::filesystem::copy_options::overwrite_existing);
+    }
+
+    pdif::compare_session make_session() {
+        return pdif::compare_session("test_pdfs/multi_page.pdf", m_revision, pdif::compare_session::make_differ<pdif::lcs_stream_differ>(), pdif::granularity::sentence);
+    }
+
+    std::string m_revision;
+};
+
+TEST_F(PDIFCompareSession, TestInitialMatchesCompare) {
+    revise("test_pdfs/multi_page_2_text_add.pdf");
+    auto session = make_session();
+
+    assert_same_diff(session.get_diff(), full_compare("test_pdfs/multi_page.pdf", "test_pdfs/multi_page_2_text_add.pdf", pdif::granularity::sentence));
+    ASSERT_EQ(session.page_count(), 3);
+}
+
+TEST_F(PDIFCompareSession, TestUnchangedRevision) {
+    revise("test_pdfs/multi_page_2_text_add.pdf");
+    auto session = make_session();
+
+    ASSERT_EQ(session.update(), 0);
+    assert_same_diff(session.get_diff(), full_compare("test_pdfs/multi_page.pdf", "test_pdfs/multi_page_2_text_add.pdf", pdif::granularity::sentence));
+}
+
+TEST_F(PDIFCompareSession, TestOnlyChangedPagesAreDiffed) {
+    revise("test_pdfs/multi_page_2_text_add.pdf");
+    auto session = make_session();
+
+    revise("test_pdfs/multi_page_3_text_add.pdf");
+    size_t rediffed = session.update();
+    ASSERT_GT(rediffed, 0);
+    ASSERT_LT(rediffed, session.page_count());
+
+    assert_same_diff(session.get_diff(), full_compare("test_pdfs/multi_page.pdf", "test_pdfs/multi_page_3_text_add.pdf", pdif::granularity::sentence));
+}
+
+TEST_F(PDIFCompareSession, TestPageCountChanges) {
+    revise("test_pdfs/multi_page.pdf");
+    auto session = make_session();
+    ASSERT_EQ(session.get_diff().edit_op_size(), full_compare("test_pdfs/multi_page.pdf", "test_pdfs/multi_page.pdf", pdif::granularity::sentence).edit_op_size());
+
+    for (auto revision : {"test_pdfs/multi_page_added.pdf", "test_pdfs/multi_page_removed.pdf", "test_pdfs/multi_page.pdf"}) {
+        revise(revision);
+        session.update();
+        assert_same_diff(session.get_diff(), full_compare("test_pdfs/multi_page.pdf", revision, pdif::granularity::sentence));
+    }
+}
+
+TEST_F(PDIFCompareSession, TestPageDiff) {
+    revise("test_pdfs/multi_page.pdf");
+    auto session = make_session();
+
+    ASSERT_NO_THROW(session.page_diff(0));
+    ASSERT_THROW(session.page_diff(session.page_count()), pdif::pdif_out_of_bounds);
+}
+
+TEST_F(PDIFCompareSession, TestPageHashes) {
+    auto pdf = QPDF::create();
+    pdf->processFile("test_pdfs/multi_page.pdf");
+    auto hashes = pdif::compare_session::page_hashes(pdf);
+
+    auto revised = QPDF::create();
+    revised->processFile("test_pdfs/multi_page_added.pdf");
+    auto revised_hashes = pdif::compare_session::page_hashes(revised);
+
+    ASSERT_EQ(hashes.size() + 1, revised_hashes.size());
+    ASSERT_EQ(hashes[0].size(), 40);
+}
+
+TEST_F(PDIFCompareSession, TestPageHashesLinkedPageEdited) {
+    // page one links to page two with a destination and a GoTo action, only page two is edited
+    auto pdf = QPDF::create();
+    pdf->processFile("test_pdfs/link_initial.pdf");
+    auto hashes = pdif::compare_session::page_hashes(pdf);
+
+    auto revised = QPDF::create();
+    revised->processFile("test_pdfs/link_target_edited.pdf");
+    auto revised_hashes = pdif::compare_session::page_hashes(revised);
+
+    ASSERT_EQ(hashes.size(), 2);
+    ASSERT_EQ(revised_hashes.size(), 2);
+    ASSERT_EQ(hashes[0], revised_hashes[0]);
+    ASSERT_NE(hashes[1], revised_hashes[1]);
+
+    revise("test_pdfs/link_initial.pdf");
+    pdif::compare_session session("test_pdfs/link_initial.pdf", m_revision, pdif::compare_session::make_differ<pdif::lcs_stream_differ>(), pdif::granularity::sentence);
+
+    revise("test_pdfs/link_target_edited.pdf");
+    ASSERT_EQ(session.update(), 1);
+    assert_same_diff(session.get_diff(), full_compare("test_pdfs/link_initial.pdf", "test_pdfs/link_target_edited.pdf", pdif::granularity::sentence));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,86 @@
+#ifndef __PDIF_TEST_COMPARE_UTIL_HPP__
+#define __PDIF_TEST_COMPARE_UTIL_HPP__
+
+#include <gtest/gtest.h>
+#include <pdif/diff.hpp>
+#include <pdif/lcs_stream_differ.hpp>
+#include <pdif/pdf.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief shared helpers for the tests of the comparisons that must match PDF::compare
+ * (compare_session, multi_compare and compare_pipeline)
+ *
+ */
+
+/**
+ * @brief revisions of test_pdfs/multi_page.pdf: unchanged, text added, a page added and a page removed
+ *
+ */
+inline const std::vector<std::string> REVISIONS = {
+    "test_pdfs/multi_page.pdf",
+    "test_pdfs/multi_page_2_text_add.pdf",
+    "test_pdfs/multi_page_3_text_add.pdf",
+    "test_pdfs/multi_page_added.pdf",
+    "test_pdfs/multi_page_removed.pdf",
+};
+
+/**
+ * @brief assert that two diffs have the same edit script, meta edit script and original streams
+ *
+ * @param actual the diff under test
+ * @param expected the diff it must equal
+ */
+inline void assert_same_diff(const pdif::diff& actual, const pdif::diff& expected) {
+    ASSERT_EQ(actual.edit_op_size(), expected.edit_op_size());
+    for (size_t i = 0; i < expected.edit_op_size(); i++) {
+        auto a = actual.get_edit_op(i);
+        auto e = expected.get_edit_op(i);
+        ASSERT_EQ(a.get_type(), e.get_type()) << "edit op " << i;
+        ASSERT_EQ(a.has_arg(), e.has_arg()) << "edit op " << i;
+        if (e.has_arg()) {
+            ASSERT_TRUE(a.get_arg()->compare(e.get_arg())) << "edit op " << i;
+        }
+    }
+
+    ASSERT_EQ(actual.meta_edit_op_size(), expected.meta_edit_op_size());
+    for (size_t i = 0; i < expected.meta_edit_op_size(); i++) {
+        auto a = actual.get_meta_edit_op(i);
+        auto e = expected.get_meta_edit_op(i);
+        ASSERT_EQ(a.get_type(), e.get_type()) << "meta edit op " << i;
+        ASSERT_EQ(a.get_meta_key(), e.get_meta_key()) << "meta edit op " << i;
+        ASSERT_EQ(a.has_meta_val(), e.has_meta_val()) << "meta edit op " << i;
+        if (e.has_meta_val()) {
+            ASSERT_EQ(a.get_meta_val(), e.get_meta_val()) << "meta edit op " << i;
+        }
+    }
+
+    ASSERT_EQ(actual.original_streams().size(), expected.original_streams().size());
+    for (size_t i = 0; i < expected.original_streams().size(); i++) {
+        const pdif::stream& a = actual.original_streams()[i];
+        const pdif::stream& e = expected.original_streams()[i];
+        ASSERT_EQ(a.size(), e.size()) << "original stream " << i;
+        for (size_t j = 0; j < e.size(); j++) {
+            ASSERT_TRUE(a[j]->compare(e[j])) << "original stream " << i << " element " << j;
+        }
+    }
+}
+
+/**
+ * @brief compare two PDFs page by page with PDF::compare and the lcs differ
+ *
+ * @param path1 the base PDF
+ * @param path2 the revised PDF
+ * @param g the granularity to extract at (default: word)
+ * @param pageno the page to compare, or -1 for all pages (default: -1)
+ * @return pdif::diff the differences between the two PDFs
+ */
+inline pdif::diff full_compare(const std::string& path1, const std::string& path2, pdif::granularity g = pdif::granularity::word, int pageno = -1) {
+    pdif::PDF pdf1(path1, g, pdif::scope::page, true, pageno);
+    pdif::PDF pdf2(path2, g, pdif::scope::page, true, pageno);
+    return pdf1.compare<pdif::lcs_stream_differ>(pdf2);
+}
+
+#endif // __PDIF_TEST_COMPARE_UTIL_HPP__
@@ -3,6 +3,24 @@
 #include <pdif/stream_elem.hpp>
 #include <qpdf/QPDF.hh>
 
+// declared first so that its page threads decode the first PostScript (Type1, no ToUnicode) glyphs of the
+// process at the same time, which is when the shared AGL map is loaded; run under PDIF_SANITIZE_THREAD
+TEST(PDIFContentExtractorThreads, ParallelPostScriptFontFirstUse) {
+    std::shared_ptr<QPDF> pdf = QPDF::create();
+    pdf->processFile("test_pdfs/multi_page.pdf");
+
+    std::vector<pdif::stream> parallel = pdif::extract_content_parallel(pdf, "test_pdfs/multi_page.pdf", pdif::granularity::word, pdif::scope::page, -1, true, -1, 8);
+    std::vector<pdif::stream> serial = pdif::extract_content(pdf, pdif::granularity::word, pdif::scope::page);
+
+    ASSERT_EQ(parallel.size(), serial.size());
+    for (size_t p = 0; p < serial.size(); p++) {
+        ASSERT_EQ(parallel[p].size(), serial[p].size());
+        for (size_t i = 0; i < serial[p].size(); i++) {
+            ASSERT_TRUE(parallel[p][i]->compare(serial[p][i]));
+        }
+    }
+}
+
 TEST(PDIFContentExtractor, TestExtractMeta) {
     std::shared_ptr<QPDF> pdf = QPDF::create();
     pdf->processFile("test_pdfs/metadata_initial.pdf");
@@ -15,6 +33,26 @@ TEST(PDIFContentExtractor, TestExtractMeta) {
     ASSERT_EQ(meta.get_metadata("Title"), "Test Title");
 }
 
+TEST(PDIFContentExtractor, TestExtractMetaIndirect) {
+    // the same /Info values, stored in objects numbered differently
+    std::shared_ptr<QPDF> pdf = QPDF::create();
+    pdf->processFile("test_pdfs/metadata_indirect.pdf");
+    std::shared_ptr<QPDF> renumbered = QPDF::create();
+    renumbered->processFile("test_pdfs/metadata_indirect_renumbered.pdf");
+
+    pdif::stream_meta meta = pdif::extract_meta(pdf);
+    pdif::stream_meta renumbered_meta = pdif::extract_meta(renumbered);
+
+    ASSERT_EQ(meta.get_metadata("Title"), "Indirect Title");
+    ASSERT_EQ(meta.get_metadata("Revision"), "42");
+    for (const char* key : {"Authors", "Review", "Revision", "Title"}) {
+        ASSERT_EQ(meta.get_metadata(key), renumbered_meta.get_metadata(key)) << key;
+        ASSERT_EQ(meta.get_metadata(key).find(" R"), std::string::npos) << key;
+    }
+    ASSERT_EQ(meta.get_metadata("Authors").size(), 16);
+    ASSERT_NE(meta.get_metadata("Authors"), meta.get_metadata("Review"));
+}
+
 TEST(PDIFContentExtractor, TextGWord) {
     std::shared_ptr<QPDF> pdf = QPDF::create();
     pdf->processFile("test_pdfs/content_initial.pdf");
@@ -370,6 +408,159 @@ TEST(PDIFContentExtractor, Backslash) {
     ASSERT_EQ(s[6]->as<pdif::text_elem>()->text(), "1");
 }
 
+TEST(PDIFContentExtractor, InlineImage) {
+    std::shared_ptr<QPDF> pdf = QPDF::create();
+    pdf->processFile("test_pdfs/inline_image_initial.pdf");
+
+    std::vector<pdif::stream> streams = pdif::extract_content(pdf, pdif::granularity::sentence, pdif::scope::page);
+
+    ASSERT_EQ(streams.size(), 1);
+
+    pdif::stream s = streams[0];
+
+    ASSERT_EQ(s.size(), 6);
+
+    ASSERT_EQ(s[0]->type(), pdif::stream_type::font_set);
+
+    ASSERT_EQ(s[1]->type(), pdif::stream_type::text);
+    ASSERT_EQ(s[1]->as<pdif::text_elem>()->text(), "Inline images below.");
+
+    ASSERT_EQ(s[2]->type(), pdif::stream_type::xobject_image);
+    ASSERT_EQ(s[2]->as<pdif::xobject_img_elem>()->width(), 2);
+    ASSERT_EQ(s[2]->as<pdif::xobject_img_elem>()->height(), 2);
+
+    // identical inline images share one cached element
+    ASSERT_EQ(s[3]->type(), pdif::stream_type::xobject_image);
+    ASSERT_TRUE(s[2]->compare(s[3]));
+    ASSERT_EQ(s[2], s[3]);
+
+    ASSERT_EQ(s[4]->type(), pdif::stream_type::font_set);
+
+    ASSERT_EQ(s[5]->type(), pdif::stream_type::text);
+    ASSERT_EQ(s[5]->as<pdif::text_elem>()->text(), "End of page.");
+}
+
+TEST(PDIFContentExtractor, InlineImageChanged) {
+    std::shared_ptr<QPDF> pdf = QPDF::create();
+    pdf->processFile("test_pdfs/inline_image_changed.pdf");
+
+    std::vector<pdif::stream> streams = pdif::extract_content(pdf, pdif::granularity::sentence, pdif::scope::page);
+
+    ASSERT_EQ(streams.size(), 1);
+
+    pdif::stream s = streams[0];
+
+    ASSERT_EQ(s.size(), 6);
+    ASSERT_EQ(s[2]->type(), pdif::stream_type::xobject_image);
+    ASSERT_EQ(s[3]->type(), pdif::stream_type::xobject_image);
+    ASSERT_FALSE(s[2]->compare(s[3]));
+}
+
+TEST(PDIFContentExtractor, InlineImageDictionary) {
+    std::shared_ptr<QPDF> pdf = QPDF::create();
+    pdf->processFile("test_pdfs/inline_image_dict.pdf");
+
+    std::vector<pdif::stream> streams = pdif::extract_content(pdf, pdif::granularity::sentence, pdif::scope::page);
+
+    ASSERT_EQ(streams.size(), 1);
+
+    pdif::stream s = streams[0];
+
+    // the first image has dictionary and array values, the second a malformed width and is skipped
+    ASSERT_EQ(s.size(), 5);
+
+    ASSERT_EQ(s[2]->type(), pdif::stream_type::xobject_image);
+    ASSERT_EQ(s[2]->as<pdif::xobject_img_elem>()->width(), 2);
+    ASSERT_EQ(s[2]->as<pdif::xobject_img_elem>()->height(), 2);
+
+    ASSERT_EQ(s[3]->type(), pdif::stream_type::font_set);
+
+    ASSERT_EQ(s[4]->type(), pdif::stream_type::text);
+    ASSERT_EQ(s[4]->as<pdif::text_elem>()->text(), "End of page.");
+}
+
+TEST(PDIFContentExtractor, FormXObject) {
+    std::shared_ptr<QPDF> pdf = QPDF::create();
+    pdf->processFile("test_pdfs/form_xobject_initial.pdf");
+
+    std::vector<pdif::stream> streams = pdif::extract_content(pdf, pdif::granularity::sentence, pdif::scope::page);
+
+    ASSERT_EQ(streams.size(), 2);
+
+    for (auto& s : streams) {
+        ASSERT_EQ(s.size(), 5);
+
+        ASSERT_EQ(s[0]->type(), pdif::stream_type::font_set);
+        ASSERT_EQ(s[0]->as<pdif::font_elem>()->font_size(), 12);
+
+        ASSERT_EQ(s[1]->type(), pdif::stream_type::text);
+
+        ASSERT_EQ(s[2]->type(), pdif::stream_type::font_set);
+        ASSERT_EQ(s[2]->as<pdif::font_elem>()->font_size(), 10);
+
+        ASSERT_EQ(s[3]->type(), pdif::stream_type::text);
+        ASSERT_EQ(s[3]->as<pdif::text_elem>()->text(), "Confidential footer.");
+
+        // the page font is set again after the form
+        ASSERT_EQ(s[4]->type(), pdif::stream_type::font_set);
+        ASSERT_EQ(s[4]->as<pdif::font_elem>()->font_size(), 12);
+    }
+
+    ASSERT_EQ(streams[0][1]->as<pdif::text_elem>()->text(), "This is page one.");
+    ASSERT_EQ(streams[1][1]->as<pdif::text_elem>()->text(), "This is page two.");
+
+    // the form is extracted once and its elements are shared between pages
+    ASSERT_EQ(streams[0][3], streams[1][3]);
+}
+
+TEST(PDIFContentExtractor, FormXObjectInherited) {
+    std::shared_ptr<QPDF> pdf = QPDF::create();
+    pdf->processFile("test_pdfs/form_xobject_inherited.pdf");
+
+    std::vector<pdif::stream> streams = pdif::extract_content(pdf, pdif::granularity::sentence, pdif::scope::page);
+
+    ASSERT_EQ(streams.size(), 2);
+
+    // the footer form has no resources and uses the font of the page it is drawn on
+    pdif::stream& s1 = streams[0];
+    ASSERT_EQ(s1.size(), 7);
+    ASSERT_EQ(s1[2]->as<pdif::font_elem>()->font_name(), "Helvetica");
+    ASSERT_EQ(s1[2]->as<pdif::font_elem>()->font_size(), 8);
+    ASSERT_EQ(s1[3]->as<pdif::text_elem>()->text(), "Footer.");
+
+    // the page font is set again after the form
+    ASSERT_EQ(s1[4]->as<pdif::font_elem>()->font_name(), "Helvetica");
+    ASSERT_EQ(s1[4]->as<pdif::font_elem>()->font_size(), 12);
+    ASSERT_EQ(s1[5]->as<pdif::text_elem>()->text(), "After form.");
+
+    // the form that draws itself is extracted once
+    ASSERT_EQ(s1[6]->as<pdif::text_elem>()->text(), "Loop.");
+
+    pdif::stream& s2 = streams[1];
+    ASSERT_EQ(s2.size(), 5);
+    ASSERT_EQ(s2[2]->as<pdif::font_elem>()->font_name(), "Courier");
+    ASSERT_EQ(s2[2]->as<pdif::font_elem>()->font_size(), 8);
+    ASSERT_EQ(s2[4]->as<pdif::font_elem>()->font_name(), "Courier");
+}
+
+TEST(PDIFContentExtractor, FormXObjectScopeDocument) {
+    std::shared_ptr<QPDF> pdf = QPDF::create();
+    pdf->processFile("test_pdfs/form_xobject_initial.pdf");
+
+    std::vector<pdif::stream> streams = pdif::extract_content(pdf, pdif::granularity::word, pdif::scope::document);
+
+    ASSERT_EQ(streams.size(), 1);
+
+    int footers = 0;
+    for (size_t i = 0; i < streams[0].size(); i++) {
+        if (streams[0][i]->type() == pdif::stream_type::text && streams[0][i]->as<pdif::text_elem>()->text() == "Confidential") {
+            footers++;
+        }
+    }
+
+    ASSERT_EQ(footers, 2);
+}
+
 TEST(PDIFContentExtractor, Pageno2) {
     std::shared_ptr<QPDF> pdf = QPDF::create();
     pdf->processFile("test_pdfs/multi_page.pdf");
@@ -591,6 +782,31 @@ TEST(PDIFContentExtractor, TestIgnoreRepeated) {
     ASSERT_EQ(s[14]->as<pdif::text_elem>()->text(), "1");
 }
 
+TEST(PDIFContentExtractor, Parallel) {
+    std::shared_ptr<QPDF> pdf = QPDF::create();
+    pdf->processFile("test_pdfs/multi_page.pdf");
+
+    for (pdif::scope s : {pdif::scope::page, pdif::scope::document}) {
+        std::vector<pdif::stream> serial = pdif::extract_content(pdf, pdif::granularity::word, s);
+
+        for (unsigned threads : {0u, 2u, 3u, 8u}) {
+            std::vector<pdif::stream> parallel = pdif::extract_content_parallel(pdf, "test_pdfs/multi_page.pdf", pdif::granularity::word, s, -1, true, -1, threads);
+
+            ASSERT_EQ(parallel.size(), serial.size());
+            for (size_t p = 0; p < serial.size(); p++) {
+                ASSERT_EQ(parallel[p].size(), serial[p].size());
+                for (size_t i = 0; i < serial[p].size(); i++) {
+                    ASSERT_TRUE(parallel[p][i]->compare(serial[p][i]));
+                }
+            }
+        }
+    }
+
+    std::vector<pdif::stream> page = pdif::extract_content_parallel(pdf, "test_pdfs/multi_page.pdf", pdif::granularity::sentence, pdif::scope::page, 1, true, -1, 4);
+    ASSERT_EQ(page.size(), 1);
+    ASSERT_EQ(page[0][1]->as<pdif::text_elem>()->text(), "This is the second page.");
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
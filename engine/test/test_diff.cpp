@@ -778,6 +778,218 @@ TEST(PDIFDiff, TestEditChunkSummaryOGStreamNotSet) {
     ASSERT_THROW(diff.edit_chunk_summary(), pdif::pdif_out_of_bounds);
 }
 
+TEST(PDIFDiff, TestForEachEditHunk) {
+    pdif::stream s;
+    s.push_back(pdif::stream_elem::create<pdif::text_elem>("0"));
+    s.push_back(pdif::stream_elem::create<pdif::text_elem>("1"));
+    s.push_back(pdif::stream_elem::create<pdif::text_elem>("2"));
+    s.push_back(pdif::stream_elem::create<pdif::text_elem>("3"));
+
+    pdif::diff diff(false);
+    diff.add_original_stream(s);
+
+    diff.set_allowed_context(1);
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::INSERT, pdif::stream_elem::create<pdif::text_elem>("Inserted")));
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::DELETE));
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+
+    int hunks = 0;
+    diff.for_each_edit_hunk([&](const pdif::diff::edit_hunk& hunk) {
+        hunks++;
+
+        ASSERT_EQ(hunk.from_file_start, 0);
+        ASSERT_EQ(hunk.from_count, 3);
+        ASSERT_EQ(hunk.to_file_start, 0);
+        ASSERT_EQ(hunk.to_count, 3);
+
+        ASSERT_EQ(hunk.lines.size(), 4);
+        ASSERT_EQ(hunk.lines[0].type, pdif::edit_op_type::EQ);
+        ASSERT_EQ(hunk.lines[0].elem->to_string(false), "0");
+        ASSERT_EQ(hunk.lines[1].type, pdif::edit_op_type::INSERT);
+        ASSERT_EQ(hunk.lines[1].elem->to_string(false), "Inserted");
+        ASSERT_EQ(hunk.lines[2].type, pdif::edit_op_type::DELETE);
+        ASSERT_EQ(hunk.lines[2].elem->to_string(false), "1");
+        ASSERT_EQ(hunk.lines[3].type, pdif::edit_op_type::EQ);
+        ASSERT_EQ(hunk.lines[3].elem->to_string(false), "2");
+    });
+
+    ASSERT_EQ(hunks, 1);
+
+    // the rendered chunks are built from the same hunks
+    auto chunks = diff.edit_chunk_summary();
+    ASSERT_EQ(chunks.size(), 1);
+    ASSERT_EQ(chunks[0].lines, std::vector<std::string>({"0", "+Inserted", "-1", "2"}));
+}
+
+TEST(PDIFDiff, TestOutputEditScriptMatchesChunks) {
+    pdif::stream s;
+    for (int i = 0; i < 10; i++) {
+        s.push_back(pdif::stream_elem::create<pdif::text_elem>(std::to_string(i)));
+    }
+
+    pdif::diff diff;
+    diff.add_original_stream(s);
+
+    diff.set_allowed_context(1);
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::INSERT, pdif::stream_elem::create<pdif::font_elem>("CMR10", 9)));
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::DELETE));
+    for (int i = 0; i < 5; i++) {
+        diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+    }
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::DELETE));
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+
+    std::stringstream expected;
+    expected << util::CONSOLE_COLOR_CODE::TEXT_BOLD << "Content Differences" << util::CONSOLE_COLOR_CODE::TEXT_RESET << std::endl;
+    expected << std::endl;
+    for (const auto& chunk : diff.edit_chunk_summary()) {
+        expected << chunk;
+    }
+    expected << util::CONSOLE_COLOR_CODE::TEXT_BOLD << "End of Content Differences" << util::CONSOLE_COLOR_CODE::TEXT_RESET << std::endl;
+
+    std::stringstream actual;
+    diff.output_edit_script(actual);
+
+    ASSERT_EQ(actual.str(), expected.str());
+}
+
+TEST(PDIFDiff, TestReplaceEditOps) {
+    auto text = [](const std::string& t) { return pdif::stream_elem::create<pdif::text_elem>(t); };
+
+    pdif::diff d;
+    d.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+    d.add_edit_op(pdif::edit_op(pdif::edit_op_type::INSERT, text("a")));
+    d.add_edit_op(pdif::edit_op(pdif::edit_op_type::DELETE));
+
+    pdif::diff grow;
+    grow.add_edit_op(pdif::edit_op(pdif::edit_op_type::INSERT, text("b")));
+    grow.add_edit_op(pdif::edit_op(pdif::edit_op_type::INSERT, text("c")));
+    grow.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+
+    d.replace_edit_ops(1, 1, grow);
+    ASSERT_EQ(d.edit_op_size(), 5);
+    ASSERT_EQ(d.get_edit_op(1).get_arg()->as<pdif::text_elem>()->text(), "b");
+    ASSERT_EQ(d.get_edit_op(2).get_arg()->as<pdif::text_elem>()->text(), "c");
+    ASSERT_EQ(d.get_edit_op(3).get_type(), pdif::edit_op_type::EQ);
+    ASSERT_EQ(d.get_edit_op(4).get_type(), pdif::edit_op_type::DELETE);
+
+    d.replace_edit_ops(1, 3, pdif::diff());
+    ASSERT_EQ(d.edit_op_size(), 2);
+    ASSERT_EQ(d.get_edit_op(1).get_type(), pdif::edit_op_type::DELETE);
+
+    d.replace_edit_ops(2, 0, grow);
+    ASSERT_EQ(d.edit_op_size(), 5);
+
+    ASSERT_THROW(d.replace_edit_ops(4, 2, grow), pdif::pdif_out_of_bounds);
+    ASSERT_THROW(d.replace_edit_ops(6, 0, grow), pdif::pdif_out_of_bounds);
+}
+
+TEST(PDIFDiff, TestSetOriginalStream) {
+    pdif::stream s;
+    s.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+
+    pdif::diff d;
+    ASSERT_THROW(d.set_original_stream(0, s), pdif::pdif_out_of_bounds);
+
+    d.add_original_stream(pdif::stream());
+    d.set_original_stream(0, s);
+    ASSERT_EQ(d.original_streams()[0].size(), 1);
+}
+
+static pdif::stream make_letters(const std::string& letters) {
+    pdif::stream s;
+    for (char c : letters) {
+        s.push_back(pdif::stream_elem::create<pdif::text_elem>(std::string(1, c)));
+    }
+    return s;
+}
+
+TEST(PDIFDiff, TestDetectMoves) {
+    pdif::stream original = make_letters("abcdefg");
+    pdif::stream revised = make_letters("afgbcde");
+
+    // b-e deleted after a and inserted after g, as an LCS differ reports it
+    pdif::diff diff(false);
+    diff.add_original_stream(original);
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+    for (int i = 0; i < 4; i++) {
+        diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::DELETE));
+    }
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+    for (int i = 3; i < 7; i++) {
+        diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::INSERT, revised[i]));
+    }
+
+    pdif::diff longer = diff;
+    ASSERT_EQ(longer.detect_moves(5), 0);
+
+    ASSERT_EQ(diff.detect_moves(4), 1);
+    for (int i = 1; i < 5; i++) {
+        ASSERT_EQ(diff.get_edit_op(i).get_type(), pdif::edit_op_type::MOVE_FROM);
+        ASSERT_EQ(diff.get_edit_op(i).get_move(), 0);
+        ASSERT_EQ(diff.get_edit_op(i + 6).get_type(), pdif::edit_op_type::MOVE_TO);
+        ASSERT_EQ(diff.get_edit_op(i + 6).get_move(), 0);
+    }
+
+    int plus, minus, eq, moved;
+    diff.count_edit_op_types(plus, minus, eq, moved);
+    ASSERT_EQ(plus, 0);
+    ASSERT_EQ(minus, 0);
+    ASSERT_EQ(eq, 3);
+    ASSERT_EQ(moved, 4);
+
+    diff.count_edit_op_types(plus, minus, eq);
+    ASSERT_EQ(plus, 4);
+    ASSERT_EQ(minus, 4);
+
+    // the script still applies to the revised stream
+    pdif::stream result = original;
+    diff.apply_edit_script(result);
+    ASSERT_EQ(result.size(), revised.size());
+    for (size_t i = 0; i < revised.size(); i++) {
+        ASSERT_TRUE(result[i]->compare(revised[i]));
+    }
+
+    auto chunks = diff.edit_chunk_summary();
+    ASSERT_EQ(chunks.size(), 1);
+    ASSERT_EQ(chunks[0].lines, std::vector<std::string>({"a", "<b", "<c", "<d", "<e", "f", "g", ">b", ">c", ">d", ">e"}));
+
+    // ops already paired are left alone
+    ASSERT_EQ(diff.detect_moves(), 0);
+}
+
+TEST(PDIFDiff, TestDetectMovesSameHunk) {
+    pdif::stream original = make_letters("abcde");
+
+    // a replacement of a block by itself is not a move
+    pdif::diff diff;
+    diff.add_original_stream(original);
+    diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+    for (int i = 1; i < 5; i++) {
+        diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::DELETE));
+    }
+    for (int i = 1; i < 5; i++) {
+        diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::INSERT, original[i]));
+    }
+
+    ASSERT_EQ(diff.detect_moves(), 0);
+}
+
+TEST(PDIFDiff, TestDetectMovesInvalid) {
+    pdif::diff diff;
+    ASSERT_THROW(diff.detect_moves(0), pdif::pdif_invalid_argment);
+
+    for (int i = 0; i < 4; i++) {
+        diff.add_edit_op(pdif::edit_op(pdif::edit_op_type::DELETE));
+    }
+    ASSERT_THROW(diff.detect_moves(), pdif::pdif_out_of_bounds);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
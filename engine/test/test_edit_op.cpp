@@ -65,6 +65,23 @@ TEST(PDIFEditOp, TestGetArgInvalid) {
     ASSERT_THROW({op.get_arg();}, pdif::pdif_invalid_argment);
 }
 
+TEST(PDIFEditOp, TestMove) {
+    pdif::edit_op from(pdif::edit_op_type::MOVE_FROM, std::nullopt, 3);
+    ASSERT_TRUE(from.is_move());
+    ASSERT_FALSE(from.has_arg());
+    ASSERT_EQ(from.get_move(), 3);
+
+    pdif::edit_op to(pdif::edit_op_type::MOVE_TO, pdif::stream_elem::create<pdif::text_elem>("Hello"), 3);
+    ASSERT_TRUE(to.is_move());
+    ASSERT_EQ(to.get_arg()->as<pdif::text_elem>()->text(), "Hello");
+
+    ASSERT_FALSE(pdif::edit_op(pdif::edit_op_type::DELETE).is_move());
+
+    ASSERT_THROW({pdif::edit_op op(pdif::edit_op_type::MOVE_TO, std::nullopt, 3);}, pdif::pdif_invalid_argment);
+    ASSERT_THROW({pdif::edit_op op(pdif::edit_op_type::MOVE_FROM, pdif::stream_elem::create<pdif::text_elem>("Hello"), 3);}, pdif::pdif_invalid_argment);
+    ASSERT_THROW({pdif::edit_op op(pdif::edit_op_type::DELETE, std::nullopt, 3);}, pdif::pdif_invalid_argment);
+}
+
 TEST(PDIFEditOp, TestHasArg) {
     pdif::edit_op op(pdif::edit_op_type::INSERT, pdif::stream_elem::create<pdif::text_elem>("Hello, World!"));
 
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+#include <pdif/extraction_cache.hpp>
+
+#include <filesystem>
+#include <fstream>
+
+static const std::string HASH = "0123456789abcdef0123456789abcdef01234567";
+
+class PDIFExtractionCache : public ::testing::Test {
+protected:
+
+    void SetUp() override {
+        m_dir = std::filesystem::temp_directory_path() / ("pdif_extraction_cache_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(m_dir);
+        std::filesystem::create_directories(m_dir);
+        m_path = (m_dir / "a.pdf.pdifx").string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(m_dir);
+    }
+
+    static std::vector<pdif::stream> make_streams() {
+        pdif::stream page1;
+        page1.push_back(pdif::stream_elem::create<pdif::font_elem>("Helvetica", 12));
+        page1.push_back(pdif::stream_elem::create<pdif::text_color_elem>(0.f, 0.5f, 1.f));
+        page1.push_back(pdif::stream_elem::create<pdif::text_elem>("the"));
+        page1.push_back(pdif::stream_elem::create<pdif::text_elem>("cat"));
+        page1.push_back(pdif::stream_elem::create<pdif::text_elem>("the"));
+        page1.push_back(pdif::stream_elem::create<pdif::stroke_color_elem>(1.f, 0.f, 0.f));
+
+        auto img = pdif::stream_elem::create<pdif::xobject_img_elem>("abc123", 64, 32);
+        img->as<pdif::xobject_img_elem>()->set_fingerprint(0xdeadbeefcafef00dull);
+        img->as<pdif::xobject_img_elem>()->set_similarity_threshold(4);
+
+        pdif::stream page2;
+        page2.push_back(pdif::stream_elem::create<pdif::text_elem>("the"));
+        page2.push_back(img);
+
+        return {page1, pdif::stream(), page2};
+    }
+
+    static pdif::stream_meta make_meta() {
+        pdif::stream_meta meta;
+        meta.add_metadata("/Title", "A test");
+        meta.add_metadata("/Author", "pdif");
+        return meta;
+    }
+
+    std::filesystem::path m_dir;
+    std::string m_path;
+};
+
+TEST_F(PDIFExtractionCache, TestRoundTrip) {
+    pdif::extraction_options options;
+    options.g = pdif::granularity::letter;
+    options.pageno = 2;
+
+    auto streams = make_streams();
+    pdif::extraction_cache::write(m_path, HASH, options, make_meta(), streams);
+
+    pdif::extraction_cache cache(m_path);
+    ASSERT_EQ(cache.file_hash(), HASH);
+    ASSERT_TRUE(cache.options() == options);
+
+    auto loaded = cache.load_streams();
+    ASSERT_EQ(loaded.size(), streams.size());
+    for (size_t s = 0; s < streams.size(); s++) {
+        ASSERT_EQ(loaded[s].size(), streams[s].size());
+        for (size_t i = 0; i < streams[s].size(); i++) {
+            ASSERT_TRUE(loaded[s][i]->compare(streams[s][i]));
+            ASSERT_EQ(loaded[s][i]->to_string(false), streams[s][i]->to_string(false));
+        }
+    }
+
+    auto img = loaded[2][1]->as<pdif::xobject_img_elem>();
+    ASSERT_TRUE(img->has_fingerprint());
+    ASSERT_EQ(img->fingerprint(), 0xdeadbeefcafef00dull);
+    ASSERT_EQ(img->similarity_threshold(), 4);
+
+    ASSERT_EQ(cache.load_meta().get_metadata(), make_meta().get_metadata());
+}
+
+TEST_F(PDIFExtractionCache, TestViews) {
+    pdif::extraction_cache::write(m_path, HASH, pdif::extraction_options(), make_meta(), make_streams());
+    pdif::extraction_cache cache(m_path);
+
+    ASSERT_EQ(cache.stream_count(), 3);
+    ASSERT_EQ(cache.stream_size(0), 6);
+    ASSERT_EQ(cache.stream_size(1), 0);
+
+    auto font = cache.elem(0, 0);
+    ASSERT_EQ(font.type, pdif::stream_type::font_set);
+    ASSERT_EQ(font.text, "Helvetica");
+    ASSERT_EQ(font.values[0], 12);
+
+    auto color = cache.elem(0, 1);
+    ASSERT_EQ(color.type, pdif::stream_type::text_color_set);
+    ASSERT_FLOAT_EQ(color.color[1], 0.5f);
+
+    ASSERT_EQ(cache.elem(0, 3).text, "cat");
+    ASSERT_THROW(cache.elem(0, 6), pdif::pdif_out_of_bounds);
+    ASSERT_THROW(cache.stream_size(3), pdif::pdif_out_of_bounds);
+
+    ASSERT_EQ(cache.meta_count(), 2);
+    ASSERT_THROW(cache.meta(2), pdif::pdif_out_of_bounds);
+}
+
+TEST_F(PDIFExtractionCache, TestAnnotationsAndFields) {
+    pdif::stream page;
+    page.push_back(pdif::stream_elem::create<pdif::annotation_elem>("Text", std::array<float, 4>{10, 20, 30.5f, 40}, "a note", 0x0123456789abcdefull));
+    page.push_back(pdif::stream_elem::create<pdif::form_field_elem>("person.name", "Tx", "Alice"));
+    page.push_back(pdif::stream_elem::create<pdif::form_field_elem>("agree", "Btn", "Yes"));
+
+    pdif::extraction_cache::write(m_path, HASH, pdif::extraction_options(), make_meta(), {page});
+    pdif::extraction_cache cache(m_path);
+
+    auto annot = cache.elem(0, 0);
+    ASSERT_EQ(annot.type, pdif::stream_type::annotation);
+    ASSERT_EQ(annot.text, "Text");
+    ASSERT_EQ(annot.detail[0], "a note");
+    ASSERT_FLOAT_EQ(annot.rect[2], 30.5f);
+    ASSERT_EQ(annot.fingerprint, 0x0123456789abcdefull);
+
+    auto field = cache.elem(0, 1);
+    ASSERT_EQ(field.type, pdif::stream_type::form_field);
+    ASSERT_EQ(field.text, "person.name");
+    ASSERT_EQ(field.detail[0], "Tx");
+    ASSERT_EQ(field.detail[1], "Alice");
+
+    auto loaded = cache.load_streams();
+    ASSERT_EQ(loaded.size(), 1);
+    ASSERT_EQ(loaded[0].size(), page.size());
+    for (size_t i = 0; i < page.size(); i++) {
+        ASSERT_TRUE(loaded[0][i]->compare(page[i]));
+        ASSERT_EQ(loaded[0][i]->to_string(false), page[i]->to_string(false));
+    }
+}
+
+TEST_F(PDIFExtractionCache, TestRepeatedElementsAreShared) {
+    pdif::extraction_cache::write(m_path, HASH, pdif::extraction_options(), make_meta(), make_streams());
+    pdif::extraction_cache cache(m_path);
+
+    // the views of repeated elements point at the same bytes
+    ASSERT_EQ(cache.elem(0, 2).text.data(), cache.elem(0, 4).text.data());
+    ASSERT_EQ(cache.elem(0, 2).text.data(), cache.elem(2, 0).text.data());
+
+    auto streams = cache.load_streams();
+    ASSERT_EQ(streams[0][2].get(), streams[0][4].get());
+    ASSERT_EQ(streams[0][2].get(), streams[2][0].get());
+    ASSERT_NE(streams[0][2].get(), streams[0][3].get());
+}
+
+TEST_F(PDIFExtractionCache, TestMatches) {
+    pdif::extraction_options options;
+    pdif::extraction_cache::write(m_path, HASH, options, make_meta(), make_streams());
+    pdif::extraction_cache cache(m_path);
+
+    ASSERT_TRUE(cache.matches(HASH, options));
+    ASSERT_FALSE(cache.matches("1123456789abcdef0123456789abcdef01234567", options));
+
+    pdif::extraction_options sentence = options;
+    sentence.g = pdif::granularity::sentence;
+    ASSERT_FALSE(cache.matches(HASH, sentence));
+
+    pdif::extraction_options images = options;
+    images.image_similarity = 8;
+    ASSERT_FALSE(cache.matches(HASH, images));
+}
+
+TEST_F(PDIFExtractionCache, TestInvalidHash) {
+    ASSERT_THROW(pdif::extraction_cache::write(m_path, "abc", pdif::extraction_options(), make_meta(), make_streams()), pdif::pdif_invalid_argment);
+    ASSERT_THROW(pdif::extraction_cache::write(m_path, std::string(40, 'z'), pdif::extraction_options(), make_meta(), make_streams()), pdif::pdif_invalid_argment);
+}
+
+TEST_F(PDIFExtractionCache, TestMissingFile) {
+    ASSERT_THROW(pdif::extraction_cache cache(m_path), pdif::pdif_invalid_format);
+}
+
+TEST_F(PDIFExtractionCache, TestTruncated) {
+    pdif::extraction_cache::write(m_path, HASH, pdif::extraction_options(), make_meta(), make_streams());
+    auto size = std::filesystem::file_size(m_path);
+
+    for (auto truncated : {size - 1, size / 2, uintmax_t(16), uintmax_t(1)}) {
+        std::filesystem::resize_file(m_path, truncated);
+        ASSERT_THROW(pdif::extraction_cache cache(m_path), pdif::pdif_invalid_format);
+    }
+}
+
+TEST_F(PDIFExtractionCache, TestCorrupt) {
+    pdif::extraction_cache::write(m_path, HASH, pdif::extraction_options(), make_meta(), make_streams());
+
+    std::string content;
+    {
+        std::ifstream file(m_path, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    auto write_with = [&](size_t offset, char value) {
+        std::string corrupt = content;
+        corrupt[offset] = value;
+        std::ofstream file(m_path, std::ios::binary | std::ios::trunc);
+        file << corrupt;
+    };
+
+    // magic
+    write_with(0, 'X');
+    ASSERT_THROW(pdif::extraction_cache cache(m_path), pdif::pdif_invalid_format);
+
+    // version
+    write_with(12, 99);
+    ASSERT_THROW(pdif::extraction_cache cache(m_path), pdif::pdif_invalid_format);
+
+    // the high byte of the meta table offset
+    write_with(71, 0x7f);
+    ASSERT_THROW(pdif::extraction_cache cache(m_path), pdif::pdif_invalid_format);
+}
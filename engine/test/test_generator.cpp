@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <pdif/generator.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static pdif::generator<int> count_to(int n, std::vector<int>& produced) {
+    for (int i = 0; i < n; i++) {
+        produced.push_back(i);
+        co_yield i;
+    }
+}
+
+TEST(PDIFGenerator, TestLazy) {
+    std::vector<int> produced;
+    pdif::generator<int> g = count_to(3, produced);
+    ASSERT_TRUE(produced.empty());
+
+    auto it = g.begin();
+    ASSERT_EQ(*it, 0);
+    ASSERT_EQ(produced, std::vector<int>({0}));
+
+    ++it;
+    ASSERT_EQ(*it, 1);
+    ASSERT_EQ(produced, std::vector<int>({0, 1}));
+
+    ++it;
+    ++it;
+    ASSERT_TRUE(it == g.end());
+    ASSERT_EQ(produced, std::vector<int>({0, 1, 2}));
+}
+
+TEST(PDIFGenerator, TestEmpty) {
+    std::vector<int> produced;
+    pdif::generator<int> g = count_to(0, produced);
+
+    ASSERT_TRUE(g.begin() == g.end());
+}
+
+static pdif::generator<std::string> words() {
+    std::string word;
+    for (const char* w : {"alpha", "beta"}) {
+        word = w;
+        co_yield std::move(word);
+        word.clear();
+    }
+}
+
+TEST(PDIFGenerator, TestMoveFromValue) {
+    std::vector<std::string> taken;
+    for (std::string& word : words()) {
+        taken.push_back(std::move(word));
+    }
+
+    ASSERT_EQ(taken, std::vector<std::string>({"alpha", "beta"}));
+}
+
+static pdif::generator<int> fail_after(int n) {
+    for (int i = 0; i < n; i++) {
+        co_yield i;
+    }
+    throw std::runtime_error("fail");
+}
+
+TEST(PDIFGenerator, TestException) {
+    pdif::generator<int> g = fail_after(1);
+    auto it = g.begin();
+    ASSERT_EQ(*it, 0);
+    ASSERT_THROW(++it, std::runtime_error);
+
+    pdif::generator<int> first = fail_after(0);
+    ASSERT_THROW(first.begin(), std::runtime_error);
+}
+
+static pdif::generator<int> hold(std::shared_ptr<int> resource) {
+    while (true) {
+        co_yield *resource;
+    }
+}
+
+TEST(PDIFGenerator, TestDestroyEarly) {
+    auto resource = std::make_shared<int>(7);
+    {
+        pdif::generator<int> g = hold(resource);
+        ASSERT_EQ(resource.use_count(), 2);
+
+        pdif::generator<int> moved = std::move(g);
+        ASSERT_EQ(*moved.begin(), 7);
+        ASSERT_EQ(resource.use_count(), 2);
+    }
+    ASSERT_EQ(resource.use_count(), 1);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
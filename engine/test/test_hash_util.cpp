@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <pdif/hash_util.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+TEST(PDIFHashUtil, TestSha1) {
+    ASSERT_EQ(pdif::to_hex(pdif::sha1::of("abc", 3)), "a9993e364706816aba3e25717850c26c9cd0d89d");
+    ASSERT_EQ(pdif::to_hex(pdif::sha1::of("", 0)), "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+    ASSERT_EQ(pdif::sha1::of("abc", 3).size(), pdif::sha1::DIGEST_SIZE);
+
+    pdif::sha1 ctx;
+    ctx.update("a", 1);
+    ctx.update("bc");
+    ASSERT_EQ(ctx.digest(), pdif::sha1::of("abc", 3));
+}
+
+TEST(PDIFHashUtil, TestSha1File) {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pdif_hash_util_test.bin";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "abc";
+    }
+
+    ASSERT_EQ(pdif::sha1::of_file(path.string()), pdif::sha1::of("abc", 3));
+    std::filesystem::remove(path);
+
+    ASSERT_THROW(pdif::sha1::of_file(path.string()), pdif::pdif_invalid_argment);
+}
+
+TEST(PDIFHashUtil, TestHex) {
+    const unsigned char bytes[] = {0x00, 0x1f, 0xa0, 0xff};
+    ASSERT_EQ(pdif::to_hex(bytes, sizeof(bytes)), "001fa0ff");
+
+    std::string hex;
+    pdif::append_hex(hex, 0x0123456789abcdefull);
+    ASSERT_EQ(hex, "0123456789abcdef");
+    pdif::append_hex(hex, 0xabc, 2);
+    ASSERT_EQ(hex, "0123456789abcdefbc");
+
+    unsigned char decoded[4];
+    ASSERT_TRUE(pdif::from_hex("001FA0ff", decoded, sizeof(decoded)));
+    ASSERT_EQ(std::memcmp(decoded, bytes, sizeof(bytes)), 0);
+    ASSERT_FALSE(pdif::from_hex("001fa0f", decoded, sizeof(decoded)));
+    ASSERT_FALSE(pdif::from_hex("001fa0fg", decoded, sizeof(decoded)));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <pdif/hierarchical_stream_differ.hpp>
+#include <pdif/stream.hpp>
+#include <pdif/stream_elem.hpp>
+
+static std::string joined_text(const pdif::stream& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i]->type() != pdif::stream_type::text) {
+            continue;
+        }
+
+        for (char c : s[i]->as<pdif::text_elem>()->text()) {
+            if (c != ' ') {
+                out.push_back(c);
+            }
+        }
+    }
+    return out;
+}
+
+TEST(PDIFHierarchicalStreamDiffer, TestSplit) {
+    pdif::stream stream;
+    stream.push_back(pdif::stream_elem::create<pdif::font_elem>("Arial", 12));
+    stream.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello big world."));
+
+    auto words = pdif::hierarchical_stream_differ::split(stream, pdif::granularity::word);
+    ASSERT_EQ(words.size(), 4);
+    ASSERT_EQ(words[0]->type(), pdif::stream_type::font_set);
+    ASSERT_EQ(words[2]->as<pdif::text_elem>()->text(), "big");
+
+    auto letters = pdif::hierarchical_stream_differ::split(stream, pdif::granularity::letter);
+    ASSERT_EQ(letters.size(), 15);
+    ASSERT_EQ(letters[1]->as<pdif::text_elem>()->text(), "H");
+
+    auto sentences = pdif::hierarchical_stream_differ::split(stream, pdif::granularity::sentence);
+    ASSERT_EQ(sentences.size(), 2);
+}
+
+TEST(PDIFHierarchicalStreamDiffer, TestInvalidGranularity) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    ASSERT_THROW(pdif::hierarchical_stream_differ(stream1, stream2, pdif::granularity::sentence), pdif::pdif_invalid_argment);
+}
+
+TEST(PDIFHierarchicalStreamDiffer, TestNoChange) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("The quick brown fox."));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("The quick brown fox."));
+
+    pdif::hierarchical_stream_differ differ(stream1, stream2);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 1);
+    ASSERT_EQ(diff.get_edit_op(0).get_type(), pdif::edit_op_type::EQ);
+    ASSERT_EQ(differ.original_stream().size(), 1);
+}
+
+TEST(PDIFHierarchicalStreamDiffer, TestWordRefinement) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("The quick brown fox."));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("It jumps over the dog."));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("The quick brown fox."));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("It leaps over the dog."));
+
+    pdif::hierarchical_stream_differ differ(stream1, stream2);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    // the unchanged sentence stays whole, the changed one is split into words
+    ASSERT_EQ(diff.edit_op_size(), 7);
+    ASSERT_EQ(differ.original_stream().size(), 6);
+    ASSERT_EQ(differ.original_stream()[0]->as<pdif::text_elem>()->text(), "The quick brown fox.");
+
+    auto op = diff.get_edit_op(2);
+    ASSERT_EQ(op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(op.get_arg()->as<pdif::text_elem>()->text(), "leaps");
+
+    op = diff.get_edit_op(3);
+    ASSERT_EQ(op.get_type(), pdif::edit_op_type::DELETE);
+}
+
+TEST(PDIFHierarchicalStreamDiffer, TestLetterRefinement) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("It jumps over the dog."));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("It jumped over the dog."));
+
+    pdif::hierarchical_stream_differ differ(stream1, stream2, pdif::granularity::letter);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    int plus, minus, eq;
+    diff.count_edit_op_types(plus, minus, eq);
+
+    // "jumps" -> "jumped": jump is kept, s is replaced by ed
+    ASSERT_EQ(plus, 2);
+    ASSERT_EQ(minus, 1);
+    ASSERT_EQ(eq, 8);
+
+    pdif::stream result(differ.original_stream());
+    ASSERT_NO_THROW(diff.apply_edit_script(result));
+    ASSERT_EQ(joined_text(result), joined_text(stream2));
+}
+
+TEST(PDIFHierarchicalStreamDiffer, TestPureInsertStaysSentence) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("First."));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("First."));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("Second sentence."));
+
+    pdif::hierarchical_stream_differ differ(stream1, stream2, pdif::granularity::letter);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 2);
+    ASSERT_EQ(diff.get_edit_op(1).get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(diff.get_edit_op(1).get_arg()->as<pdif::text_elem>()->text(), "Second sentence.");
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,270 @@
+#include <gtest/gtest.h>
+#include <pdif/histogram_stream_differ.hpp>
+#include <pdif/stream.hpp>
+#include <pdif/stream_elem.hpp>
+
+#include <random>
+
+TEST(PDIFHistogramStreamDiffer, TestAdd) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+
+    pdif::histogram_stream_differ differ(stream1, stream2);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 2);
+
+    auto edit_op = diff.get_edit_op(0);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+    ASSERT_EQ(edit_op.has_arg(), false);
+
+    edit_op = diff.get_edit_op(1);
+
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(edit_op.has_arg(), true);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::text_elem>()->text(), "World");
+}
+
+TEST(PDIFHistogramStreamDiffer, TestDelete) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+
+    pdif::histogram_stream_differ differ(stream1, stream2);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 2);
+
+    auto edit_op = diff.get_edit_op(0);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+    ASSERT_EQ(edit_op.has_arg(), false);
+
+    edit_op = diff.get_edit_op(1);
+
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::DELETE);
+    ASSERT_EQ(edit_op.has_arg(), false);
+}
+
+TEST(PDIFHistogramStreamDiffer, TestReplace) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("World!"));
+
+    pdif::histogram_stream_differ differ(stream1, stream2);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 3);
+
+    auto edit_op = diff.get_edit_op(0);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+    ASSERT_EQ(edit_op.has_arg(), false);
+
+    edit_op = diff.get_edit_op(1);
+
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(edit_op.has_arg(), true);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::text_elem>()->text(), "World!");
+
+    edit_op = diff.get_edit_op(2);
+
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::DELETE);
+    ASSERT_EQ(edit_op.has_arg(), false);
+}
+
+TEST(PDIFHistogramStreamDiffer, TestEmpty) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    pdif::histogram_stream_differ differ(stream1, stream2);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 0);
+}
+
+TEST(PDIFHistogramStreamDiffer, TestNoChange) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+
+    pdif::histogram_stream_differ differ(stream1, stream2);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 1);
+
+    auto edit_op = diff.get_edit_op(0);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+    ASSERT_EQ(edit_op.has_arg(), false);
+}
+
+TEST(PDIFHistogramStreamDiffer, TestBigChange) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("The"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("quick"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("brown"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("fox"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("jumps"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("over"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("the"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("lazy"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("dog")); 
+
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("The"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("fast"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("brown"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("cat"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("over"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("the"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("lazy"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("mouse"));
+
+    pdif::histogram_stream_differ differ(stream1, stream2);
+
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 12);
+
+    auto edit_op = diff.get_edit_op(0);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+    
+    edit_op = diff.get_edit_op(1);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(edit_op.has_arg(), true);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::text_elem>()->text(), "fast");
+
+    edit_op = diff.get_edit_op(2);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::DELETE);
+
+    edit_op = diff.get_edit_op(3);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+
+    edit_op = diff.get_edit_op(4);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(edit_op.has_arg(), true);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::text_elem>()->text(), "cat");
+
+    edit_op = diff.get_edit_op(5);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::DELETE);
+
+    edit_op = diff.get_edit_op(6);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::DELETE);
+
+    edit_op = diff.get_edit_op(7);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+
+    edit_op = diff.get_edit_op(8);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+
+    edit_op = diff.get_edit_op(9);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
+
+    edit_op = diff.get_edit_op(10);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(edit_op.has_arg(), true);
+    ASSERT_EQ(edit_op.get_arg()->as<pdif::text_elem>()->text(), "mouse");
+
+    edit_op = diff.get_edit_op(11);
+    ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::DELETE);
+}
+
+TEST(PDIFHistogramStreamDiffer, TestMovedParagraph) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    std::vector<std::string> para1 = {"Alpha", "beta", "gamma", "delta"};
+    std::vector<std::string> para2 = {"One", "two", "three", "four"};
+
+    for (const auto& word : para1) stream1.push_back(pdif::stream_elem::create<pdif::text_elem>(word));
+    for (const auto& word : para2) stream1.push_back(pdif::stream_elem::create<pdif::text_elem>(word));
+
+    for (const auto& word : para2) stream2.push_back(pdif::stream_elem::create<pdif::text_elem>(word));
+    for (const auto& word : para1) stream2.push_back(pdif::stream_elem::create<pdif::text_elem>(word));
+
+    pdif::histogram_stream_differ differ(stream1, stream2);
+    pdif::diff diff;
+
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    int plus, minus, eq;
+    diff.count_edit_op_types(plus, minus, eq);
+    ASSERT_EQ(eq, 4);
+    ASSERT_EQ(plus, 4);
+    ASSERT_EQ(minus, 4);
+}
+
+TEST(PDIFHistogramStreamDiffer, TestRandomApply) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> word(0, 20);
+    std::uniform_int_distribution<int> length(0, 300);
+    std::uniform_int_distribution<int> edit(0, 9);
+
+    for (int round = 0; round < 50; round++) {
+        pdif::stream stream1;
+        pdif::stream stream2;
+
+        int size = length(rng);
+        for (int i = 0; i < size; i++) {
+            std::string w = "w" + std::to_string(word(rng));
+            stream1.push_back(pdif::stream_elem::create<pdif::text_elem>(w));
+
+            // mutate roughly a third of the elements into stream2
+            int e = edit(rng);
+            if (e == 0) {
+                continue;
+            } else if (e == 1) {
+                stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("w" + std::to_string(word(rng))));
+            } else if (e == 2) {
+                stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("new"));
+            }
+            stream2.push_back(pdif::stream_elem::create<pdif::text_elem>(w));
+        }
+
+        pdif::histogram_stream_differ differ(stream1, stream2);
+        pdif::diff diff;
+
+        ASSERT_NO_THROW(differ.diff(diff));
+
+        int plus, minus, eq;
+        diff.count_edit_op_types(plus, minus, eq);
+        ASSERT_EQ(eq + minus, (int)stream1.size());
+        ASSERT_EQ(eq + plus, (int)stream2.size());
+
+        pdif::stream result = stream1;
+        ASSERT_NO_THROW(diff.apply_edit_script(result));
+        ASSERT_EQ(result.size(), stream2.size());
+        for (size_t i = 0; i < result.size(); i++) {
+            ASSERT_TRUE(result[i]->compare(stream2[i]));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
\ No newline at end of file
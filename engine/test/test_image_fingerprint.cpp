@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <pdif/image_fingerprint.hpp>
+
+#include <vector>
+#include <algorithm>
+
+// horizontal gradient, brightness increasing left to right
+static std::vector<unsigned char> gradient(int width, int height, int components) {
+    std::vector<unsigned char> pixels((size_t)width * height * components);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < components; c++) {
+                pixels[((size_t)y * width + x) * components + c] = (unsigned char)(x * 255 / (width - 1));
+            }
+        }
+    }
+    return pixels;
+}
+
+TEST(PDIFImageFingerprint, DownscaleUniform) {
+    std::vector<unsigned char> pixels(100 * 80, 42);
+
+    auto grid = pdif::image_fingerprint::downscale(pixels.data(), 100, 80, 1, 9, 8);
+
+    ASSERT_EQ(grid.size(), 72);
+    for (auto v : grid) {
+        ASSERT_EQ(v, 42);
+    }
+}
+
+TEST(PDIFImageFingerprint, DownscaleBoxAverage) {
+    // 2x1 grid over a 4x1 image: averages of {0, 10} and {20, 30}
+    std::vector<unsigned char> pixels = {0, 10, 20, 30};
+
+    auto grid = pdif::image_fingerprint::downscale(pixels.data(), 4, 1, 1, 2, 1);
+
+    ASSERT_EQ(grid.size(), 2);
+    ASSERT_EQ(grid[0], 5);
+    ASSERT_EQ(grid[1], 25);
+}
+
+TEST(PDIFImageFingerprint, DownscaleWideRows) {
+    // rows longer than a vector register to exercise the simd path
+    std::vector<unsigned char> pixels(257 * 3, 200);
+
+    auto grid = pdif::image_fingerprint::downscale(pixels.data(), 257, 3, 1, 1, 1);
+
+    ASSERT_EQ(grid.size(), 1);
+    ASSERT_EQ(grid[0], 200);
+}
+
+TEST(PDIFImageFingerprint, DownscaleSmallerThanGrid) {
+    std::vector<unsigned char> pixels = {7, 9};
+
+    auto grid = pdif::image_fingerprint::downscale(pixels.data(), 2, 1, 1, 9, 8);
+
+    ASSERT_EQ(grid.size(), 72);
+    ASSERT_EQ(grid[0], 7);
+    ASSERT_EQ(grid[71], 9);
+}
+
+TEST(PDIFImageFingerprint, DownscaleInvalid) {
+    std::vector<unsigned char> pixels(16, 0);
+
+    ASSERT_THROW(pdif::image_fingerprint::downscale(pixels.data(), 0, 4, 1, 9, 8), pdif::pdif_invalid_argment);
+    ASSERT_THROW(pdif::image_fingerprint::downscale(pixels.data(), 4, 4, 2, 9, 8), pdif::pdif_invalid_argment);
+}
+
+TEST(PDIFImageFingerprint, DHashGradient) {
+    auto pixels = gradient(90, 80, 1);
+
+    // every left cell is darker than its right neighbour
+    ASSERT_EQ(pdif::image_fingerprint::dhash(pixels.data(), 90, 80, 1), 0);
+}
+
+TEST(PDIFImageFingerprint, DHashReverseGradient) {
+    auto pixels = gradient(90, 80, 1);
+    std::reverse(pixels.begin(), pixels.end());
+
+    ASSERT_EQ(pdif::image_fingerprint::dhash(pixels.data(), 90, 80, 1), ~0ULL);
+}
+
+TEST(PDIFImageFingerprint, DHashResized) {
+    auto small = gradient(90, 80, 3);
+    auto large = gradient(450, 400, 3);
+
+    uint64_t a = pdif::image_fingerprint::dhash(small.data(), 90, 80, 3);
+    uint64_t b = pdif::image_fingerprint::dhash(large.data(), 450, 400, 3);
+
+    ASSERT_LE(pdif::image_fingerprint::distance(a, b), 4);
+}
+
+TEST(PDIFImageFingerprint, DHashGrayMatchesRGB) {
+    auto gray = gradient(90, 80, 1);
+    auto rgb = gradient(90, 80, 3);
+
+    ASSERT_EQ(pdif::image_fingerprint::dhash(gray.data(), 90, 80, 1), pdif::image_fingerprint::dhash(rgb.data(), 90, 80, 3));
+}
+
+TEST(PDIFImageFingerprint, Distance) {
+    ASSERT_EQ(pdif::image_fingerprint::distance(0, 0), 0);
+    ASSERT_EQ(pdif::image_fingerprint::distance(0, ~0ULL), 64);
+    ASSERT_EQ(pdif::image_fingerprint::distance(0b1010, 0b0110), 2);
+}
+
+TEST(PDIFImageFingerprint, Bucket) {
+    ASSERT_EQ(pdif::image_fingerprint::bucket(0), 0);
+    ASSERT_EQ(pdif::image_fingerprint::bucket(~0ULL), 0b1111);
+    // the left half of every row is set: the two left quadrants
+    ASSERT_EQ(pdif::image_fingerprint::bucket(0xF0F0F0F0F0F0F0F0ULL), 0b0101);
+    // a bit flipped in one quadrant does not change its majority
+    ASSERT_EQ(pdif::image_fingerprint::bucket(0xF0F0F0F0F0F0F0F1ULL), 0b0101);
+}
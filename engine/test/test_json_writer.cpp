@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+#include <pdif/json_writer.hpp>
+
+static pdif::diff make_diff() {
+    pdif::stream s;
+    s.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    s.push_back(pdif::stream_elem::create<pdif::text_elem>("old"));
+    s.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+
+    pdif::diff d(false);
+    d.add_original_stream(s);
+    d.set_allowed_context(1);
+    d.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+    d.add_edit_op(pdif::edit_op(pdif::edit_op_type::INSERT, pdif::stream_elem::create<pdif::font_elem>("CMR10", 9)));
+    d.add_edit_op(pdif::edit_op(pdif::edit_op_type::DELETE));
+    d.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+
+    d.add_meta_edit_op(pdif::meta_edit_op(pdif::meta_edit_op_type::META_ADD, "/Title", "New"));
+    d.add_meta_edit_op(pdif::meta_edit_op(pdif::meta_edit_op_type::META_DELETE, "/Author"));
+    return d;
+}
+
+TEST(PDIFJsonWriter, TestNdjsonDiff) {
+    pdif::diff d = make_diff();
+
+    std::stringstream ss;
+    {
+        pdif::json_writer writer(ss, pdif::output_format::ndjson);
+        writer.write_meta_edit_script(d);
+        writer.write_edit_script(d);
+        writer.write_edit_summary(d);
+        writer.write_meta_summary(d);
+    }
+
+    std::string expected =
+        "{\"type\":\"meta_change\",\"op\":\"add\",\"key\":\"/Title\",\"value\":\"New\"}\n"
+        "{\"type\":\"meta_change\",\"op\":\"delete\",\"key\":\"/Author\"}\n"
+        "{\"type\":\"hunk\",\"from_start\":0,\"from_count\":3,\"to_start\":0,\"to_count\":3,\"lines\":["
+        "{\"op\":\"eq\",\"elem\":{\"kind\":\"text\",\"text\":\"Hello\"}},"
+        "{\"op\":\"insert\",\"elem\":{\"kind\":\"font\",\"name\":\"CMR10\",\"size\":9}},"
+        "{\"op\":\"delete\",\"elem\":{\"kind\":\"text\",\"text\":\"old\"}},"
+        "{\"op\":\"eq\",\"elem\":{\"kind\":\"text\",\"text\":\"World\"}}]}\n"
+        "{\"type\":\"summary\",\"scope\":\"content\",\"insert\":1,\"delete\":1,\"eq\":2,\"move\":0}\n"
+        "{\"type\":\"summary\",\"scope\":\"meta\",\"insert\":1,\"delete\":1,\"update\":0}\n";
+
+    ASSERT_EQ(ss.str(), expected);
+}
+
+TEST(PDIFJsonWriter, TestJsonWrapsRecords) {
+    pdif::diff d = make_diff();
+
+    std::stringstream ss;
+    pdif::json_writer writer(ss, pdif::output_format::json);
+    writer.write_meta_edit_script(d);
+    writer.finish();
+
+    std::string expected =
+        "[\n"
+        "{\"type\":\"meta_change\",\"op\":\"add\",\"key\":\"/Title\",\"value\":\"New\"},\n"
+        "{\"type\":\"meta_change\",\"op\":\"delete\",\"key\":\"/Author\"}\n"
+        "]\n";
+
+    ASSERT_EQ(ss.str(), expected);
+    ASSERT_THROW(writer.write_edit_summary(d), pdif::pdif_invalid_operation);
+}
+
+TEST(PDIFJsonWriter, TestJsonEmpty) {
+    std::stringstream ss;
+    {
+        pdif::json_writer writer(ss, pdif::output_format::json);
+    }
+
+    ASSERT_EQ(ss.str(), "[]\n");
+}
+
+TEST(PDIFJsonWriter, TestTextFormatInvalid) {
+    std::stringstream ss;
+    ASSERT_THROW(pdif::json_writer writer(ss, pdif::output_format::text), pdif::pdif_invalid_argment);
+}
+
+TEST(PDIFJsonWriter, TestStreamElements) {
+    pdif::stream s;
+    s.push_back(pdif::stream_elem::create<pdif::text_color_elem>(1.f, 0.5f, 0.f));
+    s.push_back(pdif::stream_elem::create<pdif::stroke_color_elem>(0.f, 0.f, 0.f));
+    s.push_back(pdif::stream_elem::create<pdif::xobject_img_elem>("abc", 10, 20));
+
+    pdif::stream_meta meta;
+    meta.add_metadata("/Title", "A");
+
+    std::stringstream ss;
+    {
+        pdif::json_writer writer(ss, pdif::output_format::ndjson);
+        writer.write_meta(meta);
+        writer.write_stream(2, s);
+    }
+
+    std::string expected =
+        "{\"type\":\"meta\",\"key\":\"/Title\",\"value\":\"A\"}\n"
+        "{\"type\":\"elem\",\"page\":2,\"index\":0,\"elem\":{\"kind\":\"text_color\",\"r\":1,\"g\":0.5,\"b\":0}}\n"
+        "{\"type\":\"elem\",\"page\":2,\"index\":1,\"elem\":{\"kind\":\"stroke_color\",\"r\":0,\"g\":0,\"b\":0}}\n"
+        "{\"type\":\"elem\",\"page\":2,\"index\":2,\"elem\":{\"kind\":\"image\",\"hash\":\"abc\",\"width\":10,\"height\":20}}\n";
+
+    ASSERT_EQ(ss.str(), expected);
+}
+
+TEST(PDIFJsonWriter, TestAnnotationsAndFields) {
+    pdif::stream s;
+    s.push_back(pdif::stream_elem::create<pdif::annotation_elem>("Text", std::array<float, 4>{1, 2, 3.5f, 4}, "a note", 0xabcull));
+    s.push_back(pdif::stream_elem::create<pdif::form_field_elem>("person.name", "Tx", "Alice"));
+
+    std::stringstream ss;
+    {
+        pdif::json_writer writer(ss, pdif::output_format::ndjson);
+        writer.write_stream(0, s);
+    }
+
+    std::string expected =
+        "{\"type\":\"elem\",\"page\":0,\"index\":0,\"elem\":{\"kind\":\"annotation\",\"subtype\":\"Text\",\"rect\":[1,2,3.5,4],\"contents\":\"a note\",\"hash\":\"0000000000000abc\"}}\n"
+        "{\"type\":\"elem\",\"page\":0,\"index\":1,\"elem\":{\"kind\":\"form_field\",\"name\":\"person.name\",\"field_type\":\"Tx\",\"value\":\"Alice\"}}\n";
+
+    ASSERT_EQ(ss.str(), expected);
+}
+
+TEST(PDIFJsonWriter, TestStats) {
+    pdif::stats stats;
+    {
+        pdif::stats::collect collect(&stats);
+        pdif::stats::add(pdif::stats::counter::tokens, 3);
+        pdif::stats::add(pdif::stats::counter::ops, 2);
+    }
+
+    std::stringstream ss;
+    {
+        pdif::json_writer writer(ss, pdif::output_format::ndjson);
+        writer.write_stats(stats);
+    }
+
+    std::string expected =
+        "{\"type\":\"stats\",\"stages\":{"
+        "\"parse\":{\"ns\":0,\"calls\":0},\"extract\":{\"ns\":0,\"calls\":0},\"fonts\":{\"ns\":0,\"calls\":0},"
+        "\"images\":{\"ns\":0,\"calls\":0},\"diff\":{\"ns\":0,\"calls\":0},\"render\":{\"ns\":0,\"calls\":0}},"
+        "\"counters\":{\"tokens\":3,\"elements\":0,\"cmaps\":0,\"bytes_hashed\":0,\"dp_cells\":0,\"ops\":2},"
+        "\"pages\":[]}\n";
+
+    ASSERT_EQ(ss.str(), expected);
+}
+
+TEST(PDIFJsonWriter, TestEscaping) {
+    pdif::stream s;
+    s.push_back(pdif::stream_elem::create<pdif::text_elem>(std::string("a\"b\\c\nd\te\x01 caf\xc3\xa9")));
+
+    std::stringstream ss;
+    {
+        pdif::json_writer writer(ss, pdif::output_format::ndjson);
+        writer.write_stream(1, s);
+    }
+
+    ASSERT_EQ(ss.str(), "{\"type\":\"elem\",\"page\":1,\"index\":0,\"elem\":{\"kind\":\"text\",\"text\":\"a\\\"b\\\\c\\nd\\te\\u0001 caf\xc3\xa9\"}}\n");
+}
+
+TEST(PDIFJsonWriter, TestFlushesIncrementally) {
+    pdif::stream s;
+    for (int i = 0; i < 1000; i++) {
+        s.push_back(pdif::stream_elem::create<pdif::text_elem>("word"));
+    }
+
+    std::stringstream ss;
+    pdif::json_writer writer(ss, pdif::output_format::ndjson, 256);
+    writer.write_stream(1, s);
+
+    // everything but the last partial buffer has already been written
+    size_t written = ss.str().size();
+    ASSERT_GT(written, 0);
+
+    writer.finish();
+    ASSERT_GE(ss.str().size(), written);
+    ASSERT_LT(ss.str().size() - written, 256);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
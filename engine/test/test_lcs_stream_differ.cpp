@@ -344,6 +344,26 @@ TEST(PDIFLcsStreamDiffer, TestAddXObjectImg) {
     ASSERT_EQ(edit_op.get_type(), pdif::edit_op_type::EQ);
 }
 
+TEST(PDIFLcsStreamDiffer, TestViews) {
+    pdif::stream stream1;
+    pdif::stream stream2;
+
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream1.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+    stream2.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+
+    // the differ views the streams without taking a reference to any element
+    pdif::lcs_stream_differ differ(pdif::stream_view(stream1).subspan(1), stream2);
+    ASSERT_EQ(stream1[1].use_count(), 1);
+
+    pdif::diff diff;
+    ASSERT_NO_THROW(differ.diff(diff));
+
+    ASSERT_EQ(diff.edit_op_size(), 1);
+    ASSERT_EQ(diff.get_edit_op(0).get_type(), pdif::edit_op_type::EQ);
+    ASSERT_EQ(differ.original_stream().size(), 1);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
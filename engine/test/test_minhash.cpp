@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <pdif/minhash.hpp>
+#include <pdif/stream_elem.hpp>
+
+#include <random>
+
+static std::vector<std::string> random_text(std::mt19937& rng, int words) {
+    std::uniform_int_distribution<int> word(0, 5000);
+
+    std::vector<std::string> text;
+    for (int i = 0; i < words; i++) {
+        text.push_back("word" + std::to_string(word(rng)));
+    }
+    return text;
+}
+
+static pdif::stream as_words(const std::vector<std::string>& text) {
+    pdif::stream s;
+    for (const auto& word : text) {
+        s.push_back(pdif::stream_elem::create<pdif::text_elem>(word));
+    }
+    return s;
+}
+
+TEST(PDIFMinhash, TestIdentical) {
+    std::mt19937 rng(1);
+    auto text = random_text(rng, 300);
+
+    auto a = pdif::minhash::sketch(as_words(text));
+    auto b = pdif::minhash::sketch(as_words(text));
+    ASSERT_EQ(a, b);
+    ASSERT_EQ(pdif::minhash::similarity(a, b), 1.0);
+}
+
+TEST(PDIFMinhash, TestGranularityAndCase) {
+    pdif::stream words;
+    for (auto word : {"The", "quick", "brown", "fox", "jumps", "over", "the", "lazy", "dog."}) {
+        words.push_back(pdif::stream_elem::create<pdif::text_elem>(word));
+    }
+
+    // state elements are ignored and sentences split into the same words
+    pdif::stream sentences;
+    sentences.push_back(pdif::stream_elem::create<pdif::font_elem>("CMR10", 9));
+    sentences.push_back(pdif::stream_elem::create<pdif::text_elem>("the QUICK brown fox jumps "));
+    sentences.push_back(pdif::stream_elem::create<pdif::text_elem>("over the lazy dog."));
+
+    ASSERT_EQ(pdif::minhash::sketch(words), pdif::minhash::sketch(sentences));
+}
+
+TEST(PDIFMinhash, TestSimilarity) {
+    std::mt19937 rng(2);
+    auto text = random_text(rng, 1000);
+
+    auto revised = text;
+    revised[100] = "changed";
+    revised.erase(revised.begin() + 500);
+    revised.insert(revised.begin() + 700, "inserted");
+
+    auto other = random_text(rng, 1000);
+
+    auto sig = pdif::minhash::sketch(as_words(text));
+    ASSERT_GT(pdif::minhash::similarity(sig, pdif::minhash::sketch(as_words(revised))), 0.9);
+    ASSERT_LT(pdif::minhash::similarity(sig, pdif::minhash::sketch(as_words(other))), 0.1);
+}
+
+TEST(PDIFMinhash, TestCombine) {
+    std::mt19937 rng(3);
+    std::vector<pdif::stream> pages = {as_words(random_text(rng, 100)), as_words(random_text(rng, 100))};
+
+    auto page_sigs = pdif::minhash::sketch_pages(pages);
+    ASSERT_EQ(page_sigs.size(), 2);
+
+    auto sig = pdif::minhash::combine(page_sigs);
+    for (size_t i = 0; i < pdif::minhash::SIGNATURE_SIZE; i++) {
+        ASSERT_EQ(sig[i], std::min(page_sigs[0][i], page_sigs[1][i]));
+    }
+
+    ASSERT_EQ(pdif::minhash::combine({}), pdif::minhash::empty());
+    ASSERT_EQ(pdif::minhash::sketch(pdif::stream()), pdif::minhash::empty());
+}
+
+TEST(PDIFMinhash, TestShortStream) {
+    pdif::stream s;
+    s.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+
+    ASSERT_NE(pdif::minhash::sketch(s), pdif::minhash::empty());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <pdif/multi_compare.hpp>
+#include <pdif/lcs_stream_differ.hpp>
+#include <pdif/hierarchical_stream_differ.hpp>
+#include <pdif/pdf.hpp>
+
+#include "test_compare_util.hpp"
+
+TEST(PDIFMultiCompare, TestMatchesCompare) {
+    pdif::multi_compare base("test_pdfs/multi_page.pdf", pdif::multi_compare::make_differ<pdif::lcs_stream_differ>());
+
+    for (const auto& revision : REVISIONS) {
+        assert_same_diff(base.compare(revision), full_compare("test_pdfs/multi_page.pdf", revision));
+    }
+}
+
+TEST(PDIFMultiCompare, TestMatchesCompareHierarchical) {
+    // unchanged pages keep the refined script and original stream of the refining differ
+    pdif::multi_compare base("test_pdfs/multi_page.pdf", pdif::multi_compare::make_differ<pdif::hierarchical_stream_differ>(-1, pdif::granularity::word), pdif::granularity::sentence);
+
+    for (const auto& revision : REVISIONS) {
+        pdif::PDF pdf1("test_pdfs/multi_page.pdf", pdif::granularity::sentence, pdif::scope::page);
+        pdif::PDF pdf2(revision, pdif::granularity::sentence, pdif::scope::page);
+        assert_same_diff(base.compare(revision), pdf1.compare<pdif::hierarchical_stream_differ>(pdf2, -1, pdif::granularity::word));
+    }
+}
+
+TEST(PDIFMultiCompare, TestUnchangedRevision) {
+    pdif::multi_compare base("test_pdfs/multi_page.pdf", pdif::multi_compare::make_differ<pdif::lcs_stream_differ>());
+    pdif::diff d = base.compare("test_pdfs/multi_page.pdf");
+
+    int plus, minus, eq;
+    d.count_edit_op_types(plus, minus, eq);
+    ASSERT_EQ(plus, 0);
+    ASSERT_EQ(minus, 0);
+    ASSERT_EQ(d.original_streams().size(), base.base_pages().size());
+}
+
+TEST(PDIFMultiCompare, TestParallel) {
+    pdif::multi_compare base("test_pdfs/multi_page.pdf", pdif::multi_compare::make_differ<pdif::lcs_stream_differ>());
+
+    auto diffs = base.compare(REVISIONS, 4);
+    ASSERT_EQ(diffs.size(), REVISIONS.size());
+    for (size_t i = 0; i < REVISIONS.size(); i++) {
+        assert_same_diff(diffs[i], base.compare(REVISIONS[i]));
+    }
+
+    ASSERT_EQ(base.compare(std::vector<std::string>()).size(), 0);
+}
+
+TEST(PDIFMultiCompare, TestParallelManyRevisions) {
+    // more revisions than threads, each revision several times, so the workers extract and reuse the
+    // unchanged pages of the base at the same time; run under PDIF_SANITIZE_THREAD
+    pdif::multi_compare base("test_pdfs/multi_page.pdf", pdif::multi_compare::make_differ<pdif::hierarchical_stream_differ>(-1, pdif::granularity::word), pdif::granularity::sentence);
+
+    std::vector<std::string> revisions;
+    for (int round = 0; round < 4; round++) {
+        revisions.insert(revisions.end(), REVISIONS.begin(), REVISIONS.end());
+    }
+
+    auto diffs = base.compare(revisions, 8);
+    ASSERT_EQ(diffs.size(), revisions.size());
+    for (size_t i = 0; i < revisions.size(); i++) {
+        pdif::PDF pdf1("test_pdfs/multi_page.pdf", pdif::granularity::sentence, pdif::scope::page);
+        pdif::PDF pdf2(revisions[i], pdif::granularity::sentence, pdif::scope::page);
+        assert_same_diff(diffs[i], pdf1.compare<pdif::hierarchical_stream_differ>(pdf2, -1, pdif::granularity::word));
+    }
+}
+
+TEST(PDIFMultiCompare, TestParallelError) {
+    pdif::multi_compare base("test_pdfs/multi_page.pdf", pdif::multi_compare::make_differ<pdif::lcs_stream_differ>());
+
+    std::vector<std::string> revisions = {"test_pdfs/multi_page.pdf", "test_pdfs/does_not_exist.pdf"};
+    ASSERT_ANY_THROW(base.compare(revisions, 2));
+}
+
+TEST(PDIFMultiCompare, TestFingerprint) {
+    pdif::stream a;
+    a.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    a.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+
+    pdif::stream b = a;
+    ASSERT_EQ(pdif::multi_compare::fingerprint(a), pdif::multi_compare::fingerprint(b));
+
+    b.pop(1);
+    ASSERT_NE(pdif::multi_compare::fingerprint(a), pdif::multi_compare::fingerprint(b));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <pdif/output_buffer.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+TEST(PDIFOutputBuffer, TestBuffersUntilFlush) {
+    std::stringstream ss;
+    pdif::output_buffer out(ss, 64);
+
+    out << "Hello" << ' ' << "World" << '\n';
+    ASSERT_EQ(ss.str(), "");
+
+    out.flush();
+    ASSERT_EQ(ss.str(), "Hello World\n");
+}
+
+TEST(PDIFOutputBuffer, TestWritesAtCapacity) {
+    std::stringstream ss;
+    pdif::output_buffer out(ss, 16);
+
+    out << "0123456789";
+    ASSERT_EQ(ss.str(), "");
+
+    out << "0123456789";
+    ASSERT_EQ(ss.str(), "01234567890123456789");
+}
+
+TEST(PDIFOutputBuffer, TestCommit) {
+    std::stringstream ss;
+    pdif::output_buffer out(ss, 8);
+
+    out.buffer().append("abc");
+    out.commit();
+    ASSERT_EQ(ss.str(), "");
+
+    out.buffer().append("defghi");
+    out.commit();
+    ASSERT_EQ(ss.str(), "abcdefghi");
+    ASSERT_TRUE(out.buffer().empty());
+}
+
+TEST(PDIFOutputBuffer, TestIntegers) {
+    std::stringstream ss;
+    {
+        pdif::output_buffer out(ss);
+        out << 42 << ',' << -7 << ',' << size_t(18446744073709551615ull) << ',' << 0;
+    }
+
+    ASSERT_EQ(ss.str(), "42,-7,18446744073709551615,0");
+}
+
+TEST(PDIFOutputBuffer, TestDestructorFlushes) {
+    std::stringstream ss;
+    {
+        pdif::output_buffer out(ss);
+        out << "pending";
+    }
+
+    ASSERT_EQ(ss.str(), "pending");
+}
+
+TEST(PDIFOutputBuffer, TestLargeAppendKeepsOrder) {
+    std::stringstream ss;
+    pdif::output_buffer out(ss, 16);
+
+    std::string large(100, 'x');
+    out << "head:" << large << ":tail";
+    out.flush();
+
+    ASSERT_EQ(ss.str(), "head:" + large + ":tail");
+}
+
+#if !defined(_WIN32)
+TEST(PDIFOutputBuffer, TestFileDescriptor) {
+    std::string path = (std::filesystem::temp_directory_path() / "pdif_test_output_buffer.txt").string();
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0);
+
+    std::string large(1000, 'y');
+    {
+        pdif::output_buffer out(fd, 64);
+        for (int i = 0; i < 100; i++) {
+            out << i << '\n';
+        }
+        out << large;
+        out.flush();
+    }
+    ::close(fd);
+
+    std::stringstream expected;
+    for (int i = 0; i < 100; i++) {
+        expected << i << '\n';
+    }
+    expected << large;
+
+    std::ifstream file(path);
+    std::stringstream actual;
+    actual << file.rdbuf();
+    ASSERT_EQ(actual.str(), expected.str());
+
+    std::filesystem::remove(path);
+}
+
+TEST(PDIFOutputBuffer, TestFileDescriptorError) {
+    pdif::output_buffer out(-1, 64);
+    out << "lost";
+    ASSERT_THROW(out.flush(), pdif::pdif_io_error);
+}
+#endif
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
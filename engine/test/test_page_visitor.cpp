@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <pdif/page_visitor.hpp>
+#include <pdif/content_extractor.hpp>
+#include <pdif/stream_elem.hpp>
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFPageDocumentHelper.hh>
+
+// a one page PDF without content, annotated with a note (and its popup), a text field and a radio group
+static std::shared_ptr<QPDF> make_annotated_pdf(const std::string& note = "a note", const std::string& name = "Alice") {
+    auto pdf = QPDF::create();
+    pdf->emptyPDF();
+
+    QPDFObjectHandle page = pdf->makeIndirectObject(QPDFObjectHandle::parse("<< /Type /Page /MediaBox [0 0 612 792] /Resources << >> >>"));
+    page.replaceKey("/Contents", QPDFObjectHandle::newStream(pdf.get(), ""));
+
+    QPDFObjectHandle text = pdf->makeIndirectObject(QPDFObjectHandle::parse("<< /Type /Annot /Subtype /Text /Rect [100 220 50 200] /C [1 0 0] /M (D:20240301) >>"));
+    text.replaceKey("/Contents", QPDFObjectHandle::newString(note));
+    QPDFObjectHandle popup = pdf->makeIndirectObject(QPDFObjectHandle::parse("<< /Type /Annot /Subtype /Popup /Rect [0 0 10 10] >>"));
+    popup.replaceKey("/Parent", text);
+    text.replaceKey("/Popup", popup);
+
+    QPDFObjectHandle person = pdf->makeIndirectObject(QPDFObjectHandle::parse("<< /T (person) >>"));
+    QPDFObjectHandle widget = pdf->makeIndirectObject(QPDFObjectHandle::parse("<< /Type /Annot /Subtype /Widget /Rect [0 0 10 10] /T (name) /FT /Tx >>"));
+    widget.replaceKey("/V", QPDFObjectHandle::newString(name));
+    widget.replaceKey("/Parent", person);
+
+    QPDFObjectHandle radio = pdf->makeIndirectObject(QPDFObjectHandle::parse("<< /T (choice) /FT /Btn /V /B >>"));
+    QPDFObjectHandle option_a = pdf->makeIndirectObject(QPDFObjectHandle::parse("<< /Type /Annot /Subtype /Widget /Rect [0 20 10 30] /AS /Off >>"));
+    QPDFObjectHandle option_b = pdf->makeIndirectObject(QPDFObjectHandle::parse("<< /Type /Annot /Subtype /Widget /Rect [0 40 10 50] /AS /B >>"));
+    option_a.replaceKey("/Parent", radio);
+    option_b.replaceKey("/Parent", radio);
+
+    QPDFObjectHandle annots = QPDFObjectHandle::newArray();
+    for (auto& annot : {text, popup, widget, option_a, option_b}) {
+        annots.appendItem(annot);
+    }
+    page.replaceKey("/Annots", annots);
+
+    QPDFPageDocumentHelper(*pdf).addPage(QPDFPageObjectHelper(page), false);
+    return pdf;
+}
+
+TEST(PDIFPageVisitor, TestAnnotationsAndFields) {
+    auto pdf = make_annotated_pdf();
+    std::vector<pdif::stream> streams = pdif::extract_content(pdf, pdif::granularity::word, pdif::scope::page);
+
+    ASSERT_EQ(streams.size(), 1);
+    pdif::stream& s = streams[0];
+    ASSERT_EQ(s.size(), 3);
+
+    ASSERT_EQ(s[0]->type(), pdif::stream_type::annotation);
+    auto note = s[0]->as<pdif::annotation_elem>();
+    ASSERT_EQ(note->subtype(), "Text");
+    ASSERT_EQ(note->rect(), (std::array<float, 4>{50, 200, 100, 220}));
+    ASSERT_EQ(note->contents(), "a note");
+
+    ASSERT_EQ(s[1]->type(), pdif::stream_type::form_field);
+    auto name = s[1]->as<pdif::form_field_elem>();
+    ASSERT_EQ(name->name(), "person.name");
+    ASSERT_EQ(name->field_type(), "Tx");
+    ASSERT_EQ(name->value(), "Alice");
+
+    // the radio group is listed once, with the value of the group
+    ASSERT_EQ(s[2]->type(), pdif::stream_type::form_field);
+    auto choice = s[2]->as<pdif::form_field_elem>();
+    ASSERT_EQ(choice->name(), "choice");
+    ASSERT_EQ(choice->field_type(), "Btn");
+    ASSERT_EQ(choice->value(), "B");
+}
+
+TEST(PDIFPageVisitor, TestChangesAreDetected) {
+    auto initial = pdif::extract_content(make_annotated_pdf(), pdif::granularity::word, pdif::scope::page);
+    auto same = pdif::extract_content(make_annotated_pdf(), pdif::granularity::word, pdif::scope::page);
+    auto note_changed = pdif::extract_content(make_annotated_pdf("another note"), pdif::granularity::word, pdif::scope::page);
+    auto value_changed = pdif::extract_content(make_annotated_pdf("a note", "Bob"), pdif::granularity::word, pdif::scope::page);
+
+    for (size_t i = 0; i < 3; i++) {
+        ASSERT_TRUE(initial[0][i]->compare(same[0][i]));
+    }
+
+    ASSERT_FALSE(initial[0][0]->compare(note_changed[0][0]));
+    ASSERT_TRUE(initial[0][1]->compare(note_changed[0][1]));
+
+    ASSERT_TRUE(initial[0][0]->compare(value_changed[0][0]));
+    ASSERT_FALSE(initial[0][1]->compare(value_changed[0][1]));
+}
+
+TEST(PDIFPageVisitor, TestStructuralHash) {
+    auto hash = [](const std::string& object) {
+        return pdif::page_visitor::structural_hash(QPDFObjectHandle::parse(object));
+    };
+
+    ASSERT_EQ(hash("<< /Subtype /Text /C [1 0 0] >>"), hash("<< /C [1 0 0] /Subtype /Text >>"));
+    ASSERT_NE(hash("<< /Subtype /Text /C [1 0 0] >>"), hash("<< /Subtype /Text /C [0 1 0] >>"));
+    ASSERT_NE(hash("<< /A (x) >>"), hash("<< /A /x >>"));
+    ASSERT_NE(hash("[(ab) (c)]"), hash("[(a) (bc)]"));
+
+    // rewritten on every save
+    ASSERT_EQ(hash("<< /Subtype /Text /M (D:20240301) >>"), hash("<< /Subtype /Text /M (D:20240302) >>"));
+    ASSERT_EQ(hash("<< /Subtype /Text >>"), hash("<< /Subtype /Text /AP << /N 1 >> >>"));
+}
+
+TEST(PDIFPageVisitor, TestStructuralHashPageReference) {
+    auto pdf = QPDF::create();
+    pdf->emptyPDF();
+
+    QPDFObjectHandle target = pdf->makeIndirectObject(QPDFObjectHandle::parse("<< /Type /Page /MediaBox [0 0 612 792] /Resources << >> >>"));
+    target.replaceKey("/Contents", QPDFObjectHandle::newStream(pdf.get(), "BT (before) Tj ET"));
+    QPDFPageDocumentHelper(*pdf).addPage(QPDFPageObjectHelper(target), false);
+
+    QPDFObjectHandle link = QPDFObjectHandle::parse("<< /Type /Annot /Subtype /Link /Rect [0 0 10 10] >>");
+    QPDFObjectHandle dest = QPDFObjectHandle::newArray();
+    dest.appendItem(target);
+    dest.appendItem(QPDFObjectHandle::newName("/Fit"));
+    link.replaceKey("/Dest", dest);
+
+    uint64_t before = pdif::page_visitor::structural_hash(link);
+
+    // editing the target page does not change the link
+    target.getKey("/Contents").replaceStreamData("BT (after) Tj ET", QPDFObjectHandle::newNull(), QPDFObjectHandle::newNull());
+    target.replaceKey("/Rotate", QPDFObjectHandle::newInteger(90));
+    ASSERT_EQ(pdif::page_visitor::structural_hash(link), before);
+
+    // pointing it at another page does
+    QPDFObjectHandle other = pdf->makeIndirectObject(QPDFObjectHandle::parse("<< /Type /Page /MediaBox [0 0 612 792] /Resources << >> >>"));
+    QPDFPageDocumentHelper(*pdf).addPage(QPDFPageObjectHelper(other), false);
+    dest.setArrayItem(0, other);
+    ASSERT_NE(pdif::page_visitor::structural_hash(link), before);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,7 +1,10 @@
 #include <gtest/gtest.h>
 #include <pdif/lcs_stream_differ.hpp>
+#include <pdif/hierarchical_stream_differ.hpp>
 #include <pdif/pdf.hpp>
 
+#include <filesystem>
+
 TEST(PDIFPDF, Constructor) {
     ASSERT_NO_THROW({pdif::PDF pdf("test_pdfs/metadata_initial.pdf", pdif::granularity::word, pdif::scope::page);});
 }
@@ -236,6 +239,34 @@ TEST(PDIFPDF, ExtractIgnoreRepeated) {
     ASSERT_EQ(s[14]->as<pdif::text_elem>()->text(), "1");
 }
 
+TEST(PDIFPDF, ExtractionCache) {
+    std::string cache_path = (std::filesystem::temp_directory_path() / "pdif_test_pdf_content_initial.pdifx").string();
+    std::filesystem::remove(cache_path);
+
+    pdif::PDF parsed("test_pdfs/content_initial.pdf", pdif::granularity::word, pdif::scope::page, false, -1, true, -1, cache_path);
+    ASSERT_FALSE(parsed.from_extraction_cache());
+    parsed.write_extraction_cache(cache_path);
+
+    pdif::PDF cached("test_pdfs/content_initial.pdf", pdif::granularity::word, pdif::scope::page, false, -1, true, -1, cache_path);
+    ASSERT_TRUE(cached.from_extraction_cache());
+
+    std::stringstream parsed_ss, cached_ss;
+    parsed.dump_content(parsed_ss);
+    parsed.dump_meta(parsed_ss);
+    cached.dump_content(cached_ss);
+    cached.dump_meta(cached_ss);
+    ASSERT_EQ(parsed_ss.str(), cached_ss.str());
+
+    // a cache written with other options or for another file is ignored
+    pdif::PDF letter("test_pdfs/content_initial.pdf", pdif::granularity::letter, pdif::scope::page, false, -1, true, -1, cache_path);
+    ASSERT_FALSE(letter.from_extraction_cache());
+
+    pdif::PDF other("test_pdfs/content_final.pdf", pdif::granularity::word, pdif::scope::page, false, -1, true, -1, cache_path);
+    ASSERT_FALSE(other.from_extraction_cache());
+
+    std::filesystem::remove(cache_path);
+}
+
 /**
  * @brief From Here on we will test the compare function
  * 
@@ -351,6 +382,27 @@ TEST(PDIFPDFCompare, BasicTextSentenceGranularity) {
     ASSERT_EQ(op.get_type(), pdif::edit_op_type::DELETE);
 }
 
+TEST(PDIFPDFCompare, BasicTextHierarchical) {
+    pdif::PDF pdf1("test_pdfs/content_initial.pdf", pdif::granularity::sentence, pdif::scope::page);
+    pdif::PDF pdf2("test_pdfs/content_final.pdf", pdif::granularity::sentence, pdif::scope::page);
+
+    pdif::diff d = pdf1.compare<pdif::hierarchical_stream_differ>(pdf2, -1, pdif::granularity::word);
+
+    // the changed sentence is refined to the same script as a word granularity diff
+    ASSERT_EQ(d.edit_op_size(), 5);
+
+    auto op = d.get_edit_op(2);
+    ASSERT_EQ(op.get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(op.get_arg()->type(), pdif::stream_type::text);
+    ASSERT_EQ(op.get_arg()->as<pdif::text_elem>()->text(), "my");
+
+    int plus, minus, eq;
+    d.count_edit_op_types(plus, minus, eq);
+    ASSERT_EQ(plus, 1);
+    ASSERT_EQ(minus, 0);
+    ASSERT_EQ(eq, 4);
+}
+
 // Font Changes
 TEST(PDIFPDFCompare, FontChangeNormalToBold) {
     pdif::PDF pdf1("test_pdfs/font_change_inital.pdf", pdif::granularity::sentence, pdif::scope::page);
@@ -1316,6 +1368,53 @@ TEST(PDIFPDFCompare, Pageno3) {
     ASSERT_EQ(op.get_type(), pdif::edit_op_type::EQ);
 }
 
+TEST(PDIFPDFCompare, InlineImageChanged) {
+    pdif::PDF pdf1("test_pdfs/inline_image_initial.pdf", pdif::granularity::sentence, pdif::scope::page);
+    pdif::PDF pdf2("test_pdfs/inline_image_changed.pdf", pdif::granularity::sentence, pdif::scope::page);
+
+    pdif::diff d = pdf1.compare<pdif::lcs_stream_differ>(pdf2);
+
+    ASSERT_EQ(d.edit_op_size(), 7);
+
+    int plus, minus, eq;
+    d.count_edit_op_types(plus, minus, eq);
+
+    ASSERT_EQ(plus, 1);
+    ASSERT_EQ(minus, 1);
+    ASSERT_EQ(eq, 5);
+
+    for (size_t i = 0; i < d.edit_op_size(); i++) {
+        auto op = d.get_edit_op(i);
+        if (op.get_type() == pdif::edit_op_type::INSERT) {
+            ASSERT_EQ(op.get_arg()->type(), pdif::stream_type::xobject_image);
+        }
+    }
+}
+
+TEST(PDIFPDFCompare, FormXObjectChanged) {
+    pdif::PDF pdf1("test_pdfs/form_xobject_initial.pdf", pdif::granularity::sentence, pdif::scope::page);
+    pdif::PDF pdf2("test_pdfs/form_xobject_changed.pdf", pdif::granularity::sentence, pdif::scope::page);
+
+    pdif::diff d = pdf1.compare<pdif::lcs_stream_differ>(pdf2);
+
+    ASSERT_EQ(d.edit_op_size(), 12);
+
+    int plus, minus, eq;
+    d.count_edit_op_types(plus, minus, eq);
+
+    // the footer changes on both pages
+    ASSERT_EQ(plus, 2);
+    ASSERT_EQ(minus, 2);
+    ASSERT_EQ(eq, 8);
+
+    for (size_t i = 0; i < d.edit_op_size(); i++) {
+        auto op = d.get_edit_op(i);
+        if (op.get_type() == pdif::edit_op_type::INSERT) {
+            ASSERT_EQ(op.get_arg()->as<pdif::text_elem>()->text(), "Public footer.");
+        }
+    }
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
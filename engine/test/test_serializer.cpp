@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <pdif/serializer.hpp>
+
+#include <sstream>
+
+TEST(PDIFSerializer, TestPrimitives) {
+    std::stringstream ss;
+    pdif::serializer::write_u8(ss, 0xab);
+    pdif::serializer::write_u32(ss, 0xdeadbeef);
+    pdif::serializer::write_u64(ss, 0x0123456789abcdefull);
+    pdif::serializer::write_i32(ss, -42);
+    pdif::serializer::write_f32(ss, 0.25f);
+    pdif::serializer::write_string(ss, "hello");
+
+    ASSERT_EQ(pdif::serializer::read_u8(ss), 0xab);
+    ASSERT_EQ(pdif::serializer::read_u32(ss), 0xdeadbeef);
+    ASSERT_EQ(pdif::serializer::read_u64(ss), 0x0123456789abcdefull);
+    ASSERT_EQ(pdif::serializer::read_i32(ss), -42);
+    ASSERT_EQ(pdif::serializer::read_f32(ss), 0.25f);
+    ASSERT_EQ(pdif::serializer::read_string(ss), "hello");
+}
+
+TEST(PDIFSerializer, TestLittleEndian) {
+    std::stringstream ss;
+    pdif::serializer::write_u32(ss, 0x01020304);
+
+    std::string bytes = ss.str();
+    ASSERT_EQ(bytes.size(), 4);
+    ASSERT_EQ(bytes[0], 0x04);
+    ASSERT_EQ(bytes[3], 0x01);
+}
+
+TEST(PDIFSerializer, TestTruncated) {
+    std::stringstream ss;
+    pdif::serializer::write_u32(ss, 100);
+    ss << "short";
+
+    ASSERT_THROW(pdif::serializer::read_string(ss), pdif::pdif_invalid_format);
+}
+
+TEST(PDIFSerializer, TestStreamRoundTrip) {
+    pdif::stream stream;
+    stream.push_back(pdif::stream_elem::create<pdif::font_elem>("Arial", 12));
+    stream.push_back(pdif::stream_elem::create<pdif::text_color_elem>(0.1f, 0.2f, 0.3f));
+    stream.push_back(pdif::stream_elem::create<pdif::stroke_color_elem>(1, 0, 0));
+    stream.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+
+    auto img = pdif::stream_elem::create<pdif::xobject_img_elem>("abc123", 300, 200);
+    img->as<pdif::xobject_img_elem>()->set_fingerprint(0xf0f0);
+    img->as<pdif::xobject_img_elem>()->set_similarity_threshold(5);
+    stream.push_back(img);
+    stream.push_back(pdif::stream_elem::create<pdif::annotation_elem>("Highlight", std::array<float, 4>{1, 2, 3, 4}, "note", 0xfeedull));
+    stream.push_back(pdif::stream_elem::create<pdif::form_field_elem>("person.name", "Tx", "Alice"));
+
+    std::stringstream ss;
+    pdif::serializer::write_stream(ss, stream);
+    pdif::stream result = pdif::serializer::read_stream(ss);
+
+    ASSERT_EQ(result.size(), stream.size());
+    for (size_t i = 0; i < stream.size(); i++) {
+        ASSERT_TRUE(result[i]->compare(stream[i]));
+    }
+
+    auto result_img = result[4]->as<pdif::xobject_img_elem>();
+    ASSERT_TRUE(result_img->has_fingerprint());
+    ASSERT_EQ(result_img->fingerprint(), 0xf0f0);
+    ASSERT_EQ(result_img->similarity_threshold(), 5);
+}
+
+TEST(PDIFSerializer, TestMetaRoundTrip) {
+    pdif::stream_meta meta;
+    meta.add_metadata("/Title", "A title");
+    meta.add_metadata("/Author", "");
+
+    std::stringstream ss;
+    pdif::serializer::write_meta(ss, meta);
+    pdif::stream_meta result = pdif::serializer::read_meta(ss);
+
+    ASSERT_EQ(result.get_metadata(), meta.get_metadata());
+}
+
+TEST(PDIFSerializer, TestDiffRoundTrip) {
+    pdif::stream original;
+    original.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    original.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+
+    pdif::diff d(false);
+    d.add_original_stream(original);
+    d.add_edit_op(pdif::edit_op(pdif::edit_op_type::EQ));
+    d.add_edit_op(pdif::edit_op(pdif::edit_op_type::INSERT, pdif::stream_elem::create<pdif::text_elem>("there")));
+    d.add_edit_op(pdif::edit_op(pdif::edit_op_type::DELETE));
+    d.add_meta_edit_op(pdif::meta_edit_op(pdif::meta_edit_op_type::META_UPDATE, "/Title", "New"));
+    d.add_meta_edit_op(pdif::meta_edit_op(pdif::meta_edit_op_type::META_DELETE, "/Author"));
+
+    std::stringstream ss;
+    pdif::serializer::write_diff(ss, d);
+    pdif::diff result = pdif::serializer::read_diff(ss, false);
+
+    ASSERT_EQ(result.edit_op_size(), 3);
+    ASSERT_EQ(result.get_edit_op(1).get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(result.get_edit_op(1).get_arg()->as<pdif::text_elem>()->text(), "there");
+    ASSERT_EQ(result.get_edit_op(2).get_type(), pdif::edit_op_type::DELETE);
+
+    ASSERT_EQ(result.meta_edit_op_size(), 2);
+    ASSERT_EQ(result.get_meta_edit_op(0).get_meta_val(), "New");
+    ASSERT_FALSE(result.get_meta_edit_op(1).has_meta_val());
+
+    ASSERT_EQ(result.original_streams().size(), 1);
+    ASSERT_EQ(result.original_streams()[0].size(), 2);
+
+    // the original streams are kept, so the diff renders the same
+    std::stringstream expected, actual;
+    d.output_edit_script(expected);
+    result.output_edit_script(actual);
+    ASSERT_EQ(actual.str(), expected.str());
+}
+
+TEST(PDIFSerializer, TestDiffMoveRoundTrip) {
+    pdif::diff d(false);
+    d.add_edit_op(pdif::edit_op(pdif::edit_op_type::MOVE_FROM, std::nullopt, 7));
+    d.add_edit_op(pdif::edit_op(pdif::edit_op_type::MOVE_TO, pdif::stream_elem::create<pdif::text_elem>("moved"), 7));
+
+    std::stringstream ss;
+    pdif::serializer::write_diff(ss, d);
+    pdif::diff result = pdif::serializer::read_diff(ss, false);
+
+    ASSERT_EQ(result.edit_op_size(), 2);
+    ASSERT_EQ(result.get_edit_op(0).get_type(), pdif::edit_op_type::MOVE_FROM);
+    ASSERT_EQ(result.get_edit_op(0).get_move(), 7);
+    ASSERT_EQ(result.get_edit_op(1).get_type(), pdif::edit_op_type::MOVE_TO);
+    ASSERT_EQ(result.get_edit_op(1).get_move(), 7);
+    ASSERT_EQ(result.get_edit_op(1).get_arg()->as<pdif::text_elem>()->text(), "moved");
+}
+
+TEST(PDIFSerializer, TestDiffBadMagic) {
+    std::stringstream ss("NOTADIFF");
+    ASSERT_THROW(pdif::serializer::read_diff(ss), pdif::pdif_invalid_format);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include <pdif/similarity_index.hpp>
+#include <pdif/stream_elem.hpp>
+#include <pdif/serializer.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+static std::vector<pdif::stream> random_document(std::mt19937& rng, int pages) {
+    std::uniform_int_distribution<int> word(0, 5000);
+
+    std::vector<pdif::stream> document(pages);
+    for (auto& page : document) {
+        for (int i = 0; i < 200; i++) {
+            page.push_back(pdif::stream_elem::create<pdif::text_elem>("word" + std::to_string(word(rng))));
+        }
+    }
+    return document;
+}
+
+class PDIFSimilarityIndex : public ::testing::Test {
+protected:
+
+    void SetUp() override {
+        m_directory = (std::filesystem::temp_directory_path() / "pdif_similarity_index_test").string();
+        std::filesystem::remove_all(m_directory);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(m_directory);
+    }
+
+    std::string m_directory;
+};
+
+TEST_F(PDIFSimilarityIndex, TestEmpty) {
+    pdif::similarity_index index(m_directory);
+    ASSERT_EQ(index.size(), 0);
+
+    std::mt19937 rng(1);
+    ASSERT_TRUE(index.query(random_document(rng, 2)).empty());
+}
+
+TEST_F(PDIFSimilarityIndex, TestFindsRevisionBase) {
+    std::mt19937 rng(2);
+    std::vector<std::vector<pdif::stream>> corpus;
+
+    {
+        pdif::similarity_index index(m_directory);
+        for (int i = 0; i < 50; i++) {
+            corpus.push_back(random_document(rng, 3));
+            ASSERT_EQ(index.add("doc" + std::to_string(i) + ".pdf", corpus.back()), i);
+        }
+    }
+
+    // reopened from disk
+    pdif::similarity_index index(m_directory);
+    ASSERT_EQ(index.size(), 50);
+
+    // a revision of document 17 with a few words changed on its second page
+    auto revision = corpus[17];
+    for (int i = 0; i < 5; i++) {
+        revision[1].pop(i * 30);
+        revision[1].push(i * 30, pdif::stream_elem::create<pdif::text_elem>("edited"));
+    }
+
+    auto candidates = index.query(revision, 5);
+    ASSERT_FALSE(candidates.empty());
+    ASSERT_EQ(candidates[0].path, "doc17.pdf");
+    ASSERT_GT(candidates[0].similarity, 0.8);
+    ASSERT_EQ(candidates[0].matched_pages, 3);
+    ASSERT_EQ(candidates[0].pages, 3);
+
+    // unrelated documents share no band
+    ASSERT_EQ(candidates.size(), 1);
+}
+
+TEST_F(PDIFSimilarityIndex, TestTopK) {
+    std::mt19937 rng(3);
+    pdif::similarity_index index(m_directory);
+
+    auto document = random_document(rng, 2);
+    for (int i = 0; i < 4; i++) {
+        index.add("copy" + std::to_string(i) + ".pdf", document);
+    }
+
+    auto candidates = index.query(document, 3);
+    ASSERT_EQ(candidates.size(), 3);
+    for (const auto& c : candidates) {
+        ASSERT_EQ(c.similarity, 1.0);
+    }
+    ASSERT_EQ(candidates[0].path, "copy0.pdf");
+}
+
+TEST_F(PDIFSimilarityIndex, TestEmptyDocuments) {
+    pdif::similarity_index index(m_directory);
+
+    // documents without text are kept but do not match each other
+    std::vector<pdif::stream> blank(2);
+    ASSERT_EQ(index.add("blank0.pdf", blank), 0);
+    ASSERT_EQ(index.add("blank1.pdf", blank), 1);
+    ASSERT_EQ(index.size(), 2);
+
+    ASSERT_TRUE(index.query(blank).empty());
+}
+
+TEST_F(PDIFSimilarityIndex, TestPartialRecord) {
+    std::mt19937 rng(4);
+    auto document = random_document(rng, 2);
+
+    {
+        pdif::similarity_index index(m_directory);
+        index.add("first.pdf", document);
+    }
+
+    // a writer stopped part way through its record
+    {
+        std::ofstream os(std::filesystem::path(m_directory) / "documents.bin", std::ios::binary | std::ios::app);
+        os.write("torn", 4);
+    }
+
+    pdif::similarity_index index(m_directory);
+    ASSERT_EQ(index.size(), 1);
+    ASSERT_EQ(index.add("second.pdf", document), 1);
+
+    auto candidates = index.query(document);
+    ASSERT_EQ(candidates.size(), 2);
+    ASSERT_EQ(candidates[0].path, "first.pdf");
+    ASSERT_EQ(candidates[1].path, "second.pdf");
+}
+
+TEST_F(PDIFSimilarityIndex, TestMergedShards) {
+    std::mt19937 rng(5);
+    auto common = random_document(rng, 2);
+    auto other = random_document(rng, 2);
+
+    // copies of one document share their band hashes, so their shards' logs fill up and are merged
+    pdif::similarity_index index(m_directory);
+    size_t copies = pdif::similarity_index::MERGE_ENTRIES + 40;
+    for (size_t i = 0; i < copies; i++) {
+        index.add("copy" + std::to_string(i) + ".pdf", common);
+    }
+    ASSERT_EQ(index.add("other.pdf", other), copies);
+
+    size_t sorted_entries = 0;
+    for (const auto& file : std::filesystem::directory_iterator(std::filesystem::path(m_directory) / "buckets")) {
+        std::ifstream is(file.path(), std::ios::binary);
+        std::vector<std::pair<uint64_t, uint32_t>> entries;
+        for (uintmax_t e = 0; e < std::filesystem::file_size(file.path()) / 12; e++) {
+            uint64_t hash = pdif::serializer::read_u64(is);
+            entries.push_back({hash, pdif::serializer::read_u32(is)});
+        }
+
+        if (file.path().extension() == ".log") {
+            ASSERT_LT(entries.size(), pdif::similarity_index::MERGE_ENTRIES);
+        } else {
+            ASSERT_TRUE(std::is_sorted(entries.begin(), entries.end()));
+            sorted_entries += entries.size();
+        }
+    }
+    ASSERT_GT(sorted_entries, 0);
+
+    // found in the sorted shards and the logs alike
+    auto candidates = index.query(common, copies);
+    ASSERT_EQ(candidates.size(), copies);
+    for (const auto& candidate : candidates) {
+        ASSERT_DOUBLE_EQ(candidate.similarity, 1.0);
+    }
+
+    candidates = index.query(other, 1);
+    ASSERT_EQ(candidates.size(), 1);
+    ASSERT_EQ(candidates[0].path, "other.pdf");
+}
+
+TEST_F(PDIFSimilarityIndex, TestNotAnIndex) {
+    std::filesystem::create_directories(m_directory);
+    std::ofstream(std::filesystem::path(m_directory) / "index.meta") << "not an index";
+
+    ASSERT_THROW(pdif::similarity_index index(m_directory), pdif::pdif_invalid_format);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
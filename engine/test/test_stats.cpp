@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <pdif/stats.hpp>
+#include <pdif/stream_differ_base.hpp>
+#include <pdif/lcs_stream_differ.hpp>
+#include <pdif/histogram_stream_differ.hpp>
+#include <pdif/bitparallel_lcs_stream_differ.hpp>
+
+#include <sstream>
+#include <thread>
+
+static pdif::stream make_stream(const std::vector<std::string>& words) {
+    pdif::stream s;
+    for (const auto& word : words) {
+        s.push_back(pdif::stream_elem::create<pdif::text_elem>(word));
+    }
+    return s;
+}
+
+TEST(PDIFStats, TestNoCollector) {
+    ASSERT_EQ(pdif::stats::current(), nullptr);
+
+    // probes without a collector do nothing
+    pdif::stats::add(pdif::stats::counter::tokens, 5);
+    pdif::stats::timer timer(pdif::stats::stage::parse);
+    timer.stop();
+}
+
+TEST(PDIFStats, TestCollect) {
+    pdif::stats outer;
+    pdif::stats inner;
+    {
+        pdif::stats::collect collect(&outer);
+        ASSERT_EQ(pdif::stats::current(), &outer);
+        pdif::stats::add(pdif::stats::counter::tokens, 2);
+
+        {
+            pdif::stats::collect nested(&inner);
+            pdif::stats::add(pdif::stats::counter::tokens, 3);
+        }
+
+        ASSERT_EQ(pdif::stats::current(), &outer);
+        pdif::stats::add(pdif::stats::counter::tokens, 4);
+
+        // other threads have their own collector
+        std::thread([]() {
+            ASSERT_EQ(pdif::stats::current(), nullptr);
+        }).join();
+    }
+
+    ASSERT_EQ(pdif::stats::current(), nullptr);
+    ASSERT_EQ(outer.count(pdif::stats::counter::tokens), 6);
+    ASSERT_EQ(inner.count(pdif::stats::counter::tokens), 3);
+}
+
+TEST(PDIFStats, TestTimers) {
+    pdif::stats stats;
+    {
+        pdif::stats::collect collect(&stats);
+
+        {
+            pdif::stats::timer timer(pdif::stats::stage::diff);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        pdif::stats::timer stopped(pdif::stats::stage::render);
+        stopped.stop();
+        stopped.stop();
+
+        pdif::stats::add(pdif::stats::counter::ops, 1);
+        {
+            pdif::stats::page_timer page(false, 2);
+            pdif::stats::add(pdif::stats::counter::tokens, 10);
+            pdif::stats::add(pdif::stats::counter::elements, 4);
+        }
+        {
+            pdif::stats::page_timer page(true, 2);
+            pdif::stats::add(pdif::stats::counter::ops, 7);
+        }
+    }
+
+    ASSERT_GE(stats.stage_ns(pdif::stats::stage::diff), 1000000u);
+    ASSERT_EQ(stats.stage_calls(pdif::stats::stage::diff), 1);
+    ASSERT_EQ(stats.stage_calls(pdif::stats::stage::render), 1);
+    ASSERT_EQ(stats.stage_calls(pdif::stats::stage::parse), 0);
+
+    ASSERT_EQ(stats.pages().size(), 1);
+    const pdif::stats::page& page = stats.pages().at(2);
+    ASSERT_EQ(page.counters[(size_t)pdif::stats::counter::tokens], 10);
+    ASSERT_EQ(page.counters[(size_t)pdif::stats::counter::elements], 4);
+    ASSERT_EQ(page.counters[(size_t)pdif::stats::counter::ops], 7);
+    ASSERT_EQ(stats.count(pdif::stats::counter::ops), 8);
+}
+
+TEST(PDIFStats, TestMerge) {
+    pdif::stats a;
+    pdif::stats b;
+
+    for (pdif::stats* s : {&a, &b}) {
+        pdif::stats::collect collect(s);
+        pdif::stats::timer timer(pdif::stats::stage::extract);
+        pdif::stats::page_timer page(false, s == &a ? 0 : 1);
+        pdif::stats::add(pdif::stats::counter::cmaps, 1);
+    }
+
+    a.merge(b);
+    ASSERT_EQ(a.count(pdif::stats::counter::cmaps), 2);
+    ASSERT_EQ(a.stage_calls(pdif::stats::stage::extract), 2);
+    ASSERT_EQ(a.pages().size(), 2);
+    ASSERT_EQ(a.pages().at(1).counters[(size_t)pdif::stats::counter::cmaps], 1);
+}
+
+TEST(PDIFStats, TestDiffCounters) {
+    pdif::stream s1 = make_stream({"the", "quick", "brown", "fox"});
+    pdif::stream s2 = make_stream({"the", "slow", "brown", "fox", "jumps"});
+
+    pdif::stats lcs;
+    {
+        pdif::stats::collect collect(&lcs);
+        pdif::diff d;
+        pdif::stream_differ_base::diff_page<pdif::lcs_stream_differ>(d, &s1, &s2, -1);
+        ASSERT_EQ(lcs.count(pdif::stats::counter::ops), d.edit_op_size());
+    }
+    ASSERT_EQ(lcs.count(pdif::stats::counter::dp_cells), 4 * 5);
+    ASSERT_EQ(lcs.stage_calls(pdif::stats::stage::diff), 1);
+
+    pdif::stats bitparallel;
+    {
+        pdif::stats::collect collect(&bitparallel);
+        pdif::diff d;
+        pdif::stream_differ_base::diff_page<pdif::bitparallel_lcs_stream_differ>(d, &s1, &s2, -1);
+    }
+    ASSERT_GT(bitparallel.count(pdif::stats::counter::dp_cells), 0);
+
+    pdif::stats histogram;
+    {
+        pdif::stats::collect collect(&histogram);
+        pdif::diff d;
+        pdif::stream_differ_base::diff_page<pdif::histogram_stream_differ>(d, &s1, &s2, 10);
+    }
+    ASSERT_GT(histogram.count(pdif::stats::counter::dp_cells), 0);
+    ASSERT_EQ(histogram.count(pdif::stats::counter::ops), lcs.count(pdif::stats::counter::ops));
+}
+
+TEST(PDIFStats, TestOutput) {
+    pdif::stats stats;
+    {
+        pdif::stats::collect collect(&stats);
+        pdif::stats::page_timer page(true, 0);
+        pdif::stats::add(pdif::stats::counter::dp_cells, 12);
+    }
+
+    std::stringstream ss;
+    stats.output(ss);
+
+    std::string out = ss.str();
+    ASSERT_EQ(out.rfind("Stats:\n", 0), 0);
+    ASSERT_NE(out.find("  parse: 0.000 ms (0 calls)\n"), std::string::npos);
+    ASSERT_NE(out.find("  dp_cells: 12\n"), std::string::npos);
+    ASSERT_NE(out.find("  page 1: extract 0.000 ms, diff "), std::string::npos);
+    ASSERT_NE(out.find(", dp_cells 12, ops 0\n"), std::string::npos);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -190,6 +190,21 @@ TEST(PDIFStream, TestStreamCallbackInvalidErrorInCallback) {
     ASSERT_THROW({stream.stream_callback(pdif::edit_op(pdif::edit_op_type::DELETE));}, pdif::pdif_error_in_callback);
 }
 
+TEST(PDIFStream, TestView) {
+    pdif::stream stream;
+    stream.push_back(pdif::stream_elem::create<pdif::text_elem>("Hello"));
+    stream.push_back(pdif::stream_elem::create<pdif::text_elem>("World"));
+
+    pdif::stream_view view = stream;
+    ASSERT_EQ(view.size(), 2);
+    ASSERT_EQ(view[1].get(), stream[1].get());
+    ASSERT_EQ(view[1].use_count(), 1);
+
+    pdif::stream tail(view.subspan(1));
+    ASSERT_EQ(tail.size(), 1);
+    ASSERT_EQ(tail[0].get(), stream[1].get());
+}
+
 
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
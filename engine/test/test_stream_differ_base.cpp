@@ -1,12 +1,17 @@
 #include <gtest/gtest.h>
 #include <pdif/stream_differ_base.hpp>
+#include <pdif/lcs_stream_differ.hpp>
+
+#include <random>
 
 // make a concrete class for testing
 class stream_differ_base_concrete : public pdif::stream_differ_base {
 public:
     stream_differ_base_concrete(const pdif::stream& stream1, const pdif::stream& stream2) : pdif::stream_differ_base(stream1, stream2) {}
 
-    void diff(pdif::diff&) override {}
+    void diff(pdif::diff&) override { diffed = true; }
+
+    bool diffed = false;
 };
 
 TEST(PDIFStreamDifferBase, TestConstructor) {
@@ -72,6 +77,166 @@ TEST(PDIFStreamDifferBase, TestMetaDiffDelete) {
     ASSERT_FALSE(op.has_meta_val());
 }
 
+TEST(PDIFStreamDifferBase, TestMetaDiffMixed) {
+    pdif::stream_meta meta1;
+    pdif::stream_meta meta2;
+
+    meta1.add_metadata("a", "deleted");
+    meta1.add_metadata("b", "same");
+    meta1.add_metadata("d", "old");
+    meta1.add_metadata("f", "deleted");
+    meta2.add_metadata("b", "same");
+    meta2.add_metadata("c", "added");
+    meta2.add_metadata("d", "new");
+    meta2.add_metadata("e", "added");
+
+    pdif::diff d;
+    pdif::stream_differ_base::meta_diff(d, meta1, meta2);
+
+    // adds and updates in key order, then deletes in key order
+    std::vector<std::pair<pdif::meta_edit_op_type, std::string>> expected = {
+        {pdif::meta_edit_op_type::META_ADD, "c"},
+        {pdif::meta_edit_op_type::META_UPDATE, "d"},
+        {pdif::meta_edit_op_type::META_ADD, "e"},
+        {pdif::meta_edit_op_type::META_DELETE, "a"},
+        {pdif::meta_edit_op_type::META_DELETE, "f"},
+    };
+
+    ASSERT_EQ(d.meta_edit_op_size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(d.get_meta_edit_op(i).get_type(), expected[i].first);
+        ASSERT_EQ(d.get_meta_edit_op(i).get_meta_key(), expected[i].second);
+    }
+
+    // applying the ops to the old metadata gives the new metadata
+    for (size_t i = 0; i < d.meta_edit_op_size(); i++) {
+        d.get_meta_edit_op(i).execute(meta1);
+    }
+    ASSERT_EQ(meta1.get_metadata(), meta2.get_metadata());
+}
+
+static pdif::stream make_text_stream(const std::string& text) {
+    pdif::stream stream;
+    for (char c : text) {
+        stream.push_back(pdif::stream_elem::create<pdif::text_elem>(std::string(1, c)));
+    }
+    return stream;
+}
+
+TEST(PDIFStreamDifferBase, TestBoundedDiffWithinBound) {
+    pdif::stream stream1 = make_text_stream("the quick brown fox");
+    pdif::stream stream2 = make_text_stream("the quack brown fix");
+
+    // within the bound the differ's own script is used
+    stream_differ_base_concrete concrete(stream1, stream2);
+    pdif::diff empty;
+    ASSERT_TRUE(concrete.bounded_diff(empty, 4));
+    ASSERT_TRUE(concrete.diffed);
+    ASSERT_EQ(empty.edit_op_size(), 0);
+
+    pdif::lcs_stream_differ differ(stream1, stream2);
+    pdif::diff d;
+
+    ASSERT_TRUE(differ.bounded_diff(d, 4));
+
+    int plus, minus, eq;
+    d.count_edit_op_types(plus, minus, eq);
+    ASSERT_EQ(plus, 2);
+    ASSERT_EQ(minus, 2);
+    ASSERT_EQ(eq, 17);
+
+    // hunks are ordered inserts first
+    ASSERT_EQ(d.get_edit_op(6).get_type(), pdif::edit_op_type::INSERT);
+    ASSERT_EQ(d.get_edit_op(6).get_arg()->as<pdif::text_elem>()->text(), "a");
+    ASSERT_EQ(d.get_edit_op(7).get_type(), pdif::edit_op_type::DELETE);
+}
+
+TEST(PDIFStreamDifferBase, TestBoundedDiffExceeded) {
+    pdif::stream stream1 = make_text_stream("abcdef");
+    pdif::stream stream2 = make_text_stream("uvwxyz");
+
+    stream_differ_base_concrete differ(stream1, stream2);
+    pdif::diff d;
+
+    ASSERT_FALSE(differ.bounded_diff(d, 5));
+    ASSERT_FALSE(differ.diffed);
+
+    ASSERT_EQ(d.edit_op_size(), 12);
+    for (int i = 0; i < 6; i++) {
+        ASSERT_EQ(d.get_edit_op(i).get_type(), pdif::edit_op_type::INSERT);
+        ASSERT_EQ(d.get_edit_op(i + 6).get_type(), pdif::edit_op_type::DELETE);
+    }
+}
+
+TEST(PDIFStreamDifferBase, TestBoundedDiffUnbounded) {
+    pdif::stream stream1 = make_text_stream("abc");
+    pdif::stream stream2 = make_text_stream("abd");
+
+    pdif::lcs_stream_differ differ(stream1, stream2);
+    pdif::diff bounded;
+    pdif::diff unbounded;
+
+    ASSERT_TRUE(differ.bounded_diff(bounded, -1));
+    differ.diff(unbounded);
+
+    ASSERT_EQ(bounded.edit_op_size(), unbounded.edit_op_size());
+}
+
+TEST(PDIFStreamDifferBase, TestBoundedDiffRandom) {
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> letter('a', 'd');
+    std::uniform_int_distribution<int> length(0, 60);
+
+    for (int round = 0; round < 100; round++) {
+        std::string text1, text2;
+        int m = length(rng), n = length(rng);
+        for (int i = 0; i < m; i++) text1 += (char)letter(rng);
+        for (int j = 0; j < n; j++) text2 += (char)letter(rng);
+
+        pdif::stream stream1 = make_text_stream(text1);
+        pdif::stream stream2 = make_text_stream(text2);
+
+        pdif::lcs_stream_differ reference(stream1, stream2);
+        pdif::diff expected;
+        reference.diff(expected);
+
+        int plus, minus, eq;
+        expected.count_edit_op_types(plus, minus, eq);
+        int distance = plus + minus;
+
+        // exactly at the bound the minimal script is found
+        pdif::diff d;
+        ASSERT_TRUE(reference.bounded_diff(d, distance));
+
+        int bounded_plus, bounded_minus, bounded_eq;
+        d.count_edit_op_types(bounded_plus, bounded_minus, bounded_eq);
+        ASSERT_EQ(bounded_eq, eq);
+
+        pdif::stream result = stream1;
+        ASSERT_NO_THROW(d.apply_edit_script(result));
+        ASSERT_EQ(result.size(), stream2.size());
+        for (size_t j = 0; j < result.size(); j++) {
+            ASSERT_TRUE(result[j]->compare(stream2[j]));
+        }
+
+        // one below the bound gives up
+        if (distance > 0) {
+            pdif::diff replaced;
+            ASSERT_FALSE(reference.bounded_diff(replaced, distance - 1));
+            ASSERT_EQ(replaced.edit_op_size(), m + n);
+        }
+    }
+}
+
+TEST(PDIFStreamDifferBase, TestNoTemporaryStreams) {
+    // a differ only views its streams, so it cannot be built from a temporary
+    static_assert(std::is_constructible_v<pdif::lcs_stream_differ, const pdif::stream&, const pdif::stream&>);
+    static_assert(std::is_constructible_v<pdif::lcs_stream_differ, pdif::stream_view, pdif::stream_view>);
+    static_assert(!std::is_constructible_v<pdif::lcs_stream_differ, pdif::stream, const pdif::stream&>);
+    static_assert(!std::is_constructible_v<pdif::lcs_stream_differ, const pdif::stream&, pdif::stream>);
+    static_assert(!std::is_constructible_v<pdif::lcs_stream_differ, pdif::stream, pdif::stream>);
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -268,6 +268,103 @@ TEST(PDIFXObjectImgElem, TestCompareFalseHeight) {
     ASSERT_FALSE(elem1->compare(elem2));
 }
 
+TEST(PDIFXObjectImgElem, TestCompareSimilarFingerprint) {
+    pdif::rxobject_img_elem elem1 = pdif::stream_elem::create<pdif::xobject_img_elem>("faf89233299323faf3f3", 300, 300)->as<pdif::xobject_img_elem>();
+    pdif::rxobject_img_elem elem2 = pdif::stream_elem::create<pdif::xobject_img_elem>("0a089233299323faf3f4", 600, 600)->as<pdif::xobject_img_elem>();
+
+    elem1->set_fingerprint(0xF0F0F0F0F0F0F0F0ULL);
+    elem2->set_fingerprint(0xF0F0F0F0F0F0F0F1ULL);
+
+    // similarity matching is disabled by default
+    ASSERT_FALSE(elem1->compare(elem2));
+
+    elem1->set_similarity_threshold(2);
+    elem2->set_similarity_threshold(2);
+
+    ASSERT_TRUE(elem1->compare(elem2));
+    ASSERT_TRUE(elem2->compare(elem1));
+}
+
+TEST(PDIFXObjectImgElem, TestHashSimilarFingerprint) {
+    pdif::rxobject_img_elem elem1 = pdif::stream_elem::create<pdif::xobject_img_elem>("faf89233299323faf3f3", 300, 300)->as<pdif::xobject_img_elem>();
+    pdif::rxobject_img_elem elem2 = pdif::stream_elem::create<pdif::xobject_img_elem>("0a089233299323faf3f4", 600, 600)->as<pdif::xobject_img_elem>();
+    pdif::rxobject_img_elem elem3 = pdif::stream_elem::create<pdif::xobject_img_elem>("1b089233299323faf3f5", 300, 300)->as<pdif::xobject_img_elem>();
+
+    elem1->set_fingerprint(0xF0F0F0F0F0F0F0F0ULL);
+    elem2->set_fingerprint(0xF0F0F0F0F0F0F0F1ULL);
+    elem3->set_fingerprint(0x0F0F0F0F0F0F0F0FULL);
+    elem1->set_similarity_threshold(64);
+    elem2->set_similarity_threshold(64);
+    elem3->set_similarity_threshold(64);
+
+    // similar images hash the same, images in another bucket neither hash nor compare the same
+    ASSERT_EQ(elem1->hash(), elem2->hash());
+    ASSERT_NE(elem1->hash(), elem3->hash());
+    ASSERT_FALSE(elem1->compare(elem3));
+}
+
+TEST(PDIFXObjectImgElem, TestHashNearDuplicates) {
+    // a resized copy: another stream hash and size, and a few fingerprint bits flipped
+    uint64_t fingerprint = 0xF3E1C0F0F8F0E0F0ULL;
+    std::vector<pdif::rxobject_img_elem> images = {
+        pdif::stream_elem::create<pdif::xobject_img_elem>("faf89233299323faf3f3", 300, 300)->as<pdif::xobject_img_elem>(),
+        pdif::stream_elem::create<pdif::xobject_img_elem>("0a089233299323faf3f4", 600, 600)->as<pdif::xobject_img_elem>(),
+        pdif::stream_elem::create<pdif::xobject_img_elem>("1b089233299323faf3f5", 150, 150)->as<pdif::xobject_img_elem>(),
+    };
+    images[0]->set_fingerprint(fingerprint);
+    images[1]->set_fingerprint(fingerprint ^ 0x0000000000000101ULL);
+    images[2]->set_fingerprint(fingerprint ^ 0x0000001000000001ULL);
+    for (auto& img : images) {
+        img->set_similarity_threshold(4);
+    }
+
+    // the same image without similarity matching
+    images.push_back(pdif::stream_elem::create<pdif::xobject_img_elem>("faf89233299323faf3f3", 300, 300)->as<pdif::xobject_img_elem>());
+
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            ASSERT_TRUE(images[i]->compare(images[j]));
+            ASSERT_EQ(images[i]->hash(), images[j]->hash());
+        }
+    }
+
+    // whatever compares equal hashes equal
+    for (auto& a : images) {
+        for (auto& b : images) {
+            if (a->compare(b)) {
+                ASSERT_EQ(a->hash(), b->hash());
+            }
+        }
+    }
+    ASSERT_FALSE(images[0]->compare(images[3]));
+    ASSERT_TRUE(images[3]->compare(images[3]));
+}
+
+TEST(PDIFXObjectImgElem, TestCompareDissimilarFingerprint) {
+    pdif::rxobject_img_elem elem1 = pdif::stream_elem::create<pdif::xobject_img_elem>("faf89233299323faf3f3", 300, 300)->as<pdif::xobject_img_elem>();
+    pdif::rxobject_img_elem elem2 = pdif::stream_elem::create<pdif::xobject_img_elem>("0a089233299323faf3f4", 300, 300)->as<pdif::xobject_img_elem>();
+
+    elem1->set_fingerprint(0xF0F0F0F0F0F0F0F0ULL);
+    elem2->set_fingerprint(0x0F0F0F0F0F0F0F0FULL);
+    elem1->set_similarity_threshold(10);
+    elem2->set_similarity_threshold(10);
+
+    ASSERT_FALSE(elem1->compare(elem2));
+}
+
+TEST(PDIFXObjectImgElem, TestCompareMissingFingerprint) {
+    pdif::rxobject_img_elem elem1 = pdif::stream_elem::create<pdif::xobject_img_elem>("faf89233299323faf3f3", 300, 300)->as<pdif::xobject_img_elem>();
+    pdif::rxobject_img_elem elem2 = pdif::stream_elem::create<pdif::xobject_img_elem>("0a089233299323faf3f4", 300, 300)->as<pdif::xobject_img_elem>();
+
+    elem1->set_fingerprint(0);
+    elem1->set_similarity_threshold(64);
+    elem2->set_similarity_threshold(64);
+
+    ASSERT_FALSE(elem2->has_fingerprint());
+    ASSERT_THROW(elem2->fingerprint(), pdif::pdif_invalid_operation);
+    ASSERT_FALSE(elem1->compare(elem2));
+}
+
 TEST(PDIFXObjectImgElem, TestToString) {
     pdif::rxobject_img_elem elem = pdif::stream_elem::create<pdif::xobject_img_elem>("faf89233299323faf3f3", 300, 300)->as<pdif::xobject_img_elem>();
 
@@ -290,6 +387,81 @@ TEST(PDIFXObjectImgElem, TestToStringNoCC) {
     ASSERT_EQ(elem->to_string(false), ss.str());
 }
 
+static pdif::rstream_elem make_annotation(const std::string& contents = "Check this", uint64_t dict_hash = 0x0123456789abcdefull) {
+    return pdif::stream_elem::create<pdif::annotation_elem>("Text", std::array<float, 4>{72, 700, 90.5, 718}, contents, dict_hash);
+}
+
+TEST(PDIFAnnotationElem, TestGetters) {
+    auto elem = make_annotation()->as<pdif::annotation_elem>();
+
+    ASSERT_EQ(elem->type(), pdif::stream_type::annotation);
+    ASSERT_EQ(elem->subtype(), "Text");
+    ASSERT_EQ(elem->rect(), (std::array<float, 4>{72, 700, 90.5, 718}));
+    ASSERT_EQ(elem->contents(), "Check this");
+    ASSERT_EQ(elem->dict_hash(), 0x0123456789abcdefull);
+}
+
+TEST(PDIFAnnotationElem, TestCompare) {
+    ASSERT_TRUE(make_annotation()->compare(make_annotation()));
+    ASSERT_EQ(make_annotation()->hash(), make_annotation()->hash());
+
+    ASSERT_FALSE(make_annotation()->compare(make_annotation("Changed")));
+    ASSERT_FALSE(make_annotation()->compare(make_annotation("Check this", 1)));
+    ASSERT_FALSE(make_annotation()->compare(pdif::stream_elem::create<pdif::annotation_elem>("Highlight", std::array<float, 4>{72, 700, 90.5, 718}, "Check this", 0x0123456789abcdefull)));
+    ASSERT_FALSE(make_annotation()->compare(pdif::stream_elem::create<pdif::annotation_elem>("Text", std::array<float, 4>{72, 701, 90.5, 718}, "Check this", 0x0123456789abcdefull)));
+    ASSERT_FALSE(make_annotation()->compare(pdif::stream_elem::create<pdif::text_elem>("Check this")));
+}
+
+TEST(PDIFAnnotationElem, TestToString) {
+    std::stringstream ss;
+    ss << util::CONSOLE_COLOR_CODE::TEXT_BOLD;
+    ss << util::CONSOLE_COLOR_CODE::FG_LIGHT_MAGENTA;
+    ss << "[Annotation: Text, (72, 700, 90.5, 718), \"Check this\", (hash)0123456789abcdef]";
+    ss << util::CONSOLE_COLOR_CODE::TEXT_RESET;
+    ss << util::CONSOLE_COLOR_CODE::FG_DEFAULT;
+
+    ASSERT_EQ(make_annotation()->to_string(), ss.str());
+    ASSERT_EQ(make_annotation("")->to_string(false), "[Annotation: Text, (72, 700, 90.5, 718), (hash)0123456789abcdef]");
+}
+
+TEST(PDIFFormFieldElem, TestGetters) {
+    auto elem = pdif::stream_elem::create<pdif::form_field_elem>("person.name", "Tx", "Alice")->as<pdif::form_field_elem>();
+
+    ASSERT_EQ(elem->type(), pdif::stream_type::form_field);
+    ASSERT_EQ(elem->name(), "person.name");
+    ASSERT_EQ(elem->field_type(), "Tx");
+    ASSERT_EQ(elem->value(), "Alice");
+}
+
+TEST(PDIFFormFieldElem, TestCompare) {
+    auto elem = pdif::stream_elem::create<pdif::form_field_elem>("person.name", "Tx", "Alice");
+
+    ASSERT_TRUE(elem->compare(pdif::stream_elem::create<pdif::form_field_elem>("person.name", "Tx", "Alice")));
+    ASSERT_EQ(elem->hash(), pdif::stream_elem::create<pdif::form_field_elem>("person.name", "Tx", "Alice")->hash());
+
+    ASSERT_FALSE(elem->compare(pdif::stream_elem::create<pdif::form_field_elem>("person.name", "Tx", "Bob")));
+    ASSERT_FALSE(elem->compare(pdif::stream_elem::create<pdif::form_field_elem>("person.surname", "Tx", "Alice")));
+    ASSERT_FALSE(elem->compare(pdif::stream_elem::create<pdif::form_field_elem>("person.name", "Ch", "Alice")));
+    ASSERT_FALSE(elem->compare(pdif::stream_elem::create<pdif::text_elem>("Alice")));
+}
+
+TEST(PDIFFormFieldElem, TestToStringNoCC) {
+    auto elem = pdif::stream_elem::create<pdif::form_field_elem>("agree", "Btn", "Yes");
+
+    ASSERT_EQ(elem->to_string(false), "[Form field: agree, Btn, \"Yes\"]");
+}
+
+TEST(PDIFStreamElem, TestStreamTypeRoundTrip) {
+    for (auto type : {pdif::stream_type::annotation, pdif::stream_type::form_field}) {
+        std::stringstream ss;
+        ss << type;
+
+        pdif::stream_type parsed;
+        ss >> parsed;
+        ASSERT_EQ(parsed, type);
+    }
+}
+
 TEST(PDIFStreamElem, TestCompareDifferentTypeTextFont) {
     pdif::rstream_elem elem1 = pdif::stream_elem::create<pdif::text_elem>("Hello, World!");
     pdif::rstream_elem elem2 = pdif::stream_elem::create<pdif::font_elem>("Arial", 9);
@@ -353,6 +525,34 @@ TEST(PDIFStreamElem, TestCompareDifferentTypeTextColorXObjectImg) {
     ASSERT_FALSE(elem1->compare(elem2));
 }
 
+TEST(PDIFStreamElem, TestRenderToAppends) {
+    std::string buffer = "> ";
+    pdif::stream_elem::create<pdif::text_elem>("Hello")->render_to(buffer, false);
+    buffer.push_back(' ');
+    pdif::stream_elem::create<pdif::font_elem>("CMR10", 9)->render_to(buffer, false);
+    buffer.push_back(' ');
+    pdif::stream_elem::create<pdif::stroke_color_elem>(0.333333333f, 1.f / 7.f, 1e-7f)->render_to(buffer, false);
+
+    ASSERT_EQ(buffer, "> Hello [Font set: CMR10, 9pt] [Stroke color set: 0.333333r, 0.142857g, 1e-07b]");
+}
+
+TEST(PDIFStreamElem, TestRenderFloatMatchesStream) {
+    for (float f : {0.f, 1.f, 0.5f, 0.81f, 0.1f, 123456.f, 1234567.f, 1e-5f, -0.25f}) {
+        std::stringstream ss;
+        ss << f;
+
+        std::string buffer;
+        pdif::render_float(buffer, f);
+        ASSERT_EQ(buffer, ss.str());
+    }
+}
+
+TEST(PDIFStreamElem, TestConsoleColor) {
+    std::stringstream ss;
+    ss << util::CONSOLE_COLOR_CODE::FG_GREEN;
+    ASSERT_EQ(pdif::console_color(util::CONSOLE_COLOR_CODE::FG_GREEN), ss.str());
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
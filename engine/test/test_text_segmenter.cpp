@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <pdif/text_segmenter.hpp>
+
+#include <random>
+#include <sstream>
+
+static std::vector<std::string> push_all(pdif::text_segmenter& segmenter, const std::vector<std::string>& ops, bool flush = true) {
+    std::vector<std::string> out;
+    auto emit = [&out](std::string_view segment) { out.emplace_back(segment); };
+
+    for (auto& op : ops) {
+        segmenter.push(op, emit);
+    }
+
+    if (flush) {
+        segmenter.flush(emit);
+    }
+
+    return out;
+}
+
+// the buffer based segmentation the segmenter replaces
+static std::vector<std::string> reference(pdif::granularity g, const std::vector<std::string>& ops) {
+    std::vector<std::string> out;
+    std::string buffer;
+
+    for (auto& op : ops) {
+        if (!buffer.empty()) {
+            buffer.push_back(' ');
+        }
+        buffer.append(op);
+
+        if (g == pdif::granularity::word) {
+            std::istringstream iss(buffer);
+            std::string word;
+            while (iss >> word) {
+                out.push_back(word);
+            }
+            buffer.clear();
+        } else {
+            size_t fullstop_pos = buffer.find('.');
+            while (fullstop_pos != std::string::npos) {
+                out.push_back(buffer.substr(0, fullstop_pos + 1));
+                buffer.erase(0, fullstop_pos + 1);
+                if (buffer.empty()) {
+                    break;
+                }
+
+                if (buffer[0] == ' ') {
+                    buffer.erase(0, 1);
+                }
+
+                fullstop_pos = buffer.find('.');
+            }
+        }
+    }
+
+    if (!buffer.empty()) {
+        out.push_back(buffer);
+    }
+
+    return out;
+}
+
+TEST(PDIFTextSegmenter, TestWords) {
+    pdif::text_segmenter segmenter(pdif::granularity::word);
+
+    std::vector<std::string> expected = {"Hello", "World", "foo", "bar"};
+    ASSERT_EQ(push_all(segmenter, {"  Hello \t World\n", "foo bar"}), expected);
+    ASSERT_TRUE(segmenter.empty());
+}
+
+TEST(PDIFTextSegmenter, TestOperatorEndsWord) {
+    pdif::text_segmenter segmenter(pdif::granularity::word);
+
+    std::vector<std::string> expected = {"Hel", "lo"};
+    ASSERT_EQ(push_all(segmenter, {"Hel", "lo"}), expected);
+}
+
+TEST(PDIFTextSegmenter, TestLetters) {
+    pdif::text_segmenter segmenter(pdif::granularity::letter);
+
+    std::vector<std::string> expected = {"a", "b", "c"};
+    ASSERT_EQ(push_all(segmenter, {"a b", " c "}), expected);
+}
+
+TEST(PDIFTextSegmenter, TestLettersKeepCombiningMarks) {
+    pdif::text_segmenter segmenter(pdif::granularity::letter);
+
+    // e + COMBINING ACUTE ACCENT, as produced by NFKD normalisation
+    std::vector<std::string> expected = {"e\xCC\x81", "t", "\xE6\x97\xA5", "\xE6\x9C\xAC"};
+    ASSERT_EQ(push_all(segmenter, {"e\xCC\x81t \xE6\x97\xA5\xE6\x9C\xAC"}), expected);
+}
+
+TEST(PDIFTextSegmenter, TestLettersAfterLongAsciiRun) {
+    pdif::text_segmenter segmenter(pdif::granularity::letter);
+
+    std::string ascii(37, 'x');
+    auto letters = push_all(segmenter, {ascii + "a\xCC\x88" + ascii});
+    ASSERT_EQ(letters.size(), 2 * ascii.size() + 1);
+    ASSERT_EQ(letters[ascii.size()], "a\xCC\x88");
+    ASSERT_EQ(letters.front(), "x");
+    ASSERT_EQ(letters.back(), "x");
+}
+
+TEST(PDIFTextSegmenter, TestLettersInvalidUtf8) {
+    pdif::text_segmenter segmenter(pdif::granularity::letter);
+
+    std::vector<std::string> expected = {"\xFF", "a", "\xC3", "\r\n"};
+    ASSERT_EQ(push_all(segmenter, {"\xFF" "a \xC3\r\n"}), expected);
+}
+
+TEST(PDIFTextSegmenter, TestSentences) {
+    pdif::text_segmenter segmenter(pdif::granularity::sentence);
+
+    std::vector<std::string> expected = {"The cat sat.", "On the mat."};
+    ASSERT_EQ(push_all(segmenter, {"The cat sat. On the", "mat. The"}, false), expected);
+    ASSERT_EQ(segmenter.pending(), "The");
+
+    std::vector<std::string> rest = {"The end"};
+    ASSERT_EQ(push_all(segmenter, {"end"}), rest);
+    ASSERT_TRUE(segmenter.empty());
+}
+
+TEST(PDIFTextSegmenter, TestSentencesKeepExtraSpaces) {
+    pdif::text_segmenter segmenter(pdif::granularity::sentence);
+
+    std::vector<std::string> expected = {"a.", " b.", "c."};
+    ASSERT_EQ(push_all(segmenter, {"a.  b.", "c."}), expected);
+}
+
+TEST(PDIFTextSegmenter, TestFindSpace) {
+    std::string text = std::string(40, 'x') + "\v" + std::string(3, 'y');
+    ASSERT_EQ(pdif::text_segmenter::find_space(text, 0), 40);
+    ASSERT_EQ(pdif::text_segmenter::find_space(text, 41), std::string_view::npos);
+    ASSERT_EQ(pdif::text_segmenter::find_non_space(std::string(33, ' ') + "z", 0), 33);
+    ASSERT_EQ(pdif::text_segmenter::find_non_space("\t\n\r\f ", 0), std::string_view::npos);
+
+    for (int c = 0; c < 256; c++) {
+        std::string s(20, 'a');
+        s[17] = static_cast<char>(c);
+        size_t expected = std::isspace(c) ? 17 : std::string_view::npos;
+        ASSERT_EQ(pdif::text_segmenter::find_space(s, 0), expected) << c;
+    }
+}
+
+TEST(PDIFTextSegmenter, TestMatchesReference) {
+    std::mt19937 rng(42);
+    const std::string alphabet = "ab. \t\n.xyz  ";
+
+    for (auto g : {pdif::granularity::word, pdif::granularity::sentence}) {
+        for (int round = 0; round < 200; round++) {
+            std::vector<std::string> ops(rng() % 6);
+            for (auto& op : ops) {
+                size_t len = rng() % 48;
+                for (size_t i = 0; i < len; i++) {
+                    op.push_back(alphabet[rng() % alphabet.size()]);
+                }
+            }
+
+            pdif::text_segmenter segmenter(g);
+            ASSERT_EQ(push_all(segmenter, ops), reference(g, ops));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <pdif/xmp_parser.hpp>
+
+#include <map>
+
+static std::map<std::string, std::string> parse(const std::string& packet) {
+    std::map<std::string, std::string> properties;
+    pdif::xmp_parser::parse(packet, [&](const std::string& key, const std::string& value) {
+        properties[key] = value;
+    });
+    return properties;
+}
+
+static const std::string PACKET = R"(<?xpacket begin="" id="W5M0MpCehiHzreSzNTczkc9d"?>
+<x:xmpmeta xmlns:x="adobe:ns:meta/" x:xmptk="Adobe XMP Core 5.6">
+  <rdf:RDF xmlns:rdf="http://www.w3.org/1999/02/22-rdf-syntax-ns#">
+    <!-- document properties -->
+    <rdf:Description rdf:about="" xmlns:dc="http://purl.org/dc/elements/1.1/" xmlns:xmp="http://ns.adobe.com/xap/1.0/"
+        xmp:CreatorTool="LaTeX with hyperref" xmp:CreateDate="2024-03-01T12:13:44Z">
+      <dc:format>application/pdf</dc:format>
+      <dc:title>
+        <rdf:Alt>
+          <rdf:li xml:lang="x-default">Fish &amp; Chips</rdf:li>
+          <rdf:li xml:lang="fr-FR">Poisson &#x26; frites</rdf:li>
+        </rdf:Alt>
+      </dc:title>
+      <dc:creator>
+        <rdf:Seq>
+          <rdf:li>First Author</rdf:li>
+          <rdf:li><![CDATA[Second <Author>]]></rdf:li>
+        </rdf:Seq>
+      </dc:creator>
+    </rdf:Description>
+    <rdf:Description rdf:about="" xmlns:xmpMM="http://ns.adobe.com/xap/1.0/mm/" xmlns:stEvt="http://ns.adobe.com/xap/1.0/sType/ResourceEvent#">
+      <xmpMM:History>
+        <rdf:Seq>
+          <rdf:li rdf:parseType="Resource">
+            <stEvt:action>created</stEvt:action>
+            <stEvt:when>2024-03-01</stEvt:when>
+          </rdf:li>
+          <rdf:li stEvt:action="saved" stEvt:when="2024-03-02"/>
+        </rdf:Seq>
+      </xmpMM:History>
+      <xmpMM:DerivedFrom rdf:resource="uuid:1234"/>
+    </rdf:Description>
+  </rdf:RDF>
+</x:xmpmeta>
+<?xpacket end="w"?>)";
+
+TEST(PDIFXmpParser, TestFlatten) {
+    std::map<std::string, std::string> expected = {
+        {"xmp:CreatorTool", "LaTeX with hyperref"},
+        {"xmp:CreateDate", "2024-03-01T12:13:44Z"},
+        {"dc:format", "application/pdf"},
+        {"dc:title[x-default]", "Fish & Chips"},
+        {"dc:title[fr-FR]", "Poisson & frites"},
+        {"dc:creator[1]", "First Author"},
+        {"dc:creator[2]", "Second <Author>"},
+        {"xmpMM:History[1]/stEvt:action", "created"},
+        {"xmpMM:History[1]/stEvt:when", "2024-03-01"},
+        {"xmpMM:History[2]/stEvt:action", "saved"},
+        {"xmpMM:History[2]/stEvt:when", "2024-03-02"},
+        {"xmpMM:DerivedFrom", "uuid:1234"},
+    };
+
+    ASSERT_EQ(parse(PACKET), expected);
+}
+
+TEST(PDIFXmpParser, TestDocumentOrder) {
+    std::vector<std::string> keys;
+    pdif::xmp_parser::parse("<rdf:Description b=\"1\"><c>2</c><a>3</a></rdf:Description>", [&](const std::string& key, const std::string&) {
+        keys.push_back(key);
+    });
+
+    ASSERT_EQ(keys, std::vector<std::string>({"b", "c", "a"}));
+}
+
+TEST(PDIFXmpParser, TestEntities) {
+    auto properties = parse("<p>&lt;&gt;&amp;&quot;&apos; &#65;&#xe9; &unknown; &#xzz;</p>");
+
+    ASSERT_EQ(properties["p"], "<>&\"' A\xc3\xa9 &unknown; &#xzz;");
+}
+
+TEST(PDIFXmpParser, TestEmpty) {
+    ASSERT_TRUE(parse("").empty());
+    ASSERT_TRUE(parse("<?xpacket begin=\"\"?><x:xmpmeta><rdf:RDF/></x:xmpmeta>").empty());
+
+    auto properties = parse("<dc:description/>");
+    ASSERT_EQ(properties.size(), 1);
+    ASSERT_EQ(properties["dc:description"], "");
+}
+
+TEST(PDIFXmpParser, TestMalformed) {
+    auto noop = [](const std::string&, const std::string&) {};
+
+    ASSERT_THROW(pdif::xmp_parser::parse("<a><b></a>", noop), pdif::pdif_invalid_format);
+    ASSERT_THROW(pdif::xmp_parser::parse("<a>", noop), pdif::pdif_invalid_format);
+    ASSERT_THROW(pdif::xmp_parser::parse("</a>", noop), pdif::pdif_invalid_format);
+    ASSERT_THROW(pdif::xmp_parser::parse("<a b=c></a>", noop), pdif::pdif_invalid_format);
+    ASSERT_THROW(pdif::xmp_parser::parse("<a b=\"c></a>", noop), pdif::pdif_invalid_format);
+    ASSERT_THROW(pdif::xmp_parser::parse("<a><!-- </a>", noop), pdif::pdif_invalid_format);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}